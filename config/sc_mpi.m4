@@ -337,6 +337,36 @@ mpiret = MPI_Finalize ();
  $2])
 ])
 
+dnl SC_MPIONESIDED_C_COMPILE_AND_LINK([action-if-successful], [action-if-failed])
+dnl Compile and link an MPI-3 one-sided communication test program
+dnl
+AC_DEFUN([SC_MPIONESIDED_C_COMPILE_AND_LINK],
+[
+AC_MSG_CHECKING([compile/link for MPI-3 one-sided C program])
+AC_LINK_IFELSE([AC_LANG_PROGRAM(
+[[
+#undef MPI
+#include <mpi.h>
+]], [[
+int mpiret;
+int one = 1, slot = 0;
+int *baseptr;
+MPI_Win win;
+MPI_Init ((int *) 0, (char ***) 0);
+mpiret = MPI_Win_allocate(sizeof (int),sizeof (int),MPI_INFO_NULL,MPI_COMM_WORLD,(void *) &baseptr,&win);
+mpiret = MPI_Win_fence(MPI_MODE_NOPRECEDE,win);
+mpiret = MPI_Fetch_and_op(&one,&slot,MPI_INT,0,0,MPI_SUM,win);
+mpiret = MPI_Put(&one,1,MPI_INT,0,0,1,MPI_INT,win);
+mpiret = MPI_Win_fence(MPI_MODE_NOSUCCEED,win);
+mpiret = MPI_Win_free(&win);
+mpiret = MPI_Finalize ();
+]])],
+[AC_MSG_RESULT([successful])
+ $1],
+[AC_MSG_RESULT([failed])
+ $2])
+])
+
 dnl SC_MPICOMMSHARED_C_COMPILE_AND_LINK([action-if-successful], [action-if-failed])
 dnl Compile and link an MPI_COMM_TYPE_SHARED test program
 dnl
@@ -456,6 +486,11 @@ dnl  ])
   if test "x$$1_ENABLE_MPICOMMSHARED" = xyes ; then
     AC_DEFINE([ENABLE_MPICOMMSHARED], 1, [Define to 1 if we can use MPI_COMM_TYPE_SHARED])
   fi
+  $1_ENABLE_MPIONESIDED=yes
+  SC_MPIONESIDED_C_COMPILE_AND_LINK(,[$1_ENABLE_MPIONESIDED=no])
+  if test "x$$1_ENABLE_MPIONESIDED" = xyes ; then
+    AC_DEFINE([ENABLE_MPIONESIDED], 1, [Define to 1 if we can use MPI-3 one-sided communication])
+  fi
 fi
 
 dnl figure out the MPI include directories
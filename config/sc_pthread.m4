@@ -49,6 +49,29 @@ dnl Keep the variables changed as done above
 dnl CFLAGS="$PRE_PTHREAD_CFLAGS"
 
   AC_MSG_RESULT([successful])
+
+  AC_CHECK_FUNCS([pthread_setaffinity_np])
+  AC_CHECK_HEADERS([linux/futex.h sys/syscall.h])
+
+  dnl Atomic builtins let threads update counters without a mutex
+  AC_MSG_CHECKING([for atomic builtins])
+  AC_LINK_IFELSE([AC_LANG_PROGRAM(
+[[
+#include <stddef.h>
+static int counter = 0;
+static size_t position = 0;
+]],[[
+  size_t expected = 0;
+  __atomic_fetch_add (&counter, 1, __ATOMIC_RELAXED);
+  __atomic_compare_exchange_n (&position, &expected, 1, 1,
+                               __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+  __atomic_store_n (&position, 2, __ATOMIC_RELEASE);
+  return __atomic_load_n (&counter, __ATOMIC_RELAXED) != 1;
+]])],
+                 [AC_MSG_RESULT([yes])
+                  AC_DEFINE([HAVE_ATOMIC_BUILTINS], 1,
+                            [Define to 1 if __atomic builtins are available])],
+                 [AC_MSG_RESULT([no])])
 else
   AC_MSG_RESULT([not used])
 fi
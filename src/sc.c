@@ -22,6 +22,7 @@
 */
 
 #include <sc_private.h>
+#include <sc_taskpool.h>
 
 #ifdef SC_HAVE_SIGNAL_H
 #include <signal.h>
@@ -50,7 +51,6 @@ typedef struct sc_package
   int                 is_registered;
   sc_log_handler_t    log_handler;
   int                 log_threshold;
-  int                 log_indent;
   int                 malloc_count;
   int                 free_count;
   int                 rc_active;
@@ -63,6 +63,23 @@ typedef struct sc_package
 }
 sc_package_t;
 
+/** Logging state private to each thread.
+ * The indentation is kept per package and thread.  The formatting and line
+ * buffers let every thread compose a log record without locking; the record
+ * is then written to the stream in one call, so lines do not interleave.
+ */
+typedef struct sc_log_thread
+{
+  int                 id;
+  int                 formatting;
+  int                *indent;
+  int                 num_indent;
+  char               *line;
+  size_t              line_len, line_alloc;
+  char                format[BUFSIZ];
+}
+sc_log_thread_t;
+
 /** The only log handler that comes with libsc. */
 static void         sc_log_handler (FILE * log_stream,
                                     const char *filename, int lineno,
@@ -106,6 +123,10 @@ static FILE        *sc_log_stream = NULL;
 static sc_log_handler_t sc_default_log_handler = sc_log_handler;
 static int          sc_default_log_threshold = SC_LP_THRESHOLD;
 
+/* a negative number of threads selects the environment variables */
+static int          sc_default_num_threads = -1;
+static int          sc_default_pin_threads = 0;
+
 static void         sc_abort_handler (void);
 static sc_abort_handler_t sc_default_abort_handler = sc_abort_handler;
 
@@ -120,6 +141,21 @@ static int          sc_num_packages = 0;
 static int          sc_num_packages_alloc = 0;
 static sc_package_t *sc_packages = NULL;
 
+/** Logging state used without threads, and before \ref sc_init with them. */
+static sc_log_thread_t sc_log_thread_static;
+
+/** Release the buffers of a logging state. */
+static void
+sc_log_thread_free (sc_log_thread_t * lt)
+{
+  free (lt->indent);
+  free (lt->line);
+  lt->indent = NULL;
+  lt->num_indent = 0;
+  lt->line = NULL;
+  lt->line_len = lt->line_alloc = 0;
+}
+
 #ifdef SC_ENABLE_PTHREAD
 
 static pthread_mutex_t sc_default_mutex = PTHREAD_MUTEX_INITIALIZER;
@@ -152,8 +188,133 @@ sc_package_mutex (int package)
   }
 }
 
+static pthread_key_t sc_log_key;
+static int          sc_log_key_valid = 0;
+static int          sc_log_num_threads = 0;
+
+static void
+sc_log_thread_destroy (void *v)
+{
+  sc_log_thread_t    *lt = (sc_log_thread_t *) v;
+
+  sc_log_thread_free (lt);
+  free (lt);
+}
+
+/** Create the key of the per-thread logging state.
+ * This is called by \ref sc_init and thus before any workers exist.
+ */
+static void
+sc_log_key_create (void)
+{
+  int                 pth;
+
+  if (!sc_log_key_valid) {
+    pth = pthread_key_create (&sc_log_key, sc_log_thread_destroy);
+    sc_check_abort_thread (pth == 0, -1, "sc_log_key_create");
+    sc_log_key_valid = 1;
+  }
+}
+
+/** Free the calling thread's logging state and delete the key.
+ * This is called by \ref sc_finalize after the workers are joined.
+ */
+static void
+sc_log_key_delete (void)
+{
+  int                 pth;
+  sc_log_thread_t    *lt;
+
+  if (sc_log_key_valid) {
+    lt = (sc_log_thread_t *) pthread_getspecific (sc_log_key);
+    if (lt != NULL) {
+      pthread_setspecific (sc_log_key, NULL);
+      sc_log_thread_destroy (lt);
+    }
+    pth = pthread_key_delete (sc_log_key);
+    sc_check_abort_thread (pth == 0, -1, "sc_log_key_delete");
+    sc_log_key_valid = 0;
+    sc_log_num_threads = 0;
+  }
+  sc_log_thread_free (&sc_log_thread_static);
+}
+
 #endif /* SC_ENABLE_PTHREAD */
 
+/** Return the logging state of the calling thread.
+ * The state is created on first use and numbered in order of creation,
+ * such that the thread calling \ref sc_init has the number 0.
+ * We allocate it with the system malloc to keep it out of the leak check.
+ */
+static sc_log_thread_t *
+sc_log_thread (void)
+{
+#ifdef SC_ENABLE_PTHREAD
+  sc_log_thread_t    *lt;
+
+  if (!sc_log_key_valid) {
+    return &sc_log_thread_static;
+  }
+  lt = (sc_log_thread_t *) pthread_getspecific (sc_log_key);
+  if (lt == NULL) {
+    lt = (sc_log_thread_t *) calloc (1, sizeof (sc_log_thread_t));
+    sc_check_abort_thread (lt != NULL, -1, "sc_log_thread");
+    pthread_mutex_lock (&sc_default_mutex);
+    lt->id = sc_log_num_threads++;
+    pthread_mutex_unlock (&sc_default_mutex);
+    pthread_setspecific (sc_log_key, lt);
+  }
+  return lt;
+#else
+  return &sc_log_thread_static;
+#endif
+}
+
+/** Return a pointer to the calling thread's indentation for a package. */
+static int         *
+sc_log_thread_indent (sc_log_thread_t * lt, int package)
+{
+  int                 i;
+
+  SC_ASSERT (package >= 0);
+  if (package >= lt->num_indent) {
+    lt->indent = (int *) realloc (lt->indent, (package + 1) * sizeof (int));
+    SC_CHECK_ABORT (lt->indent != NULL, "Failed to allocate memory");
+    for (i = lt->num_indent; i <= package; ++i) {
+      lt->indent[i] = 0;
+    }
+    lt->num_indent = package + 1;
+  }
+  return lt->indent + package;
+}
+
+/** Append formatted text to the calling thread's log line. */
+static void
+sc_log_line_append (sc_log_thread_t * lt, const char *fmt, ...)
+{
+  int                 n;
+  size_t              avail;
+  va_list             ap;
+
+  for (;;) {
+    avail = lt->line_alloc - lt->line_len;
+    va_start (ap, fmt);
+    n = vsnprintf (avail > 0 ? lt->line + lt->line_len : NULL, avail,
+                   fmt, ap);
+    va_end (ap);
+    SC_CHECK_ABORT (n >= 0, "Log line format");
+    if ((size_t) n < avail) {
+      lt->line_len += (size_t) n;
+      return;
+    }
+
+    /* grow the line buffer and try again */
+    lt->line_alloc = 2 * (lt->line_len + (size_t) n + 1);
+    lt->line = (char *) realloc (lt->line, lt->line_alloc);
+    SC_CHECK_ABORT (lt->line != NULL, "Failed to allocate memory");
+  }
+}
+
 void
 sc_package_lock (int package)
 {
@@ -259,28 +420,37 @@ static void
 sc_log_handler (FILE * log_stream, const char *filename, int lineno,
                 int package, int category, int priority, const char *msg)
 {
-  int                 wp = 0, wi = 0;
+  int                 wp = 0, wi = 0, wt = 0;
   int                 lindent = 0;
+  sc_log_thread_t    *lt;
 
+  lt = sc_log_thread ();
   if (package != -1) {
     if (!sc_package_is_registered (package))
       package = -1;
     else {
       wp = 1;
-      lindent = sc_packages[package].log_indent;
+      lindent = *sc_log_thread_indent (lt, package);
     }
   }
   wi = (category == SC_LC_NORMAL && sc_identifier >= 0);
+  wt = (lt->id > 0);
 
-  if (wp || wi) {
-    fputc ('[', log_stream);
+  /* compose the complete record before writing it */
+  lt->line_len = 0;
+  if (wp || wi || wt) {
+    sc_log_line_append (lt, "[");
     if (wp)
-      fprintf (log_stream, "%s", sc_packages[package].name);
+      sc_log_line_append (lt, "%s", sc_packages[package].name);
     if (wp && wi)
-      fputc (' ', log_stream);
+      sc_log_line_append (lt, " ");
     if (wi)
-      fprintf (log_stream, "%d", sc_identifier);
-    fprintf (log_stream, "] %*s", lindent, "");
+      sc_log_line_append (lt, "%d", sc_identifier);
+    if ((wp || wi) && wt)
+      sc_log_line_append (lt, " ");
+    if (wt)
+      sc_log_line_append (lt, "t%d", lt->id);
+    sc_log_line_append (lt, "] %*s", lindent, "");
   }
 
   if (priority == SC_LP_TRACE) {
@@ -288,10 +458,11 @@ sc_log_handler (FILE * log_stream, const char *filename, int lineno,
 
     snprintf (bn, BUFSIZ, "%s", filename);
     bp = basename (bn);
-    fprintf (log_stream, "%s:%d ", bp, lineno);
+    sc_log_line_append (lt, "%s:%d ", bp, lineno);
   }
 
-  fputs (msg, log_stream);
+  sc_log_line_append (lt, "%s", msg);
+  fwrite (lt->line, 1, lt->line_len, log_stream);
   fflush (log_stream);
 }
 
@@ -315,6 +486,39 @@ sc_free_count (int package)
   return &sc_packages[package].free_count;
 }
 
+/** Add to an allocation counter of a package.
+ * With threads, we use relaxed atomics if available and the package mutex
+ * otherwise.  The counters are only compared after the threads have joined,
+ * so no ordering with respect to other memory operations is required.
+ */
+static inline void
+sc_alloc_count_add (int package, int *counter, int increment)
+{
+#ifdef SC_ENABLE_PTHREAD
+#ifdef SC_HAVE_ATOMIC_BUILTINS
+  __atomic_fetch_add (counter, increment, __ATOMIC_RELAXED);
+#else
+  sc_package_lock (package);
+  *counter += increment;
+  sc_package_unlock (package);
+#endif
+#else
+  *counter += increment;
+#endif
+}
+
+/** Read an allocation counter that may be updated by \ref sc_alloc_count_add.
+ */
+static inline int
+sc_alloc_count_get (const int *counter)
+{
+#if defined SC_ENABLE_PTHREAD && defined SC_HAVE_ATOMIC_BUILTINS
+  return __atomic_load_n (counter, __ATOMIC_RELAXED);
+#else
+  return *counter;
+#endif
+}
+
 #ifdef SC_ENABLE_MEMALIGN
 
 /* *INDENT-OFF* */
@@ -531,18 +735,9 @@ sc_malloc (int package, size_t size)
 #endif
 
   /* count the allocations */
-#ifdef SC_ENABLE_PTHREAD
-  sc_package_lock (package);
-#endif
-  if (size > 0) {
-    ++*malloc_count;
+  if (size > 0 || ret != NULL) {
+    sc_alloc_count_add (package, malloc_count, 1);
   }
-  else {
-    *malloc_count += ((ret == NULL) ? 0 : 1);
-  }
-#ifdef SC_ENABLE_PTHREAD
-  sc_package_unlock (package);
-#endif
 
   return ret;
 }
@@ -566,18 +761,9 @@ sc_calloc (int package, size_t nmemb, size_t size)
 #endif
 
   /* count the allocations */
-#ifdef SC_ENABLE_PTHREAD
-  sc_package_lock (package);
-#endif
-  if (nmemb * size > 0) {
-    ++*malloc_count;
-  }
-  else {
-    *malloc_count += ((ret == NULL) ? 0 : 1);
+  if (nmemb * size > 0 || ret != NULL) {
+    sc_alloc_count_add (package, malloc_count, 1);
   }
-#ifdef SC_ENABLE_PTHREAD
-  sc_package_unlock (package);
-#endif
 
   return ret;
 }
@@ -634,13 +820,7 @@ sc_free (int package, void *ptr)
     /* uncount the allocations */
     int                *free_count = sc_free_count (package);
 
-#ifdef SC_ENABLE_PTHREAD
-    sc_package_lock (package);
-#endif
-    ++*free_count;
-#ifdef SC_ENABLE_PTHREAD
-    sc_package_unlock (package);
-#endif
+    sc_alloc_count_add (package, free_count, 1);
   }
 
   /* free memory */
@@ -657,12 +837,14 @@ sc_memory_status (int package)
   sc_package_t       *p;
 
   if (package == -1) {
-    return (default_malloc_count - default_free_count);
+    return (sc_alloc_count_get (&default_malloc_count) -
+            sc_alloc_count_get (&default_free_count));
   }
   else {
     SC_ASSERT (sc_package_is_registered (package));
     p = sc_packages + package;
-    return (p->malloc_count - p->free_count);
+    return (sc_alloc_count_get (&p->malloc_count) -
+            sc_alloc_count_get (&p->free_count));
   }
 }
 
@@ -684,15 +866,16 @@ sc_package_set_abort_alloc_mismatch (int package_id, int set_abort)
 void
 sc_memory_check (int package)
 {
+  int                 balance;
   sc_package_t       *p;
 
+  balance = sc_memory_status (package);
   if (package == -1) {
     SC_CHECK_ABORT (default_rc_active == 0, "Leftover references (default)");
     if (default_abort_mismatch) {
-      SC_CHECK_ABORT (default_malloc_count == default_free_count,
-                      "Memory balance (default)");
+      SC_CHECK_ABORT (balance == 0, "Memory balance (default)");
     }
-    else if (default_malloc_count != default_free_count) {
+    else if (balance != 0) {
       SC_GLOBAL_LERROR ("Memory balance (default)\n");
     }
   }
@@ -701,15 +884,20 @@ sc_memory_check (int package)
     p = sc_packages + package;
     SC_CHECK_ABORTF (p->rc_active == 0, "Leftover references (%s)", p->name);
     if (p->abort_mismatch) {
-      SC_CHECK_ABORTF (p->malloc_count == p->free_count,
-                       "Memory balance (%s)", p->name);
+      SC_CHECK_ABORTF (balance == 0, "Memory balance (%s)", p->name);
     }
-    else if (p->malloc_count != p->free_count) {
+    else if (balance != 0) {
       SC_GLOBAL_LERRORF ("Memory balance (%s)\n", p->name);
     }
   }
 }
 
+int
+sc_compare_plain (const void *v1, const void *v2, void *arg)
+{
+  return (*(int (**)(const void *, const void *)) arg) (v1, v2);
+}
+
 int
 sc_int_compare (const void *v1, const void *v2)
 {
@@ -782,11 +970,50 @@ sc_set_log_defaults (FILE * log_stream,
   sc_log_stream = log_stream;
 }
 
+/** Create the global task pool as set by sc_set_thread_defaults,
+ * or else by environment variables.
+ */
+static void
+sc_init_taskpool (void)
+{
+  int                 num_threads;
+  const char         *env_value;
+
+  if (sc_default_num_threads >= 0) {
+    sc_taskpool_global_init (sc_default_num_threads, sc_default_pin_threads);
+    return;
+  }
+
+  num_threads = 0;
+  env_value = getenv ("SC_NUM_THREADS");
+  if (env_value != NULL) {
+    num_threads = atoi (env_value);
+    SC_CHECK_ABORT (num_threads >= 0, "Invalid SC_NUM_THREADS");
+  }
+  env_value = getenv ("SC_PIN_THREADS");
+  sc_taskpool_global_init (num_threads,
+                           env_value != NULL && atoi (env_value) != 0);
+}
+
+void
+sc_set_thread_defaults (int num_threads, int pin)
+{
+  sc_default_num_threads = num_threads;
+  sc_default_pin_threads = pin;
+
+  /* replace the global task pool if sc_init has created it */
+  if (sc_taskpool_global_lookup () != NULL) {
+    sc_taskpool_global_finalize ();
+    sc_init_taskpool ();
+  }
+}
+
 void
 sc_log (const char *filename, int lineno,
         int package, int category, int priority, const char *msg)
 {
   int                 log_threshold;
+  int                 is_builtin;
   sc_log_handler_t    log_handler;
   sc_package_t       *p;
 
@@ -813,9 +1040,10 @@ sc_log (const char *filename, int lineno,
   if (category == SC_LC_GLOBAL && sc_identifier > 0)
     return;
 
-#ifdef SC_ENABLE_PTHREAD
-  sc_package_lock (package);
-#endif
+  /* the builtin handler writes each record atomically by itself */
+  is_builtin = (log_handler == sc_log_handler);
+  if (!is_builtin)
+    sc_package_lock (package);
   if (sc_trace_file != NULL && priority >= sc_trace_prio)
     log_handler (sc_trace_file, filename, lineno,
                  package, category, priority, msg);
@@ -823,9 +1051,8 @@ sc_log (const char *filename, int lineno,
   if (priority >= log_threshold)
     log_handler (sc_log_stream != NULL ? sc_log_stream : stdout,
                  filename, lineno, package, category, priority, msg);
-#ifdef SC_ENABLE_PTHREAD
-  sc_package_unlock (package);
-#endif
+  if (!is_builtin)
+    sc_package_unlock (package);
 }
 
 void
@@ -843,16 +1070,25 @@ void
 sc_logv (const char *filename, int lineno,
          int package, int category, int priority, const char *fmt, va_list ap)
 {
-  char                buffer[BUFSIZ];
-
-#ifdef SC_ENABLE_PTHREAD
-  sc_package_lock (package);
-#endif
-  vsnprintf (buffer, BUFSIZ, fmt, ap);
-#ifdef SC_ENABLE_PTHREAD
-  sc_package_unlock (package);
-#endif
-  sc_log (filename, lineno, package, category, priority, buffer);
+  char               *buffer;
+  sc_log_thread_t    *lt;
+
+  lt = sc_log_thread ();
+  if (!lt->formatting) {
+    /* format into the buffer of this thread without locking */
+    lt->formatting = 1;
+    vsnprintf (lt->format, BUFSIZ, fmt, ap);
+    sc_log (filename, lineno, package, category, priority, lt->format);
+    lt->formatting = 0;
+  }
+  else {
+    /* a log handler is logging itself; keep the outer message intact */
+    buffer = (char *) malloc (BUFSIZ);
+    SC_CHECK_ABORT (buffer != NULL, "Failed to allocate memory");
+    vsnprintf (buffer, BUFSIZ, fmt, ap);
+    sc_log (filename, lineno, package, category, priority, buffer);
+    free (buffer);
+  }
 }
 
 void
@@ -870,30 +1106,27 @@ sc_log_indent_pop (void)
 void
 sc_log_indent_push_count (int package, int count)
 {
-  /* TODO: figure out a version that makes sense with threads */
-#ifndef SC_ENABLE_PTHREAD
+  int                *indent;
+
   SC_ASSERT (package < sc_num_packages);
 
   if (package >= 0) {
-    sc_packages[package].log_indent += SC_MAX (0, count);
+    indent = sc_log_thread_indent (sc_log_thread (), package);
+    *indent += SC_MAX (0, count);
   }
-#endif
 }
 
 void
 sc_log_indent_pop_count (int package, int count)
 {
-  /* TODO: figure out a version that makes sense with threads */
-#ifndef SC_ENABLE_PTHREAD
-  int                 new_indent;
+  int                *indent;
 
   SC_ASSERT (package < sc_num_packages);
 
   if (package >= 0) {
-    new_indent = sc_packages[package].log_indent - SC_MAX (0, count);
-    sc_packages[package].log_indent = SC_MAX (0, new_indent);
+    indent = sc_log_thread_indent (sc_log_thread (), package);
+    *indent = SC_MAX (0, *indent - SC_MAX (0, count));
   }
-#endif
 }
 
 void
@@ -1055,7 +1288,6 @@ sc_package_register (sc_log_handler_t log_handler, int log_threshold,
       p->is_registered = 0;
       p->log_handler = NULL;
       p->log_threshold = SC_LP_SILENT;
-      p->log_indent = 0;
       p->malloc_count = 0;
       p->free_count = 0;
       p->rc_active = 0;
@@ -1067,7 +1299,6 @@ sc_package_register (sc_log_handler_t log_handler, int log_threshold,
   new_package->is_registered = 1;
   new_package->log_handler = log_handler;
   new_package->log_threshold = log_threshold;
-  new_package->log_indent = 0;
   new_package->malloc_count = 0;
   new_package->free_count = 0;
   new_package->rc_active = 0;
@@ -1153,7 +1384,8 @@ sc_package_print_summary (int log_priority)
     if (p->is_registered) {
       SC_GEN_LOGF (sc_package_id, SC_LC_GLOBAL, log_priority,
                    "   %3d: %-15s +%d-%d   %s\n",
-                   i, p->name, p->malloc_count, p->free_count, p->full);
+                   i, p->name, sc_alloc_count_get (&p->malloc_count),
+                   sc_alloc_count_get (&p->free_count), p->full);
     }
   }
 }
@@ -1171,6 +1403,12 @@ sc_init (sc_MPI_Comm mpicomm,
   sc_mpicomm = sc_MPI_COMM_NULL;
   sc_print_backtrace = print_backtrace;
 
+  /* the initializing thread is logged without a thread number */
+#ifdef SC_ENABLE_PTHREAD
+  sc_log_key_create ();
+#endif
+  (void) sc_log_thread ();
+
   if (mpicomm != sc_MPI_COMM_NULL) {
     int                 mpiret;
 
@@ -1229,6 +1467,8 @@ sc_init (sc_MPI_Comm mpicomm,
     }
   }
 
+  sc_init_taskpool ();
+
   w = 24;
   SC_GLOBAL_ESSENTIALF ("This is %s\n", SC_PACKAGE_STRING);
 #if 0
@@ -1284,6 +1524,9 @@ sc_finalize (void)
   sc_mpi_comm_detach_node_comms (sc_mpicomm);
 #endif
 
+  /* join the worker threads before checking for leaks */
+  sc_taskpool_global_finalize ();
+
   /* sc_packages is static and thus initialized to all zeros */
   for (i = sc_num_packages_alloc - 1; i >= 0; --i)
     if (sc_packages[i].is_registered)
@@ -1302,6 +1545,13 @@ sc_finalize (void)
   sc_print_backtrace = 0;
   sc_identifier = -1;
 
+  /* release the logging state of the calling thread */
+#ifdef SC_ENABLE_PTHREAD
+  sc_log_key_delete ();
+#else
+  sc_log_thread_free (&sc_log_thread_static);
+#endif
+
   /* close trace file */
   if (sc_trace_file != NULL) {
     retval = fclose (sc_trace_file);
@@ -509,6 +509,25 @@ int                 sc_int32_compare (const void *v1, const void *v2);
 int                 sc_int64_compare (const void *v1, const void *v2);
 int                 sc_double_compare (const void *v1, const void *v2);
 
+/** Comparison function that takes a context argument.
+ * It is used by the reentrant sorting and searching functions, whose names
+ * end in _r, such as \ref sc_qsort_r and \ref sc_array_sort_r.
+ * \param [in] v1      First object.
+ * \param [in] v2      Second object.
+ * \param [in] arg     Context passed to the sorting or searching function.
+ * \return             Less than, equal to, or greater than zero if \b v1
+ *                     is less than, equal to, or greater than \b v2.
+ */
+typedef int         (*sc_compare_r_t) (const void *v1, const void *v2,
+                                       void *arg);
+
+/** Call a comparison function without context as an \ref sc_compare_r_t.
+ * \param [in] arg     Address of a variable of type
+ *                     int (*) (const void *, const void *).
+ */
+int                 sc_compare_plain (const void *v1, const void *v2,
+                                      void *arg);
+
 /** Controls the default SC log behavior.
  * \param [in] log_stream    Set stream to use by sc_logf (or NULL for stdout).
  * \param [in] log_handler   Set default SC log handler (NULL selects builtin).
@@ -519,6 +538,18 @@ void                sc_set_log_defaults (FILE * log_stream,
                                          sc_log_handler_t log_handler,
                                          int log_thresold);
 
+/** Controls the global task pool (see sc_taskpool.h).
+ * Called before \ref sc_init, it sets the pool that sc_init creates.
+ * Called between sc_init and \ref sc_finalize, it replaces the pool,
+ * which must not have pending tasks at that time.
+ * The setting takes precedence over the environment variables.
+ * \param [in] num_threads  Number of worker threads, may be zero.
+ *                          If negative, the environment variables
+ *                          SC_NUM_THREADS and SC_PIN_THREADS are used.
+ * \param [in] pin          Boolean to pin the workers to cores.
+ */
+void                sc_set_thread_defaults (int num_threads, int pin);
+
 /** Controls the default SC abort behavior.
  * \param [in] abort_handler Set default SC above handler (NULL selects
  *                           builtin).  ***This function should not return!***
@@ -527,6 +558,10 @@ void                sc_set_abort_handler (sc_abort_handler_t abort_handler);
 
 /** The central log function to be called by all packages.
  * Dispatches the log calls by package and filters by category and priority.
+ * The builtin log handler prefixes the message with the package name,
+ * the MPI rank, and a thread number tN for all threads other than the one
+ * that called \ref sc_init.  It writes every message in one call without
+ * locking.  A custom log handler is called under the package lock.
  * \param [in] package   Must be a registered package id or -1.
  * \param [in] category  Must be SC_LC_NORMAL or SC_LC_GLOBAL.
  * \param [in] priority  Must be > SC_LP_ALWAYS and < SC_LP_SILENT.
@@ -542,10 +577,14 @@ void                sc_logv (const char *filename, int lineno,
                              int package, int category, int priority,
                              const char *fmt, va_list ap);
 
-/** Add spaces to the start of a package's default log format. */
+/** Add spaces to the start of a package's default log format.
+ * The indentation is private to the calling thread.
+ */
 void                sc_log_indent_push_count (int package, int count);
 
-/** Remove spaces from the start of a package's default log format. */
+/** Remove spaces from the start of a package's default log format.
+ * The indentation is private to the calling thread.
+ */
 void                sc_log_indent_pop_count (int package, int count);
 
 /** Add one space to the start of sc's default log format. */
@@ -659,6 +698,12 @@ void                sc_package_print_summary (int log_priority);
  *                              Otherwise, sc_MPI_Init must have been called.
  * \param [in] catch_signals    If true, signals INT SEGV USR2 are be caught.
  * \param [in] print_backtrace  If true, sc_abort prints a backtrace.
+ *
+ * The global task pool (see sc_taskpool.h) is created as set by
+ * sc_set_thread_defaults ().  If that is not called, the environment
+ * variable SC_NUM_THREADS sets its number of worker threads, which
+ * defaults to zero, and if SC_PIN_THREADS is set to a nonzero number,
+ * the workers are pinned.
  */
 void                sc_init (sc_MPI_Comm mpicomm,
                              int catch_signals, int print_backtrace,
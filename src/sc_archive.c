@@ -0,0 +1,517 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_archive.h>
+#include <sc_private.h>
+
+/** The first word of an archive and the last word of its trailer. */
+#define SC_ARCHIVE_MAGIC ((uint64_t) 0x5343415243563031ULL)
+
+/** A word that tells the byte order of the writer. */
+#define SC_ARCHIVE_ORDER ((uint64_t) 0x0102030405060708ULL)
+
+/** The version of the archive format. */
+#define SC_ARCHIVE_FORMAT 1
+
+/** Alignment of the sections in the archive. */
+#define SC_ARCHIVE_ALIGN 64
+
+/** Number of words in a section header after the name. */
+#define SC_ARCHIVE_WORDS 10
+
+/** Size of a section header. */
+#define SC_ARCHIVE_HEADER \
+  (SC_ARCHIVE_NAME_LEN + SC_ARCHIVE_WORDS * sizeof (uint64_t))
+
+/** Size of an index entry: a section header and its offset. */
+#define SC_ARCHIVE_ENTRY (SC_ARCHIVE_HEADER + sizeof (uint64_t))
+
+/** Number of words in the trailer at the end of the archive. */
+#define SC_ARCHIVE_TRAILER 3
+
+struct sc_archive_writer
+{
+  sc_io_sink_t       *sink;
+  int                 level;
+  int                 error;    /**< some write has failed */
+  uint64_t            offset;   /**< bytes written so far */
+  sc_array_t         *index;    /**< sc_archive_section_t for each section */
+};
+
+struct sc_archive_reader
+{
+  sc_io_source_t     *source;
+  int                 swapped;  /**< the byte order is not ours */
+  sc_array_t         *index;    /**< sc_archive_section_t for each section */
+};
+
+/** Zeros to pad the sections. */
+static const char   sc_archive_zeros[SC_ARCHIVE_ALIGN];
+
+static              uint64_t
+sc_archive_swap64 (uint64_t w)
+{
+  w = ((w & 0x00000000ffffffffULL) << 32) | (w >> 32);
+  w = ((w & 0x0000ffff0000ffffULL) << 16) |
+    ((w >> 16) & 0x0000ffff0000ffffULL);
+  w = ((w & 0x00ff00ff00ff00ffULL) << 8) |
+    ((w >> 8) & 0x00ff00ff00ff00ffULL);
+  return w;
+}
+
+/** Reverse the bytes of each element of an array in place. */
+static void
+sc_archive_swap_elements (char *data, size_t elem_size, size_t elem_count)
+{
+  size_t              iz, ib;
+  char                c;
+
+  for (iz = 0; iz < elem_count; ++iz, data += elem_size) {
+    for (ib = 0; ib < elem_size / 2; ++ib) {
+      c = data[ib];
+      data[ib] = data[elem_size - 1 - ib];
+      data[elem_size - 1 - ib] = c;
+    }
+  }
+}
+
+/** Write the header of a section and, for the index, its data offset. */
+static void
+sc_archive_pack (const sc_archive_section_t * section, char *out,
+                 int with_offset)
+{
+  uint64_t            words[SC_ARCHIVE_WORDS + 1];
+
+  memset (words, 0, sizeof (words));
+  words[0] = section->type;
+  words[1] = section->version;
+  words[2] = section->elem_size;
+  words[3] = section->elem_count;
+  words[4] = section->encoding;
+  words[5] = section->bytes;
+  words[6] = section->checksum;
+  words[7] = section->checksum_kind;
+  words[SC_ARCHIVE_WORDS] = section->offset;
+  memcpy (out, section->name, SC_ARCHIVE_NAME_LEN);
+  memcpy (out + SC_ARCHIVE_NAME_LEN, words,
+          (SC_ARCHIVE_WORDS + (with_offset ? 1 : 0)) * sizeof (uint64_t));
+}
+
+/** Read an index entry.
+ * \return              0 on success, nonzero if the entry is invalid.
+ */
+static int
+sc_archive_unpack (const char *in, int swapped, sc_archive_section_t * section)
+{
+  int                 i;
+  uint64_t            words[SC_ARCHIVE_WORDS + 1];
+
+  memcpy (section->name, in, SC_ARCHIVE_NAME_LEN);
+  memcpy (words, in + SC_ARCHIVE_NAME_LEN, sizeof (words));
+  if (swapped) {
+    for (i = 0; i <= SC_ARCHIVE_WORDS; ++i) {
+      words[i] = sc_archive_swap64 (words[i]);
+    }
+  }
+  section->type = words[0];
+  section->version = words[1];
+  section->elem_size = words[2];
+  section->elem_count = words[3];
+  section->encoding = words[4];
+  section->bytes = words[5];
+  section->checksum = words[6];
+  section->checksum_kind = words[7];
+  section->offset = words[SC_ARCHIVE_WORDS];
+  section->swapped = swapped;
+
+  /* raw data must fill the section exactly */
+  return section->name[SC_ARCHIVE_NAME_LEN - 1] != '\0' ||
+    section->elem_size == 0 ||
+    section->encoding >= (uint64_t) SC_ARCHIVE_ENCODE_LAST ||
+    (section->encoding == SC_ARCHIVE_ENCODE_NONE &&
+     (section->elem_count > UINT64_MAX / section->elem_size ||
+      section->bytes != section->elem_size * section->elem_count));
+}
+
+/** Write pieces to the sink and count them. */
+static void
+sc_archive_writev (sc_archive_writer_t * writer, const sc_io_vec_t * vecs,
+                   int count)
+{
+  int                 i;
+
+  if (writer->error) {
+    return;
+  }
+  writer->error = sc_io_sink_writev (writer->sink, vecs, count);
+  for (i = 0; i < count; ++i) {
+    writer->offset += (uint64_t) vecs[i].bytes;
+  }
+}
+
+sc_archive_writer_t *
+sc_archive_writer_new (sc_io_sink_t * sink, int level)
+{
+  uint64_t            words[4];
+  sc_io_vec_t         vecs[2];
+  sc_archive_writer_t *writer;
+
+  SC_ASSERT (sink != NULL);
+
+  writer = SC_ALLOC_ZERO (sc_archive_writer_t, 1);
+  writer->sink = sink;
+  writer->level = level;
+  writer->index = sc_array_new (sizeof (sc_archive_section_t));
+
+  /* the first section starts on the alignment boundary */
+  words[0] = SC_ARCHIVE_MAGIC;
+  words[1] = SC_ARCHIVE_ORDER;
+  words[2] = SC_ARCHIVE_FORMAT;
+  words[3] = 0;
+  vecs[0].data = words;
+  vecs[0].bytes = sizeof (words);
+  vecs[1].data = (void *) sc_archive_zeros;
+  vecs[1].bytes = SC_ARCHIVE_ALIGN - sizeof (words);
+  sc_archive_writev (writer, vecs, 2);
+  if (writer->error) {
+    sc_array_destroy (writer->index);
+    SC_FREE (writer);
+    return NULL;
+  }
+
+  return writer;
+}
+
+int
+sc_archive_write (sc_archive_writer_t * writer, const char *name,
+                  uint64_t type, uint64_t version, sc_array_t * data,
+                  int encode)
+{
+  size_t              bytes;
+  char                header[SC_ARCHIVE_HEADER];
+  sc_array_t         *coded;
+  sc_io_vec_t         vecs[3];
+  sc_archive_section_t *section;
+
+  SC_ASSERT (writer != NULL);
+  SC_ASSERT (name != NULL);
+  SC_ASSERT (data != NULL && data->elem_size > 0);
+  SC_ASSERT (0 <= encode && encode < SC_ARCHIVE_ENCODE_LAST);
+
+  if (writer->error || strlen (name) >= SC_ARCHIVE_NAME_LEN) {
+    return SC_IO_ERROR_FATAL;
+  }
+
+  section = (sc_archive_section_t *) sc_array_push (writer->index);
+  memset (section, 0, sizeof (sc_archive_section_t));
+  strcpy (section->name, name);
+  section->type = type;
+  section->version = version;
+  section->elem_size = (uint64_t) data->elem_size;
+  section->elem_count = (uint64_t) data->elem_count;
+  section->encoding = (uint64_t) encode;
+  bytes = data->elem_size * data->elem_count;
+  section->checksum = sc_io_hash64 (data->array, bytes);
+  section->checksum_kind = SC_IO_HASH64_KIND;
+
+  /* the header, the stored data and the padding in one write */
+  coded = NULL;
+  if (encode == SC_ARCHIVE_ENCODE_NONE) {
+    vecs[1].data = data->array;
+    vecs[1].bytes = bytes;
+  }
+  else {
+    coded = sc_array_new (sizeof (char));
+    sc_io_encode_shuffle (data, coded, encode ==
+                          SC_ARCHIVE_ENCODE_SHUFFLE_DELTA, writer->level);
+    sc_io_vec_array (&vecs[1], coded);
+  }
+  section->bytes = (uint64_t) vecs[1].bytes;
+  section->offset = writer->offset + SC_ARCHIVE_HEADER;
+  sc_archive_pack (section, header, 0);
+  vecs[0].data = header;
+  vecs[0].bytes = SC_ARCHIVE_HEADER;
+  vecs[2].data = (void *) sc_archive_zeros;
+  vecs[2].bytes = (SC_ARCHIVE_ALIGN - (size_t) ((section->offset +
+                                                 section->bytes) %
+                                                SC_ARCHIVE_ALIGN)) %
+    SC_ARCHIVE_ALIGN;
+  sc_archive_writev (writer, vecs, 3);
+  if (coded != NULL) {
+    sc_array_destroy (coded);
+  }
+
+  return writer->error ? SC_IO_ERROR_FATAL : SC_IO_ERROR_NONE;
+}
+
+int
+sc_archive_writer_destroy (sc_archive_writer_t * writer)
+{
+  int                 retval;
+  size_t              iz, num;
+  uint64_t            trailer[SC_ARCHIVE_TRAILER];
+  char               *entries;
+  sc_io_vec_t         vecs[2];
+
+  SC_ASSERT (writer != NULL);
+
+  /* the index is followed by the trailer that locates it */
+  num = writer->index->elem_count;
+  entries = SC_ALLOC (char, SC_MAX (num, 1) * SC_ARCHIVE_ENTRY);
+  for (iz = 0; iz < num; ++iz) {
+    sc_archive_pack ((sc_archive_section_t *)
+                     sc_array_index (writer->index, iz),
+                     entries + iz * SC_ARCHIVE_ENTRY, 1);
+  }
+  trailer[0] = (uint64_t) num;
+  trailer[1] = writer->offset;
+  trailer[2] = SC_ARCHIVE_MAGIC;
+  vecs[0].data = entries;
+  vecs[0].bytes = num * SC_ARCHIVE_ENTRY;
+  vecs[1].data = trailer;
+  vecs[1].bytes = sizeof (trailer);
+  sc_archive_writev (writer, vecs, 2);
+  SC_FREE (entries);
+
+  retval = writer->error;
+  sc_array_destroy (writer->index);
+  SC_FREE (writer);
+
+  return retval ? SC_IO_ERROR_FATAL : SC_IO_ERROR_NONE;
+}
+
+/** Copy a range of the archive into memory.
+ * \return              0 on success, nonzero on error.
+ */
+static int
+sc_archive_fetch (sc_archive_reader_t * reader, uint64_t offset,
+                  uint64_t bytes, void *dest)
+{
+  sc_io_source_t     *source = reader->source;
+  uint64_t            size;
+
+  if (source->iotype == SC_IO_TYPE_BUFFER) {
+    size = (uint64_t) (source->buffer->elem_count *
+                       source->buffer->elem_size);
+    if (offset > size || bytes > size - offset) {
+      return -1;
+    }
+    memcpy (dest, source->buffer->array + offset, (size_t) bytes);
+    return 0;
+  }
+  return fseek (source->file, (long) offset, SEEK_SET) ||
+    fread (dest, 1, (size_t) bytes, source->file) != (size_t) bytes;
+}
+
+sc_archive_reader_t *
+sc_archive_reader_new (sc_io_source_t * source)
+{
+  int                 swapped;
+  long                fsize;
+  size_t              iz, num;
+  uint64_t            size, head[4], trailer[SC_ARCHIVE_TRAILER];
+  char               *entries;
+  sc_archive_reader_t *reader;
+  sc_archive_section_t *section;
+
+  SC_ASSERT (source != NULL);
+
+  /* find the size of the archive */
+  if (source->iotype == SC_IO_TYPE_BUFFER) {
+    size = (uint64_t) (source->buffer->elem_count *
+                       source->buffer->elem_size);
+  }
+  else {
+    if (source->direct != NULL || fseek (source->file, 0, SEEK_END) ||
+        (fsize = ftell (source->file)) < 0) {
+      return NULL;
+    }
+    size = (uint64_t) fsize;
+  }
+  if (size < SC_ARCHIVE_ALIGN + sizeof (trailer)) {
+    return NULL;
+  }
+
+  /* the trailer tells the byte order and where the index is */
+  reader = SC_ALLOC_ZERO (sc_archive_reader_t, 1);
+  reader->source = source;
+  reader->index = sc_array_new (sizeof (sc_archive_section_t));
+  entries = NULL;
+  if (sc_archive_fetch (reader, size - sizeof (trailer), sizeof (trailer),
+                        trailer) ||
+      sc_archive_fetch (reader, 0, sizeof (head), head)) {
+    goto bad;
+  }
+  swapped = trailer[2] != SC_ARCHIVE_MAGIC;
+  if (swapped) {
+    for (iz = 0; iz < SC_ARCHIVE_TRAILER; ++iz) {
+      trailer[iz] = sc_archive_swap64 (trailer[iz]);
+    }
+    for (iz = 0; iz < 4; ++iz) {
+      head[iz] = sc_archive_swap64 (head[iz]);
+    }
+  }
+  if (trailer[2] != SC_ARCHIVE_MAGIC || head[0] != SC_ARCHIVE_MAGIC ||
+      head[1] != SC_ARCHIVE_ORDER || head[2] != SC_ARCHIVE_FORMAT ||
+      trailer[1] > size || trailer[0] > (uint64_t) INT_MAX ||
+      trailer[0] * SC_ARCHIVE_ENTRY + trailer[1] + sizeof (trailer) != size) {
+    goto bad;
+  }
+  reader->swapped = swapped;
+
+  /* load and check the index */
+  num = (size_t) trailer[0];
+  entries = SC_ALLOC (char, SC_MAX (num, 1) * SC_ARCHIVE_ENTRY);
+  if (sc_archive_fetch (reader, trailer[1], num * SC_ARCHIVE_ENTRY,
+                        entries)) {
+    goto bad;
+  }
+  sc_array_resize (reader->index, num);
+  for (iz = 0; iz < num; ++iz) {
+    section = (sc_archive_section_t *) sc_array_index (reader->index, iz);
+    if (sc_archive_unpack (entries + iz * SC_ARCHIVE_ENTRY, swapped,
+                           section) || section->offset > trailer[1] ||
+        section->bytes > trailer[1] - section->offset) {
+      goto bad;
+    }
+  }
+  SC_FREE (entries);
+
+  return reader;
+
+bad:
+  SC_FREE (entries);
+  sc_archive_reader_destroy (reader);
+  return NULL;
+}
+
+void
+sc_archive_reader_destroy (sc_archive_reader_t * reader)
+{
+  SC_ASSERT (reader != NULL);
+
+  sc_array_destroy (reader->index);
+  SC_FREE (reader);
+}
+
+int
+sc_archive_num_sections (sc_archive_reader_t * reader)
+{
+  SC_ASSERT (reader != NULL);
+
+  return (int) reader->index->elem_count;
+}
+
+const sc_archive_section_t *
+sc_archive_section (sc_archive_reader_t * reader, int i)
+{
+  SC_ASSERT (reader != NULL);
+
+  return (const sc_archive_section_t *) sc_array_index_int (reader->index,
+                                                            i);
+}
+
+int
+sc_archive_find (sc_archive_reader_t * reader, const char *name)
+{
+  size_t              iz;
+  sc_archive_section_t *section;
+
+  SC_ASSERT (reader != NULL);
+  SC_ASSERT (name != NULL);
+
+  for (iz = 0; iz < reader->index->elem_count; ++iz) {
+    section = (sc_archive_section_t *) sc_array_index (reader->index, iz);
+    if (!strcmp (section->name, name)) {
+      return (int) iz;
+    }
+  }
+  return -1;
+}
+
+int
+sc_archive_read (sc_archive_reader_t * reader, int i, sc_array_t * data)
+{
+  int                 retval;
+  sc_array_t         *coded;
+  const sc_archive_section_t *section;
+
+  SC_ASSERT (data != NULL);
+
+  section = sc_archive_section (reader, i);
+  if ((uint64_t) data->elem_size != section->elem_size) {
+    return SC_IO_ERROR_FATAL;
+  }
+
+  if (section->encoding == SC_ARCHIVE_ENCODE_NONE) {
+    sc_array_resize (data, (size_t) section->elem_count);
+    retval = sc_archive_fetch (reader, section->offset,
+                               (uint64_t) (data->elem_count *
+                                           data->elem_size), data->array);
+  }
+  else {
+    /* the encoding is in the byte order of the writer */
+    if (section->swapped) {
+      return SC_IO_ERROR_FATAL;
+    }
+    coded = sc_array_new_count (sizeof (char), (size_t) section->bytes);
+    retval = sc_archive_fetch (reader, section->offset, section->bytes,
+                               coded->array) ||
+      sc_io_decode_shuffle (coded, data) ||
+      (uint64_t) data->elem_count != section->elem_count;
+    sc_array_destroy (coded);
+  }
+
+  /* the checksum was computed in the byte order of the writer */
+  if (!retval && section->checksum_kind == SC_IO_HASH64_KIND) {
+    retval = sc_io_hash64 (data->array, data->elem_count * data->elem_size)
+      != section->checksum;
+  }
+  if (!retval && section->swapped &&
+      (data->elem_size == 2 || data->elem_size == 4 ||
+       data->elem_size == 8)) {
+    sc_archive_swap_elements (data->array, data->elem_size,
+                              data->elem_count);
+  }
+
+  return retval ? SC_IO_ERROR_FATAL : SC_IO_ERROR_NONE;
+}
+
+int
+sc_archive_view (sc_archive_reader_t * reader, int i, sc_array_t * view)
+{
+  const sc_archive_section_t *section;
+
+  SC_ASSERT (view != NULL);
+
+  section = sc_archive_section (reader, i);
+  if (reader->source->iotype != SC_IO_TYPE_BUFFER ||
+      section->encoding != SC_ARCHIVE_ENCODE_NONE || section->swapped) {
+    return SC_IO_ERROR_FATAL;
+  }
+  sc_array_init_data (view, reader->source->buffer->array +
+                      section->offset, (size_t) section->elem_size,
+                      (size_t) section->elem_count);
+
+  return SC_IO_ERROR_NONE;
+}
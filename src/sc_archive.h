@@ -0,0 +1,188 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef SC_ARCHIVE_H
+#define SC_ARCHIVE_H
+
+/** \file sc_archive.h
+ * This file provides a self-describing binary container of arrays.
+ *
+ * An archive consists of named sections, each holding the data of one
+ * array together with a user type code and version, its element size and
+ * count, the byte order of the writer, an optional encoding, and a 64 bit
+ * checksum of the data.  Sizes and offsets are 64 bit throughout.
+ *
+ * Archives are written in one pass through an \ref sc_io_sink_t.  Every
+ * section starts on a 64 byte boundary, and the data follow a section
+ * header of fixed size, so that the data of unencoded sections are aligned
+ * in the file and in memory mapped copies of it.  At the end, the writer
+ * appends an index of all sections and a trailer that points to it.
+ *
+ * A reader works on an \ref sc_io_source_t of type BUFFER or on a file
+ * source.  It loads the index from the end, so any section can be found
+ * and loaded without reading the others.  For BUFFER sources, which may
+ * wrap memory mapped files, unencoded sections can be accessed as views
+ * without copying.  Data of element size 2, 4 or 8 written on a machine
+ * of the other byte order are swapped on loading; encoded sections can
+ * only be decoded with the byte order they were written in.
+ */
+
+#include <sc_io.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** Maximum length of a section name including the terminating zero. */
+#define SC_ARCHIVE_NAME_LEN 48
+
+/** The encodings of the data of a section. */
+typedef enum
+{
+  SC_ARCHIVE_ENCODE_NONE = 0,   /**< raw data */
+  SC_ARCHIVE_ENCODE_SHUFFLE,    /**< see \ref sc_io_encode_shuffle */
+  SC_ARCHIVE_ENCODE_SHUFFLE_DELTA,      /**< the same with neighbor deltas */
+  SC_ARCHIVE_ENCODE_LAST        /**< Invalid entry to close list */
+}
+sc_archive_encode_t;
+
+/** The description of a section in an archive. */
+typedef struct sc_archive_section
+{
+  char                name[SC_ARCHIVE_NAME_LEN];        /**< zero terminated */
+  uint64_t            type;     /**< code chosen by the application */
+  uint64_t            version;  /**< version chosen by the application */
+  uint64_t            elem_size;        /**< element size in bytes */
+  uint64_t            elem_count;       /**< number of elements */
+  uint64_t            encoding; /**< an \ref sc_archive_encode_t value */
+  uint64_t            bytes;    /**< stored size of the data */
+  uint64_t            checksum; /**< checksum of the decoded data */
+  uint64_t            checksum_kind;    /**< algorithm of the checksum */
+  uint64_t            offset;   /**< offset of the stored data */
+  int                 swapped;  /**< written in the other byte order */
+}
+sc_archive_section_t;
+
+/** A writer of an archive; opaque structure. */
+typedef struct sc_archive_writer sc_archive_writer_t;
+
+/** A reader of an archive; opaque structure. */
+typedef struct sc_archive_reader sc_archive_reader_t;
+
+/** Begin writing an archive to a sink.
+ * \param [in,out] sink     The sink is borrowed by the writer.  Its output
+ *                          must start with the archive.
+ * \param [in] level        Compression level for the shuffle encodings;
+ *                          see \ref sc_io_encode_shuffle.
+ * \return                  A valid writer, or NULL if writing failed.
+ */
+sc_archive_writer_t *sc_archive_writer_new (sc_io_sink_t * sink, int level);
+
+/** Add the data of an array to the archive as a new section.
+ * \param [in,out] writer   Valid writer.
+ * \param [in] name         Name of the section, shorter than
+ *                          \ref SC_ARCHIVE_NAME_LEN.  Names need not be
+ *                          unique.
+ * \param [in] type         Type code chosen by the application.
+ * \param [in] version      Version chosen by the application.
+ * \param [in] data         The elements to store.
+ * \param [in] encode       An \ref sc_archive_encode_t value.
+ * \return                  0 on success, nonzero on error.
+ */
+int                 sc_archive_write (sc_archive_writer_t * writer,
+                                      const char *name, uint64_t type,
+                                      uint64_t version, sc_array_t * data,
+                                      int encode);
+
+/** Finish an archive by writing its index and free the writer.
+ * The sink is neither completed nor destroyed.
+ * \param [in,out] writer   This writer is invalidated.
+ * \return                  0 on success, nonzero if this or an earlier
+ *                          write failed.
+ */
+int                 sc_archive_writer_destroy (sc_archive_writer_t * writer);
+
+/** Open an archive for reading and load its index.
+ * \param [in] source       A source of type BUFFER, or of a file type and
+ *                          not in direct mode.  The reader positions the
+ *                          source as needed; it must not be read from
+ *                          otherwise while the reader exists.
+ * \return                  A valid reader, or NULL if the source does not
+ *                          hold a valid archive.
+ */
+sc_archive_reader_t *sc_archive_reader_new (sc_io_source_t * source);
+
+/** Free a reader.  The source is not destroyed.
+ * \param [in,out] reader   This reader is invalidated.
+ */
+void                sc_archive_reader_destroy (sc_archive_reader_t *
+                                               reader);
+
+/** Return the number of sections of an archive.
+ * \param [in] reader       Valid reader.
+ * \return                  Number of sections.
+ */
+int                 sc_archive_num_sections (sc_archive_reader_t * reader);
+
+/** Return the description of a section.
+ * \param [in] reader       Valid reader.
+ * \param [in] i            Number of the section in the order written.
+ * \return                  The description, valid with the reader.
+ */
+const sc_archive_section_t *sc_archive_section (sc_archive_reader_t *
+                                                reader, int i);
+
+/** Find a section by name.
+ * \param [in] reader       Valid reader.
+ * \param [in] name         Name of the section.
+ * \return                  Number of the first section of this name, or -1
+ *                          if there is none.
+ */
+int                 sc_archive_find (sc_archive_reader_t * reader,
+                                     const char *name);
+
+/** Load the data of a section.
+ * The data are decoded, brought into our byte order, and checked against
+ * the checksum if it was computed by the same algorithm as in this build.
+ * \param [in] reader       Valid reader.
+ * \param [in] i            Number of the section.
+ * \param [in,out] data     Array of the element size of the section.  It
+ *                          is resized to the number of elements.
+ * \return                  0 on success, nonzero on error.
+ */
+int                 sc_archive_read (sc_archive_reader_t * reader, int i,
+                                     sc_array_t * data);
+
+/** Access the data of a section in a BUFFER source without copying.
+ * The data are not checked against the checksum.
+ * \param [in] reader       Valid reader of a BUFFER source.
+ * \param [in] i            Number of the section, which must not be
+ *                          encoded and not need byte swapping.
+ * \param [out] view        Initialized as a view of the section's elements.
+ *                          It is valid as long as the source buffer.
+ * \return                  0 on success, nonzero if a view is not possible.
+ */
+int                 sc_archive_view (sc_archive_reader_t * reader, int i,
+                                     sc_array_t * view);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_ARCHIVE_H */
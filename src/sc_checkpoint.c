@@ -0,0 +1,373 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_checkpoint.h>
+#include <sc_private.h>
+
+/** The default block size in bytes. */
+#define SC_CHECKPOINT_BLOCK ((size_t) 1 << 16)
+
+/** The first word of each checkpoint. */
+#define SC_CHECKPOINT_MAGIC ((uint64_t) 0x5343434b50543031ULL)
+
+/** Number of words in the header of a checkpoint. */
+#define SC_CHECKPOINT_HEADER 5
+
+/** Number of words in the header of an array in a checkpoint. */
+#define SC_CHECKPOINT_FIELD 3
+
+/** A registered array and the checksums of its blocks. */
+typedef struct sc_checkpoint_field
+{
+  sc_array_t         *array;
+  sc_array_t         *sums;     /**< uint64_t per block */
+  size_t              bytes;    /**< size of the array at the last time */
+  int                 valid;    /**< sums describe the last checkpoint */
+}
+sc_checkpoint_field_t;
+
+struct sc_checkpoint
+{
+  size_t              block_size;
+  uint64_t            sequence; /**< number of the last checkpoint */
+  int                 valid;    /**< a checkpoint was written or read */
+  sc_array_t         *fields;
+};
+
+/** Data to compute the checksums of the blocks of an array in parallel. */
+typedef struct sc_checkpoint_sum
+{
+  const char         *data;
+  size_t              bytes, block_size;
+  uint64_t           *sums;
+}
+sc_checkpoint_sum_t;
+
+sc_checkpoint_t    *
+sc_checkpoint_new (size_t block_size)
+{
+  sc_checkpoint_t    *ckpt;
+
+  ckpt = SC_ALLOC_ZERO (sc_checkpoint_t, 1);
+  ckpt->block_size = block_size > 0 ? block_size : SC_CHECKPOINT_BLOCK;
+  ckpt->fields = sc_array_new (sizeof (sc_checkpoint_field_t));
+
+  return ckpt;
+}
+
+void
+sc_checkpoint_destroy (sc_checkpoint_t * ckpt)
+{
+  size_t              iz;
+  sc_checkpoint_field_t *field;
+
+  for (iz = 0; iz < ckpt->fields->elem_count; ++iz) {
+    field = (sc_checkpoint_field_t *) sc_array_index (ckpt->fields, iz);
+    sc_array_destroy (field->sums);
+  }
+  sc_array_destroy (ckpt->fields);
+  SC_FREE (ckpt);
+}
+
+int
+sc_checkpoint_add (sc_checkpoint_t * ckpt, sc_array_t * array)
+{
+  sc_checkpoint_field_t *field;
+
+  SC_ASSERT (ckpt != NULL);
+  SC_ASSERT (array != NULL && array->elem_size > 0);
+
+  field = (sc_checkpoint_field_t *) sc_array_push (ckpt->fields);
+  field->array = array;
+  field->sums = sc_array_new (sizeof (uint64_t));
+  field->valid = 0;
+
+  /* a new array needs a full checkpoint */
+  ckpt->valid = 0;
+
+  return (int) ckpt->fields->elem_count - 1;
+}
+
+static void
+sc_checkpoint_sum_blocks (size_t begin, size_t end, void *data)
+{
+  sc_checkpoint_sum_t *cs = (sc_checkpoint_sum_t *) data;
+  size_t              ib, offset;
+
+  for (ib = begin; ib < end; ++ib) {
+    offset = ib * cs->block_size;
+    cs->sums[ib] = sc_io_hash64 (cs->data + offset,
+                                 SC_MIN (cs->block_size, cs->bytes - offset));
+  }
+}
+
+/** Compute the checksums of all blocks of an array. */
+static void
+sc_checkpoint_sum (sc_checkpoint_t * ckpt, sc_array_t * array,
+                   sc_array_t * sums)
+{
+  size_t              nblocks;
+  sc_taskpool_t      *pool;
+  sc_checkpoint_sum_t cs;
+
+  cs.data = array->array;
+  cs.bytes = array->elem_count * array->elem_size;
+  cs.block_size = ckpt->block_size;
+  nblocks = (cs.bytes + cs.block_size - 1) / cs.block_size;
+  sc_array_resize (sums, nblocks);
+  cs.sums = (uint64_t *) sums->array;
+
+  pool = sc_taskpool_global_lookup ();
+  if (pool != NULL && nblocks > 1) {
+    sc_taskpool_parallel_for (pool, 0, nblocks, 0,
+                              sc_checkpoint_sum_blocks, &cs);
+  }
+  else {
+    sc_checkpoint_sum_blocks (0, nblocks, &cs);
+  }
+}
+
+/** Write the changed blocks of one array. */
+static int
+sc_checkpoint_write_field (sc_checkpoint_t * ckpt,
+                           sc_checkpoint_field_t * field, sc_io_sink_t * sink,
+                           int full, size_t * blocks)
+{
+  int                 retval;
+  size_t              ib, nblocks, bytes, offset;
+  uint64_t            header[SC_CHECKPOINT_FIELD];
+  uint64_t           *old_sums, *new_sums;
+  sc_array_t         *sums, *changed, *vecs;
+  sc_array_t         *array = field->array;
+  sc_io_vec_t        *vec;
+
+  /* compare the checksums with those of the last checkpoint */
+  sums = sc_array_new (sizeof (uint64_t));
+  sc_checkpoint_sum (ckpt, array, sums);
+  nblocks = sums->elem_count;
+  bytes = array->elem_count * array->elem_size;
+  full = full || !field->valid || field->bytes != bytes;
+  changed = sc_array_new (sizeof (uint64_t));
+  old_sums = (uint64_t *) field->sums->array;
+  new_sums = (uint64_t *) sums->array;
+  for (ib = 0; ib < nblocks; ++ib) {
+    if (full || old_sums[ib] != new_sums[ib]) {
+      *(uint64_t *) sc_array_push (changed) = (uint64_t) ib;
+    }
+  }
+
+  /* header, block indices and blocks go out in one vectored write */
+  header[0] = (uint64_t) array->elem_size;
+  header[1] = (uint64_t) array->elem_count;
+  header[2] = (uint64_t) changed->elem_count;
+  vecs = sc_array_new (sizeof (sc_io_vec_t));
+  vec = (sc_io_vec_t *) sc_array_push (vecs);
+  vec->data = header;
+  vec->bytes = sizeof (header);
+  vec = (sc_io_vec_t *) sc_array_push (vecs);
+  sc_io_vec_array (vec, changed);
+  for (ib = 0; ib < changed->elem_count; ++ib) {
+    offset = (size_t) *(uint64_t *) sc_array_index (changed, ib) *
+      ckpt->block_size;
+    vec = (sc_io_vec_t *) sc_array_index (vecs, vecs->elem_count - 1);
+    if (ib > 0 && (char *) vec->data + vec->bytes == array->array + offset) {
+      /* merge consecutive blocks */
+      vec->bytes += SC_MIN (ckpt->block_size, bytes - offset);
+    }
+    else {
+      vec = (sc_io_vec_t *) sc_array_push (vecs);
+      vec->data = array->array + offset;
+      vec->bytes = SC_MIN (ckpt->block_size, bytes - offset);
+    }
+  }
+  retval = sc_io_sink_writev (sink, (sc_io_vec_t *) vecs->array,
+                              (int) vecs->elem_count);
+  *blocks += changed->elem_count;
+
+  /* the new checksums describe this checkpoint */
+  sc_array_destroy (field->sums);
+  field->sums = sums;
+  field->bytes = bytes;
+  field->valid = 1;
+
+  sc_array_destroy (vecs);
+  sc_array_destroy (changed);
+  return retval;
+}
+
+int
+sc_checkpoint_write (sc_checkpoint_t * ckpt, sc_io_sink_t * sink, int full,
+                     size_t * blocks)
+{
+  int                 retval;
+  size_t              iz, num_blocks;
+  uint64_t            header[SC_CHECKPOINT_HEADER];
+  sc_checkpoint_field_t *field;
+
+  SC_ASSERT (ckpt != NULL);
+  SC_ASSERT (sink != NULL);
+
+  full = full || !ckpt->valid;
+  if (full) {
+    for (iz = 0; iz < ckpt->fields->elem_count; ++iz) {
+      field = (sc_checkpoint_field_t *) sc_array_index (ckpt->fields, iz);
+      field->valid = 0;
+    }
+  }
+
+  header[0] = SC_CHECKPOINT_MAGIC;
+  header[1] = ++ckpt->sequence;
+  header[2] = (uint64_t) full;
+  header[3] = (uint64_t) ckpt->fields->elem_count;
+  header[4] = (uint64_t) ckpt->block_size;
+  retval = sc_io_sink_write (sink, header, sizeof (header));
+
+  num_blocks = 0;
+  for (iz = 0; !retval && iz < ckpt->fields->elem_count; ++iz) {
+    field = (sc_checkpoint_field_t *) sc_array_index (ckpt->fields, iz);
+    retval = sc_checkpoint_write_field (ckpt, field, sink, full,
+                                        &num_blocks);
+  }
+  ckpt->valid = !retval;
+  if (blocks != NULL) {
+    *blocks = num_blocks;
+  }
+
+  return retval;
+}
+
+/** Read the blocks of one array and apply them. */
+static int
+sc_checkpoint_read_field (sc_checkpoint_t * ckpt,
+                          sc_checkpoint_field_t * field,
+                          sc_io_source_t * source, int full)
+{
+  int                 retval;
+  size_t              ib, nblocks, bytes, offset;
+  uint64_t            header[SC_CHECKPOINT_FIELD];
+  sc_array_t         *changed, *vecs;
+  sc_array_t         *array = field->array;
+  sc_io_vec_t        *vec;
+
+  retval = sc_io_source_read (source, header, sizeof (header), NULL);
+  if (retval) {
+    return retval;
+  }
+  if (header[0] != (uint64_t) array->elem_size ||
+      header[1] > (uint64_t) (SIZE_MAX / array->elem_size)) {
+    return SC_IO_ERROR_FATAL;
+  }
+  bytes = (size_t) header[1] * array->elem_size;
+  nblocks = bytes / ckpt->block_size + (bytes % ckpt->block_size != 0);
+  if (header[2] > (uint64_t) nblocks ||
+      ((full || bytes != field->bytes) && header[2] != (uint64_t) nblocks)) {
+    /* a full or resized array must contain all blocks */
+    return SC_IO_ERROR_FATAL;
+  }
+
+  /* the array is resized once its block list has been read */
+  changed = sc_array_new_count (sizeof (uint64_t), (size_t) header[2]);
+  retval = sc_io_source_read_arrays (source, &changed, 1);
+  if (!retval) {
+    sc_array_resize (array, (size_t) header[1]);
+  }
+  vecs = sc_array_new (sizeof (sc_io_vec_t));
+  for (ib = 0; !retval && ib < changed->elem_count; ++ib) {
+    offset = (size_t) *(uint64_t *) sc_array_index (changed, ib);
+    if (offset >= nblocks) {
+      retval = SC_IO_ERROR_FATAL;
+      break;
+    }
+    offset *= ckpt->block_size;
+    vec = vecs->elem_count == 0 ? NULL :
+      (sc_io_vec_t *) sc_array_index (vecs, vecs->elem_count - 1);
+    if (vec != NULL && (char *) vec->data + vec->bytes ==
+        array->array + offset) {
+      vec->bytes += SC_MIN (ckpt->block_size, bytes - offset);
+    }
+    else {
+      vec = (sc_io_vec_t *) sc_array_push (vecs);
+      vec->data = array->array + offset;
+      vec->bytes = SC_MIN (ckpt->block_size, bytes - offset);
+    }
+  }
+  if (!retval) {
+    retval = sc_io_source_readv (source, (sc_io_vec_t *) vecs->array,
+                                 (int) vecs->elem_count, NULL);
+  }
+  if (!retval) {
+    /* continue writing deltas against the state read */
+    sc_checkpoint_sum (ckpt, array, field->sums);
+    field->bytes = bytes;
+    field->valid = 1;
+  }
+
+  sc_array_destroy (vecs);
+  sc_array_destroy (changed);
+  return retval;
+}
+
+int
+sc_checkpoint_read (sc_checkpoint_t * ckpt, sc_io_source_t * source,
+                    int *num_read)
+{
+  int                 retval, full, count;
+  size_t              iz, bytes_out;
+  uint64_t            header[SC_CHECKPOINT_HEADER];
+  sc_checkpoint_field_t *field;
+
+  SC_ASSERT (ckpt != NULL);
+  SC_ASSERT (source != NULL);
+
+  retval = SC_IO_ERROR_NONE;
+  for (count = 0;; ++count) {
+    /* the source ends cleanly before a checkpoint */
+    retval = sc_io_source_read (source, header, sizeof (header), &bytes_out);
+    if (retval || bytes_out == 0) {
+      break;
+    }
+    full = header[2] != 0;
+    if (bytes_out != sizeof (header) || header[0] != SC_CHECKPOINT_MAGIC ||
+        header[3] != (uint64_t) ckpt->fields->elem_count ||
+        header[4] != (uint64_t) ckpt->block_size ||
+        (!full && (!ckpt->valid || header[1] != ckpt->sequence + 1))) {
+      retval = SC_IO_ERROR_FATAL;
+      break;
+    }
+    ckpt->valid = 0;
+    for (iz = 0; !retval && iz < ckpt->fields->elem_count; ++iz) {
+      field = (sc_checkpoint_field_t *) sc_array_index (ckpt->fields, iz);
+      retval = sc_checkpoint_read_field (ckpt, field, source, full);
+    }
+    if (retval) {
+      break;
+    }
+    ckpt->sequence = header[1];
+    ckpt->valid = 1;
+  }
+  if (num_read != NULL) {
+    *num_read = count;
+  }
+
+  return retval;
+}
@@ -0,0 +1,106 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef SC_CHECKPOINT_H
+#define SC_CHECKPOINT_H
+
+/** \file sc_checkpoint.h
+ * This file provides incremental checkpoints of a set of arrays.
+ *
+ * The arrays are registered once.  Each is cut into blocks of a fixed
+ * byte size, and we remember a checksum of every block.  A checkpoint
+ * writes only the blocks whose checksum changed since the previous one,
+ * together with their indices.  An array whose size changed is written
+ * completely.  The first checkpoint, and any requested explicitly, is a
+ * full one that contains all blocks.
+ *
+ * The checkpoints are written to an \ref sc_io_sink_t one after the
+ * other, for example by appending to one file, or into a base file and
+ * one or more delta files.  Reading applies the checkpoints of a source
+ * in order, which reconstructs the latest state from the full one and the
+ * deltas.  After reading, further checkpoints may be written as deltas.
+ *
+ * With zlib, the checksum of a block combines its CRC-32 and Adler-32
+ * values; otherwise a 64 bit FNV-1a hash is used.
+ */
+
+#include <sc_io.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** The set of arrays to checkpoint; opaque structure. */
+typedef struct sc_checkpoint sc_checkpoint_t;
+
+/** Create a checkpoint writer and reader without arrays.
+ * \param [in] block_size   Size of the blocks in bytes, or 0 for 64 KiB.
+ *                          Writer and reader must use the same size.
+ * \return                  A valid object.
+ */
+sc_checkpoint_t    *sc_checkpoint_new (size_t block_size);
+
+/** Destroy a checkpoint object.  The arrays are not touched.
+ * \param [in,out] ckpt     This object is invalidated.
+ */
+void                sc_checkpoint_destroy (sc_checkpoint_t * ckpt);
+
+/** Register an array.
+ * Arrays are identified by the order of registration, which must be the
+ * same for writing and reading.  They are borrowed by the object.
+ * \param [in,out] ckpt     Valid object.
+ * \param [in] array        Array that stays valid while \b ckpt is used.
+ *                          When reading, it is resized to the size
+ *                          stored in the checkpoint.
+ * \return                  Index of the array.
+ */
+int                 sc_checkpoint_add (sc_checkpoint_t * ckpt,
+                                       sc_array_t * array);
+
+/** Write a checkpoint of the registered arrays.
+ * \param [in,out] ckpt     Valid object.
+ * \param [in,out] sink     Sink to write to.
+ * \param [in] full         If true, write all blocks.  Otherwise only the
+ *                          blocks changed since the last checkpoint
+ *                          written or read.
+ * \param [out] blocks      If not NULL, the number of blocks written.
+ * \return                  0 on success, nonzero on error.
+ */
+int                 sc_checkpoint_write (sc_checkpoint_t * ckpt,
+                                         sc_io_sink_t * sink, int full,
+                                         size_t * blocks);
+
+/** Apply all checkpoints from a source to the registered arrays.
+ * The source is read until it has no more data.  It must start with a
+ * full checkpoint, or continue the last one read or written by \b ckpt.
+ * \param [in,out] ckpt     Valid object.
+ * \param [in,out] source   Source to read from.
+ * \param [out] num_read    If not NULL, the number of checkpoints read.
+ * \return                  0 on success, nonzero on error.  After an
+ *                          error, the arrays are in an undefined state.
+ */
+int                 sc_checkpoint_read (sc_checkpoint_t * ckpt,
+                                        sc_io_source_t * source,
+                                        int *num_read);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_CHECKPOINT_H */
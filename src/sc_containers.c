@@ -22,6 +22,9 @@
 */
 
 #include <sc_containers.h>
+#include <sc_private.h>
+#include <sc_search.h>
+#include <sc_sort.h>
 #ifdef SC_HAVE_ZLIB
 #include <zlib.h>
 #endif
@@ -330,9 +333,21 @@ sc_array_sort (sc_array_t * array, int (*compar) (const void *, const void *))
   qsort (array->array, array->elem_count, array->elem_size, compar);
 }
 
+void
+sc_array_sort_r (sc_array_t * array, sc_compare_r_t compar, void *arg)
+{
+  sc_qsort_r (array->array, array->elem_count, array->elem_size, compar, arg);
+}
+
 int
 sc_array_is_sorted (sc_array_t * array,
                     int (*compar) (const void *, const void *))
+{
+  return sc_array_is_sorted_r (array, sc_compare_plain, &compar);
+}
+
+int
+sc_array_is_sorted_r (sc_array_t * array, sc_compare_r_t compar, void *arg)
 {
   const size_t        count = array->elem_count;
   size_t              zz;
@@ -345,7 +360,7 @@ sc_array_is_sorted (sc_array_t * array,
   vold = sc_array_index (array, 0);
   for (zz = 1; zz < count; ++zz) {
     vnew = sc_array_index (array, zz);
-    if (compar (vold, vnew) > 0) {
+    if (compar (vold, vnew, arg) > 0) {
       return 0;
     }
     vold = vnew;
@@ -367,6 +382,12 @@ sc_array_is_equal (sc_array_t * array, sc_array_t * other)
 
 void
 sc_array_uniq (sc_array_t * array, int (*compar) (const void *, const void *))
+{
+  sc_array_uniq_r (array, sc_compare_plain, &compar);
+}
+
+void
+sc_array_uniq_r (sc_array_t * array, sc_compare_r_t compar, void *arg)
 {
   size_t              incount, dupcount;
   size_t              i, j;
@@ -385,7 +406,7 @@ sc_array_uniq (sc_array_t * array, int (*compar) (const void *, const void *))
   elem1 = sc_array_index (array, 0);
   while (i < incount) {
     elem2 = ((i < incount - 1) ? sc_array_index (array, i + 1) : NULL);
-    if (i < incount - 1 && compar (elem1, elem2) == 0) {
+    if (i < incount - 1 && compar (elem1, elem2, arg) == 0) {
       ++dupcount;
       ++i;
     }
@@ -422,6 +443,24 @@ sc_array_bsearch (sc_array_t * array, const void *key,
   return is;
 }
 
+ssize_t
+sc_array_bsearch_r (sc_array_t * array, const void *key,
+                    sc_compare_r_t compar, void *arg)
+{
+  ssize_t             is = -1;
+  char               *retval;
+
+  retval = (char *) sc_bsearch_r (key, array->array, array->elem_count,
+                                  array->elem_size, compar, arg);
+
+  if (retval != NULL) {
+    is = (ssize_t) ((retval - array->array) / array->elem_size);
+    SC_ASSERT (is >= 0 && is < (ssize_t) array->elem_count);
+  }
+
+  return is;
+}
+
 void
 sc_array_split (sc_array_t * array, sc_array_t * offsets, size_t num_types,
                 sc_array_type_t type_fn, void *data)
@@ -639,9 +678,282 @@ sc_array_checksum (sc_array_t * array)
 #endif
 }
 
+void
+sc_array_scan_sum_int (void *accum, const void *elem, void *data)
+{
+  *(int *) accum += *(const int *) elem;
+}
+
+void
+sc_array_scan_sum_long (void *accum, const void *elem, void *data)
+{
+  *(long *) accum += *(const long *) elem;
+}
+
+void
+sc_array_scan_sum_size_t (void *accum, const void *elem, void *data)
+{
+  *(size_t *) accum += *(const size_t *) elem;
+}
+
+/** Arrays are split into blocks of at least this many elements. */
+#define SC_ARRAY_BLOCK_MIN 8192
+
+/** State shared by the blocks of sc_array_scan and sc_array_compact. */
+typedef struct sc_array_blocks
+{
+  sc_taskpool_t      *pool;
+  sc_array_t         *array;
+  size_t              num_blocks;
+  size_t              elem_size;
+  int                 exclusive;
+  sc_array_scan_op_t  op;
+  sc_array_predicate_t pred;
+  void               *data;
+  char               *partial;  /**< scan: one element per block */
+  char               *scratch;  /**< scan: one element per block */
+  sc_array_t         *dest;
+  size_t             *offsets;  /**< compact: one count per block */
+  sc_hash_t          *hash;
+  sc_hash_visit_t     visit;
+  void              **objects;  /**< hash: objects to insert */
+  size_t             *slot;     /**< hash: hash value of each object */
+  size_t             *perm;     /**< hash: objects ordered by partition */
+  size_t             *bounds;   /**< hash: partition offsets into perm */
+  size_t              part_size;        /**< hash: slots per partition */
+  size_t             *heads;    /**< hash: last new object of each slot */
+  size_t             *next;     /**< hash: previous new object in a slot */
+  size_t             *first;    /**< hash: first equal object in input */
+}
+sc_array_blocks_t;
+
+static void
+sc_array_blocks_init (sc_array_blocks_t * ab, sc_array_t * array)
+{
+  int                 num_threads;
+
+  memset (ab, 0, sizeof (*ab));
+  ab->pool = sc_taskpool_global_lookup ();
+  ab->array = array;
+  ab->elem_size = array->elem_size;
+
+  /* a few blocks per thread balance the load if some run late */
+  num_threads = ab->pool == NULL ? 0 : sc_taskpool_num_threads (ab->pool);
+  ab->num_blocks = 1;
+  if (num_threads > 0 && array->elem_count >= 2 * SC_ARRAY_BLOCK_MIN) {
+    ab->num_blocks = SC_MIN ((size_t) 4 * (num_threads + 1),
+                             array->elem_count / SC_ARRAY_BLOCK_MIN);
+  }
+}
+
+static void
+sc_array_blocks_range (sc_array_blocks_t * ab, size_t b,
+                       size_t * begin, size_t * end)
+{
+  const size_t        q = ab->array->elem_count / ab->num_blocks;
+  const size_t        r = ab->array->elem_count % ab->num_blocks;
+
+  *begin = q * b + SC_MIN (b, r);
+  *end = q * (b + 1) + SC_MIN (b + 1, r);
+}
+
+static void
+sc_array_blocks_run (sc_array_blocks_t * ab, sc_range_function_t fn)
+{
+  if (ab->num_blocks == 1) {
+    fn (0, 1, ab);
+  }
+  else {
+    sc_taskpool_parallel_for (ab->pool, 0, ab->num_blocks, 1, fn, ab);
+  }
+}
+
+static void
+sc_array_scan_reduce (size_t bbegin, size_t bend, void *user)
+{
+  sc_array_blocks_t  *ab = (sc_array_blocks_t *) user;
+  const size_t        es = ab->elem_size;
+  size_t              b, zz, begin, end;
+  char               *p;
+
+  for (b = bbegin; b < bend; ++b) {
+    sc_array_blocks_range (ab, b, &begin, &end);
+    p = ab->array->array + begin * es;
+    for (zz = begin; zz < end; ++zz, p += es) {
+      ab->op (ab->partial + b * es, p, ab->data);
+    }
+  }
+}
+
+static void
+sc_array_scan_block (size_t bbegin, size_t bend, void *user)
+{
+  sc_array_blocks_t  *ab = (sc_array_blocks_t *) user;
+  const size_t        es = ab->elem_size;
+  size_t              b, zz, begin, end;
+  char               *p, *accum, *temp;
+
+  for (b = bbegin; b < bend; ++b) {
+    sc_array_blocks_range (ab, b, &begin, &end);
+    p = ab->array->array + begin * es;
+    accum = ab->partial + b * es;
+    temp = ab->scratch + b * es;
+    if (ab->exclusive) {
+      for (zz = begin; zz < end; ++zz, p += es) {
+        memcpy (temp, p, es);
+        memcpy (p, accum, es);
+        ab->op (accum, temp, ab->data);
+      }
+    }
+    else {
+      for (zz = begin; zz < end; ++zz, p += es) {
+        ab->op (accum, p, ab->data);
+        memcpy (p, accum, es);
+      }
+    }
+  }
+}
+
+void
+sc_array_scan (sc_array_t * array, int exclusive, const void *identity,
+               sc_array_scan_op_t op, void *data, void *total)
+{
+  size_t              es, b;
+  char               *running;
+  sc_array_blocks_t   sab, *ab = &sab;
+
+  SC_ASSERT (op != NULL);
+
+  sc_array_blocks_init (ab, array);
+  ab->exclusive = exclusive;
+  ab->op = op;
+  ab->data = data;
+
+  es = ab->elem_size;
+  ab->partial = SC_ALLOC (char, (2 * ab->num_blocks + 1) * es);
+  ab->scratch = ab->partial + ab->num_blocks * es;
+  running = ab->scratch + ab->num_blocks * es;
+  if (identity == NULL) {
+    memset (running, 0, es);
+  }
+  else {
+    memcpy (running, identity, es);
+  }
+  for (b = 0; b < ab->num_blocks; ++b) {
+    memcpy (ab->partial + b * es, running, es);
+  }
+  if (ab->num_blocks > 1) {
+    /* reduce each block and replace the result by the block's offset */
+    sc_array_blocks_run (ab, sc_array_scan_reduce);
+    for (b = 0; b < ab->num_blocks; ++b) {
+      memcpy (ab->scratch, ab->partial + b * es, es);
+      memcpy (ab->partial + b * es, running, es);
+      op (running, ab->scratch, data);
+    }
+  }
+
+  /* afterwards each block's accumulator holds the sum up to its end */
+  sc_array_blocks_run (ab, sc_array_scan_block);
+  if (total != NULL) {
+    memcpy (total, ab->partial + (ab->num_blocks - 1) * es, es);
+  }
+  SC_FREE (ab->partial);
+}
+
+static void
+sc_array_compact_count (size_t bbegin, size_t bend, void *user)
+{
+  sc_array_blocks_t  *ab = (sc_array_blocks_t *) user;
+  size_t              b, zz, begin, end, count;
+
+  for (b = bbegin; b < bend; ++b) {
+    sc_array_blocks_range (ab, b, &begin, &end);
+    count = 0;
+    for (zz = begin; zz < end; ++zz) {
+      if (ab->pred (ab->array, zz, ab->data)) {
+        ++count;
+      }
+    }
+    ab->offsets[b] = count;
+  }
+}
+
+static void
+sc_array_compact_copy (size_t bbegin, size_t bend, void *user)
+{
+  sc_array_blocks_t  *ab = (sc_array_blocks_t *) user;
+  const size_t        es = ab->elem_size;
+  size_t              b, zz, begin, end, run, out;
+
+  for (b = bbegin; b < bend; ++b) {
+    sc_array_blocks_range (ab, b, &begin, &end);
+    out = ab->offsets[b];
+
+    /* copy contiguous runs of selected entries at once */
+    run = begin;
+    for (zz = begin; zz <= end; ++zz) {
+      if (zz == end || !ab->pred (ab->array, zz, ab->data)) {
+        if (zz > run) {
+          memcpy (ab->dest->array + out * es, ab->array->array + run * es,
+                  (zz - run) * es);
+          out += zz - run;
+        }
+        run = zz + 1;
+      }
+    }
+    ab->offsets[b] = out;
+  }
+}
+
+void
+sc_array_compact (sc_array_t * dest, sc_array_t * src,
+                  sc_array_predicate_t pred, void *data)
+{
+  size_t              b, count, offset;
+  sc_array_blocks_t   sab, *ab = &sab;
+
+  SC_ASSERT (dest != src);
+  SC_ASSERT (dest->elem_size == src->elem_size);
+  SC_ASSERT (pred != NULL);
+
+  sc_array_blocks_init (ab, src);
+  ab->pred = pred;
+  ab->data = data;
+  ab->dest = dest;
+  ab->offsets = SC_ALLOC (size_t, ab->num_blocks);
+
+  if (ab->num_blocks == 1) {
+    /* a single pass suffices when the output is written in order */
+    sc_array_resize (dest, src->elem_count);
+    ab->offsets[0] = 0;
+    sc_array_compact_copy (0, 1, ab);
+    sc_array_resize (dest, ab->offsets[0]);
+  }
+  else {
+    sc_array_blocks_run (ab, sc_array_compact_count);
+    offset = 0;
+    for (b = 0; b < ab->num_blocks; ++b) {
+      count = ab->offsets[b];
+      ab->offsets[b] = offset;
+      offset += count;
+    }
+    sc_array_resize (dest, offset);
+    sc_array_blocks_run (ab, sc_array_compact_copy);
+    SC_ASSERT (ab->offsets[ab->num_blocks - 1] == offset);
+  }
+  SC_FREE (ab->offsets);
+}
+
 size_t
 sc_array_pqueue_add (sc_array_t * array, void *temp,
                      int (*compar) (const void *, const void *))
+{
+  return sc_array_pqueue_add_r (array, temp, sc_compare_plain, &compar);
+}
+
+size_t
+sc_array_pqueue_add_r (sc_array_t * array, void *temp,
+                       sc_compare_r_t compar, void *arg)
 {
   int                 comp;
   size_t              parent, child, swaps;
@@ -663,7 +975,7 @@ sc_array_pqueue_add (sc_array_t * array, void *temp,
     p = array->array + (size * parent);
 
     /* compare child to parent */
-    comp = compar (p, c);
+    comp = compar (p, c, arg);
     if (comp <= 0) {
       break;
     }
@@ -685,6 +997,13 @@ sc_array_pqueue_add (sc_array_t * array, void *temp,
 size_t
 sc_array_pqueue_pop (sc_array_t * array, void *result,
                      int (*compar) (const void *, const void *))
+{
+  return sc_array_pqueue_pop_r (array, result, sc_compare_plain, &compar);
+}
+
+size_t
+sc_array_pqueue_pop_r (sc_array_t * array, void *result,
+                       sc_compare_r_t compar, void *arg)
 {
   int                 comp;
   size_t              new_count, swaps;
@@ -721,7 +1040,7 @@ sc_array_pqueue_pop (sc_array_t * array, void *result,
     /* check if child has a sibling and use that one if it is smaller */
     if ((child1 = 2 * parent + 2) < new_count) {
       c1 = array->array + (size * child1);
-      comp = compar (c, c1);
+      comp = compar (c, c1, arg);
       if (comp > 0) {
         child = child1;
         c = c1;
@@ -729,7 +1048,7 @@ sc_array_pqueue_pop (sc_array_t * array, void *result,
     }
 
     /* sift down the parent if it is larger */
-    comp = compar (p, c);
+    comp = compar (p, c, arg);
     if (comp <= 0) {
       break;
     }
@@ -1510,6 +1829,227 @@ sc_hash_foreach (sc_hash_t * hash, sc_hash_foreach_t fn)
   }
 }
 
+static void
+sc_hash_visit_blocks (size_t bbegin, size_t bend, void *user)
+{
+  sc_array_blocks_t  *ab = (sc_array_blocks_t *) user;
+  size_t              b, slot, begin, end;
+  void               *accum;
+  sc_list_t          *list;
+  sc_link_t          *lynk;
+
+  for (b = bbegin; b < bend; ++b) {
+    sc_array_blocks_range (ab, b, &begin, &end);
+    accum = ab->partial == NULL ? NULL : ab->partial + b * ab->elem_size;
+    for (slot = begin; slot < end; ++slot) {
+      list = (sc_list_t *) sc_array_index (ab->array, slot);
+      for (lynk = list->first; lynk != NULL; lynk = lynk->next) {
+        ab->visit (&lynk->data, ab->hash->user_data, accum, ab->data);
+      }
+    }
+  }
+}
+
+void
+sc_hash_foreach_parallel (sc_hash_t * hash, sc_hash_visit_t fn, void *data,
+                          size_t accum_size, const void *identity,
+                          sc_array_scan_op_t combine, void *result)
+{
+  size_t              b;
+  sc_array_blocks_t   sab, *ab = &sab;
+
+  SC_ASSERT (fn != NULL);
+
+  sc_array_blocks_init (ab, hash->slots);
+  ab->hash = hash;
+  ab->visit = fn;
+  ab->data = data;
+  ab->elem_size = accum_size;
+  if (accum_size > 0) {
+    SC_ASSERT (combine != NULL && result != NULL);
+    ab->partial = SC_ALLOC (char, (ab->num_blocks + 1) * accum_size);
+    for (b = 0; b <= ab->num_blocks; ++b) {
+      if (identity == NULL) {
+        memset (ab->partial + b * accum_size, 0, accum_size);
+      }
+      else {
+        memcpy (ab->partial + b * accum_size, identity, accum_size);
+      }
+    }
+  }
+
+  sc_array_blocks_run (ab, sc_hash_visit_blocks);
+
+  if (accum_size > 0) {
+    /* combine in block order so the operator need not be commutative */
+    memcpy (result, ab->partial + ab->num_blocks * accum_size, accum_size);
+    for (b = 0; b < ab->num_blocks; ++b) {
+      combine (result, ab->partial + b * accum_size, data);
+    }
+    SC_FREE (ab->partial);
+  }
+}
+
+static void
+sc_hash_bulk_count (size_t bbegin, size_t bend, void *user)
+{
+  sc_array_blocks_t  *ab = (sc_array_blocks_t *) user;
+  const size_t        nb = ab->num_blocks;
+  const size_t        num_slots = ab->array->elem_count;
+  size_t              b, zz, begin, end, *counts;
+
+  for (b = bbegin; b < bend; ++b) {
+    sc_array_blocks_range (ab, b, &begin, &end);
+    counts = ab->offsets + b * nb;
+    memset (counts, 0, nb * sizeof (size_t));
+    for (zz = begin; zz < end; ++zz) {
+      ab->slot[zz] = (size_t) ab->hash->hash_fn (ab->objects[zz],
+                                                 ab->hash->user_data);
+      ++counts[(ab->slot[zz] % num_slots) / ab->part_size];
+    }
+  }
+}
+
+static void
+sc_hash_bulk_scatter (size_t bbegin, size_t bend, void *user)
+{
+  sc_array_blocks_t  *ab = (sc_array_blocks_t *) user;
+  const size_t        num_slots = ab->array->elem_count;
+  size_t              b, zz, begin, end, *offsets;
+
+  for (b = bbegin; b < bend; ++b) {
+    sc_array_blocks_range (ab, b, &begin, &end);
+    offsets = ab->offsets + b * ab->num_blocks;
+    for (zz = begin; zz < end; ++zz) {
+      ab->perm[offsets[(ab->slot[zz] % num_slots) / ab->part_size]++] = zz;
+    }
+  }
+}
+
+static void
+sc_hash_bulk_unique (size_t pbegin, size_t pend, void *user)
+{
+  sc_array_blocks_t  *ab = (sc_array_blocks_t *) user;
+  sc_hash_t          *hash = ab->hash;
+  const size_t        num_slots = ab->array->elem_count;
+  size_t              p, k, i, sl, zz;
+
+  for (p = pbegin; p < pend; ++p) {
+    for (sl = p * ab->part_size;
+         sl < SC_MIN ((p + 1) * ab->part_size, num_slots); ++sl) {
+      ab->heads[sl] = num_slots;
+    }
+
+    /* the objects of a partition are ordered as in the input */
+    for (k = ab->bounds[p]; k < ab->bounds[p + 1]; ++k) {
+      zz = ab->perm[k];
+      sl = ab->slot[zz] % num_slots;
+      for (i = ab->heads[sl]; i != num_slots; i = ab->next[i]) {
+        if (hash->equal_fn (ab->objects[i], ab->objects[zz],
+                            hash->user_data)) {
+          break;
+        }
+      }
+      if (i == num_slots) {
+        ab->next[zz] = ab->heads[sl];
+        ab->heads[sl] = i = zz;
+      }
+      ab->first[zz] = i;
+    }
+  }
+}
+
+size_t
+sc_hash_insert_bulk (sc_hash_t * hash, sc_array_t * objects,
+                     sc_array_t * contained)
+{
+  size_t              nb, n, zz, b, p, offset, count;
+  void              **found;
+  sc_list_t          *list;
+  sc_array_blocks_t   sab, *ab = &sab;
+
+  SC_ASSERT (objects->elem_size == sizeof (void *));
+  SC_ASSERT (contained == NULL || contained != objects);
+
+  if (contained != NULL) {
+    SC_ASSERT (contained->elem_size == sizeof (void *));
+    sc_array_resize (contained, objects->elem_count);
+  }
+
+  sc_array_blocks_init (ab, objects);
+  nb = ab->num_blocks;
+  if (hash->elem_count > 0 || nb == 1) {
+    /* insert one by one */
+    count = 0;
+    for (zz = 0; zz < objects->elem_count; ++zz) {
+      count += sc_hash_insert_unique
+        (hash, *(void **) sc_array_index (objects, zz), &found);
+      if (contained != NULL) {
+        *(void **) sc_array_index (contained, zz) = *found;
+      }
+    }
+    return count;
+  }
+
+  /* find the first of equal objects in a scratch table with one slot per
+     object, partitioned by contiguous ranges of slots, one per block */
+  n = objects->elem_count;
+  ab->hash = hash;
+  ab->objects = (void **) objects->array;
+  ab->part_size = (n + nb - 1) / nb;
+  ab->slot = SC_ALLOC (size_t, n);
+  ab->perm = SC_ALLOC (size_t, n);
+  ab->offsets = SC_ALLOC (size_t, nb * nb);
+  ab->bounds = SC_ALLOC (size_t, nb + 1);
+  ab->heads = SC_ALLOC (size_t, n);
+  ab->next = SC_ALLOC (size_t, n);
+  ab->first = SC_ALLOC (size_t, n);
+  sc_array_blocks_run (ab, sc_hash_bulk_count);
+
+  /* the objects of partition p from input block b start at offsets[b][p] */
+  offset = 0;
+  for (p = 0; p < nb; ++p) {
+    ab->bounds[p] = offset;
+    for (b = 0; b < nb; ++b) {
+      count = ab->offsets[b * nb + p];
+      ab->offsets[b * nb + p] = offset;
+      offset += count;
+    }
+  }
+  ab->bounds[nb] = offset;
+  SC_ASSERT (offset == n);
+  sc_array_blocks_run (ab, sc_hash_bulk_scatter);
+  sc_array_blocks_run (ab, sc_hash_bulk_unique);
+
+  /* link the new objects in order as sc_hash_insert_unique does, such that
+     the table grows by the same resize steps and ends up identical */
+  count = 0;
+  for (zz = 0; zz < n; ++zz) {
+    if (ab->first[zz] == zz) {
+      list = (sc_list_t *) sc_array_index
+        (hash->slots, ab->slot[zz] % hash->slots->elem_count);
+      (void) sc_list_append (list, ab->objects[zz]);
+      ++count;
+      if (++hash->elem_count % hash->slots->elem_count == 0) {
+        sc_hash_maybe_resize (hash);
+      }
+    }
+    if (contained != NULL) {
+      *(void **) sc_array_index (contained, zz) = ab->objects[ab->first[zz]];
+    }
+  }
+
+  SC_FREE (ab->first);
+  SC_FREE (ab->next);
+  SC_FREE (ab->heads);
+  SC_FREE (ab->bounds);
+  SC_FREE (ab->offsets);
+  SC_FREE (ab->perm);
+  SC_FREE (ab->slot);
+
+  return count;
+}
+
 void
 sc_hash_print_statistics (int package_id, int log_priority, sc_hash_t * hash)
 {
@@ -1609,6 +2149,57 @@ sc_hash_array_destroy (sc_hash_array_t * hash_array)
   SC_FREE (hash_array);
 }
 
+static void
+sc_hash_array_renumber (void **v, const void *u, void *accum, void *data)
+{
+  *v = (void *) ((size_t *) data)[(size_t) * v];
+}
+
+sc_hash_array_t    *
+sc_hash_array_new_bulk (sc_array_t * src, sc_hash_function_t hash_fn,
+                        sc_equal_function_t equal_fn, void *user_data)
+{
+  size_t              zz, count, added;
+  size_t             *position;
+  sc_array_t          indices, contained;
+  sc_hash_array_t    *hash_array;
+
+  hash_array = sc_hash_array_new (src->elem_size, hash_fn, equal_fn,
+                                  user_data);
+  sc_array_copy (&hash_array->a, src);
+
+  /* the hash table stores array positions */
+  sc_array_init_count (&indices, sizeof (void *), src->elem_count);
+  for (zz = 0; zz < src->elem_count; ++zz) {
+    *(void **) sc_array_index (&indices, zz) = (void *) zz;
+  }
+  sc_array_init (&contained, sizeof (void *));
+  added = sc_hash_insert_bulk (hash_array->h, &indices, &contained);
+
+  if (added < src->elem_count) {
+    /* remove the duplicates from the array and renumber the positions */
+    position = (size_t *) indices.array;
+    count = 0;
+    for (zz = 0; zz < src->elem_count; ++zz) {
+      if ((size_t) * (void **) sc_array_index (&contained, zz) == zz) {
+        if (count < zz) {
+          memcpy (sc_array_index (&hash_array->a, count),
+                  sc_array_index (&hash_array->a, zz), src->elem_size);
+        }
+        position[zz] = count++;
+      }
+    }
+    SC_ASSERT (count == added);
+    sc_array_resize (&hash_array->a, count);
+    sc_hash_foreach_parallel (hash_array->h, sc_hash_array_renumber,
+                              position, 0, NULL, NULL, NULL);
+  }
+  sc_array_reset (&indices);
+  sc_array_reset (&contained);
+
+  return hash_array;
+}
+
 int
 sc_hash_array_is_valid (sc_hash_array_t * hash_array)
 {
@@ -1684,6 +2275,47 @@ sc_hash_array_insert_unique (sc_hash_array_t * hash_array, void *v,
   }
 }
 
+int
+sc_hash_array_remove (sc_hash_array_t * hash_array, void *v,
+                      size_t * position)
+{
+  int                 found;
+  size_t              pos, last;
+  void               *found_data;
+  void              **found_void;
+
+  SC_ASSERT (hash_array->a.elem_count == hash_array->h->elem_count);
+
+  hash_array->internal_data.current_item = v;
+  found = sc_hash_remove (hash_array->h, (void *) (-1L), &found_data);
+  hash_array->internal_data.current_item = NULL;
+
+  if (!found) {
+    return 0;
+  }
+  pos = (size_t) found_data;
+  last = hash_array->a.elem_count - 1;
+  SC_ASSERT (pos <= last);
+  if (pos < last) {
+    /* move the last element into the gap and update its hash entry */
+    hash_array->internal_data.current_item =
+      sc_array_index (&hash_array->a, last);
+    SC_EXECUTE_ASSERT_TRUE (sc_hash_lookup (hash_array->h, (void *) (-1L),
+                                            &found_void));
+    hash_array->internal_data.current_item = NULL;
+    SC_ASSERT ((size_t) (*found_void) == last);
+    *found_void = (void *) pos;
+    memcpy (sc_array_index (&hash_array->a, pos),
+            sc_array_index (&hash_array->a, last), hash_array->a.elem_size);
+  }
+  sc_array_resize (&hash_array->a, last);
+
+  if (position != NULL) {
+    *position = pos;
+  }
+  return 1;
+}
+
 void
 sc_hash_array_rip (sc_hash_array_t * hash_array, sc_array_t * rip)
 {
@@ -323,6 +323,15 @@ void                sc_array_sort (sc_array_t * array,
                                    int (*compar) (const void *,
                                                   const void *));
 
+/** Sorts the array in ascending order wrt. a comparison with context.
+ * This function uses \ref sc_qsort_r and is safe to call concurrently.
+ * \param [in,out] array  Array to sort.
+ * \param [in] compar     The comparison function to be used.
+ * \param [in] arg        Passed to \a compar.
+ */
+void                sc_array_sort_r (sc_array_t * array,
+                                     sc_compare_r_t compar, void *arg);
+
 /** Check whether the array is sorted wrt. the comparison function.
  * \param [in] array    The array to check.
  * \param [in] compar   The comparison function to be used.
@@ -332,6 +341,15 @@ int                 sc_array_is_sorted (sc_array_t * array,
                                         int (*compar) (const void *,
                                                        const void *));
 
+/** Check whether the array is sorted wrt. a comparison with context.
+ * \param [in] array    The array to check.
+ * \param [in] compar   The comparison function to be used.
+ * \param [in] arg      Passed to \a compar.
+ * \return              True if array is sorted, false otherwise.
+ */
+int                 sc_array_is_sorted_r (sc_array_t * array,
+                                          sc_compare_r_t compar, void *arg);
+
 /** Check whether two arrays have equal size, count, and content.
  * Either array may be a view.  Both arrays will not be changed.
  * \param [in] array   One array to be compared.
@@ -350,6 +368,15 @@ void                sc_array_uniq (sc_array_t * array,
                                    int (*compar) (const void *,
                                                   const void *));
 
+/** Removed duplicate entries from a sorted array, comparing with context.
+ * This function is not allowed for views.
+ * \param [in,out] array  The array size will be reduced as necessary.
+ * \param [in] compar     The comparison function to be used.
+ * \param [in] arg        Passed to \a compar.
+ */
+void                sc_array_uniq_r (sc_array_t * array,
+                                     sc_compare_r_t compar, void *arg);
+
 /** Performs a binary search on an array. The array must be sorted.
  * \param [in] array   A sorted array to search in.
  * \param [in] key     An element to be searched for.
@@ -361,6 +388,17 @@ ssize_t             sc_array_bsearch (sc_array_t * array,
                                       int (*compar) (const void *,
                                                      const void *));
 
+/** Performs a binary search on an array, comparing with context.
+ * \param [in] array   A sorted array to search in.
+ * \param [in] key     An element to be searched for.
+ * \param [in] compar  The comparison function to be used.
+ * \param [in] arg     Passed to \a compar.
+ * \return Returns the index into array for the item found, or -1.
+ */
+ssize_t             sc_array_bsearch_r (sc_array_t * array,
+                                        const void *key,
+                                        sc_compare_r_t compar, void *arg);
+
 /** Function to determine the enumerable type of an object in an array.
  * \param [in] array   Array containing the object.
  * \param [in] index   The location of the object.
@@ -417,6 +455,69 @@ void                sc_array_permute (sc_array_t * array,
  */
 unsigned            sc_array_checksum (sc_array_t * array);
 
+/** Associative operator for \ref sc_array_scan.
+ * \param [in,out] accum  On input the left operand, on output the result.
+ * \param [in] elem       The right operand.
+ * \param [in] data       User data passed to \ref sc_array_scan.
+ */
+typedef void        (*sc_array_scan_op_t) (void *accum, const void *elem,
+                                           void *data);
+
+/** Operator for \ref sc_array_scan that adds ints. */
+void                sc_array_scan_sum_int (void *accum, const void *elem,
+                                           void *data);
+
+/** Operator for \ref sc_array_scan that adds longs. */
+void                sc_array_scan_sum_long (void *accum, const void *elem,
+                                            void *data);
+
+/** Operator for \ref sc_array_scan that adds size_t's. */
+void                sc_array_scan_sum_size_t (void *accum, const void *elem,
+                                              void *data);
+
+/** Compute the prefix sums of an array in place.
+ * Large arrays are processed in blocks by the global task pool (see
+ * \ref sc_taskpool_global): each block is reduced, the block results are
+ * scanned, and each block is scanned again starting from its offset.
+ * Thus \a op is called about twice per element and must be associative;
+ * it may be called from several threads concurrently.
+ * \param [in,out] array  On output, entry i is the sum of entries 0..i
+ *                        of the input, or 0..i-1 if \a exclusive.
+ * \param [in] exclusive  Boolean to compute an exclusive scan.
+ * \param [in] identity   Identity element of \a op.  If NULL, the
+ *                        element with all bytes zero is used.
+ * \param [in] op         Associative operator.
+ * \param [in] data       Passed to \a op.
+ * \param [out] total     If not NULL, receives the sum of all entries.
+ */
+void                sc_array_scan (sc_array_t * array, int exclusive,
+                                   const void *identity,
+                                   sc_array_scan_op_t op, void *data,
+                                   void *total);
+
+/** Function to select entries in \ref sc_array_compact.
+ * \param [in] array      Array containing the object.
+ * \param [in] index      The location of the object.
+ * \param [in] data       Arbitrary user data.
+ * \return                True if the object is to be kept.
+ */
+typedef int         (*sc_array_predicate_t) (sc_array_t * array,
+                                             size_t index, void *data);
+
+/** Copy the entries of an array that satisfy a predicate.
+ * The relative order of the entries is preserved.
+ * Large arrays are processed in blocks by the global task pool; the
+ * predicate is called twice per entry and possibly concurrently.
+ * \param [in,out] dest   Initialized array that is not a view, with the
+ *                        same element size as \a src.  It is resized to
+ *                        the number of selected entries.
+ * \param [in] src        Array to select from, distinct from \a dest.
+ * \param [in] pred       Returns true for the entries to keep.
+ * \param [in] data       Passed to \a pred.
+ */
+void                sc_array_compact (sc_array_t * dest, sc_array_t * src,
+                                      sc_array_predicate_t pred, void *data);
+
 /** Adds an element to a priority queue.
  * PQUEUE FUNCTIONS ARE UNTESTED AND CURRENTLY DISABLED.
  * This function is not allowed for views.
@@ -435,6 +536,14 @@ size_t              sc_array_pqueue_add (sc_array_t * array,
                                          int (*compar) (const void *,
                                                         const void *));
 
+/** Adds an element to a priority queue, comparing with context.
+ * PQUEUE FUNCTIONS ARE UNTESTED AND CURRENTLY DISABLED.
+ * See \ref sc_array_pqueue_add; \a arg is passed to \a compar.
+ */
+size_t              sc_array_pqueue_add_r (sc_array_t * array,
+                                           void *temp,
+                                           sc_compare_r_t compar, void *arg);
+
 /** Pops the smallest element from a priority queue.
  * PQUEUE FUNCTIONS ARE UNTESTED AND CURRENTLY DISABLED.
  * This function is not allowed for views.
@@ -449,6 +558,14 @@ size_t              sc_array_pqueue_pop (sc_array_t * array,
                                          int (*compar) (const void *,
                                                         const void *));
 
+/** Pops the smallest element from a priority queue, comparing with context.
+ * PQUEUE FUNCTIONS ARE UNTESTED AND CURRENTLY DISABLED.
+ * See \ref sc_array_pqueue_pop; \a arg is passed to \a compar.
+ */
+size_t              sc_array_pqueue_pop_r (sc_array_t * array,
+                                           void *result,
+                                           sc_compare_r_t compar, void *arg);
+
 /** Returns a pointer to an array element.
  * \param [in] array Valid array.
  * \param [in] index needs to be in [0]..[elem_count-1].
@@ -1008,6 +1125,58 @@ int                 sc_hash_remove (sc_hash_t * hash, void *v, void **found);
  */
 void                sc_hash_foreach (sc_hash_t * hash, sc_hash_foreach_t fn);
 
+/** Function to visit the members in \ref sc_hash_foreach_parallel.
+ * \param [in,out] v      The address of the pointer to the current object.
+ * \param [in] u          The user data of the hash table.
+ * \param [in,out] accum  Accumulator of the calling task, or NULL.
+ * \param [in] data       User data passed to sc_hash_foreach_parallel.
+ */
+typedef void        (*sc_hash_visit_t) (void **v, const void *u,
+                                        void *accum, void *data);
+
+/** Invoke a callback for every member of the hash table in parallel.
+ * Ranges of hash slots are visited by the global task pool, so \a fn may
+ * be called concurrently.  It may modify the objects but not their hash
+ * values, and the table must not be modified otherwise.  The traversal
+ * cannot be stopped early.
+ * \param [in] hash       The hash table.
+ * \param [in] fn         Called once for every member.
+ * \param [in] data       Passed to \a fn and \a combine.
+ * \param [in] accum_size Size of an accumulator.  If 0, \a fn receives
+ *                        NULL and the remaining arguments are ignored.
+ * \param [in] identity   Initial value of each accumulator.  If NULL,
+ *                        all bytes are zero.
+ * \param [in] combine    Associative operator to combine the accumulators.
+ * \param [out] result    Receives the combined accumulators.
+ */
+void                sc_hash_foreach_parallel (sc_hash_t * hash,
+                                              sc_hash_visit_t fn,
+                                              void *data,
+                                              size_t accum_size,
+                                              const void *identity,
+                                              sc_array_scan_op_t combine,
+                                              void *result);
+
+/** Insert many objects into a hash table at once.
+ * If the table is empty, the objects are hashed and compared in parallel
+ * by the global task pool, partitioned by their hash value, and the new
+ * objects are then linked into the table in order.  Otherwise they are
+ * inserted one by one.
+ * In both cases the result equals that of calling \ref
+ * sc_hash_insert_unique for each object in order; hash_fn and equal_fn
+ * may be called concurrently.
+ * \param [in,out] hash       The hash table.
+ * \param [in] objects        Array of void * pointers to the objects.
+ * \param [out] contained     If not NULL, resized to the length of
+ *                            \a objects and filled with the contained
+ *                            object equal to each input object.  It
+ *                            differs from the input for duplicates.
+ * \return                    The number of objects added.
+ */
+size_t              sc_hash_insert_bulk (sc_hash_t * hash,
+                                         sc_array_t * objects,
+                                         sc_array_t * contained);
+
 /** Compute and print statistical information about the occupancy.
  */
 void                sc_hash_print_statistics (int package_id,
@@ -1056,6 +1225,19 @@ sc_hash_array_t    *sc_hash_array_new (size_t elem_size,
  */
 void                sc_hash_array_destroy (sc_hash_array_t * hash_array);
 
+/** Create a new hash array from the unique elements of an array.
+ * The hash table is built with \ref sc_hash_insert_bulk.
+ * \param [in] src         Array of elements to copy.  Of equal elements,
+ *                         only the first one is kept, and the order of the
+ *                         kept elements is preserved.
+ * \param [in] hash_fn     Function to compute the hash value.
+ * \param [in] equal_fn    Function to test two objects for equality.
+ */
+sc_hash_array_t    *sc_hash_array_new_bulk (sc_array_t * src,
+                                            sc_hash_function_t hash_fn,
+                                            sc_equal_function_t equal_fn,
+                                            void *user_data);
+
 /** Check the internal consistency of a hash array.
  */
 int                 sc_hash_array_is_valid (sc_hash_array_t * hash_array);
@@ -1090,6 +1272,19 @@ int                 sc_hash_array_lookup (sc_hash_array_t * hash_array,
 void               *sc_hash_array_insert_unique (sc_hash_array_t * hash_array,
                                                  void *v, size_t * position);
 
+/** Remove an object from a hash array.
+ * To keep the array contiguous, the last array element is moved into the
+ * position of the removed object.  Thus, the position of that element changes.
+ *
+ * \param [in]  v          A pointer to the object.  Used for search only.
+ * \param [out] position   If position != NULL and the object is found,
+ *                         *position is set to the array position that the
+ *                         object occupied before its removal.
+ * \return                 Returns true if object is found, false otherwise.
+ */
+int                 sc_hash_array_remove (sc_hash_array_t * hash_array,
+                                          void *v, size_t * position);
+
 /** Extract the array data from a hash array and destroy everything else.
  * \param [in] hash_array   The hash array is destroyed after extraction.
  * \param [in] rip          Array structure that will be overwritten.
@@ -0,0 +1,506 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_dht.h>
+#include <sc_notify.h>
+
+struct sc_dht
+{
+  sc_MPI_Comm         mpicomm;
+  int                 mpisize, mpirank;
+  size_t              key_size, value_size, item_size;
+  sc_hash_function_t  hash_fn;
+  sc_equal_function_t equal_fn;
+  void               *user_data;
+  sc_hash_array_t    *local;
+};
+
+/** Communication pattern of one batched operation.
+ * The entries are sorted by owner rank and grouped into one message each.
+ */
+typedef struct sc_dht_route
+{
+  sc_array_t          order;    /**< Input position of each sorted entry */
+  sc_array_t          receivers;        /**< Owner ranks in ascending order */
+  sc_array_t          rcounts;  /**< Number of entries sent per owner */
+  sc_array_t          senders;  /**< Ranks sending to us in ascending order */
+  sc_array_t          scounts;  /**< Number of entries received per sender */
+  size_t              num_incoming;     /**< Sum of the scounts */
+}
+sc_dht_route_t;
+
+/** Used to sort entries by owner while preserving their input order. */
+typedef struct sc_dht_owned
+{
+  int                 owner;
+  size_t              position;
+}
+sc_dht_owned_t;
+
+static unsigned
+sc_dht_hash_bytes (const void *v, const void *u)
+{
+  const sc_dht_t     *dht = (const sc_dht_t *) u;
+  const unsigned char *p = (const unsigned char *) v;
+  size_t              zz;
+  unsigned            a, b, c, w;
+
+  a = b = c = 0xdeadbeefU + (unsigned) dht->key_size;
+  for (zz = 0; zz < dht->key_size; ++zz) {
+    w = (unsigned) p[zz] << (8 * (zz % 4));
+    switch ((zz / 4) % 3) {
+    case 0:
+      a += w;
+      break;
+    case 1:
+      b += w;
+      break;
+    default:
+      c += w;
+      if (zz % 12 == 11) {
+        sc_hash_mix (a, b, c);
+      }
+    }
+  }
+  sc_hash_final (a, b, c);
+
+  return c;
+}
+
+static int
+sc_dht_equal_bytes (const void *v1, const void *v2, const void *u)
+{
+  const sc_dht_t     *dht = (const sc_dht_t *) u;
+
+  return !memcmp (v1, v2, dht->key_size);
+}
+
+static int
+sc_dht_owned_compare (const void *v1, const void *v2)
+{
+  const sc_dht_owned_t *o1 = (const sc_dht_owned_t *) v1;
+  const sc_dht_owned_t *o2 = (const sc_dht_owned_t *) v2;
+
+  if (o1->owner != o2->owner) {
+    return o1->owner < o2->owner ? -1 : 1;
+  }
+  return o1->position < o2->position ? -1 :
+    o1->position > o2->position ? 1 : 0;
+}
+
+sc_dht_t           *
+sc_dht_new (sc_MPI_Comm mpicomm, size_t key_size, size_t value_size,
+            sc_hash_function_t hash_fn, sc_equal_function_t equal_fn,
+            void *user_data)
+{
+  int                 mpiret;
+  sc_dht_t           *dht;
+
+  SC_ASSERT (key_size > 0);
+  SC_ASSERT ((hash_fn == NULL) == (equal_fn == NULL));
+
+  dht = SC_ALLOC (sc_dht_t, 1);
+  mpiret = sc_MPI_Comm_dup (mpicomm, &dht->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (dht->mpicomm, &dht->mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (dht->mpicomm, &dht->mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  dht->key_size = key_size;
+  dht->value_size = value_size;
+  dht->item_size = key_size + value_size;
+  if (hash_fn == NULL) {
+    dht->hash_fn = sc_dht_hash_bytes;
+    dht->equal_fn = sc_dht_equal_bytes;
+    dht->user_data = dht;
+  }
+  else {
+    dht->hash_fn = hash_fn;
+    dht->equal_fn = equal_fn;
+    dht->user_data = user_data;
+  }
+  dht->local = sc_hash_array_new (dht->item_size, dht->hash_fn,
+                                  dht->equal_fn, dht->user_data);
+
+  return dht;
+}
+
+void
+sc_dht_destroy (sc_dht_t * dht)
+{
+  int                 mpiret;
+
+  sc_hash_array_destroy (dht->local);
+  mpiret = sc_MPI_Comm_free (&dht->mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  SC_FREE (dht);
+}
+
+int
+sc_dht_owner (sc_dht_t * dht, const void *key)
+{
+  unsigned            a, b, c;
+
+  /* rehash to decorrelate the owner from the local hash slots */
+  a = dht->hash_fn (key, dht->user_data);
+  b = 0x9e3779b9U;
+  c = (unsigned) dht->mpisize;
+  sc_hash_final (a, b, c);
+
+  return (int) (c % (unsigned) dht->mpisize);
+}
+
+/** Sort entries by owner and determine the communication pattern.
+ * \param [in] dht          Valid distributed hash table.
+ * \param [out] route       Initialized by this function.
+ * \param [in] entries      Each entry begins with a key.
+ * \param [in,out] sendbuf  Initialized array of the entries' element size.
+ *                          On output, holds the entries sorted by owner.
+ */
+static void
+sc_dht_route_init (sc_dht_t * dht, sc_dht_route_t * route,
+                   sc_array_t * entries, sc_array_t * sendbuf)
+{
+  size_t              zz, num_entries;
+  int                 prev;
+  int                *pcount;
+  sc_array_t          owned;
+  sc_dht_owned_t     *o;
+
+  SC_ASSERT (entries->elem_size == sendbuf->elem_size);
+
+  /* sort the entries by owner */
+  num_entries = entries->elem_count;
+  sc_array_init_count (&owned, sizeof (sc_dht_owned_t), num_entries);
+  for (zz = 0; zz < num_entries; ++zz) {
+    o = (sc_dht_owned_t *) sc_array_index (&owned, zz);
+    o->owner = sc_dht_owner (dht, sc_array_index (entries, zz));
+    o->position = zz;
+  }
+  sc_array_sort (&owned, sc_dht_owned_compare);
+
+  /* pack the send buffer and count the entries per owner */
+  sc_array_init_count (&route->order, sizeof (size_t), num_entries);
+  sc_array_init (&route->receivers, sizeof (int));
+  sc_array_init (&route->rcounts, sizeof (int));
+  sc_array_resize (sendbuf, num_entries);
+  prev = -1;
+  pcount = NULL;
+  for (zz = 0; zz < num_entries; ++zz) {
+    o = (sc_dht_owned_t *) sc_array_index (&owned, zz);
+    *(size_t *) sc_array_index (&route->order, zz) = o->position;
+    memcpy (sc_array_index (sendbuf, zz),
+            sc_array_index (entries, o->position), entries->elem_size);
+    if (o->owner != prev) {
+      SC_ASSERT (prev < o->owner);
+      prev = o->owner;
+      *(int *) sc_array_push (&route->receivers) = prev;
+      pcount = (int *) sc_array_push (&route->rcounts);
+      *pcount = 0;
+    }
+    ++*pcount;
+  }
+  sc_array_reset (&owned);
+
+  /* transpose the pattern with the counts as payload */
+  sc_array_init (&route->senders, sizeof (int));
+  sc_array_init (&route->scounts, sizeof (int));
+  sc_array_copy (&route->scounts, &route->rcounts);
+  sc_notify_ext (&route->receivers, &route->senders, &route->scounts,
+                 sc_notify_nary_ntop, sc_notify_nary_nint,
+                 sc_notify_nary_nbot, dht->mpicomm);
+  SC_ASSERT (route->senders.elem_count == route->scounts.elem_count);
+
+  route->num_incoming = 0;
+  for (zz = 0; zz < route->scounts.elem_count; ++zz) {
+    route->num_incoming += *(int *) sc_array_index (&route->scounts, zz);
+  }
+}
+
+static void
+sc_dht_route_reset (sc_dht_route_t * route)
+{
+  sc_array_reset (&route->order);
+  sc_array_reset (&route->receivers);
+  sc_array_reset (&route->rcounts);
+  sc_array_reset (&route->senders);
+  sc_array_reset (&route->scounts);
+}
+
+/** Exchange grouped entries with point-to-point messages.
+ * Messages to the calling process are copied locally.
+ * \param [in] sendto       Ranks to send to in ascending order.
+ * \param [in] sendcounts   Number of entries for each rank in sendto.
+ * \param [in] sendbuf      Entries grouped by rank in the order of sendto.
+ * \param [in] recvfrom     Ranks to receive from in ascending order.
+ * \param [in] recvcounts   Number of entries from each rank in recvfrom.
+ * \param [in,out] recvbuf  Array of matching size with enough entries.
+ */
+static void
+sc_dht_exchange (sc_dht_t * dht, int tag,
+                 sc_array_t * sendto, sc_array_t * sendcounts,
+                 sc_array_t * sendbuf,
+                 sc_array_t * recvfrom, sc_array_t * recvcounts,
+                 sc_array_t * recvbuf)
+{
+  int                 mpiret;
+  int                 peer, count;
+  size_t              zz, num_recvs, num_sends;
+  size_t              offset, bytes;
+  size_t              self_recv, self_send, self_count;
+  const size_t        es = sendbuf->elem_size;
+  sc_array_t          requests;
+  sc_MPI_Request     *req;
+
+  SC_ASSERT (recvbuf->elem_size == es);
+
+  num_recvs = recvfrom->elem_count;
+  num_sends = sendto->elem_count;
+  sc_array_init_count (&requests, sizeof (sc_MPI_Request),
+                       num_recvs + num_sends);
+  self_recv = self_send = self_count = 0;
+
+  /* post receives */
+  offset = 0;
+  for (zz = 0; zz < num_recvs; ++zz) {
+    peer = *(int *) sc_array_index (recvfrom, zz);
+    count = *(int *) sc_array_index (recvcounts, zz);
+    req = (sc_MPI_Request *) sc_array_index (&requests, zz);
+    if (peer == dht->mpirank) {
+      self_recv = offset;
+      *req = sc_MPI_REQUEST_NULL;
+    }
+    else {
+      bytes = (size_t) count * es;
+      SC_CHECK_ABORT (bytes <= (size_t) INT_MAX, "DHT message too large");
+      mpiret = sc_MPI_Irecv (recvbuf->array + offset * es, (int) bytes,
+                             sc_MPI_BYTE, peer, tag, dht->mpicomm, req);
+      SC_CHECK_MPI (mpiret);
+    }
+    offset += (size_t) count;
+  }
+  SC_ASSERT (offset <= recvbuf->elem_count);
+
+  /* post sends */
+  offset = 0;
+  for (zz = 0; zz < num_sends; ++zz) {
+    peer = *(int *) sc_array_index (sendto, zz);
+    count = *(int *) sc_array_index (sendcounts, zz);
+    req = (sc_MPI_Request *) sc_array_index (&requests, num_recvs + zz);
+    if (peer == dht->mpirank) {
+      self_send = offset;
+      self_count = (size_t) count;
+      *req = sc_MPI_REQUEST_NULL;
+    }
+    else {
+      bytes = (size_t) count * es;
+      SC_CHECK_ABORT (bytes <= (size_t) INT_MAX, "DHT message too large");
+      mpiret = sc_MPI_Isend (sendbuf->array + offset * es, (int) bytes,
+                             sc_MPI_BYTE, peer, tag, dht->mpicomm, req);
+      SC_CHECK_MPI (mpiret);
+    }
+    offset += (size_t) count;
+  }
+  SC_ASSERT (offset == sendbuf->elem_count);
+
+  /* the message to ourselves is a copy */
+  if (self_count > 0) {
+    memcpy (recvbuf->array + self_recv * es,
+            sendbuf->array + self_send * es, self_count * es);
+  }
+
+  mpiret = sc_MPI_Waitall ((int) requests.elem_count,
+                           (sc_MPI_Request *) requests.array,
+                           sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  sc_array_reset (&requests);
+}
+
+void
+sc_dht_insert (sc_dht_t * dht, sc_array_t * items)
+{
+  size_t              zz, position;
+  void               *item, *slot;
+  sc_array_t          sendbuf, recvbuf;
+  sc_dht_route_t      route;
+
+  SC_ASSERT (items != NULL && items->elem_size == dht->item_size);
+
+  /* send the items to their owners */
+  sc_array_init (&sendbuf, dht->item_size);
+  sc_dht_route_init (dht, &route, items, &sendbuf);
+  sc_array_init_count (&recvbuf, dht->item_size, route.num_incoming);
+  sc_dht_exchange (dht, SC_TAG_DHT_REQUEST,
+                   &route.receivers, &route.rcounts, &sendbuf,
+                   &route.senders, &route.scounts, &recvbuf);
+  sc_array_reset (&sendbuf);
+
+  /* insert or overwrite in order of ascending sender rank */
+  for (zz = 0; zz < recvbuf.elem_count; ++zz) {
+    item = sc_array_index (&recvbuf, zz);
+    slot = sc_hash_array_insert_unique (dht->local, item, &position);
+    if (slot == NULL) {
+      slot = sc_array_index (&dht->local->a, position);
+    }
+    memcpy (slot, item, dht->item_size);
+  }
+  sc_array_reset (&recvbuf);
+  sc_dht_route_reset (&route);
+}
+
+/** Query the owners of keys and return one reply per key.
+ * \param [in] with_value   If true, the reply contains the value.
+ * \param [in] remove       If true, the keys found are removed.
+ * \param [in] with_reply   If false, no reply is sent.
+ * \param [in,out] values   Output array for values or NULL.
+ * \param [in,out] found    Output array for found flags or NULL.
+ */
+static void
+sc_dht_query (sc_dht_t * dht, sc_array_t * keys, int with_value,
+              int remove, int with_reply,
+              sc_array_t * values, sc_array_t * found)
+{
+  int                 is_found;
+  size_t              zz, position;
+  size_t              reply_size, num_keys;
+  char               *reply;
+  void               *key;
+  sc_array_t          sendbuf, recvbuf;
+  sc_array_t          replies, answers;
+  sc_dht_route_t      route;
+
+  SC_ASSERT (keys != NULL && keys->elem_size == dht->key_size);
+  SC_ASSERT (values == NULL || values->elem_size == dht->value_size);
+  SC_ASSERT (found == NULL || found->elem_size == sizeof (int));
+
+  /* send the keys to their owners */
+  num_keys = keys->elem_count;
+  position = 0;
+  sc_array_init (&sendbuf, dht->key_size);
+  sc_dht_route_init (dht, &route, keys, &sendbuf);
+  sc_array_init_count (&recvbuf, dht->key_size, route.num_incoming);
+  sc_dht_exchange (dht, SC_TAG_DHT_REQUEST,
+                   &route.receivers, &route.rcounts, &sendbuf,
+                   &route.senders, &route.scounts, &recvbuf);
+  sc_array_reset (&sendbuf);
+
+  /* process the incoming keys; a reply is a flag followed by the value */
+  reply_size = sizeof (int) + (with_value ? dht->value_size : 0);
+  sc_array_init_count (&replies, reply_size,
+                       with_reply ? recvbuf.elem_count : 0);
+  for (zz = 0; zz < recvbuf.elem_count; ++zz) {
+    key = sc_array_index (&recvbuf, zz);
+    if (remove) {
+      is_found = sc_hash_array_remove (dht->local, key, NULL);
+    }
+    else {
+      is_found = sc_hash_array_lookup (dht->local, key, &position);
+    }
+    if (with_reply) {
+      reply = (char *) sc_array_index (&replies, zz);
+      memcpy (reply, &is_found, sizeof (int));
+      if (with_value) {
+        if (is_found) {
+          memcpy (reply + sizeof (int),
+                  (char *) sc_array_index (&dht->local->a, position) +
+                  dht->key_size, dht->value_size);
+        }
+        else {
+          memset (reply + sizeof (int), 0, dht->value_size);
+        }
+      }
+    }
+  }
+  sc_array_reset (&recvbuf);
+
+  if (with_reply) {
+    /* return the replies along the reverse pattern */
+    sc_array_init_count (&answers, reply_size, num_keys);
+    sc_dht_exchange (dht, SC_TAG_DHT_REPLY,
+                     &route.senders, &route.scounts, &replies,
+                     &route.receivers, &route.rcounts, &answers);
+
+    /* scatter the answers into input order */
+    if (values != NULL) {
+      sc_array_resize (values, num_keys);
+    }
+    if (found != NULL) {
+      sc_array_resize (found, num_keys);
+    }
+    for (zz = 0; zz < num_keys; ++zz) {
+      reply = (char *) sc_array_index (&answers, zz);
+      position = *(size_t *) sc_array_index (&route.order, zz);
+      if (found != NULL) {
+        memcpy (sc_array_index (found, position), reply, sizeof (int));
+      }
+      if (values != NULL && dht->value_size > 0) {
+        memcpy (sc_array_index (values, position), reply + sizeof (int),
+                dht->value_size);
+      }
+    }
+    sc_array_reset (&answers);
+  }
+  sc_array_reset (&replies);
+  sc_dht_route_reset (&route);
+}
+
+void
+sc_dht_lookup (sc_dht_t * dht, sc_array_t * keys,
+               sc_array_t * values, sc_array_t * found)
+{
+  sc_dht_query (dht, keys, values != NULL, 0, 1, values, found);
+}
+
+void
+sc_dht_remove (sc_dht_t * dht, sc_array_t * keys, sc_array_t * found)
+{
+  sc_dht_query (dht, keys, 0, 1, found != NULL, NULL, found);
+}
+
+sc_array_t         *
+sc_dht_local_items (sc_dht_t * dht)
+{
+  return &dht->local->a;
+}
+
+size_t
+sc_dht_local_count (sc_dht_t * dht)
+{
+  return dht->local->a.elem_count;
+}
+
+size_t
+sc_dht_global_count (sc_dht_t * dht)
+{
+  int                 mpiret;
+  long long           lcount, gcount;
+
+  lcount = (long long) dht->local->a.elem_count;
+  mpiret = sc_MPI_Allreduce (&lcount, &gcount, 1, sc_MPI_LONG_LONG_INT,
+                             sc_MPI_SUM, dht->mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  return (size_t) gcount;
+}
@@ -0,0 +1,143 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef SC_DHT_H
+#define SC_DHT_H
+
+/** \file sc_dht.h
+ * This file provides a distributed hash table.
+ *
+ * Each item consists of a key of fixed size followed by a value of fixed size.
+ * The keys are partitioned over the processes of a communicator by hashing.
+ * Each process stores the items it owns in a local \ref sc_hash_array_t.
+ * All operations are collective and batched: each call processes many
+ * keys at once and uses one sparse exchange in each direction.
+ * Thus, a global map of N items needs O(N/P) memory per process.
+ */
+
+#include <sc_containers.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** The distributed hash table is an opaque structure. */
+typedef struct sc_dht sc_dht_t;
+
+/** Create a new and empty distributed hash table.
+ * This function is collective.
+ * \param [in] mpicomm      The communicator is duplicated internally.
+ * \param [in] key_size     Size of a key in bytes.  Must be positive.
+ * \param [in] value_size   Size of a value in bytes.  May be 0.
+ * \param [in] hash_fn      Hash function for a key.  It must be the same on
+ *                          all processes and must only read key_size bytes.
+ *                          If NULL, the bytes of the key are hashed.
+ * \param [in] equal_fn     Equality function for two keys.  It must only
+ *                          read key_size bytes.  If NULL, the bytes of the
+ *                          keys are compared.  Must be NULL if and only
+ *                          if hash_fn is NULL.
+ * \param [in] user_data    Passed to \b hash_fn and \b equal_fn.
+ *                          Ignored if they are NULL.
+ * \return                  A valid distributed hash table.
+ */
+sc_dht_t           *sc_dht_new (sc_MPI_Comm mpicomm,
+                                size_t key_size, size_t value_size,
+                                sc_hash_function_t hash_fn,
+                                sc_equal_function_t equal_fn,
+                                void *user_data);
+
+/** Destroy a distributed hash table.
+ * This function is collective.
+ * \param [in,out] dht      This table is invalidated.
+ */
+void                sc_dht_destroy (sc_dht_t * dht);
+
+/** Return the rank of the process that owns a key.
+ * \param [in] dht          Valid distributed hash table.
+ * \param [in] key          Pointer to a key.
+ * \return                  Rank in the communicator of the table.
+ */
+int                 sc_dht_owner (sc_dht_t * dht, const void *key);
+
+/** Insert items into a distributed hash table.
+ * This function is collective.
+ * If a key is already present, its value is overwritten.
+ * If multiple processes insert the same key in one call, the value from
+ * the highest rank wins.  Within one process, the last occurrence wins.
+ * \param [in] dht          Valid distributed hash table.
+ * \param [in] items        Array of items of size key_size + value_size.
+ *                          Each item holds the key followed by the value.
+ */
+void                sc_dht_insert (sc_dht_t * dht, sc_array_t * items);
+
+/** Look up keys in a distributed hash table.
+ * This function is collective.
+ * \param [in] dht          Valid distributed hash table.
+ * \param [in] keys         Array of keys of size key_size.
+ * \param [in,out] values   If not NULL, array of element size value_size.
+ *                          It is resized to the number of keys and contains
+ *                          the value of each key found.  The values of keys
+ *                          not found are set to zero.
+ * \param [in,out] found    If not NULL, array of element size sizeof (int).
+ *                          It is resized to the number of keys and contains
+ *                          true for each key found and false otherwise.
+ */
+void                sc_dht_lookup (sc_dht_t * dht, sc_array_t * keys,
+                                   sc_array_t * values, sc_array_t * found);
+
+/** Remove keys from a distributed hash table.
+ * This function is collective.
+ * Keys that are not present are ignored.
+ * \param [in] dht          Valid distributed hash table.
+ * \param [in] keys         Array of keys of size key_size.
+ * \param [in,out] found    If not NULL, array of element size sizeof (int).
+ *                          It is resized to the number of keys and contains
+ *                          true for each key removed and false otherwise.
+ *                          If NULL, there is no reply communication.
+ *                          It must be NULL on either all or no processes.
+ */
+void                sc_dht_remove (sc_dht_t * dht, sc_array_t * keys,
+                                   sc_array_t * found);
+
+/** Access the items owned by this process.
+ * \param [in] dht          Valid distributed hash table.
+ * \return                  Array of local items in unspecified order.
+ *                          It must not be modified and is valid until
+ *                          the next modifying call on \b dht.
+ */
+sc_array_t         *sc_dht_local_items (sc_dht_t * dht);
+
+/** Return the number of items owned by this process.
+ * \param [in] dht          Valid distributed hash table.
+ * \return                  Local number of items.
+ */
+size_t              sc_dht_local_count (sc_dht_t * dht);
+
+/** Return the global number of items.
+ * This function is collective.
+ * \param [in] dht          Valid distributed hash table.
+ * \return                  Global number of items.
+ */
+size_t              sc_dht_global_count (sc_dht_t * dht);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_DHT_H */
@@ -21,11 +21,228 @@
   02110-1301, USA.
 */
 
+/* we need O_DIRECT for direct file access */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include <sc_io.h>
+#include <sc_private.h>
 #include <libb64.h>
 #ifdef SC_HAVE_ZLIB
 #include <zlib.h>
 #endif
+#include <errno.h>
+#include <fcntl.h>
+#if defined SC_HAVE_SYS_UIO_H && defined SC_HAVE_WRITEV
+#include <limits.h>
+#include <sys/uio.h>
+#define SC_IO_WRITEV
+#ifndef IOV_MAX
+#define IOV_MAX 16
+#endif
+#endif
+
+/** Allocate a buffer for direct file access.
+ * \param [in,out] bytes   Requested size, 0 for the default; it is rounded
+ *                         up to a multiple of the alignment.
+ * \param [out] raw        The memory to free eventually.
+ * \return                 The aligned buffer.
+ */
+static char        *
+sc_io_direct_alloc (size_t * bytes, char **raw)
+{
+  size_t              size;
+
+  size = *bytes == 0 ? SC_IO_BUFFER_DEFAULT : *bytes;
+  size = (size + SC_IO_DIRECT_ALIGN - 1) / SC_IO_DIRECT_ALIGN *
+    SC_IO_DIRECT_ALIGN;
+  *raw = SC_ALLOC (char, size + SC_IO_DIRECT_ALIGN - 1);
+  *bytes = size;
+
+  return *raw + (SC_IO_DIRECT_ALIGN - (size_t) * raw % SC_IO_DIRECT_ALIGN)
+    % SC_IO_DIRECT_ALIGN;
+}
+
+/** Turn on direct access for a file descriptor where possible.
+ * File descriptors open for appending are changed to honor the offsets
+ * of positioned writes.
+ */
+static void
+sc_io_direct_enable (int fd)
+{
+  int                 flags;
+
+  flags = fcntl (fd, F_GETFL);
+  if (flags == -1) {
+    return;
+  }
+  flags &= ~O_APPEND;
+  if (fcntl (fd, F_SETFL, flags) == -1) {
+    return;
+  }
+#ifdef O_DIRECT
+  /* not every file system supports it, and then we go without */
+  (void) fcntl (fd, F_SETFL, flags | O_DIRECT);
+#endif
+}
+
+/** Write at a file offset in direct mode, resuming after partial writes.
+ * Pieces that are not aligned go through the page cache.  If the file
+ * system refuses an aligned direct write, we stop using direct access.
+ * \return             0 on success, -1 on error.
+ */
+static int
+sc_io_direct_pwrite (int fd, const char *data, size_t bytes, size_t offset)
+{
+  ssize_t             written;
+#ifdef O_DIRECT
+  int                 flags, aligned;
+
+  flags = fcntl (fd, F_GETFL);
+  aligned = offset % SC_IO_DIRECT_ALIGN == 0 &&
+    bytes % SC_IO_DIRECT_ALIGN == 0 &&
+    (size_t) data % SC_IO_DIRECT_ALIGN == 0;
+  if (flags != -1 && (flags & O_DIRECT) && !aligned) {
+    if (fcntl (fd, F_SETFL, flags & ~O_DIRECT) == -1) {
+      return -1;
+    }
+  }
+#endif
+
+  while (bytes > 0) {
+    written = pwrite (fd, data, bytes, (off_t) offset);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+#ifdef O_DIRECT
+      if (errno == EINVAL && flags != -1 && (flags & O_DIRECT) && aligned) {
+        flags &= ~O_DIRECT;
+        if (fcntl (fd, F_SETFL, flags) == 0) {
+          continue;
+        }
+      }
+#endif
+      return -1;
+    }
+    data += written;
+    bytes -= (size_t) written;
+    offset += (size_t) written;
+  }
+
+#ifdef O_DIRECT
+  if (flags != -1 && (flags & O_DIRECT) && !aligned) {
+    if (fcntl (fd, F_SETFL, flags) == -1) {
+      return -1;
+    }
+  }
+#endif
+  return 0;
+}
+
+/** Read at a file offset in direct mode, retrying after interrupts.
+ * The buffer, offset and size are aligned.  If the file system refuses
+ * the direct read all the same, we stop using direct access.
+ * \return             The number of bytes read, or -1 on error.
+ */
+static ssize_t
+sc_io_direct_pread (int fd, char *data, size_t bytes, size_t offset)
+{
+  ssize_t             nread;
+#ifdef O_DIRECT
+  int                 flags;
+#endif
+
+  for (;;) {
+    nread = pread (fd, data, bytes, (off_t) offset);
+    if (nread >= 0) {
+      return nread;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+#ifdef O_DIRECT
+    if (errno == EINVAL) {
+      flags = fcntl (fd, F_GETFL);
+      if (flags != -1 && (flags & O_DIRECT) &&
+          fcntl (fd, F_SETFL, flags & ~O_DIRECT) == 0) {
+        continue;
+      }
+    }
+#endif
+    return -1;
+  }
+}
+
+/** Write the buffered data of a sink in direct mode.
+ * \param [in] all     If false, write only up to the last block boundary
+ *                     of the file.  Otherwise write everything and keep
+ *                     the partial block to be written again later.
+ * \return             0 on success, -1 on error.
+ */
+static int
+sc_io_sink_direct_flush (sc_io_sink_t * sink, int all)
+{
+  size_t              end, keep, bytes;
+
+  /* the buffer keeps the data after the last block boundary */
+  end = sink->direct_offset + sink->direct_fill;
+  keep = SC_MIN (end % SC_IO_DIRECT_ALIGN, sink->direct_fill);
+  bytes = all ? sink->direct_fill : sink->direct_fill - keep;
+  if (bytes > 0 &&
+      sc_io_direct_pwrite (fileno (sink->file), sink->direct, bytes,
+                           sink->direct_offset)) {
+    return -1;
+  }
+  if (keep < sink->direct_fill) {
+    memmove (sink->direct, sink->direct + sink->direct_fill - keep, keep);
+    sink->direct_offset = end - keep;
+    sink->direct_fill = keep;
+  }
+  return 0;
+}
+
+/** Write to a sink in direct mode.
+ * \return             The number of bytes accepted.
+ */
+static size_t
+sc_io_sink_direct_write (sc_io_sink_t * sink, const char *data, size_t bytes)
+{
+  size_t              done, n;
+
+  done = 0;
+  while (done < bytes) {
+    /* large aligned pieces are written from the caller's memory */
+    if ((sink->direct_offset + sink->direct_fill) % SC_IO_DIRECT_ALIGN == 0
+        && (size_t) (data + done) % SC_IO_DIRECT_ALIGN == 0
+        && bytes - done >= sink->direct_size) {
+      if (sc_io_sink_direct_flush (sink, 0)) {
+        return done;
+      }
+      SC_ASSERT (sink->direct_fill == 0);
+      n = (bytes - done) / SC_IO_DIRECT_ALIGN * SC_IO_DIRECT_ALIGN;
+      if (sc_io_direct_pwrite (fileno (sink->file), data + done, n,
+                               sink->direct_offset)) {
+        return done;
+      }
+      sink->direct_offset += n;
+      done += n;
+      continue;
+    }
+
+    /* otherwise the data are copied and full buffers written */
+    n = SC_MIN (sink->direct_size - sink->direct_fill, bytes - done);
+    memcpy (sink->direct + sink->direct_fill, data + done, n);
+    sink->direct_fill += n;
+    done += n;
+    if (sink->direct_fill == sink->direct_size &&
+        sc_io_sink_direct_flush (sink, 0)) {
+      return done - n;
+    }
+  }
+  return done;
+}
 
 sc_io_sink_t       *
 sc_io_sink_new (sc_io_type_t iotype, sc_io_mode_t mode,
@@ -88,6 +305,7 @@ sc_io_sink_destroy (sc_io_sink_t * sink)
     /* Attempt close even on complete error */
     retval = fclose (sink->file) || retval;
   }
+  SC_FREE (sink->vbuf);
   SC_FREE (sink);
 
   return retval ? SC_IO_ERROR_FATAL : SC_IO_ERROR_NONE;
@@ -120,7 +338,150 @@ sc_io_sink_write (sc_io_sink_t * sink, const void *data, size_t bytes_avail)
   else if (sink->iotype == SC_IO_TYPE_FILENAME ||
            sink->iotype == SC_IO_TYPE_FILEFILE) {
     SC_ASSERT (sink->file != NULL);
-    bytes_out = fwrite (data, 1, bytes_avail, sink->file);
+    if (sink->direct != NULL) {
+      bytes_out = sc_io_sink_direct_write (sink, (const char *) data,
+                                           bytes_avail);
+    }
+    else {
+      bytes_out = fwrite (data, 1, bytes_avail, sink->file);
+    }
+    if (bytes_out != bytes_avail) {
+      return SC_IO_ERROR_FATAL;
+    }
+  }
+
+  sink->bytes_in += bytes_avail;
+  sink->bytes_out += bytes_out;
+
+  return SC_IO_ERROR_NONE;
+}
+
+void
+sc_io_vec_array (sc_io_vec_t * vec, sc_array_t * array)
+{
+  SC_ASSERT (vec != NULL);
+  SC_ASSERT (array != NULL);
+
+  vec->data = array->array;
+  vec->bytes = array->elem_count * array->elem_size;
+}
+
+#ifdef SC_IO_WRITEV
+
+/** Write pieces to a file descriptor, resuming after partial writes.
+ * \return             Number of bytes written.
+ */
+static size_t
+sc_io_writev_fd (int fd, const sc_io_vec_t * vecs, int count)
+{
+  int                 i, num;
+  ssize_t             written;
+  size_t              total, skip;
+  struct iovec        iov[IOV_MAX];
+
+  total = skip = 0;
+  while (count > 0) {
+    /* the first piece may have been written partially */
+    num = SC_MIN (count, IOV_MAX);
+    for (i = 0; i < num; ++i) {
+      iov[i].iov_base = (char *) vecs[i].data + (i == 0 ? skip : 0);
+      iov[i].iov_len = vecs[i].bytes - (i == 0 ? skip : 0);
+    }
+    written = writev (fd, iov, num);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    total += (size_t) written;
+
+    /* advance to the first piece not written completely */
+    skip += (size_t) written;
+    while (count > 0 && skip >= vecs[0].bytes) {
+      skip -= vecs[0].bytes;
+      ++vecs;
+      --count;
+    }
+    if (written == 0 && count > 0) {
+      break;
+    }
+  }
+  return total;
+}
+
+#endif
+
+int
+sc_io_sink_writev (sc_io_sink_t * sink, const sc_io_vec_t * vecs, int count)
+{
+  int                 i;
+  size_t              bytes_avail, bytes_out;
+
+  SC_ASSERT (count >= 0);
+  SC_ASSERT (vecs != NULL || count == 0);
+
+  bytes_avail = 0;
+  for (i = 0; i < count; ++i) {
+    SC_ASSERT (vecs[i].data != NULL || vecs[i].bytes == 0);
+    bytes_avail += vecs[i].bytes;
+  }
+  bytes_out = 0;
+
+  if (sink->iotype == SC_IO_TYPE_BUFFER) {
+    size_t              elem_size, new_count;
+
+    /* resize the buffer only once */
+    SC_ASSERT (sink->buffer != NULL);
+    elem_size = sink->buffer->elem_size;
+    new_count =
+      (sink->buffer_bytes + bytes_avail + elem_size - 1) / elem_size;
+    sc_array_resize (sink->buffer, new_count);
+    if (new_count * elem_size > SC_ARRAY_BYTE_ALLOC (sink->buffer)) {
+      return SC_IO_ERROR_FATAL;
+    }
+
+    for (i = 0; i < count; ++i) {
+      memcpy (sink->buffer->array + sink->buffer_bytes, vecs[i].data,
+              vecs[i].bytes);
+      sink->buffer_bytes += vecs[i].bytes;
+    }
+    bytes_out = bytes_avail;
+  }
+  else if (sink->iotype == SC_IO_TYPE_FILENAME ||
+           sink->iotype == SC_IO_TYPE_FILEFILE) {
+    SC_ASSERT (sink->file != NULL);
+    if (sink->direct != NULL) {
+      for (i = 0; i < count; ++i) {
+        bytes_out += sc_io_sink_direct_write
+          (sink, (const char *) vecs[i].data, vecs[i].bytes);
+      }
+    }
+    else {
+#ifdef SC_IO_WRITEV
+    {
+      int                 fd;
+      off_t               position;
+
+      /* bypass the stream buffer after emptying it */
+      if (fflush (sink->file)) {
+        return SC_IO_ERROR_FATAL;
+      }
+      fd = fileno (sink->file);
+      bytes_out = sc_io_writev_fd (fd, vecs, count);
+
+      /* let the stream know where the file position is now */
+      position = lseek (fd, 0, SEEK_CUR);
+      if (position >= 0 && fseek (sink->file, (long) position, SEEK_SET)) {
+        return SC_IO_ERROR_FATAL;
+      }
+    }
+#else
+    for (i = 0; i < count; ++i) {
+      bytes_out += fwrite (vecs[i].data, 1, vecs[i].bytes, sink->file);
+    }
+#endif
+    }
     if (bytes_out != bytes_avail) {
       return SC_IO_ERROR_FATAL;
     }
@@ -132,6 +493,25 @@ sc_io_sink_write (sc_io_sink_t * sink, const void *data, size_t bytes_avail)
   return SC_IO_ERROR_NONE;
 }
 
+int
+sc_io_sink_write_arrays (sc_io_sink_t * sink, sc_array_t ** arrays,
+                         int count)
+{
+  int                 i, retval;
+  sc_io_vec_t        *vecs;
+
+  SC_ASSERT (count >= 0);
+
+  vecs = SC_ALLOC (sc_io_vec_t, SC_MAX (count, 1));
+  for (i = 0; i < count; ++i) {
+    sc_io_vec_array (&vecs[i], arrays[i]);
+  }
+  retval = sc_io_sink_writev (sink, vecs, count);
+  SC_FREE (vecs);
+
+  return retval;
+}
+
 int
 sc_io_sink_complete (sc_io_sink_t * sink,
                      size_t * bytes_in, size_t * bytes_out)
@@ -148,7 +528,12 @@ sc_io_sink_complete (sc_io_sink_t * sink,
   else if (sink->iotype == SC_IO_TYPE_FILENAME ||
            sink->iotype == SC_IO_TYPE_FILEFILE) {
     SC_ASSERT (sink->file != NULL);
-    retval = fflush (sink->file);
+    if (sink->direct != NULL) {
+      retval = sc_io_sink_direct_flush (sink, 1);
+    }
+    else {
+      retval = fflush (sink->file);
+    }
   }
   if (retval) {
     return SC_IO_ERROR_FATAL;
@@ -180,6 +565,40 @@ sc_io_sink_align (sc_io_sink_t * sink, size_t bytes_align)
   return retval;
 }
 
+int
+sc_io_sink_set_buffer (sc_io_sink_t * sink, size_t bytes, int direct)
+{
+  int                 fd;
+  off_t               position;
+
+  if (sink->iotype != SC_IO_TYPE_FILENAME || sink->bytes_in > 0 ||
+      sink->vbuf != NULL) {
+    return SC_IO_ERROR_FATAL;
+  }
+  SC_ASSERT (sink->file != NULL);
+
+  if (!direct) {
+    bytes = bytes == 0 ? SC_IO_BUFFER_DEFAULT : bytes;
+    sink->vbuf = SC_ALLOC (char, bytes);
+    return setvbuf (sink->file, sink->vbuf, _IOFBF, bytes) ?
+      SC_IO_ERROR_FATAL : SC_IO_ERROR_NONE;
+  }
+
+  /* we write at explicit offsets from now on */
+  fd = fileno (sink->file);
+  position = lseek (fd, 0, SEEK_END);
+  if (position < 0) {
+    return SC_IO_ERROR_FATAL;
+  }
+  sc_io_direct_enable (fd);
+  sink->direct = sc_io_direct_alloc (&bytes, &sink->vbuf);
+  sink->direct_size = bytes;
+  sink->direct_fill = 0;
+  sink->direct_offset = (size_t) position;
+
+  return SC_IO_ERROR_NONE;
+}
+
 sc_io_source_t     *
 sc_io_source_new (sc_io_type_t iotype, sc_io_encode_t encode, ...)
 {
@@ -205,6 +624,10 @@ sc_io_source_new (sc_io_type_t iotype, sc_io_encode_t encode, ...)
       SC_FREE (source);
       return NULL;
     }
+#ifdef SC_HAVE_POSIX_FADVISE
+    (void) posix_fadvise (fileno (source->file), 0, 0,
+                          POSIX_FADV_SEQUENTIAL);
+#endif
   }
   else if (iotype == SC_IO_TYPE_FILEFILE) {
     source->file = va_arg (ap, FILE *);
@@ -230,10 +653,12 @@ sc_io_source_destroy (sc_io_source_t * source)
   retval = sc_io_source_complete (source, NULL, NULL);
 
   /* destroy mirror */
-  if (source->mirror != NULL) {
-    retval = sc_io_sink_destroy (source->mirror) || retval;
+  if (source->mirror_buffer != NULL) {
     sc_array_destroy (source->mirror_buffer);
   }
+  if (source->mirror_chunks != NULL) {
+    sc_array_destroy (source->mirror_chunks);
+  }
 
   /* The error value SC_IO_ERROR_AGAIN is turned into FATAL */
   if (source->iotype == SC_IO_TYPE_FILENAME) {
@@ -242,11 +667,176 @@ sc_io_source_destroy (sc_io_source_t * source)
     /* Attempt close even on complete error */
     retval = fclose (source->file) || retval;
   }
+  SC_FREE (source->vbuf);
   SC_FREE (source);
 
   return retval ? SC_IO_ERROR_FATAL : SC_IO_ERROR_NONE;
 }
 
+/** Read from a source in direct mode.
+ * Skipping only moves the position, as does fseek for the other sources.
+ * \return             0 on success, -1 on error.
+ */
+static int
+sc_io_source_direct_read (sc_io_source_t * source, char *data,
+                          size_t bytes, size_t * bytes_out)
+{
+  int                 fd;
+  ssize_t             nread;
+  size_t              done, n, end;
+
+  if (data == NULL) {
+    source->direct_pos += bytes;
+    *bytes_out = bytes;
+    return 0;
+  }
+
+  fd = fileno (source->file);
+  done = 0;
+  while (done < bytes) {
+    end = source->direct_offset + source->direct_fill;
+    if (source->direct_pos < source->direct_offset ||
+        source->direct_pos >= end) {
+      /* read the aligned block range containing the position */
+      source->direct_offset = source->direct_pos / SC_IO_DIRECT_ALIGN *
+        SC_IO_DIRECT_ALIGN;
+      nread = sc_io_direct_pread (fd, source->direct, source->direct_size,
+                                  source->direct_offset);
+      if (nread < 0) {
+        source->direct_fill = 0;
+        return -1;
+      }
+      source->direct_fill = (size_t) nread;
+      end = source->direct_offset + source->direct_fill;
+      if (source->direct_pos >= end) {
+        /* we are at the end of the file */
+        break;
+      }
+    }
+    n = SC_MIN (end - source->direct_pos, bytes - done);
+    memcpy (data + done, source->direct +
+            (source->direct_pos - source->direct_offset), n);
+    source->direct_pos += n;
+    done += n;
+  }
+  *bytes_out = done;
+  return 0;
+}
+
+uint64_t
+sc_io_hash64 (const void *data, size_t bytes)
+{
+  const char         *cdata = (const char *) data;
+#ifdef SC_HAVE_ZLIB
+  uInt                n;
+  uLong               crc, adler;
+
+  /* zlib counts lengths in unsigned ints */
+  crc = crc32 (0L, Z_NULL, 0);
+  adler = adler32 (0L, Z_NULL, 0);
+  for (; bytes > 0; cdata += n, bytes -= n) {
+    n = (uInt) SC_MIN (bytes, (size_t) 1 << 30);
+    crc = crc32 (crc, (const Bytef *) cdata, n);
+    adler = adler32 (adler, (const Bytef *) cdata, n);
+  }
+
+  return ((uint64_t) (crc & 0xffffffffUL) << 32) |
+    (uint64_t) (adler & 0xffffffffUL);
+#else
+  size_t              iz;
+  uint64_t            hash = (uint64_t) 0xcbf29ce484222325ULL;
+
+  for (iz = 0; iz < bytes; ++iz) {
+    hash ^= (uint64_t) (unsigned char) cdata[iz];
+    hash *= (uint64_t) 0x100000001b3ULL;
+  }
+  return hash;
+#endif
+}
+
+void
+sc_io_exscan_size (size_t local, size_t * base, size_t * total,
+                   sc_MPI_Comm mpicomm)
+{
+  int                 mpiret, rank;
+  unsigned long long  lsize, lbase, ltotal;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  lsize = (unsigned long long) local;
+  lbase = 0;
+  mpiret = sc_MPI_Exscan (&lsize, &lbase, 1, sc_MPI_UNSIGNED_LONG_LONG,
+                          sc_MPI_SUM, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Allreduce (&lsize, &ltotal, 1, sc_MPI_UNSIGNED_LONG_LONG,
+                             sc_MPI_SUM, mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  /* the result of exscan is undefined on the first process */
+  *base = rank == 0 ? 0 : (size_t) lbase;
+  *total = (size_t) ltotal;
+}
+
+/** A range of bytes, such as the data of a BUFFER source recorded by its
+ * mirror or a piece of a file. */
+typedef struct sc_io_range
+{
+  size_t              offset;   /**< byte offset in the buffer or file */
+  size_t              bytes;
+}
+sc_io_range_t;
+
+/** Record a range of a BUFFER source in the mirror. */
+static void
+sc_io_source_mirror_range (sc_io_source_t * source, size_t offset,
+                           size_t bytes)
+{
+  sc_io_range_t *chunk;
+
+  if (bytes == 0) {
+    return;
+  }
+
+  /* consecutive reads extend the last range */
+  chunk = NULL;
+  if (source->mirror_chunks->elem_count > 0) {
+    chunk = (sc_io_range_t *) sc_array_index
+      (source->mirror_chunks, source->mirror_chunks->elem_count - 1);
+    if (chunk->offset + chunk->bytes != offset) {
+      chunk = NULL;
+    }
+  }
+  if (chunk == NULL) {
+    chunk = (sc_io_range_t *) sc_array_push (source->mirror_chunks);
+    chunk->offset = offset;
+    chunk->bytes = 0;
+  }
+  chunk->bytes += bytes;
+  source->mirror_bytes += bytes;
+}
+
+/** Append data read from a file to the mirror buffer. */
+static void
+sc_io_source_mirror_copy (sc_io_source_t * source, const void *data,
+                          size_t bytes)
+{
+  size_t              offset;
+  sc_array_t         *mb = source->mirror_buffer;
+
+  /* the memory of a presized mirror is kept until it is full,
+     and sc_array_resize doubles the allocation beyond that */
+  offset = mb->elem_count;
+  if (offset + bytes <= (size_t) mb->byte_alloc) {
+    mb->elem_count = offset + bytes;
+  }
+  else {
+    sc_array_resize (mb, offset + bytes);
+  }
+  memcpy (mb->array + offset, data, bytes);
+  source->mirror_bytes = mb->elem_count;
+}
+
 int
 sc_io_source_read (sc_io_source_t * source, void *data,
                    size_t bytes_avail, size_t * bytes_out)
@@ -259,26 +849,37 @@ sc_io_source_read (sc_io_source_t * source, void *data,
 
   if (source->iotype == SC_IO_TYPE_BUFFER) {
     SC_ASSERT (source->buffer != NULL);
-    bbytes_out = SC_ARRAY_BYTE_ALLOC (source->buffer);
+    bbytes_out = source->buffer->elem_count * source->buffer->elem_size;
     SC_ASSERT (bbytes_out >= source->buffer_bytes);
     bbytes_out -= source->buffer_bytes;
     bbytes_out = SC_MIN (bbytes_out, bytes_avail);
 
     if (data != NULL) {
       memcpy (data, source->buffer->array + source->buffer_bytes, bbytes_out);
+      if (source->mirror_chunks != NULL) {
+        sc_io_source_mirror_range (source, source->buffer_bytes, bbytes_out);
+      }
     }
     source->buffer_bytes += bbytes_out;
   }
   else if (source->iotype == SC_IO_TYPE_FILENAME ||
            source->iotype == SC_IO_TYPE_FILEFILE) {
     SC_ASSERT (source->file != NULL);
-    if (data != NULL) {
+    if (source->direct != NULL) {
+      retval = sc_io_source_direct_read (source, (char *) data, bytes_avail,
+                                         &bbytes_out);
+      if (retval == SC_IO_ERROR_NONE && data != NULL &&
+          source->mirror_buffer != NULL) {
+        sc_io_source_mirror_copy (source, data, bbytes_out);
+      }
+    }
+    else if (data != NULL) {
       bbytes_out = fread (data, 1, bytes_avail, source->file);
       if (bbytes_out < bytes_avail) {
         retval = !feof (source->file) || ferror (source->file);
       }
-      if (retval == SC_IO_ERROR_NONE && source->mirror != NULL) {
-        retval = sc_io_sink_write (source->mirror, data, bbytes_out);
+      if (retval == SC_IO_ERROR_NONE && source->mirror_buffer != NULL) {
+        sc_io_source_mirror_copy (source, data, bbytes_out);
       }
     }
     else {
@@ -302,24 +903,66 @@ sc_io_source_read (sc_io_source_t * source, void *data,
   return SC_IO_ERROR_NONE;
 }
 
+int
+sc_io_source_readv (sc_io_source_t * source, const sc_io_vec_t * vecs,
+                    int count, size_t * bytes_out)
+{
+  int                 i, retval;
+  size_t              piece_out, total;
+
+  SC_ASSERT (count >= 0);
+  SC_ASSERT (vecs != NULL || count == 0);
+
+  /* large stream reads go straight into the pieces without buffering */
+  total = 0;
+  for (i = 0; i < count; ++i) {
+    retval = sc_io_source_read (source, vecs[i].data, vecs[i].bytes,
+                                &piece_out);
+    if (retval) {
+      return retval;
+    }
+    total += piece_out;
+    if (piece_out < vecs[i].bytes) {
+      break;
+    }
+  }
+  if (bytes_out == NULL) {
+    return i < count ? SC_IO_ERROR_FATAL : SC_IO_ERROR_NONE;
+  }
+  *bytes_out = total;
+
+  return SC_IO_ERROR_NONE;
+}
+
+int
+sc_io_source_read_arrays (sc_io_source_t * source, sc_array_t ** arrays,
+                          int count)
+{
+  int                 i, retval;
+  sc_io_vec_t        *vecs;
+
+  SC_ASSERT (count >= 0);
+
+  vecs = SC_ALLOC (sc_io_vec_t, SC_MAX (count, 1));
+  for (i = 0; i < count; ++i) {
+    sc_io_vec_array (&vecs[i], arrays[i]);
+  }
+  retval = sc_io_source_readv (source, vecs, count, NULL);
+  SC_FREE (vecs);
+
+  return retval;
+}
+
 int
 sc_io_source_complete (sc_io_source_t * source,
                        size_t * bytes_in, size_t * bytes_out)
 {
-  int                 retval = SC_IO_ERROR_NONE;
-
   if (source->iotype == SC_IO_TYPE_BUFFER) {
     SC_ASSERT (source->buffer != NULL);
     if (source->buffer_bytes % source->buffer->elem_size != 0) {
       return SC_IO_ERROR_AGAIN;
     }
   }
-  else if (source->iotype == SC_IO_TYPE_FILENAME ||
-           source->iotype == SC_IO_TYPE_FILEFILE) {
-    if (source->mirror != NULL) {
-      retval = sc_io_sink_complete (source->mirror, NULL, NULL);
-    }
-  }
 
   if (bytes_in != NULL) {
     *bytes_in = source->bytes_in;
@@ -329,7 +972,7 @@ sc_io_source_complete (sc_io_source_t * source,
   }
   source->bytes_in = source->bytes_out = 0;
 
-  return retval;
+  return SC_IO_ERROR_NONE;
 }
 
 int
@@ -343,56 +986,581 @@ sc_io_source_align (sc_io_source_t * source, size_t bytes_align)
 }
 
 int
-sc_io_source_activate_mirror (sc_io_source_t * source)
+sc_io_source_set_buffer (sc_io_source_t * source, size_t bytes, int direct)
 {
-  if (source->iotype == SC_IO_TYPE_BUFFER) {
+  if (source->iotype != SC_IO_TYPE_FILENAME || source->bytes_in > 0 ||
+      source->vbuf != NULL) {
     return SC_IO_ERROR_FATAL;
   }
-  if (source->mirror != NULL) {
-    return SC_IO_ERROR_FATAL;
+  SC_ASSERT (source->file != NULL);
+
+  if (!direct) {
+    bytes = bytes == 0 ? SC_IO_BUFFER_DEFAULT : bytes;
+    source->vbuf = SC_ALLOC (char, bytes);
+    return setvbuf (source->file, source->vbuf, _IOFBF, bytes) ?
+      SC_IO_ERROR_FATAL : SC_IO_ERROR_NONE;
   }
 
-  source->mirror_buffer = sc_array_new (sizeof (char));
-  source->mirror = sc_io_sink_new (SC_IO_TYPE_BUFFER, SC_IO_MODE_WRITE,
-                                   SC_IO_ENCODE_NONE, source->mirror_buffer);
+  /* we read at explicit offsets from now on */
+  sc_io_direct_enable (fileno (source->file));
+  source->direct = sc_io_direct_alloc (&bytes, &source->vbuf);
+  source->direct_size = bytes;
+  source->direct_fill = 0;
+  source->direct_offset = 0;
+  source->direct_pos = 0;
 
-  return (source->mirror != NULL ? SC_IO_ERROR_NONE : SC_IO_ERROR_FATAL);
+  return SC_IO_ERROR_NONE;
 }
 
 int
-sc_io_source_read_mirror (sc_io_source_t * source, void *data,
-                          size_t bytes_avail, size_t * bytes_out)
+sc_io_source_activate_mirror (sc_io_source_t * source)
 {
-  sc_io_source_t     *mirror_src;
-  int                 retval;
+  return sc_io_source_activate_mirror_bytes (source, 0);
+}
 
-  if (source->mirror_buffer == NULL) {
+int
+sc_io_source_activate_mirror_bytes (sc_io_source_t * source, size_t bytes)
+{
+  if (source->mirror_buffer != NULL) {
     return SC_IO_ERROR_FATAL;
   }
 
-  mirror_src = sc_io_source_new (SC_IO_TYPE_BUFFER, SC_IO_ENCODE_NONE,
-                                 source->mirror_buffer);
-  retval = (mirror_src != NULL ? SC_IO_ERROR_NONE : SC_IO_ERROR_FATAL);
-  retval = retval || sc_io_source_read (mirror_src, data, bytes_avail,
-                                        bytes_out);
-  if (mirror_src != NULL) {
-    retval = sc_io_source_destroy (mirror_src) || retval;
+  /* a buffer is referenced and not copied */
+  source->mirror_bytes = 0;
+  source->mirror_cursor = source->mirror_cursor_start = 0;
+  if (source->iotype == SC_IO_TYPE_BUFFER) {
+    source->mirror_buffer = sc_array_new (sizeof (char));
+    source->mirror_chunks = sc_array_new (sizeof (sc_io_range_t));
+  }
+  else {
+    /* allocate the memory but mirror nothing yet */
+    source->mirror_buffer = sc_array_new_count (sizeof (char), bytes);
+    sc_array_truncate (source->mirror_buffer);
   }
 
-  return retval;
+  return SC_IO_ERROR_NONE;
 }
 
-int
-sc_vtk_write_binary (FILE * vtkfile, char *numeric_data, size_t byte_length)
+/** Find the mirrored piece that contains a byte offset of the mirror.
+ * The search starts at the chunk found by the previous call if it does
+ * not lie beyond the offset, such that reading forward is linear overall.
+ * \param [in,out] offset  On input the offset into the mirror, on output
+ *                         the offset into the returned memory.
+ * \param [out] avail      Number of bytes from there to the piece's end.
+ * \return                 The memory of the piece.
+ */
+static char        *
+sc_io_source_mirror_find (sc_io_source_t * source, size_t * offset,
+                          size_t * avail)
 {
-  size_t              chunks, chunksize, remaining, writenow;
-  size_t              code_length, base_length;
-  uint32_t            int_header;
-  char               *base_data;
-  base64_encodestate  encode_state;
+  size_t              iz, start;
+  sc_io_range_t *chunk;
 
-  /* VTK format used 32bit header info */
-  SC_ASSERT (byte_length <= (size_t) UINT32_MAX);
+  SC_ASSERT (*offset < source->mirror_bytes);
+
+  if (source->mirror_chunks == NULL) {
+    *avail = source->mirror_bytes - *offset;
+    return source->mirror_buffer->array;
+  }
+  iz = source->mirror_cursor;
+  start = source->mirror_cursor_start;
+  if (*offset < start) {
+    iz = start = 0;
+  }
+  for (;; ++iz) {
+    chunk = (sc_io_range_t *)
+      sc_array_index (source->mirror_chunks, iz);
+    if (*offset < start + chunk->bytes) {
+      break;
+    }
+    start += chunk->bytes;
+  }
+  source->mirror_cursor = iz;
+  source->mirror_cursor_start = start;
+  *offset -= start;
+  *avail = chunk->bytes - *offset;
+  *offset += chunk->offset;
+  return source->buffer->array;
+}
+
+int
+sc_io_source_read_mirror (sc_io_source_t * source, void *data,
+                          size_t bytes_avail, size_t * bytes_out)
+{
+  size_t              bbytes_out, done, offset, avail, n;
+  char               *mem;
+
+  if (source->mirror_buffer == NULL) {
+    return SC_IO_ERROR_FATAL;
+  }
+
+  bbytes_out = SC_MIN (bytes_avail, source->mirror_bytes);
+  if (data != NULL) {
+    for (done = 0; done < bbytes_out; done += n) {
+      offset = done;
+      mem = sc_io_source_mirror_find (source, &offset, &avail);
+      n = SC_MIN (avail, bbytes_out - done);
+      memcpy ((char *) data + done, mem + offset, n);
+    }
+  }
+  if (bytes_out == NULL && bbytes_out < bytes_avail) {
+    return SC_IO_ERROR_FATAL;
+  }
+  if (bytes_out != NULL) {
+    *bytes_out = bbytes_out;
+  }
+
+  return SC_IO_ERROR_NONE;
+}
+
+int
+sc_io_source_mirror_view (sc_io_source_t * source, size_t offset,
+                          size_t bytes, sc_array_t * view)
+{
+  size_t              avail;
+  char               *mem;
+
+  if (source->mirror_buffer == NULL ||
+      offset + bytes > source->mirror_bytes) {
+    return SC_IO_ERROR_FATAL;
+  }
+  if (bytes == 0) {
+    sc_array_init_data (view, NULL, sizeof (char), 0);
+    return SC_IO_ERROR_NONE;
+  }
+
+  mem = sc_io_source_mirror_find (source, &offset, &avail);
+  if (bytes > avail) {
+    return SC_IO_ERROR_FATAL;
+  }
+  sc_array_init_data (view, mem + offset, sizeof (char), bytes);
+
+  return SC_IO_ERROR_NONE;
+}
+
+/** The approximate byte size of the blocks of the shuffle codec. */
+#define SC_IO_SHUFFLE_BLOCK ((size_t) 1 << 16)
+
+/** The first header word of a shuffle encoding. */
+#define SC_IO_SHUFFLE_MAGIC ((uint64_t) 0x5343534855464c31ULL)
+
+/** Number of words in the header of a shuffle encoding. */
+#define SC_IO_SHUFFLE_HEADER 6
+
+/** Flags in the header of a shuffle encoding. */
+#define SC_IO_SHUFFLE_DELTA 1
+#define SC_IO_SHUFFLE_ZLIB 2
+
+typedef struct sc_io_shuffle
+{
+  char               *data;     /**< the elements */
+  size_t              elem_size, elem_count, block_elems;
+  int                 delta, level;
+  char               *blocks;   /**< the encoded blocks */
+  size_t              bound;    /**< slot size of a block when encoding */
+  uint64_t           *sizes;    /**< encoded size of each block */
+  size_t             *offsets;  /**< position of each block when decoding */
+  int                 error;
+}
+sc_io_shuffle_t;
+
+/** Run a function on all blocks, in parallel if there are threads. */
+static void
+sc_io_shuffle_run (sc_io_shuffle_t * sh, size_t nblocks,
+                   sc_range_function_t fn)
+{
+  sc_taskpool_t      *pool = sc_taskpool_global_lookup ();
+
+  if (pool != NULL && nblocks > 1) {
+    sc_taskpool_parallel_for (pool, 0, nblocks, 1, fn, sh);
+  }
+  else {
+    fn (0, nblocks, sh);
+  }
+}
+
+static void
+sc_io_encode_shuffle_blocks (size_t begin, size_t end, void *data)
+{
+  sc_io_shuffle_t    *sh = (sc_io_shuffle_t *) data;
+  const size_t        es = sh->elem_size;
+  size_t              ib, first, n, i, b;
+  const unsigned char *src;
+  unsigned char      *dest, *tmp;
+
+  tmp = sh->level > 0 ? SC_ALLOC (unsigned char, sh->block_elems * es) : NULL;
+  for (ib = begin; ib < end; ++ib) {
+    first = ib * sh->block_elems;
+    n = SC_MIN (sh->block_elems, sh->elem_count - first);
+    src = (const unsigned char *) sh->data + first * es;
+    dest = tmp != NULL ? tmp : (unsigned char *) sh->blocks + ib * sh->bound;
+
+    /* byte b of element i goes to position b * n + i */
+    for (b = 0; b < es; ++b) {
+      if (sh->delta) {
+        dest[b * n] = src[b];
+        for (i = 1; i < n; ++i) {
+          dest[b * n + i] = src[i * es + b] ^ src[(i - 1) * es + b];
+        }
+      }
+      else {
+        for (i = 0; i < n; ++i) {
+          dest[b * n + i] = src[i * es + b];
+        }
+      }
+    }
+    sh->sizes[ib] = (uint64_t) (n * es);
+
+#ifdef SC_HAVE_ZLIB
+    if (tmp != NULL) {
+      int                 retval;
+      uLongf              comp_length = (uLongf) sh->bound;
+
+      retval = compress2 ((Bytef *) sh->blocks + ib * sh->bound,
+                          &comp_length, (const Bytef *) tmp,
+                          (uLong) (n * es), sh->level);
+      SC_CHECK_ZLIB (retval);
+      sh->sizes[ib] = (uint64_t) comp_length;
+    }
+#endif
+  }
+  SC_FREE (tmp);
+}
+
+void
+sc_io_encode_shuffle (sc_array_t * data, sc_array_t * out, int delta,
+                      int level)
+{
+  size_t              ib, nblocks, total;
+  uint64_t           *header;
+  char               *dest;
+  sc_io_shuffle_t     sh;
+
+  SC_ASSERT (data != NULL && data->elem_size > 0);
+  SC_ASSERT (out != NULL && out->elem_size == 1);
+  SC_ASSERT (0 <= level && level <= 9);
+#ifndef SC_HAVE_ZLIB
+  level = 0;
+#endif
+
+  memset (&sh, 0, sizeof (sh));
+  sh.data = data->array;
+  sh.elem_size = data->elem_size;
+  sh.elem_count = data->elem_count;
+  sh.block_elems = SC_MAX (SC_IO_SHUFFLE_BLOCK / data->elem_size, 1);
+  sh.delta = delta;
+  sh.level = level;
+  sh.bound = sh.block_elems * sh.elem_size;
+#ifdef SC_HAVE_ZLIB
+  if (level > 0) {
+    sh.bound = (size_t) compressBound ((uLong) sh.bound);
+  }
+#endif
+  nblocks = (sh.elem_count + sh.block_elems - 1) / sh.block_elems;
+  sh.blocks = SC_ALLOC (char, SC_MAX (nblocks * sh.bound, 1));
+  sh.sizes = SC_ALLOC (uint64_t, SC_MAX (nblocks, 1));
+  sc_io_shuffle_run (&sh, nblocks, sc_io_encode_shuffle_blocks);
+
+  /* the header and the block sizes precede the blocks */
+  for (total = 0, ib = 0; ib < nblocks; ++ib) {
+    total += (size_t) sh.sizes[ib];
+  }
+  sc_array_resize (out, (SC_IO_SHUFFLE_HEADER + nblocks) * sizeof (uint64_t)
+                   + total);
+  header = SC_ALLOC (uint64_t, SC_IO_SHUFFLE_HEADER);
+  header[0] = SC_IO_SHUFFLE_MAGIC;
+  header[1] = (uint64_t) sh.elem_size;
+  header[2] = (uint64_t) sh.elem_count;
+  header[3] = (uint64_t) sh.block_elems;
+  header[4] = (uint64_t) ((delta ? SC_IO_SHUFFLE_DELTA : 0) |
+                          (level > 0 ? SC_IO_SHUFFLE_ZLIB : 0));
+  header[5] = (uint64_t) nblocks;
+  dest = out->array;
+  memcpy (dest, header, SC_IO_SHUFFLE_HEADER * sizeof (uint64_t));
+  dest += SC_IO_SHUFFLE_HEADER * sizeof (uint64_t);
+  memcpy (dest, sh.sizes, nblocks * sizeof (uint64_t));
+  dest += nblocks * sizeof (uint64_t);
+  for (ib = 0; ib < nblocks; ++ib) {
+    memcpy (dest, sh.blocks + ib * sh.bound, (size_t) sh.sizes[ib]);
+    dest += sh.sizes[ib];
+  }
+
+  SC_FREE (header);
+  SC_FREE (sh.sizes);
+  SC_FREE (sh.blocks);
+}
+
+static void
+sc_io_decode_shuffle_blocks (size_t begin, size_t end, void *data)
+{
+  sc_io_shuffle_t    *sh = (sc_io_shuffle_t *) data;
+  const size_t        es = sh->elem_size;
+  size_t              ib, first, n, i, b;
+  const unsigned char *src;
+  unsigned char      *dest, *tmp;
+
+  tmp = sh->level > 0 ? SC_ALLOC (unsigned char, sh->block_elems * es) : NULL;
+  for (ib = begin; ib < end; ++ib) {
+    first = ib * sh->block_elems;
+    n = SC_MIN (sh->block_elems, sh->elem_count - first);
+    src = (const unsigned char *) sh->blocks + sh->offsets[ib];
+    dest = (unsigned char *) sh->data + first * es;
+
+    if (tmp != NULL) {
+#ifdef SC_HAVE_ZLIB
+      int                 retval;
+      uLongf              length = (uLongf) (n * es);
+
+      retval = uncompress ((Bytef *) tmp, &length, (const Bytef *) src,
+                           (uLong) sh->sizes[ib]);
+      if (retval != Z_OK || length != (uLongf) (n * es)) {
+        sh->error = 1;
+        continue;
+      }
+      src = tmp;
+#endif
+    }
+    else if (sh->sizes[ib] != (uint64_t) (n * es)) {
+      sh->error = 1;
+      continue;
+    }
+
+    /* invert the transposition and the exclusive or */
+    for (b = 0; b < es; ++b) {
+      for (i = 0; i < n; ++i) {
+        dest[i * es + b] = src[b * n + i];
+      }
+      if (sh->delta) {
+        for (i = 1; i < n; ++i) {
+          dest[i * es + b] ^= dest[(i - 1) * es + b];
+        }
+      }
+    }
+  }
+  SC_FREE (tmp);
+}
+
+/** Check the header of a shuffle encoding against the data to decode.
+ * The counts must be small enough for the sizes derived from them.
+ * \return          The number of blocks, or -1 if the header is invalid.
+ */
+static long
+sc_io_shuffle_check_header (const uint64_t * header, sc_array_t * data)
+{
+  if (header[0] != SC_IO_SHUFFLE_MAGIC ||
+      header[1] != (uint64_t) data->elem_size ||
+      header[3] != (uint64_t) SC_MAX (SC_IO_SHUFFLE_BLOCK /
+                                      data->elem_size, 1) ||
+      header[2] > (uint64_t) (SIZE_MAX / data->elem_size) ||
+      header[5] != header[2] / header[3] + (header[2] % header[3] != 0) ||
+      header[5] > (uint64_t) (SIZE_MAX / sizeof (uint64_t) -
+                              SC_IO_SHUFFLE_HEADER) ||
+      header[5] > (uint64_t) LONG_MAX) {
+    return -1;
+  }
+#ifndef SC_HAVE_ZLIB
+  if (header[4] & SC_IO_SHUFFLE_ZLIB) {
+    return -1;
+  }
+#endif
+  return (long) header[5];
+}
+
+/** Check some encoded block sizes of a shuffle encoding and add them up.
+ * A raw block has exactly the size of its elements, and a compressed one
+ * is not empty and at most as large as zlib's bound for them.
+ * \param [in] header      The valid header of the encoding.
+ * \param [in] sizes       Block sizes in the byte order of the encoding.
+ * \param [in] first       The block number of the first size.
+ * \param [in] count       The number of sizes to check.
+ * \param [in,out] total   The sizes are added to this sum.
+ * \return                 0 if all sizes are possible, -1 otherwise.
+ */
+static int
+sc_io_shuffle_check_sizes (const uint64_t * header, const char *sizes,
+                           size_t first, size_t count, size_t *total)
+{
+  const size_t        elem_count = (size_t) header[2];
+  const size_t        block_elems = (size_t) header[3];
+  size_t              ib, bytes;
+  uint64_t            size;
+
+  for (ib = first; ib < first + count; ++ib) {
+    memcpy (&size, sizes + (ib - first) * sizeof (uint64_t),
+            sizeof (uint64_t));
+    bytes = SC_MIN (block_elems, elem_count - ib * block_elems) *
+      (size_t) header[1];
+#ifdef SC_HAVE_ZLIB
+    if (header[4] & SC_IO_SHUFFLE_ZLIB) {
+      if (size == 0 || size > (uint64_t) compressBound ((uLong) bytes)) {
+        return -1;
+      }
+    }
+    else
+#endif
+    if (size != (uint64_t) bytes) {
+      return -1;
+    }
+    if ((size_t) size > SIZE_MAX - *total) {
+      return -1;
+    }
+    *total += (size_t) size;
+  }
+  return 0;
+}
+
+/** Append bytes from a source to an array in pieces of bounded size.
+ * The array grows only as far as the source actually delivers data, such
+ * that a corrupt count does not lead to a huge allocation.
+ */
+static int
+sc_io_source_read_append (sc_io_source_t * source, sc_array_t * in,
+                          size_t bytes)
+{
+  int                 retval;
+  size_t              offset, piece;
+
+  while (bytes > 0) {
+    piece = SC_MIN (bytes, SC_IO_SHUFFLE_BLOCK);
+    offset = in->elem_count;
+    sc_array_resize (in, offset + piece);
+    retval = sc_io_source_read (source, in->array + offset, piece, NULL);
+    if (retval) {
+      return retval;
+    }
+    bytes -= piece;
+  }
+  return SC_IO_ERROR_NONE;
+}
+
+int
+sc_io_decode_shuffle (sc_array_t * in, sc_array_t * data)
+{
+  long                lnblocks;
+  size_t              ib, nblocks, position, total;
+  uint64_t            header[SC_IO_SHUFFLE_HEADER];
+  sc_io_shuffle_t     sh;
+
+  SC_ASSERT (in != NULL && in->elem_size == 1);
+  SC_ASSERT (data != NULL && data->elem_size > 0);
+
+  if (in->elem_count < SC_IO_SHUFFLE_HEADER * sizeof (uint64_t)) {
+    return SC_IO_ERROR_FATAL;
+  }
+  memcpy (header, in->array, sizeof (header));
+  lnblocks = sc_io_shuffle_check_header (header, data);
+  if (lnblocks < 0) {
+    return SC_IO_ERROR_FATAL;
+  }
+  nblocks = (size_t) lnblocks;
+  position = (SC_IO_SHUFFLE_HEADER + nblocks) * sizeof (uint64_t);
+  if (in->elem_count < position) {
+    return SC_IO_ERROR_FATAL;
+  }
+
+  /* the block sizes are checked before anything is allocated */
+  total = 0;
+  if (sc_io_shuffle_check_sizes (header, in->array + SC_IO_SHUFFLE_HEADER *
+                                 sizeof (uint64_t), 0, nblocks, &total) ||
+      total != in->elem_count - position) {
+    return SC_IO_ERROR_FATAL;
+  }
+
+  memset (&sh, 0, sizeof (sh));
+  sh.elem_size = data->elem_size;
+  sh.elem_count = (size_t) header[2];
+  sh.block_elems = (size_t) header[3];
+  sh.delta = (header[4] & SC_IO_SHUFFLE_DELTA) ? 1 : 0;
+  sh.level = (header[4] & SC_IO_SHUFFLE_ZLIB) ? 1 : 0;
+  sh.blocks = in->array + position;
+  sh.sizes = SC_ALLOC (uint64_t, SC_MAX (nblocks, 1));
+  sh.offsets = SC_ALLOC (size_t, SC_MAX (nblocks, 1));
+  memcpy (sh.sizes, in->array + SC_IO_SHUFFLE_HEADER * sizeof (uint64_t),
+          nblocks * sizeof (uint64_t));
+  for (total = 0, ib = 0; ib < nblocks; ++ib) {
+    sh.offsets[ib] = total;
+    total += (size_t) sh.sizes[ib];
+  }
+
+  sc_array_resize (data, sh.elem_count);
+  sh.data = data->array;
+  sc_io_shuffle_run (&sh, nblocks, sc_io_decode_shuffle_blocks);
+
+  SC_FREE (sh.offsets);
+  SC_FREE (sh.sizes);
+  return sh.error ? SC_IO_ERROR_FATAL : SC_IO_ERROR_NONE;
+}
+
+int
+sc_io_sink_write_shuffle (sc_io_sink_t * sink, sc_array_t * data,
+                          int delta, int level)
+{
+  int                 retval;
+  sc_array_t         *out;
+
+  out = sc_array_new (1);
+  sc_io_encode_shuffle (data, out, delta, level);
+  retval = sc_io_sink_write (sink, out->array, out->elem_count);
+  sc_array_destroy (out);
+
+  return retval;
+}
+
+int
+sc_io_source_read_shuffle (sc_io_source_t * source, sc_array_t * data)
+{
+  int                 retval;
+  long                lnblocks;
+  size_t              ib, nblocks, count, bytes, total;
+  uint64_t            header[SC_IO_SHUFFLE_HEADER];
+  sc_array_t         *in;
+
+  /* the header tells how much more to read */
+  retval = sc_io_source_read (source, header, sizeof (header), NULL);
+  if (retval) {
+    return retval;
+  }
+  lnblocks = sc_io_shuffle_check_header (header, data);
+  if (lnblocks < 0) {
+    return SC_IO_ERROR_FATAL;
+  }
+  nblocks = (size_t) lnblocks;
+
+  /* the block sizes are read and checked in pieces */
+  in = sc_array_new_count (1, sizeof (header));
+  memcpy (in->array, header, sizeof (header));
+  retval = SC_IO_ERROR_NONE;
+  for (total = 0, ib = 0; !retval && ib < nblocks; ib += count) {
+    count = SC_MIN (nblocks - ib, SC_IO_SHUFFLE_BLOCK / sizeof (uint64_t));
+    bytes = in->elem_count;
+    retval = sc_io_source_read_append (source, in, count * sizeof (uint64_t));
+    if (!retval && sc_io_shuffle_check_sizes (header, in->array + bytes,
+                                              ib, count, &total)) {
+      retval = SC_IO_ERROR_FATAL;
+    }
+  }
+  if (!retval) {
+    retval = sc_io_source_read_append (source, in, total);
+  }
+  if (!retval) {
+    retval = sc_io_decode_shuffle (in, data);
+  }
+  sc_array_destroy (in);
+
+  return retval;
+}
+
+int
+sc_vtk_write_binary (FILE * vtkfile, char *numeric_data, size_t byte_length)
+{
+  size_t              chunks, chunksize, remaining, writenow;
+  size_t              code_length, base_length;
+  uint32_t            int_header;
+  char               *base_data;
+  base64_encodestate  encode_state;
+
+  /* VTK format used 32bit header info */
+  SC_ASSERT (byte_length <= (size_t) UINT32_MAX);
 
   /* This value may be changed although this is not tested with VTK */
   chunksize = (size_t) 1 << 15; /* 32768 */
@@ -549,6 +1717,585 @@ sc_vtk_write_compressed (FILE * vtkfile, char *numeric_data,
   return 0;
 }
 
+/** The block size of compressed VTK data. */
+#define SC_VTK_BLOCK_SIZE ((size_t) 1 << 15)
+
+/** The maximum length of one piece of data written at a time. */
+#define SC_VTK_CHUNK_MAX ((size_t) 1 << 30)
+
+typedef struct sc_vtk_chunk
+{
+  const char         *data;     /**< borrowed data, or NULL if owned */
+  size_t              owned;    /**< position in the owned bytes */
+  size_t              bytes;
+}
+sc_vtk_chunk_t;
+
+struct sc_vtk_appended
+{
+  int                 compression;
+  int                 exscanned;
+  size_t              base;     /**< sizes of the lower processes */
+  size_t              size;     /**< size of the local section */
+  size_t              total;    /**< size of the sections of all processes */
+  sc_array_t          offsets;  /**< local offset of each array */
+  sc_array_t          chunks;   /**< pieces of data in order of writing */
+  sc_array_t          owned;    /**< headers and compressed data */
+};
+
+typedef struct sc_vtk_compress
+{
+  const char         *data;
+  size_t              byte_length;
+  size_t              bound;
+  int                 level;
+  char               *comp;
+  uint64_t           *sizes;
+}
+sc_vtk_compress_t;
+
+sc_vtk_appended_t  *
+sc_vtk_appended_new (int compression)
+{
+  sc_vtk_appended_t  *app;
+
+  SC_ASSERT (0 <= compression && compression <= 9);
+#ifndef SC_HAVE_ZLIB
+  SC_CHECK_ABORT (compression == 0,
+                  "Configure did not find a recent enough zlib");
+#endif
+
+  app = SC_ALLOC_ZERO (sc_vtk_appended_t, 1);
+  app->compression = compression;
+  sc_array_init (&app->offsets, sizeof (size_t));
+  sc_array_init (&app->chunks, sizeof (sc_vtk_chunk_t));
+  sc_array_init (&app->owned, sizeof (char));
+
+  return app;
+}
+
+void
+sc_vtk_appended_destroy (sc_vtk_appended_t * app)
+{
+  sc_array_reset (&app->offsets);
+  sc_array_reset (&app->chunks);
+  sc_array_reset (&app->owned);
+  SC_FREE (app);
+}
+
+/** Append uninitialized owned bytes to the data to write.
+ * Owned bytes that follow each other are written as one chunk.
+ */
+static char        *
+sc_vtk_appended_own (sc_vtk_appended_t * app, size_t bytes)
+{
+  sc_vtk_chunk_t     *chunk = NULL;
+
+  if (app->chunks.elem_count > 0) {
+    chunk = (sc_vtk_chunk_t *) sc_array_index (&app->chunks,
+                                               app->chunks.elem_count - 1);
+    if (chunk->data != NULL || chunk->bytes + bytes > SC_VTK_CHUNK_MAX) {
+      chunk = NULL;
+    }
+  }
+  if (chunk == NULL) {
+    chunk = (sc_vtk_chunk_t *) sc_array_push (&app->chunks);
+    chunk->data = NULL;
+    chunk->owned = app->owned.elem_count;
+    chunk->bytes = 0;
+  }
+  chunk->bytes += bytes;
+  app->size += bytes;
+
+  return (char *) sc_array_push_count (&app->owned, bytes);
+}
+
+/** Append borrowed bytes to the data to write. */
+static void
+sc_vtk_appended_borrow (sc_vtk_appended_t * app, const char *data,
+                        size_t bytes)
+{
+  size_t              piece;
+  sc_vtk_chunk_t     *chunk;
+
+  while (bytes > 0) {
+    piece = SC_MIN (bytes, SC_VTK_CHUNK_MAX);
+    chunk = (sc_vtk_chunk_t *) sc_array_push (&app->chunks);
+    chunk->data = data;
+    chunk->owned = 0;
+    chunk->bytes = piece;
+    app->size += piece;
+    data += piece;
+    bytes -= piece;
+  }
+}
+
+#ifdef SC_HAVE_ZLIB
+
+static void
+sc_vtk_compress_blocks (size_t begin, size_t end, void *data)
+{
+  sc_vtk_compress_t  *vc = (sc_vtk_compress_t *) data;
+  int                 retval;
+  size_t              ib, offset;
+  uLongf              comp_length;
+
+  for (ib = begin; ib < end; ++ib) {
+    offset = ib * SC_VTK_BLOCK_SIZE;
+    comp_length = (uLongf) vc->bound;
+    retval = compress2 ((Bytef *) (vc->comp + ib * vc->bound), &comp_length,
+                        (const Bytef *) (vc->data + offset),
+                        (uLong) SC_MIN (SC_VTK_BLOCK_SIZE,
+                                        vc->byte_length - offset),
+                        vc->level);
+    SC_CHECK_ZLIB (retval);
+    vc->sizes[ib] = (uint64_t) comp_length;
+  }
+}
+
+#endif
+
+size_t
+sc_vtk_appended_add (sc_vtk_appended_t * app, const void *data,
+                     size_t byte_length)
+{
+  size_t              offset;
+  uint64_t            header;
+
+  SC_ASSERT (app != NULL);
+  SC_ASSERT (!app->exscanned);
+  SC_ASSERT (data != NULL || byte_length == 0);
+
+  offset = app->size;
+  *(size_t *) sc_array_push (&app->offsets) = offset;
+
+  if (app->compression == 0) {
+    /* a single header with the data length, then the data itself */
+    header = (uint64_t) byte_length;
+    memcpy (sc_vtk_appended_own (app, sizeof (header)), &header,
+            sizeof (header));
+    sc_vtk_appended_borrow (app, (const char *) data, byte_length);
+  }
+  else {
+#ifdef SC_HAVE_ZLIB
+    size_t              ib, nblocks, lastsize, total;
+    uint64_t           *headers;
+    char               *dest;
+    sc_taskpool_t      *pool;
+    sc_vtk_compress_t   vc;
+
+    nblocks = (byte_length + SC_VTK_BLOCK_SIZE - 1) / SC_VTK_BLOCK_SIZE;
+    lastsize = byte_length % SC_VTK_BLOCK_SIZE;
+
+    /* compress each block into a slot of the maximum compressed size */
+    vc.data = (const char *) data;
+    vc.byte_length = byte_length;
+    vc.bound = (size_t) compressBound ((uLong) SC_VTK_BLOCK_SIZE);
+    vc.level = app->compression;
+    vc.comp = SC_ALLOC (char, SC_MAX (nblocks, 1) * vc.bound);
+    vc.sizes = SC_ALLOC (uint64_t, SC_MAX (nblocks, 1));
+    pool = sc_taskpool_global_lookup ();
+    if (pool != NULL && nblocks > 1) {
+      sc_taskpool_parallel_for (pool, 0, nblocks, 1,
+                                sc_vtk_compress_blocks, &vc);
+    }
+    else {
+      sc_vtk_compress_blocks (0, nblocks, &vc);
+    }
+
+    /* the header lists the block sizes before and after compression */
+    for (total = 0, ib = 0; ib < nblocks; ++ib) {
+      total += (size_t) vc.sizes[ib];
+    }
+    dest = sc_vtk_appended_own (app, (3 + nblocks) * sizeof (uint64_t) +
+                                total);
+    headers = SC_ALLOC (uint64_t, 3 + nblocks);
+    headers[0] = (uint64_t) nblocks;
+    headers[1] = (uint64_t) SC_VTK_BLOCK_SIZE;
+    headers[2] = (uint64_t)
+      (lastsize > 0 || byte_length == 0 ? lastsize : SC_VTK_BLOCK_SIZE);
+    for (ib = 0; ib < nblocks; ++ib) {
+      headers[3 + ib] = vc.sizes[ib];
+    }
+    memcpy (dest, headers, (3 + nblocks) * sizeof (uint64_t));
+    dest += (3 + nblocks) * sizeof (uint64_t);
+    for (ib = 0; ib < nblocks; ++ib) {
+      memcpy (dest, vc.comp + ib * vc.bound, (size_t) vc.sizes[ib]);
+      dest += vc.sizes[ib];
+    }
+
+    SC_FREE (headers);
+    SC_FREE (vc.sizes);
+    SC_FREE (vc.comp);
+#else
+    SC_ABORT_NOT_REACHED ();
+#endif
+  }
+
+  return offset;
+}
+
+size_t
+sc_vtk_appended_offset (sc_vtk_appended_t * app, size_t which)
+{
+  SC_ASSERT (app != NULL);
+  SC_ASSERT (which < app->offsets.elem_count);
+
+  return app->base + *(size_t *) sc_array_index (&app->offsets, which);
+}
+
+size_t
+sc_vtk_appended_size (sc_vtk_appended_t * app)
+{
+  SC_ASSERT (app != NULL);
+
+  return app->size;
+}
+
+/** Return the address of the data of a chunk. */
+static const char  *
+sc_vtk_chunk_data (sc_vtk_appended_t * app, sc_vtk_chunk_t * chunk)
+{
+  if (chunk->data != NULL) {
+    return chunk->data;
+  }
+  return chunk->bytes == 0 ? NULL :
+    (const char *) sc_array_index (&app->owned, chunk->owned);
+}
+
+int
+sc_vtk_appended_write (sc_vtk_appended_t * app, FILE * vtkfile)
+{
+  size_t              iz;
+  sc_vtk_chunk_t     *chunk;
+
+  SC_ASSERT (app != NULL);
+  SC_ASSERT (vtkfile != NULL);
+
+  for (iz = 0; iz < app->chunks.elem_count; ++iz) {
+    chunk = (sc_vtk_chunk_t *) sc_array_index (&app->chunks, iz);
+    if (chunk->bytes > 0 &&
+        fwrite (sc_vtk_chunk_data (app, chunk), 1, chunk->bytes,
+                vtkfile) != chunk->bytes) {
+      return -1;
+    }
+  }
+  if (ferror (vtkfile)) {
+    return -1;
+  }
+  return 0;
+}
+
+int
+sc_vtk_appended_write_sink (sc_vtk_appended_t * app, sc_io_sink_t * sink)
+{
+  int                 retval;
+  size_t              iz;
+  sc_vtk_chunk_t     *chunk;
+
+  SC_ASSERT (app != NULL);
+  SC_ASSERT (sink != NULL);
+
+  for (iz = 0; iz < app->chunks.elem_count; ++iz) {
+    chunk = (sc_vtk_chunk_t *) sc_array_index (&app->chunks, iz);
+    if (chunk->bytes > 0) {
+      retval = sc_io_sink_write (sink, sc_vtk_chunk_data (app, chunk),
+                                 chunk->bytes);
+      if (retval) {
+        return retval;
+      }
+    }
+  }
+  return 0;
+}
+
+size_t
+sc_vtk_appended_exscan (sc_vtk_appended_t * app, sc_MPI_Comm mpicomm)
+{
+  SC_ASSERT (app != NULL);
+  SC_ASSERT (!app->exscanned);
+
+  sc_io_exscan_size (app->size, &app->base, &app->total, mpicomm);
+  app->exscanned = 1;
+
+  return app->total;
+}
+
+#ifdef SC_ENABLE_MPIIO
+
+int
+sc_vtk_write_ordered_mpi (MPI_File mpifile, MPI_Offset * offset,
+                          const char *text, size_t length,
+                          sc_MPI_Comm mpicomm)
+{
+  int                 mpiret;
+  size_t              base, total;
+  sc_MPI_Status       mpistatus;
+
+  SC_ASSERT (offset != NULL);
+  SC_ASSERT (text != NULL || length == 0);
+  SC_ASSERT (length <= (size_t) INT_MAX);
+
+  sc_io_exscan_size (length, &base, &total, mpicomm);
+  mpiret = MPI_File_write_at_all (mpifile, *offset + (MPI_Offset) base,
+                                  (void *) text, (int) length,
+                                  sc_MPI_BYTE, &mpistatus);
+  *offset += (MPI_Offset) total;
+
+  return mpiret != sc_MPI_SUCCESS;
+}
+
+int
+sc_vtk_appended_write_mpi (sc_vtk_appended_t * app, MPI_File mpifile,
+                           MPI_Offset * offset)
+{
+  int                 mpiret, retval;
+  int                *lengths;
+  size_t              iz, count;
+  MPI_Aint           *displs;
+  sc_MPI_Datatype     filetype;
+  sc_MPI_Status       mpistatus;
+  sc_vtk_chunk_t     *chunk;
+
+  SC_ASSERT (app != NULL);
+  SC_ASSERT (app->exscanned);
+  SC_ASSERT (offset != NULL);
+
+  /* describe all chunks in memory by one datatype without copying them */
+  count = app->chunks.elem_count;
+  lengths = SC_ALLOC (int, SC_MAX (count, 1));
+  displs = SC_ALLOC (MPI_Aint, SC_MAX (count, 1));
+  for (iz = 0; iz < count; ++iz) {
+    chunk = (sc_vtk_chunk_t *) sc_array_index (&app->chunks, iz);
+    SC_ASSERT (chunk->bytes <= SC_VTK_CHUNK_MAX);
+    lengths[iz] = (int) chunk->bytes;
+    mpiret = MPI_Get_address ((void *) sc_vtk_chunk_data (app, chunk),
+                              &displs[iz]);
+    SC_CHECK_MPI (mpiret);
+  }
+  mpiret = MPI_Type_create_hindexed ((int) count, lengths, displs,
+                                     sc_MPI_BYTE, &filetype);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Type_commit (&filetype);
+  SC_CHECK_MPI (mpiret);
+
+  retval = MPI_File_write_at_all (mpifile, *offset + (MPI_Offset) app->base,
+                                  MPI_BOTTOM, count > 0 ? 1 : 0, filetype,
+                                  &mpistatus);
+  *offset += (MPI_Offset) app->total;
+
+  mpiret = MPI_Type_free (&filetype);
+  SC_CHECK_MPI (mpiret);
+  SC_FREE (displs);
+  SC_FREE (lengths);
+
+  return retval != sc_MPI_SUCCESS;
+}
+
+#endif
+
+size_t
+sc_io_partition_weighted (size_t total, double weight, sc_MPI_Comm mpicomm)
+{
+  int                 mpiret, rank, size, i;
+  double             *weights, prefix, sum;
+  size_t              begin, end;
+
+  SC_ASSERT (weight >= 0.);
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+
+  /* every process sums all weights in the same order, such that the
+     neighbors compute bit-identical boundaries */
+  weights = SC_ALLOC (double, size);
+  mpiret = sc_MPI_Allgather (&weight, 1, sc_MPI_DOUBLE,
+                             weights, 1, sc_MPI_DOUBLE, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  sum = 0.;
+  for (i = 0; i < size; ++i) {
+    sum += weights[i];
+  }
+  if (sum <= 0.) {
+    for (i = 0; i < size; ++i) {
+      weights[i] = 1.;
+    }
+    sum = (double) size;
+  }
+  prefix = 0.;
+  for (i = 0; i < rank; ++i) {
+    prefix += weights[i];
+  }
+  begin = SC_MIN ((size_t) ((double) total * (prefix / sum)), total);
+  prefix += weights[rank];
+  end = rank == size - 1 ? total :
+    SC_MIN ((size_t) ((double) total * (prefix / sum)), total);
+  SC_FREE (weights);
+
+  return end > begin ? end - begin : 0;
+}
+
+/** The maximum number of bytes in one collective read. */
+#define SC_IO_READ_ROUND ((size_t) 1 << 30)
+
+/** Read the pieces of a redistributed array.
+ * \return             0 on success, nonzero on error.
+ */
+static int
+sc_io_read_pieces (sc_MPI_Comm mpicomm, const char *filename,
+                   sc_array_t * pieces, char *data, size_t bytes)
+{
+  int                 error;
+  size_t              iz;
+  sc_io_range_t      *piece;
+#ifdef SC_ENABLE_MPIIO
+  int                 mpiret, count, num_pieces, round, num_rounds;
+  int                *lengths;
+  size_t              done, n;
+  MPI_Aint           *displs;
+  MPI_File            mpifile;
+  MPI_Datatype        filetype;
+  MPI_Status          mpistatus;
+
+  /* all processes agree on a failed open to stay in the collectives */
+  error = MPI_File_open (mpicomm, (char *) filename, MPI_MODE_RDONLY,
+                         MPI_INFO_NULL, &mpifile) != MPI_SUCCESS;
+  mpiret = sc_MPI_Allreduce (&error, &round, 1, sc_MPI_INT, sc_MPI_MAX,
+                             mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (round) {
+    if (!error) {
+      MPI_File_close (&mpifile);
+    }
+    return -1;
+  }
+
+  /* the file view consists of our pieces */
+  num_pieces = (int) pieces->elem_count;
+  lengths = SC_ALLOC (int, SC_MAX (num_pieces, 1));
+  displs = SC_ALLOC (MPI_Aint, SC_MAX (num_pieces, 1));
+  for (iz = 0; iz < pieces->elem_count; ++iz) {
+    piece = (sc_io_range_t *) sc_array_index (pieces, iz);
+    lengths[iz] = (int) piece->bytes;
+    displs[iz] = (MPI_Aint) piece->offset;
+  }
+  filetype = MPI_BYTE;
+  if (num_pieces > 0) {
+    mpiret = MPI_Type_create_hindexed (num_pieces, lengths, displs,
+                                       MPI_BYTE, &filetype);
+    SC_CHECK_MPI (mpiret);
+    mpiret = MPI_Type_commit (&filetype);
+    SC_CHECK_MPI (mpiret);
+  }
+  error = MPI_File_set_view (mpifile, 0, MPI_BYTE, filetype, "native",
+                             MPI_INFO_NULL) != MPI_SUCCESS;
+
+  /* every process takes part in the same number of collective reads */
+  num_rounds = (int) ((bytes + SC_IO_READ_ROUND - 1) / SC_IO_READ_ROUND);
+  mpiret = sc_MPI_Allreduce (&num_rounds, &round, 1, sc_MPI_INT, sc_MPI_MAX,
+                             mpicomm);
+  SC_CHECK_MPI (mpiret);
+  num_rounds = round;
+  for (round = 0, done = 0; round < num_rounds; ++round, done += n) {
+    n = error ? 0 : SC_MIN (bytes - done, (size_t) SC_IO_READ_ROUND);
+    mpiret = MPI_File_read_at_all (mpifile, (MPI_Offset) done, data + done,
+                                   (int) n, MPI_BYTE, &mpistatus);
+    if (mpiret == MPI_SUCCESS) {
+      mpiret = MPI_Get_count (&mpistatus, MPI_BYTE, &count);
+      SC_CHECK_MPI (mpiret);
+    }
+    error = error || mpiret != MPI_SUCCESS || (size_t) count != n;
+  }
+
+  if (num_pieces > 0) {
+    mpiret = MPI_Type_free (&filetype);
+    SC_CHECK_MPI (mpiret);
+  }
+  SC_FREE (displs);
+  SC_FREE (lengths);
+  error = MPI_File_close (&mpifile) != MPI_SUCCESS || error;
+#else
+  FILE               *file;
+
+  file = fopen (filename, "rb");
+  error = file == NULL;
+  for (iz = 0; !error && iz < pieces->elem_count; ++iz) {
+    piece = (sc_io_range_t *) sc_array_index (pieces, iz);
+    error = fseeko (file, (off_t) piece->offset, SEEK_SET) ||
+      fread (data, 1, piece->bytes, file) != piece->bytes;
+    data += piece->bytes;
+  }
+  if (file != NULL) {
+    error = fclose (file) || error;
+  }
+#endif
+
+  return error;
+}
+
+int
+sc_io_read_redistribute (sc_MPI_Comm mpicomm, const char *filename,
+                         int num_sections, const size_t *section_counts,
+                         const size_t *section_offsets, size_t local_count,
+                         sc_array_t * data)
+{
+  int                 mpiret, error, global;
+  int                 s;
+  size_t              elem_size, begin, total, sbegin, first, last, n;
+  sc_array_t          pieces;
+  sc_io_range_t      *piece;
+
+  SC_ASSERT (filename != NULL);
+  SC_ASSERT (num_sections >= 0);
+  SC_ASSERT (data != NULL);
+  SC_ASSERT (0 < data->elem_size && data->elem_size <= SC_IO_READ_ROUND);
+
+  /* our range of the array and a check of the sections */
+  sc_io_exscan_size (local_count, &begin, &total, mpicomm);
+  elem_size = data->elem_size;
+  sbegin = 0;
+  error = 0;
+  for (s = 0; s < num_sections; ++s) {
+    if (s > 0 && section_offsets[s] < section_offsets[s - 1] +
+        section_counts[s - 1] * elem_size) {
+      error = 1;
+    }
+    sbegin += section_counts[s];
+  }
+  if (error || sbegin != total) {
+    return SC_IO_ERROR_FATAL;
+  }
+
+  /* the overlaps of our range with the sections in file order */
+  sc_array_resize (data, local_count);
+  sc_array_init (&pieces, sizeof (sc_io_range_t));
+  sbegin = 0;
+  for (s = 0; s < num_sections && sbegin < begin + local_count;
+       sbegin += section_counts[s++]) {
+    first = SC_MAX (begin, sbegin);
+    last = SC_MIN (begin + local_count, sbegin + section_counts[s]);
+    for (; first < last; first += n) {
+      /* pieces are limited to what an int counts */
+      n = SC_MIN (last - first, SC_IO_READ_ROUND / elem_size);
+      piece = (sc_io_range_t *) sc_array_push (&pieces);
+      piece->offset = section_offsets[s] + (first - sbegin) * elem_size;
+      piece->bytes = n * elem_size;
+    }
+  }
+
+  error = sc_io_read_pieces (mpicomm, filename, &pieces, data->array,
+                             local_count * elem_size);
+  sc_array_reset (&pieces);
+
+  mpiret = sc_MPI_Allreduce (&error, &global, 1, sc_MPI_INT, sc_MPI_MAX,
+                             mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  return global ? SC_IO_ERROR_FATAL : SC_IO_ERROR_NONE;
+}
+
 void
 sc_fwrite (const void *ptr, size_t size, size_t nmemb, FILE * file,
            const char *errmsg)
@@ -591,4 +2338,58 @@ sc_mpi_write (MPI_File mpifile, const void *ptr, size_t zcount,
 #endif
 }
 
+void
+sc_mpi_writev (MPI_File mpifile, const sc_io_vec_t * vecs, int count,
+               const char *errmsg)
+{
+#ifdef SC_ENABLE_DEBUG
+  int                 icount;
+#endif
+  int                 mpiret, i;
+  int                *lengths;
+  size_t              total;
+  MPI_Aint           *displs;
+  sc_MPI_Datatype     memtype;
+  sc_MPI_Status       mpistatus;
+
+  SC_ASSERT (count >= 0);
+
+  /* describe the pieces by their absolute addresses */
+  lengths = SC_ALLOC (int, SC_MAX (count, 1));
+  displs = SC_ALLOC (MPI_Aint, SC_MAX (count, 1));
+  for (total = 0, i = 0; i < count; ++i) {
+    SC_CHECK_ABORT (vecs[i].bytes <= (size_t) INT_MAX, errmsg);
+    lengths[i] = (int) vecs[i].bytes;
+    total += vecs[i].bytes;
+    mpiret = MPI_Get_address (vecs[i].data, &displs[i]);
+    SC_CHECK_MPI (mpiret);
+  }
+  mpiret = MPI_Type_create_hindexed (count, lengths, displs, sc_MPI_BYTE,
+                                     &memtype);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Type_commit (&memtype);
+  SC_CHECK_MPI (mpiret);
+
+  mpiret = MPI_File_write (mpifile, MPI_BOTTOM, count > 0 ? 1 : 0, memtype,
+                           &mpistatus);
+  SC_CHECK_ABORT (mpiret == sc_MPI_SUCCESS, errmsg);
+
+#ifdef SC_ENABLE_DEBUG
+  /* the byte count is representable only below 2 GiB */
+  if (total <= (size_t) INT_MAX) {
+    MPI_Get_elements (&mpistatus, memtype, &icount);
+    SC_CHECK_ABORT (icount == (int) total, errmsg);
+  }
+  else {
+    sc_MPI_Get_count (&mpistatus, memtype, &icount);
+    SC_CHECK_ABORT (icount == 1, errmsg);
+  }
+#endif
+
+  mpiret = MPI_Type_free (&memtype);
+  SC_CHECK_MPI (mpiret);
+  SC_FREE (displs);
+  SC_FREE (lengths);
+}
+
 #endif
@@ -64,6 +64,13 @@ typedef enum
 }
 sc_io_type_t;
 
+/** Alignment of memory, file offsets and sizes for direct file access. */
+#define SC_IO_DIRECT_ALIGN 4096
+
+/** Default size of the buffers set by \ref sc_io_sink_set_buffer and
+ * \ref sc_io_source_set_buffer. */
+#define SC_IO_BUFFER_DEFAULT (1 << 22)
+
 typedef struct sc_io_sink
 {
   sc_io_type_t        iotype;
@@ -74,6 +81,11 @@ typedef struct sc_io_sink
   FILE               *file;
   size_t              bytes_in;
   size_t              bytes_out;
+  char               *vbuf;     /**< memory owned for file buffering */
+  char               *direct;   /**< aligned buffer in direct mode */
+  size_t              direct_size;      /**< size of the direct buffer */
+  size_t              direct_fill;      /**< bytes held in it */
+  size_t              direct_offset;    /**< file offset of its start */
 }
 sc_io_sink_t;
 
@@ -86,11 +98,37 @@ typedef struct sc_io_source
   FILE               *file;
   size_t              bytes_in;
   size_t              bytes_out;
-  sc_io_sink_t       *mirror;
-  sc_array_t         *mirror_buffer;
+  sc_array_t         *mirror_buffer;    /**< mirrored data of files */
+  sc_array_t         *mirror_chunks;    /**< ranges of a mirrored buffer */
+  size_t              mirror_bytes;     /**< number of bytes mirrored */
+  size_t              mirror_cursor;    /**< chunk found last */
+  size_t              mirror_cursor_start;      /**< its mirror offset */
+  char               *vbuf;     /**< memory owned for file buffering */
+  char               *direct;   /**< aligned buffer in direct mode */
+  size_t              direct_size;      /**< size of the direct buffer */
+  size_t              direct_fill;      /**< bytes held in it */
+  size_t              direct_offset;    /**< file offset of its start */
+  size_t              direct_pos;       /**< file offset of the next read */
 }
 sc_io_source_t;
 
+/** A piece of memory for vectored input and output.
+ * Any number of them can be written or read in one call, which saves
+ * both system calls and packing the data into one buffer.
+ */
+typedef struct sc_io_vec
+{
+  void               *data;     /**< Start of the memory. */
+  size_t              bytes;    /**< Its length in bytes. */
+}
+sc_io_vec_t;
+
+/** Point a vector entry to the memory of an array.
+ * \param [out] vec     The entry covers the elements of the array.
+ * \param [in] array    The array must not be resized while \b vec is used.
+ */
+void                sc_io_vec_array (sc_io_vec_t * vec, sc_array_t * array);
+
 /** Create a generic data sink.
  * \param [in] iotype           Type of the sink.
  *                              Depending on iotype, varargs must follow:
@@ -126,6 +164,28 @@ int                 sc_io_sink_destroy (sc_io_sink_t * sink);
 int                 sc_io_sink_write (sc_io_sink_t * sink,
                                       const void *data, size_t bytes_avail);
 
+/** Write several pieces of memory to a sink one after the other.
+ * The result is the same as calling \ref sc_io_sink_write for each piece.
+ * File sinks are flushed and the pieces are passed to the system in one
+ * writev call where available.
+ * \param [in,out] sink         The sink object to write to.
+ * \param [in] vecs             Array of pieces.
+ * \param [in] count            Number of pieces.
+ * \return                      0 on success, nonzero on error.
+ */
+int                 sc_io_sink_writev (sc_io_sink_t * sink,
+                                       const sc_io_vec_t * vecs, int count);
+
+/** Write the data of several arrays to a sink one after the other.
+ * \param [in,out] sink         The sink object to write to.
+ * \param [in] arrays           Array of pointers to arrays.
+ * \param [in] count            Number of arrays.
+ * \return                      0 on success, nonzero on error.
+ */
+int                 sc_io_sink_write_arrays (sc_io_sink_t * sink,
+                                             sc_array_t ** arrays,
+                                             int count);
+
 /** Flush all buffered output data to sink.
  * This function may return SC_IO_ERROR_AGAIN if another write is required.
  * Currently this may happen if BUFFER requires an integer multiple of bytes.
@@ -156,6 +216,29 @@ int                 sc_io_sink_complete (sc_io_sink_t * sink,
 int                 sc_io_sink_align (sc_io_sink_t * sink,
                                       size_t bytes_align);
 
+/** Set the buffering of a sink of type FILENAME.
+ * This must be called before any data is written to the sink.
+ * In the default mode, the file stream receives a buffer of the given size.
+ * In direct mode, the file is written around the page cache (O_DIRECT)
+ * where the system supports it.  The data are collected in an aligned
+ * buffer and written in whole blocks of \ref SC_IO_DIRECT_ALIGN bytes.
+ * The pieces of the file that are not whole blocks, such as the tail
+ * written by \ref sc_io_sink_complete, go through the page cache.
+ * Writes of at least the buffer size from aligned memory at an aligned
+ * position, which \ref sc_io_sink_align with a multiple of
+ * \ref SC_IO_DIRECT_ALIGN provides, are passed to the file without copy.
+ * \param [in,out] sink         The sink object to configure.
+ * \param [in] bytes            Buffer size, or 0 for
+ *                              \ref SC_IO_BUFFER_DEFAULT.  In direct mode
+ *                              it is rounded up to a multiple of
+ *                              \ref SC_IO_DIRECT_ALIGN.
+ * \param [in] direct           Boolean to select direct mode.
+ * \return                      0 on success, nonzero if the sink is not of
+ *                              type FILENAME or has been written to.
+ */
+int                 sc_io_sink_set_buffer (sc_io_sink_t * sink,
+                                           size_t bytes, int direct);
+
 /** Create a generic data source.
  * \param [in] iotype           Type of the source.
  *                              Depending on iotype, varargs must follow:
@@ -196,6 +279,33 @@ int                 sc_io_source_read (sc_io_source_t * source,
                                        void *data, size_t bytes_avail,
                                        size_t * bytes_out);
 
+/** Read data from a source into several pieces of memory in order.
+ * The result is the same as calling \ref sc_io_source_read for each piece
+ * until one is not filled completely.
+ * \param [in,out] source       The source object to read from.
+ * \param [in] vecs             Array of pieces.  An entry with NULL data
+ *                              skips its number of bytes.
+ * \param [in] count            Number of pieces.
+ * \param [in,out] bytes_out    If not NULL, byte count read in total.
+ *                              Otherwise, requires to fill all pieces.
+ * \return                      0 on success, nonzero on error.
+ */
+int                 sc_io_source_readv (sc_io_source_t * source,
+                                        const sc_io_vec_t * vecs, int count,
+                                        size_t * bytes_out);
+
+/** Read data from a source into several arrays in order.
+ * The arrays must have their final size.
+ * \param [in,out] source       The source object to read from.
+ * \param [in] arrays           Array of pointers to arrays.
+ * \param [in] count            Number of arrays.
+ * \return                      0 on success, nonzero on error or if the
+ *                              arrays could not be filled completely.
+ */
+int                 sc_io_source_read_arrays (sc_io_source_t * source,
+                                              sc_array_t ** arrays,
+                                              int count);
+
 /** Determine whether all data buffered from source has been returned by read.
  * If it returns SC_IO_ERROR_AGAIN, another sc_io_source_read is required.
  * If the call returns no error, the internal counters source->bytes_in and
@@ -223,14 +333,50 @@ int                 sc_io_source_complete (sc_io_source_t * source,
 int                 sc_io_source_align (sc_io_source_t * source,
                                         size_t bytes_align);
 
+/** Set the buffering of a source of type FILENAME.
+ * This must be called before any data is read from the source.
+ * In the default mode, the file stream receives a buffer of the given size.
+ * In direct mode, the file is read around the page cache (O_DIRECT) where
+ * the system supports it, in aligned blocks of the buffer size.
+ * Sources of type FILENAME advise the system of sequential access anyway.
+ * \param [in,out] source       The source object to configure.
+ * \param [in] bytes            Buffer size, or 0 for
+ *                              \ref SC_IO_BUFFER_DEFAULT.  In direct mode
+ *                              it is rounded up to a multiple of
+ *                              \ref SC_IO_DIRECT_ALIGN.
+ * \param [in] direct           Boolean to select direct mode.
+ * \return                      0 on success, nonzero if the source is not
+ *                              of type FILENAME or has been read from.
+ */
+int                 sc_io_source_set_buffer (sc_io_source_t * source,
+                                             size_t bytes, int direct);
+
 /** Activate a buffer that mirrors (i.e., stores) the data that was read.
+ * Data skipped by reading into NULL are not mirrored.
+ * Equivalent to \ref sc_io_source_activate_mirror_bytes with 0 bytes.
  * \param [in,out] source       The source object to activate mirror in.
  * \return                      0 on success, nonzero on error.
  */
 int                 sc_io_source_activate_mirror (sc_io_source_t * source);
 
+/** Activate a mirror of the data read with room for a number of bytes.
+ * The mirror of a source of type BUFFER records which ranges of the
+ * buffer were read and copies nothing; the buffer must not change while
+ * the source exists.  Other sources copy the data into the mirror buffer,
+ * whose element count is the number of bytes mirrored; its memory is
+ * allocated for \b bytes and grows by doubling if necessary.
+ * \param [in,out] source       The source object to activate mirror in.
+ * \param [in] bytes            Expected number of bytes to mirror.
+ * \return                      0 on success, nonzero if a mirror is
+ *                              already active.
+ */
+int                 sc_io_source_activate_mirror_bytes (sc_io_source_t *
+                                                        source,
+                                                        size_t bytes);
+
 /** Read data from the source's mirror.
  * Same behaviour as sc_io_source_read.
+ * Each call reads from the beginning of the mirrored data.
  * \param [in,out] source       The source object to read mirror data from.
  * \return                      0 on success, nonzero on error.
  */
@@ -239,6 +385,74 @@ int                 sc_io_source_read_mirror (sc_io_source_t * source,
                                               size_t bytes_avail,
                                               size_t * bytes_out);
 
+/** Access mirrored data through an array view without copying it.
+ * For sources of type BUFFER the view points into the source buffer and
+ * stays valid with it.  Otherwise it points into the mirror buffer and is
+ * valid until the next read from the source.
+ * \param [in] source           The source object with an active mirror.
+ * \param [in] offset           Byte offset into the mirrored data.
+ * \param [in] bytes            Number of bytes; the range must have been
+ *                              mirrored.
+ * \param [out] view            Initialized as a view of element size 1.
+ * \return                      0 on success, nonzero if the range is not
+ *                              mirrored or, for BUFFER sources, not
+ *                              contiguous in the buffer.
+ */
+int                 sc_io_source_mirror_view (sc_io_source_t * source,
+                                              size_t offset, size_t bytes,
+                                              sc_array_t * view);
+
+/** Encode the elements of an array for storage with a shuffle filter.
+ * The elements are cut into independent blocks of about 64 KiB.  In each
+ * block, the bytes of the elements are transposed, so that the first
+ * bytes of all elements come first, then all second bytes, and so on.
+ * For smooth floating point fields, this groups the slowly changing sign,
+ * exponent and leading mantissa bytes, which compress much better than
+ * the raw data.  Optionally, each element is replaced by its bitwise
+ * exclusive or with the previous one before the transposition.  Each
+ * block is then compressed with zlib.  The blocks are processed in
+ * parallel on the global task pool, both here and when decoding.
+ * The result is self-describing and in native byte order.
+ * \param [in] data         Array of fixed-size elements.
+ * \param [out] out         Array of elem_size 1, resized to the encoding.
+ * \param [in] delta        If true, encode the exclusive or of neighbors.
+ * \param [in] level        0 to only transpose, or a zlib compression
+ *                          level from 1 to 9.  Without zlib, the blocks
+ *                          are stored without compression.
+ */
+void                sc_io_encode_shuffle (sc_array_t * data,
+                                          sc_array_t * out,
+                                          int delta, int level);
+
+/** Decode the output of \ref sc_io_encode_shuffle.
+ * \param [in] in           Array of elem_size 1 with the encoding.
+ * \param [in,out] data     Array whose element size must match the one
+ *                          encoded.  Resized to the number of elements.
+ * \return                  0 on success, nonzero if the encoding is
+ *                          corrupt or does not match \b data.
+ */
+int                 sc_io_decode_shuffle (sc_array_t * in, sc_array_t * data);
+
+/** Write an array to a sink with \ref sc_io_encode_shuffle.
+ * \param [in,out] sink     The sink object to write to.
+ * \param [in] data         Array of fixed-size elements.
+ * \param [in] delta        See \ref sc_io_encode_shuffle.
+ * \param [in] level        See \ref sc_io_encode_shuffle.
+ * \return                  0 on success, nonzero on error.
+ */
+int                 sc_io_sink_write_shuffle (sc_io_sink_t * sink,
+                                              sc_array_t * data,
+                                              int delta, int level);
+
+/** Read an array written by \ref sc_io_sink_write_shuffle from a source.
+ * \param [in,out] source   The source object to read from.
+ * \param [in,out] data     Array whose element size must match the one
+ *                          encoded.  Resized to the number of elements.
+ * \return                  0 on success, nonzero on error.
+ */
+int                 sc_io_source_read_shuffle (sc_io_source_t * source,
+                                               sc_array_t * data);
+
 /** This function writes numeric binary data in VTK base64 encoding.
  * \param vtkfile        Stream openened for writing.
  * \param numeric_data   A pointer to a numeric data array.
@@ -258,6 +472,179 @@ int                 sc_vtk_write_compressed (FILE * vtkfile,
                                              char *numeric_data,
                                              size_t byte_length);
 
+/** The appended data section of a VTK XML file; opaque structure.
+ *
+ * Instead of inline base64 DataArrays, the arrays are written as raw
+ * binary blocks behind the XML markup.  The usage is:
+ * 1. Add all arrays with \ref sc_vtk_appended_add and put the returned
+ *    offsets into the offset attributes of the DataArray elements that
+ *    have format="appended".
+ * 2. Write the XML markup up to and including the line
+ *    <AppendedData encoding="raw">, followed by a single underscore.
+ * 3. Write the data with \ref sc_vtk_appended_write or one of its variants.
+ * 4. Close the AppendedData and VTKFile elements.
+ *
+ * The block headers are 64 bit integers in native byte order, so the
+ * VTKFile element needs the attributes header_type="UInt64" and the
+ * matching byte_order.  If compression is used, it also needs the
+ * attribute compressor="vtkZLibDataCompressor".
+ */
+typedef struct sc_vtk_appended sc_vtk_appended_t;
+
+/** Create an empty appended data section.
+ * \param [in] compression  0 for raw data, or a zlib compression level
+ *                          from 1 (fastest) to 9 (smallest).  Compression
+ *                          requires zlib; otherwise we abort.
+ * \return                  A valid appended section.
+ */
+sc_vtk_appended_t  *sc_vtk_appended_new (int compression);
+
+/** Destroy an appended section.
+ * \param [in,out] app      This object is invalidated.
+ */
+void                sc_vtk_appended_destroy (sc_vtk_appended_t * app);
+
+/** Add an array to the appended section.
+ * Raw data is not copied, so it must stay valid until the section is
+ * written.  Compressed data is compressed immediately, using the threads
+ * of the global task pool for the 32 KiB blocks.
+ * \param [in,out] app      Valid appended section.
+ * \param [in] data         The data of one DataArray.
+ * \param [in] byte_length  The length of the data in bytes.
+ * \return                  The offset of the array in the appended
+ *                          section, relative to the byte after the
+ *                          underscore.  In parallel, the offset is local
+ *                          until \ref sc_vtk_appended_exscan is called.
+ */
+size_t              sc_vtk_appended_add (sc_vtk_appended_t * app,
+                                         const void *data,
+                                         size_t byte_length);
+
+/** Return the offset of an array added before.
+ * \param [in] app          Valid appended section.
+ * \param [in] which        Index of the array in order of addition.
+ * \return                  Its offset, including the base of this process
+ *                          after \ref sc_vtk_appended_exscan.
+ */
+size_t              sc_vtk_appended_offset (sc_vtk_appended_t * app,
+                                            size_t which);
+
+/** Return the number of bytes this section will write.
+ * \param [in] app          Valid appended section.
+ * \return                  Byte count of the local data and block headers.
+ */
+size_t              sc_vtk_appended_size (sc_vtk_appended_t * app);
+
+/** Write the appended section to a stream.
+ * \param [in] app          Valid appended section.
+ * \param [in,out] vtkfile  Stream opened for writing.
+ * \return                  0 on success, -1 on file error.
+ */
+int                 sc_vtk_appended_write (sc_vtk_appended_t * app,
+                                           FILE * vtkfile);
+
+/** Write the appended section to a data sink.
+ * \param [in] app          Valid appended section.
+ * \param [in,out] sink     Valid sink.
+ * \return                  0 on success, nonzero on error.
+ */
+int                 sc_vtk_appended_write_sink (sc_vtk_appended_t * app,
+                                                sc_io_sink_t * sink);
+
+/** Place the appended sections of all processes one after the other.
+ * This function is collective.  Each process obtains the sum of the sizes
+ * of the processes of lower rank by a prefix sum, and adds it to its
+ * offsets.  Afterwards, no more arrays may be added.
+ * \param [in,out] app      Valid appended section.
+ * \param [in] mpicomm      The processes sharing one file.
+ * \return                  The total size of the appended sections.
+ */
+size_t              sc_vtk_appended_exscan (sc_vtk_appended_t * app,
+                                            sc_MPI_Comm mpicomm);
+
+#ifdef SC_ENABLE_MPIIO
+
+/** Write text of all processes into a shared file in order of rank.
+ * This function is collective and may be used for the XML markup.
+ * \param [in] mpifile      MPI file opened for writing.
+ * \param [in,out] offset   On input, the file position to start writing at.
+ *                          On output, the position after the text of all
+ *                          processes.  Must be the same on all processes.
+ * \param [in] text         The text of this process.
+ * \param [in] length       Length of the text; may be 0.
+ * \param [in] mpicomm      The communicator of \b mpifile.
+ * \return                  0 on success, nonzero on error.
+ */
+int                 sc_vtk_write_ordered_mpi (MPI_File mpifile,
+                                              MPI_Offset * offset,
+                                              const char *text,
+                                              size_t length,
+                                              sc_MPI_Comm mpicomm);
+
+/** Write the appended sections of all processes into a shared file.
+ * This function is collective and requires \ref sc_vtk_appended_exscan.
+ * \param [in] app          Valid appended section.
+ * \param [in] mpifile      MPI file opened for writing.
+ * \param [in,out] offset   On input, the file position after the
+ *                          underscore.  On output, the position after the
+ *                          sections of all processes.
+ *                          Must be the same on all processes.
+ * \return                  0 on success, nonzero on error.
+ */
+int                 sc_vtk_appended_write_mpi (sc_vtk_appended_t * app,
+                                               MPI_File mpifile,
+                                               MPI_Offset * offset);
+
+#endif
+
+/** Compute the element count of this process in a weighted partition.
+ * The elements are assigned to the processes in order of rank, and each
+ * process receives a share proportional to its weight.
+ * This function is collective.
+ * \param [in] total        Total number of elements.
+ * \param [in] weight       Nonnegative weight of this process.  If all
+ *                          weights are zero, they are treated as equal.
+ * \param [in] mpicomm      The processes to partition over.
+ * \return                  The number of elements of this process.  The
+ *                          counts of all processes add up to \b total.
+ */
+size_t              sc_io_partition_weighted (size_t total, double weight,
+                                              sc_MPI_Comm mpicomm);
+
+/** Read a distributed array from a file with a new partition.
+ * The file holds the array in sections, usually one per writing process,
+ * whose counts and offsets are known from a header.  Each process names
+ * how many elements it reads, and the processes read consecutive parts
+ * of the array in order of rank.  This function computes which pieces of
+ * which sections each process needs.  With MPI I/O it describes them by
+ * a file view and reads them collectively, and with POSIX calls
+ * otherwise.  The number of readers need not be the number of sections.
+ * This function is collective.
+ * \param [in] mpicomm          The processes that read the file.
+ * \param [in] filename         Name of the file; same on all processes.
+ * \param [in] num_sections     Number of sections in the file.
+ * \param [in] section_counts   Element count of each section.
+ * \param [in] section_offsets  Byte offset of each section in the file.
+ *                              They must be increasing, and the sections
+ *                              must not overlap.  The arrays describing
+ *                              the sections are the same on all processes.
+ * \param [in] local_count      Number of elements to read on this process.
+ *                              The counts of all processes must add up to
+ *                              the total count of the sections.
+ * \param [out] data            Resized to \b local_count elements of its
+ *                              element size, which is the element size in
+ *                              the file, and filled with the data.
+ * \return                      0 on success, nonzero on error.  The value
+ *                              is the same on all processes.
+ */
+int                 sc_io_read_redistribute (sc_MPI_Comm mpicomm,
+                                             const char *filename,
+                                             int num_sections,
+                                             const size_t *section_counts,
+                                             const size_t *section_offsets,
+                                             size_t local_count,
+                                             sc_array_t * data);
+
 /** Write memory content to a file.
  * \param [in] ptr      Data array to write to disk.
  * \param [in] size     Size of one array member.
@@ -294,6 +681,18 @@ void                sc_mpi_write (MPI_File mpifile, const void *ptr,
                                   size_t zcount, sc_MPI_Datatype t,
                                   const char *errmsg);
 
+/** Write several pieces of memory to an MPI file in one call.
+ * The pieces are described by one hindexed datatype without copying.
+ * \param [in,out] mpifile      MPI file object opened for writing.
+ * \param [in] vecs     Array of pieces; each must be less than 2 GiB.
+ * \param [in] count    Number of pieces.
+ * \param [in] errmsg   Error message passed to SC_CHECK_ABORT.
+ * \note                This function aborts on MPI file and count errors.
+ */
+void                sc_mpi_writev (MPI_File mpifile,
+                                   const sc_io_vec_t * vecs, int count,
+                                   const char *errmsg);
+
 #endif
 
 SC_EXTERN_C_END;
@@ -492,6 +492,22 @@ sc_MPI_Waitall (int count, sc_MPI_Request * array_of_requests,
   return sc_MPI_SUCCESS;
 }
 
+int
+sc_MPI_Testsome (int incount, sc_MPI_Request * array_of_requests,
+                 int *outcount, int *array_of_indices,
+                 sc_MPI_Status * array_of_statuses)
+{
+  int                 i;
+
+  for (i = 0; i < incount; ++i) {
+    SC_CHECK_ABORT (array_of_requests[i] == sc_MPI_REQUEST_NULL,
+                    "non-MPI MPI_Testsome handles NULL requests only");
+  }
+  *outcount = 0;
+
+  return sc_MPI_SUCCESS;
+}
+
 double
 sc_MPI_Wtime (void)
 {
@@ -62,6 +62,8 @@ typedef enum
   SC_TAG_REDUCE = SC_TAG_NOTIFY_NARY + 32,
   SC_TAG_PSORT_LO,
   SC_TAG_PSORT_HI,
+  SC_TAG_DHT_REQUEST,
+  SC_TAG_DHT_REPLY,
   SC_TAG_LAST
 }
 sc_tag_t;
@@ -182,6 +184,7 @@ sc_tag_t;
 #define sc_MPI_Wtime               MPI_Wtime
 #define sc_MPI_Wait                MPI_Wait
 #define sc_MPI_Waitsome            MPI_Waitsome
+#define sc_MPI_Testsome            MPI_Testsome
 #define sc_MPI_Waitall             MPI_Waitall
 
 #else /* !SC_ENABLE_MPI */
@@ -349,6 +352,8 @@ int                 sc_MPI_Wait (sc_MPI_Request *, sc_MPI_Status *);
 int                 sc_MPI_Waitsome (int, sc_MPI_Request *,
                                      int *, int *, sc_MPI_Status *);
 int                 sc_MPI_Waitall (int, sc_MPI_Request *, sc_MPI_Status *);
+int                 sc_MPI_Testsome (int, sc_MPI_Request *,
+                                     int *, int *, sc_MPI_Status *);
 
 #endif /* !SC_ENABLE_MPI */
 
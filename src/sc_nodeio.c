@@ -0,0 +1,473 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_nodeio.h>
+#include <sc_containers.h>
+#include <sc_private.h>
+#include <errno.h>
+#include <fcntl.h>
+
+/** The default stripe size of the file system. */
+#define SC_NODEIO_STRIPE ((size_t) 1 << 20)
+
+/** The number of stripes the aggregators write at most at a time. */
+#define SC_NODEIO_STRIPES 4
+
+/** A piece of data received by an aggregator. */
+typedef struct sc_nodeio_piece
+{
+  size_t              offset;
+  size_t              bytes;
+  const char         *data;
+}
+sc_nodeio_piece_t;
+
+struct sc_nodeio
+{
+  sc_MPI_Comm         mpicomm;
+  sc_MPI_Comm         groupcomm;        /**< an aggregator and its clients */
+  int                 grouprank, groupsize;
+  int                 shared;   /**< the group can share memory */
+  int                 error;    /**< an aggregator write failed */
+  size_t              stripe;
+  size_t              position; /**< for ordered writes */
+
+  /* data of aggregators only */
+  size_t              stage_offset;     /**< file offset of the stage */
+  size_t              stage_bytes;      /**< bytes in the stage */
+  char               *stage;    /**< pieces are merged here */
+#ifdef SC_ENABLE_MPIIO
+  sc_MPI_Comm         aggcomm;
+  MPI_File            mpifile;
+#else
+  int                 fd;
+#endif
+};
+
+/** Combine the error flags of all processes. */
+static int
+sc_nodeio_agree (sc_MPI_Comm mpicomm, int error)
+{
+  int                 mpiret, global;
+
+  mpiret = sc_MPI_Allreduce (&error, &global, 1, sc_MPI_INT, sc_MPI_MAX,
+                             mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  return global;
+}
+
+sc_nodeio_t        *
+sc_nodeio_open (sc_MPI_Comm mpicomm, const char *filename,
+                int aggregators, size_t stripe_size)
+{
+  int                 mpiret, error;
+  int                 intrarank, intrasize;
+  sc_MPI_Comm         intranode, internode;
+  sc_nodeio_t        *nio;
+
+  SC_ASSERT (filename != NULL);
+
+  nio = SC_ALLOC_ZERO (sc_nodeio_t, 1);
+  nio->mpicomm = mpicomm;
+  nio->stripe = stripe_size > 0 ? stripe_size : SC_NODEIO_STRIPE;
+  SC_CHECK_ABORT (nio->stripe * SC_NODEIO_STRIPES <= (size_t) INT_MAX,
+                  "sc_nodeio stripe size too large");
+
+  /* split each node into groups of consecutive processes */
+  sc_mpi_comm_get_node_comms (mpicomm, &intranode, &internode);
+  if (intranode == sc_MPI_COMM_NULL) {
+    mpiret = sc_MPI_Comm_dup (sc_MPI_COMM_SELF, &nio->groupcomm);
+    SC_CHECK_MPI (mpiret);
+  }
+  else {
+    mpiret = sc_MPI_Comm_rank (intranode, &intrarank);
+    SC_CHECK_MPI (mpiret);
+    mpiret = sc_MPI_Comm_size (intranode, &intrasize);
+    SC_CHECK_MPI (mpiret);
+    aggregators = SC_MAX (1, SC_MIN (aggregators, intrasize));
+    mpiret = sc_MPI_Comm_split (intranode, (int) ((long) intrarank *
+                                                  aggregators / intrasize),
+                                intrarank, &nio->groupcomm);
+    SC_CHECK_MPI (mpiret);
+  }
+  mpiret = sc_MPI_Comm_rank (nio->groupcomm, &nio->grouprank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (nio->groupcomm, &nio->groupsize);
+  SC_CHECK_MPI (mpiret);
+#if defined(SC_ENABLE_MPIWINSHARED) && defined(SC_ENABLE_MPICOMMSHARED)
+  if (intranode != sc_MPI_COMM_NULL) {
+    int                 sharedsize;
+    MPI_Comm            sharedcomm;
+
+    /* node communicators of a given size need not share memory:
+       use a window only if the whole group is one shared domain */
+    mpiret = MPI_Comm_split_type (nio->groupcomm, MPI_COMM_TYPE_SHARED,
+                                  nio->grouprank, MPI_INFO_NULL,
+                                  &sharedcomm);
+    SC_CHECK_MPI (mpiret);
+    mpiret = MPI_Comm_size (sharedcomm, &sharedsize);
+    SC_CHECK_MPI (mpiret);
+    mpiret = MPI_Comm_free (&sharedcomm);
+    SC_CHECK_MPI (mpiret);
+    nio->shared = (sharedsize == nio->groupsize);
+  }
+#endif
+
+  /* only the aggregators open the file */
+  error = 0;
+#ifdef SC_ENABLE_MPIIO
+  nio->aggcomm = sc_MPI_COMM_NULL;
+  nio->mpifile = MPI_FILE_NULL;
+  mpiret = sc_MPI_Comm_split (mpicomm, nio->grouprank == 0 ? 0 :
+                              sc_MPI_UNDEFINED, 0, &nio->aggcomm);
+  SC_CHECK_MPI (mpiret);
+  if (nio->grouprank == 0) {
+    char                value[32];
+    MPI_Info            info;
+
+    snprintf (value, 32, "%lu", (unsigned long) nio->stripe);
+    mpiret = MPI_Info_create (&info);
+    SC_CHECK_MPI (mpiret);
+    mpiret = MPI_Info_set (info, "striping_unit", value);
+    SC_CHECK_MPI (mpiret);
+    mpiret = MPI_File_open (nio->aggcomm, (char *) filename,
+                            MPI_MODE_WRONLY | MPI_MODE_CREATE, info,
+                            &nio->mpifile);
+    if (mpiret == sc_MPI_SUCCESS) {
+      error = MPI_File_set_size (nio->mpifile, 0) != sc_MPI_SUCCESS;
+    }
+    else {
+      error = 1;
+    }
+    mpiret = MPI_Info_free (&info);
+    SC_CHECK_MPI (mpiret);
+  }
+#else
+  nio->fd = -1;
+  {
+    int                 rank;
+
+    /* the first process truncates the file before anyone writes */
+    mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+    SC_CHECK_MPI (mpiret);
+    if (rank == 0) {
+      nio->fd = open (filename, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+      error = nio->fd < 0;
+      if (!error && nio->grouprank != 0) {
+        close (nio->fd);
+        nio->fd = -1;
+      }
+    }
+    error = sc_nodeio_agree (mpicomm, error);
+  }
+  if (!error && nio->grouprank == 0 && nio->fd < 0) {
+    nio->fd = open (filename, O_WRONLY);
+    error = nio->fd < 0;
+  }
+#endif
+  if (sc_nodeio_agree (mpicomm, error)) {
+    nio->error = 1;
+    (void) sc_nodeio_close (nio);
+    return NULL;
+  }
+
+  if (nio->grouprank == 0) {
+    nio->stage = SC_ALLOC (char, nio->stripe * SC_NODEIO_STRIPES);
+  }
+  return nio;
+}
+
+int
+sc_nodeio_close (sc_nodeio_t * nio)
+{
+  int                 mpiret, error;
+
+  SC_ASSERT (nio != NULL);
+  SC_ASSERT (nio->stage_bytes == 0);
+
+  error = nio->error;
+#ifdef SC_ENABLE_MPIIO
+  if (nio->mpifile != MPI_FILE_NULL) {
+    error = MPI_File_close (&nio->mpifile) != sc_MPI_SUCCESS || error;
+  }
+  if (nio->aggcomm != sc_MPI_COMM_NULL) {
+    mpiret = sc_MPI_Comm_free (&nio->aggcomm);
+    SC_CHECK_MPI (mpiret);
+  }
+#else
+  if (nio->fd >= 0) {
+    error = close (nio->fd) != 0 || error;
+  }
+#endif
+  error = sc_nodeio_agree (nio->mpicomm, error);
+
+  mpiret = sc_MPI_Comm_free (&nio->groupcomm);
+  SC_CHECK_MPI (mpiret);
+  SC_FREE (nio->stage);
+  SC_FREE (nio);
+
+  return error;
+}
+
+/** Write a contiguous range of the file on an aggregator. */
+static void
+sc_nodeio_pwrite (sc_nodeio_t * nio, size_t offset, const char *data,
+                  size_t bytes)
+{
+#ifdef SC_ENABLE_MPIIO
+  int                 mpiret, count;
+  sc_MPI_Status       mpistatus;
+
+  mpiret = MPI_File_write_at (nio->mpifile, (MPI_Offset) offset,
+                              (void *) data, (int) bytes, sc_MPI_BYTE,
+                              &mpistatus);
+  if (mpiret != sc_MPI_SUCCESS) {
+    nio->error = 1;
+    return;
+  }
+  mpiret = sc_MPI_Get_count (&mpistatus, sc_MPI_BYTE, &count);
+  SC_CHECK_MPI (mpiret);
+  if (count != (int) bytes) {
+    nio->error = 1;
+  }
+#else
+  ssize_t             written;
+
+  while (bytes > 0) {
+    written = pwrite (nio->fd, data, bytes, (off_t) offset);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      nio->error = 1;
+      return;
+    }
+    offset += (size_t) written;
+    data += written;
+    bytes -= (size_t) written;
+  }
+#endif
+}
+
+/** Write out the merged pieces in the stage. */
+static void
+sc_nodeio_flush (sc_nodeio_t * nio)
+{
+  if (nio->stage_bytes > 0) {
+    sc_nodeio_pwrite (nio, nio->stage_offset, nio->stage, nio->stage_bytes);
+    nio->stage_bytes = 0;
+  }
+}
+
+/** Pass a piece of data through the stage of an aggregator.
+ * The file is cut into windows of a few stripes, aligned to the stripe
+ * size.  We write a window directly from the piece if the piece covers
+ * it, and merge adjacent pieces in the stage otherwise.
+ */
+static void
+sc_nodeio_put (sc_nodeio_t * nio, size_t offset, const char *data,
+               size_t bytes)
+{
+  size_t              start, wend, n;
+
+  while (bytes > 0) {
+    if (nio->stage_bytes > 0 &&
+        offset != nio->stage_offset + nio->stage_bytes) {
+      sc_nodeio_flush (nio);
+    }
+    start = nio->stage_bytes > 0 ? nio->stage_offset : offset;
+    wend = (start / nio->stripe) * nio->stripe +
+      nio->stripe * SC_NODEIO_STRIPES;
+    n = SC_MIN (bytes, wend - offset);
+    if (nio->stage_bytes == 0 && offset + n == wend) {
+      sc_nodeio_pwrite (nio, offset, data, n);
+    }
+    else {
+      if (nio->stage_bytes == 0) {
+        nio->stage_offset = offset;
+      }
+      memcpy (nio->stage + nio->stage_bytes, data, n);
+      nio->stage_bytes += n;
+      if (offset + n == wend) {
+        sc_nodeio_flush (nio);
+      }
+    }
+    offset += n;
+    data += n;
+    bytes -= n;
+  }
+}
+
+static int
+sc_nodeio_piece_compare (const void *v1, const void *v2)
+{
+  const sc_nodeio_piece_t *p1 = (const sc_nodeio_piece_t *) v1;
+  const sc_nodeio_piece_t *p2 = (const sc_nodeio_piece_t *) v2;
+
+  return p1->offset < p2->offset ? -1 : p1->offset > p2->offset;
+}
+
+/** Write the pieces of a group on its aggregator in order of offset. */
+static void
+sc_nodeio_put_pieces (sc_nodeio_t * nio, sc_array_t * pieces)
+{
+  size_t              iz;
+  sc_nodeio_piece_t  *piece;
+
+  sc_array_sort (pieces, sc_nodeio_piece_compare);
+  for (iz = 0; iz < pieces->elem_count; ++iz) {
+    piece = (sc_nodeio_piece_t *) sc_array_index (pieces, iz);
+    sc_nodeio_put (nio, piece->offset, piece->data, piece->bytes);
+  }
+  sc_nodeio_flush (nio);
+}
+
+int
+sc_nodeio_write_at (sc_nodeio_t * nio, size_t offset, const void *data,
+                    size_t bytes)
+{
+  int                 mpiret, q;
+  unsigned long long  range[2], *ranges = NULL;
+  sc_array_t         *pieces = NULL;
+  sc_nodeio_piece_t  *piece;
+
+  SC_ASSERT (nio != NULL);
+  SC_ASSERT (data != NULL || bytes == 0);
+
+  /* the aggregator learns where each piece goes */
+  range[0] = (unsigned long long) offset;
+  range[1] = (unsigned long long) bytes;
+  if (nio->grouprank == 0) {
+    ranges = SC_ALLOC (unsigned long long, 2 * nio->groupsize);
+    pieces = sc_array_new_count (sizeof (sc_nodeio_piece_t),
+                                 (size_t) nio->groupsize);
+  }
+  mpiret = sc_MPI_Gather (range, 2, sc_MPI_UNSIGNED_LONG_LONG,
+                          ranges, 2, sc_MPI_UNSIGNED_LONG_LONG, 0,
+                          nio->groupcomm);
+  SC_CHECK_MPI (mpiret);
+  if (nio->grouprank == 0) {
+    for (q = 0; q < nio->groupsize; ++q) {
+      piece = (sc_nodeio_piece_t *) sc_array_index_int (pieces, q);
+      piece->offset = (size_t) ranges[2 * q];
+      piece->bytes = (size_t) ranges[2 * q + 1];
+      piece->data = NULL;
+    }
+  }
+
+#ifdef SC_ENABLE_MPIWINSHARED
+  if (nio->shared) {
+    char               *base;
+    int                 disp_unit;
+    MPI_Aint            winsize;
+    MPI_Win             win;
+
+    /* each process copies its data into its own part of a window */
+    mpiret = MPI_Win_allocate_shared ((MPI_Aint) bytes, 1, MPI_INFO_NULL,
+                                      nio->groupcomm, &base, &win);
+    SC_CHECK_MPI (mpiret);
+    if (bytes > 0) {
+      memcpy (base, data, bytes);
+    }
+    mpiret = MPI_Win_fence (0, win);
+    SC_CHECK_MPI (mpiret);
+    if (nio->grouprank == 0) {
+      for (q = 0; q < nio->groupsize; ++q) {
+        piece = (sc_nodeio_piece_t *) sc_array_index_int (pieces, q);
+        mpiret = MPI_Win_shared_query (win, q, &winsize, &disp_unit, &base);
+        SC_CHECK_MPI (mpiret);
+        piece->data = base;
+      }
+      sc_nodeio_put_pieces (nio, pieces);
+    }
+    mpiret = MPI_Win_fence (0, win);
+    SC_CHECK_MPI (mpiret);
+    mpiret = MPI_Win_free (&win);
+    SC_CHECK_MPI (mpiret);
+  }
+  else
+#endif
+  {
+    int                *counts = NULL, *displs = NULL;
+    char               *buffer = NULL;
+    size_t              total = 0;
+
+    /* the aggregator gathers the data of its group */
+    if (nio->grouprank == 0) {
+      counts = SC_ALLOC (int, nio->groupsize);
+      displs = SC_ALLOC (int, nio->groupsize);
+      for (q = 0; q < nio->groupsize; ++q) {
+        piece = (sc_nodeio_piece_t *) sc_array_index_int (pieces, q);
+        SC_CHECK_ABORT (total + piece->bytes <= (size_t) INT_MAX,
+                        "sc_nodeio gather too large");
+        counts[q] = (int) piece->bytes;
+        displs[q] = (int) total;
+        total += piece->bytes;
+      }
+      buffer = SC_ALLOC (char, SC_MAX (total, 1));
+      for (q = 0; q < nio->groupsize; ++q) {
+        piece = (sc_nodeio_piece_t *) sc_array_index_int (pieces, q);
+        piece->data = buffer + displs[q];
+      }
+    }
+    mpiret = sc_MPI_Gatherv ((void *) data, (int) bytes, sc_MPI_BYTE,
+                             buffer, counts, displs, sc_MPI_BYTE, 0,
+                             nio->groupcomm);
+    SC_CHECK_MPI (mpiret);
+    if (nio->grouprank == 0) {
+      sc_nodeio_put_pieces (nio, pieces);
+      SC_FREE (buffer);
+      SC_FREE (displs);
+      SC_FREE (counts);
+    }
+  }
+
+  if (nio->grouprank == 0) {
+    sc_array_destroy (pieces);
+    SC_FREE (ranges);
+  }
+  return sc_nodeio_agree (nio->mpicomm, nio->error);
+}
+
+int
+sc_nodeio_write_ordered (sc_nodeio_t * nio, const void *data, size_t bytes)
+{
+  size_t              base, total;
+
+  SC_ASSERT (nio != NULL);
+
+  /* the data goes behind the data of the lower processes */
+  sc_io_exscan_size (bytes, &base, &total, nio->mpicomm);
+  base += nio->position;
+  nio->position += total;
+  return sc_nodeio_write_at (nio, base, data, bytes);
+}
+
+size_t
+sc_nodeio_position (sc_nodeio_t * nio)
+{
+  SC_ASSERT (nio != NULL);
+
+  return nio->position;
+}
@@ -0,0 +1,111 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef SC_NODEIO_H
+#define SC_NODEIO_H
+
+/** \file sc_nodeio.h
+ * This file provides collective writes to a shared file through a few
+ * aggregator processes per node.
+ *
+ * When every process writes its own part of a file, a parallel file
+ * system has to serve as many clients as there are processes.  Here, the
+ * processes of a node are split into groups of consecutive ranks, and
+ * only the first process of each group opens the file.  The others pass
+ * their data to it in a shared memory window if node communicators from
+ * \ref sc_mpi_comm_attach_node_comms are attached, MPI 3 is available and
+ * the whole group shares memory, and with a gather otherwise.  The
+ * aggregator sorts the pieces by file offset, merges adjacent ones, and
+ * writes them in pieces that do not cross stripe boundaries needlessly.
+ *
+ * If MPI I/O is available, the aggregators write with it, and POSIX
+ * calls are used otherwise.  Without attached node communicators, every
+ * process is its own aggregator.
+ */
+
+#include <sc.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** A file opened for aggregated writing; opaque structure. */
+typedef struct sc_nodeio sc_nodeio_t;
+
+/** Open a file for aggregated writing.  The file is created or truncated.
+ * This function is collective.
+ * \param [in] mpicomm      The processes that write the file.
+ * \param [in] filename     Name of the file; same on all processes.
+ * \param [in] aggregators  Number of aggregators per node.  It is reduced
+ *                          to the number of processes of the node if
+ *                          necessary.  Values less than 1 mean 1.
+ * \param [in] stripe_size  Stripe size of the file system in bytes, or 0
+ *                          for a default of 1 MiB.  Passed to MPI I/O as
+ *                          the striping_unit hint.
+ * \return                  A valid object, or NULL if the file could not
+ *                          be opened on some process.
+ */
+sc_nodeio_t        *sc_nodeio_open (sc_MPI_Comm mpicomm,
+                                    const char *filename,
+                                    int aggregators, size_t stripe_size);
+
+/** Close a file opened by \ref sc_nodeio_open.
+ * This function is collective.
+ * \param [in,out] nio      This object is invalidated.
+ * \return                  0 on success, nonzero if closing failed on
+ *                          some process.
+ */
+int                 sc_nodeio_close (sc_nodeio_t * nio);
+
+/** Write the data of each process at a file offset of its own choice.
+ * This function is collective.  The ranges of the processes must not
+ * overlap.
+ * \param [in,out] nio      Valid object.
+ * \param [in] offset       File offset to write the data of this process.
+ * \param [in] data         Data of this process.
+ * \param [in] bytes        Number of bytes; may be 0.
+ * \return                  0 on success, nonzero if writing failed on
+ *                          some process.
+ */
+int                 sc_nodeio_write_at (sc_nodeio_t * nio, size_t offset,
+                                        const void *data, size_t bytes);
+
+/** Write the data of all processes one after the other in rank order.
+ * This function is collective.  The data is placed at the current
+ * position, which starts at zero and is advanced by the total size.
+ * \param [in,out] nio      Valid object.
+ * \param [in] data         Data of this process.
+ * \param [in] bytes        Number of bytes; may be 0.
+ * \return                  0 on success, nonzero if writing failed on
+ *                          some process.
+ */
+int                 sc_nodeio_write_ordered (sc_nodeio_t * nio,
+                                             const void *data, size_t bytes);
+
+/** Return the current position of ordered writes.
+ * \param [in] nio          Valid object.
+ * \return                  The total size of all ordered writes so far.
+ */
+size_t              sc_nodeio_position (sc_nodeio_t * nio);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_NODEIO_H */
@@ -27,6 +27,7 @@
 int                 sc_notify_nary_ntop = 2;
 int                 sc_notify_nary_nint = 2;
 int                 sc_notify_nary_nbot = 2;
+int                 sc_notify_compress = 0;
 
 #if 0
 
@@ -369,6 +370,222 @@ sc_notify_merge (sc_array_t * output, sc_array_t * input, sc_array_t * second,
   SC_ASSERT (ir == (int) second->elem_count);
 }
 
+/** Append one non-negative integer in variable-byte format.
+ * Each byte carries 7 bits of the value, lowest first, and the high bit
+ * of a byte is set if more bytes follow.
+ */
+static unsigned char *
+sc_notify_put_varint (unsigned char *pbyte, unsigned value)
+{
+  while (value >= 0x80) {
+    *pbyte++ = (unsigned char) (value | 0x80);
+    value >>= 7;
+  }
+  *pbyte++ = (unsigned char) value;
+  return pbyte;
+}
+
+/** Read one integer in variable-byte format.
+ * Single-byte values, the common case for clustered ranks, take no loop.
+ */
+static const unsigned char *
+sc_notify_get_varint (const unsigned char *pbyte, unsigned *value)
+{
+  int                 shift;
+  unsigned            v;
+
+  if (!(*pbyte & 0x80)) {
+    *value = *pbyte;
+    return pbyte + 1;
+  }
+  v = *pbyte++ & 0x7F;
+  shift = 7;
+  do {
+    v |= (unsigned) (*pbyte & 0x7F) << shift;
+    shift += 7;
+  }
+  while (*pbyte++ & 0x80);
+  *value = v;
+  return pbyte;
+}
+
+/** Compress an array of variable-length records in place.
+ * The records have the format documented with \ref sc_notify_merge.
+ * The toranks and the fromranks in each record are ascending; we store
+ * their differences minus one.  The count of fromranks is stored minus one.
+ * The payload may be negative and is stored in zigzag format.
+ * All numbers are then written in variable-byte format.
+ * \param [in,out] array    On input, array of integer records.
+ *                          On output, array of bytes holding the encoding.
+ * \param [in] withp        Boolean to indicate a payload in the records.
+ */
+static void
+sc_notify_encode (sc_array_t * array, int withp)
+{
+  int                 i, j;
+  int                 num_ints;
+  int                 multi;
+  int                 torank, numfroms, fromrank;
+  int                *pint;
+  unsigned char      *pbyte;
+  sc_array_t          bytes;
+
+  SC_ASSERT (array != NULL && array->elem_size == sizeof (int));
+  SC_ASSERT (SC_ARRAY_IS_OWNER (array));
+
+  multi = 1 + withp;
+  num_ints = (int) array->elem_count;
+
+  /* each 32-bit number occupies at most five bytes */
+  sc_array_init_count (&bytes, 1, 5 * (size_t) num_ints);
+  pbyte = (unsigned char *) bytes.array;
+  pint = (int *) array->array;
+  torank = -1;
+  for (i = 0; i < num_ints;) {
+    SC_ASSERT (torank < pint[i]);
+    pbyte = sc_notify_put_varint (pbyte, (unsigned) (pint[i] - torank - 1));
+    torank = pint[i];
+    numfroms = pint[i + 1];
+    SC_ASSERT (numfroms > 0);
+    pbyte = sc_notify_put_varint (pbyte, (unsigned) (numfroms - 1));
+    i += 2;
+    fromrank = -1;
+    for (j = 0; j < numfroms; ++j, i += multi) {
+      SC_ASSERT (fromrank < pint[i]);
+      pbyte = sc_notify_put_varint (pbyte,
+                                    (unsigned) (pint[i] - fromrank - 1));
+      fromrank = pint[i];
+      if (withp) {
+        pbyte = sc_notify_put_varint (pbyte, ((unsigned) pint[i + 1] << 1) ^
+                                      (unsigned) -(pint[i + 1] < 0));
+      }
+    }
+  }
+  SC_ASSERT (i == num_ints);
+  sc_array_resize (&bytes, (size_t) (pbyte - (unsigned char *) bytes.array));
+
+  sc_array_reset (array);
+  *array = bytes;
+}
+
+/** Expand a byte array produced by \ref sc_notify_encode.
+ * \param [out] array       Array of integers, resized to the records.
+ * \param [in] bytes        Encoded input data.
+ * \param [in] num_bytes    Number of encoded bytes.
+ * \param [in] withp        Boolean to indicate a payload in the records.
+ */
+static void
+sc_notify_decode (sc_array_t * array, const unsigned char *bytes,
+                  size_t num_bytes, int withp)
+{
+  int                 j;
+  int                 torank, numfroms, fromrank;
+  int                *pint, *pout;
+  unsigned            value;
+  const unsigned char *pbyte, *pend;
+
+  SC_ASSERT (array != NULL && array->elem_size == sizeof (int));
+  SC_ASSERT (bytes != NULL || num_bytes == 0);
+
+  /* each encoded number occupies at least one byte */
+  sc_array_resize (array, num_bytes);
+  pint = pout = (int *) array->array;
+  pbyte = bytes;
+  pend = bytes + num_bytes;
+  torank = -1;
+  while (pbyte < pend) {
+    pbyte = sc_notify_get_varint (pbyte, &value);
+    torank += (int) value + 1;
+    *pout++ = torank;
+    pbyte = sc_notify_get_varint (pbyte, &value);
+    numfroms = (int) value + 1;
+    *pout++ = numfroms;
+    fromrank = -1;
+    for (j = 0; j < numfroms; ++j) {
+      pbyte = sc_notify_get_varint (pbyte, &value);
+      fromrank += (int) value + 1;
+      *pout++ = fromrank;
+      if (withp) {
+        pbyte = sc_notify_get_varint (pbyte, &value);
+        *pout++ = (int) (value >> 1) ^ -(int) (value & 1);
+      }
+    }
+    SC_ASSERT (pbyte <= pend);
+  }
+  sc_array_resize (array, (size_t) (pout - pint));
+}
+
+/** Receive a message of notify records that has been probed for.
+ * Depending on \ref sc_notify_compress it is sent raw or encoded.
+ * \param [in,out] recvbuf  Initialized integer array, resized on output.
+ * \param [in] withp        Boolean to indicate a payload in the records.
+ * \param [in] instatus     Status returned by the matching probe.
+ * \param [in] tag          Message tag.
+ * \param [in] mpicomm      Communicator to use.
+ */
+static void
+sc_notify_recv (sc_array_t * recvbuf, int withp, sc_MPI_Status * instatus,
+                int tag, sc_MPI_Comm mpicomm)
+{
+  int                 mpiret;
+  int                 count;
+  sc_array_t          bytes;
+
+  SC_ASSERT (recvbuf != NULL && recvbuf->elem_size == sizeof (int));
+
+  if (!sc_notify_compress) {
+    mpiret = sc_MPI_Get_count (instatus, sc_MPI_INT, &count);
+    SC_CHECK_MPI (mpiret);
+    sc_array_resize (recvbuf, (size_t) count);
+    mpiret = sc_MPI_Recv (recvbuf->array, count, sc_MPI_INT,
+                          instatus->MPI_SOURCE, tag, mpicomm,
+                          sc_MPI_STATUS_IGNORE);
+    SC_CHECK_MPI (mpiret);
+  }
+  else {
+    mpiret = sc_MPI_Get_count (instatus, sc_MPI_BYTE, &count);
+    SC_CHECK_MPI (mpiret);
+    sc_array_init_count (&bytes, 1, (size_t) count);
+    mpiret = sc_MPI_Recv (bytes.array, count, sc_MPI_BYTE,
+                          instatus->MPI_SOURCE, tag, mpicomm,
+                          sc_MPI_STATUS_IGNORE);
+    SC_CHECK_MPI (mpiret);
+    sc_notify_decode (recvbuf, (unsigned char *) bytes.array,
+                      bytes.elem_count, withp);
+    sc_array_reset (&bytes);
+  }
+}
+
+/** Post the send of a message of notify records.
+ * If \ref sc_notify_compress is true, the buffer is encoded in place.
+ * \param [in,out] sendbuf  Integer array of records.  Must stay alive
+ *                          until the request is completed.
+ * \param [in] withp        Boolean to indicate a payload in the records.
+ * \param [in] peer         Destination rank.
+ * \param [in] tag          Message tag.
+ * \param [in] mpicomm      Communicator to use.
+ * \param [out] request     Request to complete later.
+ */
+static void
+sc_notify_isend (sc_array_t * sendbuf, int withp, int peer, int tag,
+                 sc_MPI_Comm mpicomm, sc_MPI_Request * request)
+{
+  int                 mpiret;
+
+  SC_ASSERT (sendbuf != NULL && sendbuf->elem_size == sizeof (int));
+
+  if (!sc_notify_compress) {
+    mpiret = sc_MPI_Isend (sendbuf->array, (int) sendbuf->elem_count,
+                           sc_MPI_INT, peer, tag, mpicomm, request);
+  }
+  else {
+    sc_notify_encode (sendbuf, withp);
+    mpiret = sc_MPI_Isend (sendbuf->array, (int) sendbuf->elem_count,
+                           sc_MPI_BYTE, peer, tag, mpicomm, request);
+  }
+  SC_CHECK_MPI (mpiret);
+}
+
 /** Internally used function to execute the sc_notify recursion.
  * The internal data format of the input and output arrays is as follows:
  * forall(torank): (torank, howmanyfroms, listoffromranks).
@@ -392,7 +609,7 @@ sc_notify_recursive (sc_MPI_Comm mpicomm, int start, int me, int length,
   int                 j, fromrank, num_out;
 #endif
   int                 peer, peer2, source;
-  int                 tag, count;
+  int                 tag;
   int                *pint, *pout;
   sc_array_t         *sendbuf, *recvbuf, morebuf;
   sc_MPI_Request      outrequest;
@@ -463,9 +680,7 @@ sc_notify_recursive (sc_MPI_Comm mpicomm, int start, int me, int length,
         }
         i += 2 + numfroms;
       }
-      mpiret = sc_MPI_Isend (sendbuf->array, (int) sendbuf->elem_count,
-                             sc_MPI_INT, peer, tag, mpicomm, &outrequest);
-      SC_CHECK_MPI (mpiret);
+      sc_notify_isend (sendbuf, 0, peer, tag, mpicomm, &outrequest);
     }
 
     recvbuf = sc_array_new (sizeof (int));
@@ -475,12 +690,7 @@ sc_notify_recursive (sc_MPI_Comm mpicomm, int start, int me, int length,
       SC_CHECK_MPI (mpiret);
       source = instatus.MPI_SOURCE;
       SC_ASSERT (source >= 0 && (source == peer || source == peer2));
-      mpiret = sc_MPI_Get_count (&instatus, sc_MPI_INT, &count);
-      SC_CHECK_MPI (mpiret);
-      sc_array_resize (recvbuf, (size_t) count);
-      mpiret = sc_MPI_Recv (recvbuf->array, count, sc_MPI_INT, source,
-                            tag, mpicomm, sc_MPI_STATUS_IGNORE);
-      SC_CHECK_MPI (mpiret);
+      sc_notify_recv (recvbuf, 0, &instatus, tag, mpicomm);
 
       if (peer2 >= 0) {
         /* merge the owned and received arrays */
@@ -492,12 +702,7 @@ sc_notify_recursive (sc_MPI_Comm mpicomm, int start, int me, int length,
         source = (source == peer2 ? peer : peer2);
         mpiret = sc_MPI_Probe (source, tag, mpicomm, &instatus);
         SC_CHECK_MPI (mpiret);
-        mpiret = sc_MPI_Get_count (&instatus, sc_MPI_INT, &count);
-        SC_CHECK_MPI (mpiret);
-        sc_array_resize (recvbuf, (size_t) count);
-        mpiret = sc_MPI_Recv (recvbuf->array, count, sc_MPI_INT, source,
-                              tag, mpicomm, sc_MPI_STATUS_IGNORE);
-        SC_CHECK_MPI (mpiret);
+        sc_notify_recv (recvbuf, 0, &instatus, tag, mpicomm);
 
         /* merge the second received array */
         sc_notify_merge (array, &morebuf, recvbuf, 0);
@@ -765,9 +970,7 @@ sc_notify_recursive_nary (const sc_notify_nary_t * nary, int level,
           continue;
         }
       }
-      mpiret = sc_MPI_Isend (sendbuf->array, (int) sendbuf->elem_count,
-                             sc_MPI_INT, peer, tag, mpicomm, sendreq);
-      SC_CHECK_MPI (mpiret);
+      sc_notify_isend (sendbuf, nary->withp, peer, tag, mpicomm, sendreq);
       ++i;
     }
     SC_ASSERT (i == nsent);
@@ -797,13 +1000,9 @@ sc_notify_recursive_nary (const sc_notify_nary_t * nary, int level,
         j = divn + (source % length) / lengthn;
         SC_ASSERT (divn <= j && j < nrecv + 1);
       }
-      mpiret = sc_MPI_Get_count (&instatus, sc_MPI_INT, &count);
-      SC_CHECK_MPI (mpiret);
       recvbuf = (sc_array_t *) sc_array_index_int (&recvbufs, j);
-      sc_array_init_count (recvbuf, sizeof (int), (size_t) count);
-      mpiret = sc_MPI_Recv (recvbuf->array, count, sc_MPI_INT, source,
-                            tag, mpicomm, sc_MPI_STATUS_IGNORE);
-      SC_CHECK_MPI (mpiret);
+      sc_array_init (recvbuf, sizeof (int));
+      sc_notify_recv (recvbuf, nary->withp, &instatus, tag, mpicomm);
     }
 
     /* run binary tree for a recursive merge of received data arrays */
@@ -974,3 +1173,147 @@ sc_notify_ext (sc_array_t * receivers, sc_array_t * senders,
   sc_notify_reset_output (array, (int *) senders->array, &num_senders,
                           payload, mpisize, mpirank);
 }
+
+int
+sc_notify_onesided (int *receivers, int num_receivers,
+                    int *senders, int *num_senders, sc_MPI_Comm mpicomm)
+{
+  sc_array_t          reca, snda;
+
+  SC_ASSERT (receivers != NULL || num_receivers == 0);
+  SC_ASSERT (num_receivers >= 0);
+  sc_array_init_data (&reca, receivers, sizeof (int), num_receivers);
+
+  SC_ASSERT (senders != NULL && num_senders != NULL);
+  sc_array_init (&snda, sizeof (int));
+
+  sc_notify_onesided_ext (&reca, &snda, NULL, mpicomm);
+  sc_array_reset (&reca);
+
+  *num_senders = (int) snda.elem_count;
+  memcpy (senders, snda.array, *num_senders * sizeof (int));
+  sc_array_reset (&snda);
+
+  return sc_MPI_SUCCESS;
+}
+
+void
+sc_notify_onesided_ext (sc_array_t * receivers, sc_array_t * senders,
+                        sc_array_t * payload, sc_MPI_Comm mpicomm)
+{
+#ifndef SC_ENABLE_MPIONESIDED
+  sc_notify_ext (receivers, senders, payload,
+                 sc_notify_nary_ntop, sc_notify_nary_nint,
+                 sc_notify_nary_nbot, mpicomm);
+#else
+  const int           one = 1;
+  int                 i;
+  int                 mpiret;
+  int                 mpisize, mpirank;
+  int                 withp, multi;
+  int                 rec;
+  int                 num_receivers, num_senders;
+  int                *recv, *slots, *entries;
+  int                *counter, *slotbuf;
+  MPI_Win             win;
+
+  SC_ASSERT (receivers != NULL && receivers->elem_size == sizeof (int));
+  SC_ASSERT (senders == NULL || senders->elem_size == sizeof (int));
+
+  num_receivers = (int) receivers->elem_count;
+  if (senders == NULL) {
+    SC_ASSERT (SC_ARRAY_IS_OWNER (receivers));
+  }
+  else {
+    SC_ASSERT (SC_ARRAY_IS_OWNER (senders));
+    sc_array_reset (senders);
+  }
+
+  SC_ASSERT (payload == NULL ||
+             (SC_ARRAY_IS_OWNER (payload) &&
+              payload->elem_size == sizeof (int) &&
+              (int) payload->elem_count == num_receivers));
+  withp = payload != NULL;
+  multi = 1 + withp;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  /* pack our rank and payload once for all receivers */
+  recv = (int *) receivers->array;
+  slots = SC_ALLOC (int, num_receivers);
+  entries = SC_ALLOC (int, multi * num_receivers);
+  rec = -1;
+  for (i = 0; i < num_receivers; ++i) {
+    SC_ASSERT (rec < recv[i]);
+    rec = recv[i];
+    SC_ASSERT (0 <= rec && rec < mpisize);
+    entries[multi * i] = mpirank;
+    if (withp) {
+      entries[multi * i + 1] = *(int *) sc_array_index_int (payload, i);
+    }
+  }
+
+  /* first epoch: each sender draws a unique slot at each of its receivers */
+  mpiret = MPI_Win_allocate (sizeof (int), sizeof (int), MPI_INFO_NULL,
+                             mpicomm, (void *) &counter, &win);
+  SC_CHECK_MPI (mpiret);
+  *counter = 0;
+  mpiret = MPI_Win_fence (MPI_MODE_NOPRECEDE, win);
+  SC_CHECK_MPI (mpiret);
+  for (i = 0; i < num_receivers; ++i) {
+    mpiret = MPI_Fetch_and_op ((void *) &one, slots + i, MPI_INT,
+                               recv[i], 0, MPI_SUM, win);
+    SC_CHECK_MPI (mpiret);
+  }
+  mpiret = MPI_Win_fence (MPI_MODE_NOSUCCEED, win);
+  SC_CHECK_MPI (mpiret);
+  num_senders = *counter;
+  SC_ASSERT (0 <= num_senders && num_senders <= mpisize);
+  mpiret = MPI_Win_free (&win);
+  SC_CHECK_MPI (mpiret);
+
+  /* second epoch: deposit rank and payload into the drawn slots */
+  mpiret = MPI_Win_allocate ((MPI_Aint) (multi * num_senders * sizeof (int)),
+                             sizeof (int), MPI_INFO_NULL,
+                             mpicomm, (void *) &slotbuf, &win);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Win_fence (MPI_MODE_NOPRECEDE, win);
+  SC_CHECK_MPI (mpiret);
+  for (i = 0; i < num_receivers; ++i) {
+    mpiret = MPI_Put (entries + multi * i, multi, MPI_INT, recv[i],
+                      (MPI_Aint) (multi * slots[i]), multi, MPI_INT, win);
+    SC_CHECK_MPI (mpiret);
+  }
+  mpiret = MPI_Win_fence (MPI_MODE_NOSUCCEED, win);
+  SC_CHECK_MPI (mpiret);
+  SC_FREE (slots);
+  SC_FREE (entries);
+
+  /* slots are filled in arbitrary order; the first int is the sender */
+  qsort (slotbuf, (size_t) num_senders, multi * sizeof (int),
+         sc_int_compare);
+
+  /* convert window content to output variables */
+  if (senders == NULL) {
+    sc_array_reset (receivers);
+    senders = receivers;
+  }
+  SC_ASSERT (senders != NULL && senders->elem_count == 0);
+  sc_array_resize (senders, (size_t) num_senders);
+  if (withp) {
+    sc_array_resize (payload, (size_t) num_senders);
+  }
+  for (i = 0; i < num_senders; ++i) {
+    SC_ASSERT (i == 0 || slotbuf[multi * (i - 1)] < slotbuf[multi * i]);
+    *(int *) sc_array_index_int (senders, i) = slotbuf[multi * i];
+    if (withp) {
+      *(int *) sc_array_index_int (payload, i) = slotbuf[multi * i + 1];
+    }
+  }
+  mpiret = MPI_Win_free (&win);
+  SC_CHECK_MPI (mpiret);
+#endif
+}
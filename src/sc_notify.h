@@ -37,6 +37,14 @@ extern int          sc_notify_nary_nint;
 /** Number of children at deepest level of tree; initialized to 2 */
 extern int          sc_notify_nary_nbot;
 
+/** Boolean to compress the messages of \ref sc_notify and \ref sc_notify_ext;
+ * initialized to 0.  If set, the sorted rank lists are delta encoded and
+ * written in a variable-byte format, which shrinks the message volume
+ * severalfold for clustered communication patterns.
+ * Must have the same value on all processes of a call.
+ */
+extern int          sc_notify_compress;
+
 /** Collective call to notify a set of receiver ranks of current rank.
  * This version uses one call to sc_MPI_Allgather and one to sc_MPI_Allgatherv.
  * We provide hand-coded alternatives \ref sc_notify and \ref sc_notify_nary.
@@ -52,6 +60,24 @@ int                 sc_notify_allgather (int *receivers, int num_receivers,
                                          int *senders, int *num_senders,
                                          sc_MPI_Comm mpicomm);
 
+/** Collective call to notify a set of receiver ranks of current rank.
+ * This version uses MPI-3 one-sided communication and is intended for
+ * dense communication patterns, where most ranks talk to many others.
+ * It has the same semantics as \ref sc_notify_allgather and calls
+ * \ref sc_notify_onesided_ext internally.
+ * \param [in] receivers        Sorted and unique array of MPI ranks to inform.
+ * \param [in] num_receivers    Count of ranks contained in receivers.
+ * \param [in,out] senders      Array of at least size sc_MPI_Comm_size.
+ *                              On output it contains the notifying ranks,
+ *                              whose number is returned in \b num_senders.
+ * \param [out] num_senders     On output the number of notifying ranks.
+ * \param [in] mpicomm          MPI communicator to use.
+ * \return                      Aborts on MPI error or returns sc_MPI_SUCCESS.
+ */
+int                 sc_notify_onesided (int *receivers, int num_receivers,
+                                        int *senders, int *num_senders,
+                                        sc_MPI_Comm mpicomm);
+
 /** Collective call to notify a set of receiver ranks of current rank.
  * This implementation uses an n-ary tree for reduced latency.
  * It chooses external global parameters to call \ref sc_notify_ext, namely
@@ -127,6 +153,28 @@ void                sc_notify_ext (sc_array_t * receivers,
                                    int ntop, int nint, int nbot,
                                    sc_MPI_Comm mpicomm);
 
+/** Collective call to notify a set of receiver ranks of current rank.
+ * This is the one-sided counterpart of \ref sc_notify_ext.
+ * Every process exposes a counter in an RMA window.  In a first fence epoch,
+ * each process increments the counter of each of its receivers by
+ * MPI_Fetch_and_op, which yields a unique slot at that receiver.
+ * After the fence every process knows its number of senders and exposes
+ * a second window of that many slots.  In a second fence epoch, each process
+ * puts its rank and optional payload into its slot at each receiver.
+ * The result is read and sorted locally; no tree traversal is needed.
+ * Without MPI-3 one-sided support (configure result SC_ENABLE_MPIONESIDED)
+ * we fall back to \ref sc_notify_ext with the global nary parameters.
+ * \param [in,out] receivers    See \ref sc_notify_ext.
+ * \param [in,out] senders      See \ref sc_notify_ext.
+ * \param [in,out] payload      See \ref sc_notify_ext.
+ * \param [in] mpicomm          MPI communicator to use.
+ *                              This function aborts on MPI error.
+ */
+void                sc_notify_onesided_ext (sc_array_t * receivers,
+                                            sc_array_t * senders,
+                                            sc_array_t * payload,
+                                            sc_MPI_Comm mpicomm);
+
 SC_EXTERN_C_END;
 
 #endif /* !SC_NOTIFY_H */
@@ -0,0 +1,426 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_overlap.h>
+#include <sc_containers.h>
+
+#if defined SC_ENABLE_PTHREAD && defined SC_ENABLE_MPI && \
+    defined SC_ENABLE_MPITHREAD
+#define SC_OVERLAP_THREAD
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+typedef struct sc_overlap_msg
+{
+  int                 rank;
+  void               *buffer;
+  size_t              bytes;
+}
+sc_overlap_msg_t;
+
+struct sc_overlap
+{
+  sc_MPI_Comm         mpicomm;
+  int                 mpirank;
+  int                 tag;
+  int                 progress;
+
+  /* registered messages of type sc_overlap_msg_t */
+  sc_array_t          recvs, sends;
+
+  /* requests of one run: remote receives first, then remote sends */
+  sc_array_t          requests;
+  sc_array_t          rindex;
+  sc_array_t          indices;
+  int                 num_rreqs;
+
+#ifdef SC_OVERLAP_THREAD
+  /* the progress thread appends completed receive requests to ready */
+  pthread_t           thread;
+  pthread_mutex_t     mutex;
+  pthread_cond_t      cond;
+  sc_array_t          ready;
+#endif
+};
+
+sc_overlap_t       *
+sc_overlap_new (sc_MPI_Comm mpicomm, int tag)
+{
+  int                 mpiret;
+  sc_overlap_t       *ov;
+
+  ov = SC_ALLOC_ZERO (sc_overlap_t, 1);
+  ov->mpicomm = mpicomm;
+  ov->tag = tag;
+  mpiret = sc_MPI_Comm_rank (mpicomm, &ov->mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  sc_array_init (&ov->recvs, sizeof (sc_overlap_msg_t));
+  sc_array_init (&ov->sends, sizeof (sc_overlap_msg_t));
+  sc_array_init (&ov->requests, sizeof (sc_MPI_Request));
+  sc_array_init (&ov->rindex, sizeof (int));
+  sc_array_init (&ov->indices, sizeof (int));
+#ifdef SC_OVERLAP_THREAD
+  pthread_mutex_init (&ov->mutex, NULL);
+  pthread_cond_init (&ov->cond, NULL);
+  sc_array_init (&ov->ready, sizeof (int));
+#endif
+
+  return ov;
+}
+
+void
+sc_overlap_destroy (sc_overlap_t * ov)
+{
+  SC_ASSERT (ov != NULL);
+
+  sc_array_reset (&ov->recvs);
+  sc_array_reset (&ov->sends);
+  sc_array_reset (&ov->requests);
+  sc_array_reset (&ov->rindex);
+  sc_array_reset (&ov->indices);
+#ifdef SC_OVERLAP_THREAD
+  sc_array_reset (&ov->ready);
+  pthread_cond_destroy (&ov->cond);
+  pthread_mutex_destroy (&ov->mutex);
+#endif
+
+  SC_FREE (ov);
+}
+
+void
+sc_overlap_add_recv (sc_overlap_t * ov, int rank, void *buffer, size_t bytes)
+{
+  sc_overlap_msg_t   *msg;
+
+  SC_ASSERT (ov != NULL);
+  SC_ASSERT (rank >= 0);
+  SC_ASSERT (buffer != NULL || bytes == 0);
+  SC_ASSERT (bytes <= (size_t) INT_MAX);
+
+  msg = (sc_overlap_msg_t *) sc_array_push (&ov->recvs);
+  msg->rank = rank;
+  msg->buffer = buffer;
+  msg->bytes = bytes;
+}
+
+void
+sc_overlap_add_send (sc_overlap_t * ov, int rank,
+                     const void *buffer, size_t bytes)
+{
+  sc_overlap_msg_t   *msg;
+
+  SC_ASSERT (ov != NULL);
+  SC_ASSERT (rank >= 0);
+  SC_ASSERT (buffer != NULL || bytes == 0);
+  SC_ASSERT (bytes <= (size_t) INT_MAX);
+
+  msg = (sc_overlap_msg_t *) sc_array_push (&ov->sends);
+  msg->rank = rank;
+  msg->buffer = (void *) buffer;
+  msg->bytes = bytes;
+}
+
+int
+sc_overlap_set_progress (sc_overlap_t * ov, int progress)
+{
+#ifdef SC_OVERLAP_THREAD
+  int                 mpiret;
+  int                 provided;
+#endif
+
+  SC_ASSERT (ov != NULL);
+
+  ov->progress = 0;
+#ifdef SC_OVERLAP_THREAD
+  if (progress) {
+    mpiret = MPI_Query_thread (&provided);
+    SC_CHECK_MPI (mpiret);
+    ov->progress = (provided == MPI_THREAD_MULTIPLE);
+  }
+#endif
+
+  return ov->progress;
+}
+
+/** Post all remote messages and copy the messages to ourselves. */
+static void
+sc_overlap_post (sc_overlap_t * ov)
+{
+  int                 mpiret;
+  int                 i, k;
+  int                 num_recvs, num_sends;
+  int                 num_self_recvs, num_self_sends;
+  sc_overlap_msg_t   *msg, *self;
+  sc_MPI_Request     *req;
+
+  num_recvs = (int) ov->recvs.elem_count;
+  num_sends = (int) ov->sends.elem_count;
+  sc_array_truncate (&ov->requests);
+  sc_array_truncate (&ov->rindex);
+
+  num_self_recvs = 0;
+  for (i = 0; i < num_recvs; ++i) {
+    msg = (sc_overlap_msg_t *) sc_array_index_int (&ov->recvs, i);
+    if (msg->rank == ov->mpirank) {
+      ++num_self_recvs;
+      continue;
+    }
+    req = (sc_MPI_Request *) sc_array_push (&ov->requests);
+    mpiret = sc_MPI_Irecv (msg->buffer, (int) msg->bytes, sc_MPI_BYTE,
+                           msg->rank, ov->tag, ov->mpicomm, req);
+    SC_CHECK_MPI (mpiret);
+    *(int *) sc_array_push (&ov->rindex) = i;
+  }
+  ov->num_rreqs = (int) ov->requests.elem_count;
+
+  /* the k-th send to ourselves matches the k-th receive from ourselves */
+  k = 0;
+  num_self_sends = 0;
+  self = NULL;
+  for (i = 0; i < num_sends; ++i) {
+    msg = (sc_overlap_msg_t *) sc_array_index_int (&ov->sends, i);
+    if (msg->rank == ov->mpirank) {
+      for (; k < num_recvs; ++k) {
+        self = (sc_overlap_msg_t *) sc_array_index_int (&ov->recvs, k);
+        if (self->rank == ov->mpirank) {
+          break;
+        }
+      }
+      SC_CHECK_ABORT (k < num_recvs, "Overlap self send without receive");
+      SC_CHECK_ABORT (self->bytes == msg->bytes, "Overlap self size");
+      if (msg->bytes > 0) {
+        memcpy (self->buffer, msg->buffer, msg->bytes);
+      }
+      ++num_self_sends;
+      ++k;
+      continue;
+    }
+    req = (sc_MPI_Request *) sc_array_push (&ov->requests);
+    mpiret = sc_MPI_Isend (msg->buffer, (int) msg->bytes, sc_MPI_BYTE,
+                           msg->rank, ov->tag, ov->mpicomm, req);
+    SC_CHECK_MPI (mpiret);
+  }
+
+  SC_CHECK_ABORT (num_self_sends == num_self_recvs,
+                  "Overlap self receive without send");
+
+  sc_array_resize (&ov->indices, ov->requests.elem_count);
+}
+
+/** Call the receive function for a completed receive request. */
+static void
+sc_overlap_deliver (sc_overlap_t * ov, int request,
+                    sc_overlap_recv_t recv_fn, void *user)
+{
+  sc_overlap_msg_t   *msg;
+
+  SC_ASSERT (0 <= request && request < ov->num_rreqs);
+
+  if (recv_fn != NULL) {
+    msg = (sc_overlap_msg_t *) sc_array_index_int
+      (&ov->recvs, *(int *) sc_array_index_int (&ov->rindex, request));
+    recv_fn (msg->rank, msg->buffer, msg->bytes, user);
+  }
+}
+
+/** Test or wait for some requests and deliver completed receives.
+ * \return          Number of delivered receives.
+ */
+static int
+sc_overlap_poll (sc_overlap_t * ov, int wait,
+                 sc_overlap_recv_t recv_fn, void *user)
+{
+  int                 mpiret;
+  int                 i, outcount;
+  int                 delivered;
+  int                *indices;
+
+  indices = (int *) ov->indices.array;
+  if (wait) {
+    mpiret = sc_MPI_Waitsome ((int) ov->requests.elem_count,
+                              (sc_MPI_Request *) ov->requests.array,
+                              &outcount, indices, sc_MPI_STATUSES_IGNORE);
+  }
+  else {
+    mpiret = sc_MPI_Testsome ((int) ov->requests.elem_count,
+                              (sc_MPI_Request *) ov->requests.array,
+                              &outcount, indices, sc_MPI_STATUSES_IGNORE);
+  }
+  SC_CHECK_MPI (mpiret);
+
+  delivered = 0;
+  if (outcount != sc_MPI_UNDEFINED) {
+    for (i = 0; i < outcount; ++i) {
+      if (indices[i] < ov->num_rreqs) {
+        sc_overlap_deliver (ov, indices[i], recv_fn, user);
+        ++delivered;
+      }
+    }
+  }
+  return delivered;
+}
+
+#ifdef SC_OVERLAP_THREAD
+
+static void        *
+sc_overlap_progress_main (void *v)
+{
+  sc_overlap_t       *ov = (sc_overlap_t *) v;
+  int                 mpiret;
+  int                 i, outcount;
+  int                 remaining;
+  int                *indices;
+
+  indices = (int *) ov->indices.array;
+  remaining = (int) ov->requests.elem_count;
+  while (remaining > 0) {
+    mpiret = MPI_Testsome ((int) ov->requests.elem_count,
+                           (MPI_Request *) ov->requests.array,
+                           &outcount, indices, MPI_STATUSES_IGNORE);
+    SC_CHECK_MPI (mpiret);
+    if (outcount == MPI_UNDEFINED || outcount == 0) {
+      sched_yield ();
+      continue;
+    }
+    remaining -= outcount;
+
+    pthread_mutex_lock (&ov->mutex);
+    for (i = 0; i < outcount; ++i) {
+      if (indices[i] < ov->num_rreqs) {
+        *(int *) sc_array_push (&ov->ready) = indices[i];
+      }
+    }
+    pthread_cond_signal (&ov->cond);
+    pthread_mutex_unlock (&ov->mutex);
+  }
+
+  return NULL;
+}
+
+/** Deliver the receives completed by the progress thread.
+ * \return          Number of delivered receives.
+ */
+static int
+sc_overlap_drain (sc_overlap_t * ov, int wait,
+                  sc_overlap_recv_t recv_fn, void *user)
+{
+  int                 i, num_ready;
+  int                 delivered;
+  sc_array_t          ready;
+
+  pthread_mutex_lock (&ov->mutex);
+  while (wait && ov->ready.elem_count == 0) {
+    pthread_cond_wait (&ov->cond, &ov->mutex);
+  }
+  ready = ov->ready;
+  sc_array_init (&ov->ready, sizeof (int));
+  pthread_mutex_unlock (&ov->mutex);
+
+  /* the callbacks run without holding the lock */
+  delivered = 0;
+  num_ready = (int) ready.elem_count;
+  for (i = 0; i < num_ready; ++i) {
+    sc_overlap_deliver (ov, *(int *) sc_array_index_int (&ready, i),
+                        recv_fn, user);
+    ++delivered;
+  }
+  sc_array_reset (&ready);
+  return delivered;
+}
+
+#endif /* SC_OVERLAP_THREAD */
+
+void
+sc_overlap_run (sc_overlap_t * ov, size_t num_interior, size_t chunk,
+                sc_range_function_t interior_fn,
+                sc_overlap_recv_t recv_fn, void *user)
+{
+  int                 i;
+  int                 mpiret;
+  int                 num_recvs;
+  int                 delivered;
+  size_t              begin, end;
+  sc_overlap_msg_t   *msg;
+#ifdef SC_OVERLAP_THREAD
+  int                 threaded;
+  int                 pth;
+#endif
+
+  SC_ASSERT (ov != NULL);
+  SC_ASSERT (interior_fn != NULL || num_interior == 0);
+
+  /* start all communication and handle the data sent to ourselves */
+  sc_overlap_post (ov);
+#ifdef SC_OVERLAP_THREAD
+  threaded = ov->progress && ov->requests.elem_count > 0;
+  if (threaded) {
+    pth = pthread_create (&ov->thread, NULL, sc_overlap_progress_main, ov);
+    SC_CHECK_ABORT (pth == 0, "Overlap progress thread creation");
+  }
+#endif
+  num_recvs = (int) ov->recvs.elem_count;
+  for (i = 0; i < num_recvs; ++i) {
+    msg = (sc_overlap_msg_t *) sc_array_index_int (&ov->recvs, i);
+    if (msg->rank == ov->mpirank && recv_fn != NULL) {
+      recv_fn (msg->rank, msg->buffer, msg->bytes, user);
+    }
+  }
+
+  /* work on the interior and look for messages in between */
+  delivered = 0;
+  for (begin = 0; begin < num_interior; begin = end) {
+    end = chunk == 0 ? num_interior : SC_MIN (begin + chunk, num_interior);
+    interior_fn (begin, end, user);
+#ifdef SC_OVERLAP_THREAD
+    if (threaded) {
+      delivered += sc_overlap_drain (ov, 0, recv_fn, user);
+      continue;
+    }
+#endif
+    if (delivered < ov->num_rreqs) {
+      delivered += sc_overlap_poll (ov, 0, recv_fn, user);
+    }
+  }
+
+  /* the interior is done and we wait for the remaining messages */
+#ifdef SC_OVERLAP_THREAD
+  if (threaded) {
+    while (delivered < ov->num_rreqs) {
+      delivered += sc_overlap_drain (ov, 1, recv_fn, user);
+    }
+    pth = pthread_join (ov->thread, NULL);
+    SC_CHECK_ABORT (pth == 0, "Overlap progress thread join");
+    SC_ASSERT (ov->ready.elem_count == 0);
+    return;
+  }
+#endif
+  while (delivered < ov->num_rreqs) {
+    delivered += sc_overlap_poll (ov, 1, recv_fn, user);
+  }
+  mpiret = sc_MPI_Waitall ((int) ov->requests.elem_count,
+                           (sc_MPI_Request *) ov->requests.array,
+                           sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+}
@@ -0,0 +1,128 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef SC_OVERLAP_H
+#define SC_OVERLAP_H
+
+/** \file sc_overlap.h
+ * This file provides a driver to overlap computation with communication.
+ *
+ * A typical use is the ghost exchange of a stencil code.  The messages to
+ * and from the neighbor processes are registered once.  Each call to
+ * \ref sc_overlap_run posts all of them, works on the interior of the local
+ * domain in chunks while the messages are in flight, and calls a function
+ * for each received message as soon as it is complete.  The boundary work
+ * that depends on a neighbor's data is then done in that function.
+ *
+ * Between the chunks of interior work, we poll for completed messages.
+ * Alternatively, a dedicated progress thread drives the communication if
+ * MPI provides MPI_THREAD_MULTIPLE and the library is built with pthreads.
+ * All user functions are called by the thread that calls sc_overlap_run.
+ *
+ * Messages to the own rank are copied in the order they are added.
+ */
+
+#include <sc_taskpool.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** The overlap driver is an opaque structure. */
+typedef struct sc_overlap sc_overlap_t;
+
+/** Function called when a message has been received.
+ * \param [in] rank     The sending process.
+ * \param [in] buffer   The buffer registered with \ref sc_overlap_add_recv.
+ * \param [in] bytes    The size registered with \ref sc_overlap_add_recv.
+ * \param [in] user     User data passed to \ref sc_overlap_run.
+ */
+typedef void        (*sc_overlap_recv_t) (int rank, void *buffer,
+                                          size_t bytes, void *user);
+
+/** Create a new overlap driver without any messages.
+ * \param [in] mpicomm      Communicator to use for all messages.
+ * \param [in] tag          Tag to use for all messages.
+ * \return                  A valid driver.
+ */
+sc_overlap_t       *sc_overlap_new (sc_MPI_Comm mpicomm, int tag);
+
+/** Destroy an overlap driver.  The buffers are not touched.
+ * \param [in,out] ov       This driver is invalidated.
+ */
+void                sc_overlap_destroy (sc_overlap_t * ov);
+
+/** Register a message to receive on each run.
+ * At most one message per peer may be registered.
+ * \param [in,out] ov       Valid driver.
+ * \param [in] rank         The sending process.
+ * \param [out] buffer      Receive buffer; must stay valid while the
+ *                          driver is used.
+ * \param [in] bytes        Size of the message.
+ */
+void                sc_overlap_add_recv (sc_overlap_t * ov, int rank,
+                                         void *buffer, size_t bytes);
+
+/** Register a message to send on each run.
+ * At most one message per peer may be registered.
+ * \param [in,out] ov       Valid driver.
+ * \param [in] rank         The receiving process.
+ * \param [in] buffer       Send buffer; must stay valid while the
+ *                          driver is used.  Its content is read on each
+ *                          run, so it may change between runs.
+ * \param [in] bytes        Size of the message.
+ */
+void                sc_overlap_add_send (sc_overlap_t * ov, int rank,
+                                         const void *buffer, size_t bytes);
+
+/** Request a progress thread for subsequent runs.
+ * The request is only honored if the library is built with pthreads and
+ * MPI reports MPI_THREAD_MULTIPLE; otherwise we poll between chunks.
+ * \param [in,out] ov       Valid driver.
+ * \param [in] progress     Boolean to request a progress thread.
+ * \return                  True if a progress thread will be used.
+ */
+int                 sc_overlap_set_progress (sc_overlap_t * ov,
+                                             int progress);
+
+/** Exchange all registered messages while working on the interior.
+ * This function is collective over the processes that have registered
+ * matching messages with each other.
+ * \param [in,out] ov           Valid driver.
+ * \param [in] num_interior     Number of interior work items.
+ * \param [in] chunk            Number of items to process between two
+ *                              polls for messages.  If 0, everything is
+ *                              processed in one chunk.
+ * \param [in] interior_fn      Called on consecutive subranges of
+ *                              [0, num_interior); may be NULL if
+ *                              \b num_interior is 0.
+ * \param [in] recv_fn          Called once for each received message.
+ *                              May be NULL.
+ * \param [in] user             Passed to \b interior_fn and \b recv_fn.
+ */
+void                sc_overlap_run (sc_overlap_t * ov,
+                                    size_t num_interior, size_t chunk,
+                                    sc_range_function_t interior_fn,
+                                    sc_overlap_recv_t recv_fn, void *user);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_OVERLAP_H */
@@ -30,7 +30,7 @@
 #ifndef SC_PRIVATE_H
 #define SC_PRIVATE_H
 
-#include <sc.h>
+#include <sc_taskpool.h>
 
 SC_EXTERN_C_BEGIN;
 
@@ -44,6 +44,50 @@ SC_EXTERN_C_BEGIN;
  */
 void                sc_package_rc_count_add (int package_id, int toadd);
 
+/** Create the global task pool of \ref sc_taskpool_global.
+ * This function is called by \ref sc_init.
+ * \param [in] num_threads      Number of worker threads, may be zero.
+ * \param [in] pin              Boolean to pin the workers to cores.
+ */
+void                sc_taskpool_global_init (int num_threads, int pin);
+
+/** Destroy the global task pool if it exists.
+ * This function is called by \ref sc_finalize.
+ */
+void                sc_taskpool_global_finalize (void);
+
+/** Return the global task pool if it exists.
+ * \return                     The global pool or NULL outside of
+ *                              \ref sc_init and \ref sc_finalize.
+ */
+sc_taskpool_t      *sc_taskpool_global_lookup (void);
+
+/** Tell which checksum \ref sc_io_hash64 computes in this build. */
+#ifdef SC_HAVE_ZLIB
+#define SC_IO_HASH64_KIND 1
+#else
+#define SC_IO_HASH64_KIND 2
+#endif
+
+/** Compute a 64 bit checksum of memory.
+ * With zlib, it combines the CRC-32 and Adler-32 values of the data;
+ * otherwise it is the 64 bit FNV-1a hash.
+ * \param [in] data             Memory of any alignment.
+ * \param [in] bytes            Its length in bytes.
+ * \return                      The checksum.
+ */
+uint64_t            sc_io_hash64 (const void *data, size_t bytes);
+
+/** Compute the exclusive prefix sum and the total of a size.
+ * This function is collective.
+ * \param [in] local            The size of this process.
+ * \param [out] base            The sum of the sizes of the lower ranks.
+ * \param [out] total           The sum of the sizes of all processes.
+ * \param [in] mpicomm          The processes to sum over.
+ */
+void                sc_io_exscan_size (size_t local, size_t * base,
+                                       size_t * total, sc_MPI_Comm mpicomm);
+
 SC_EXTERN_C_END;
 
 #endif /* SC_PRIVATE_H */
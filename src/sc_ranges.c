@@ -21,6 +21,7 @@
   02110-1301, USA.
 */
 
+#include <sc_notify.h>
 #include <sc_ranges.h>
 #include <sc_statistics.h>
 
@@ -306,6 +307,48 @@ sc_ranges_decode (int num_procs, int rank,
   *num_senders = ns;
 }
 
+void
+sc_ranges_decode_notify (sc_MPI_Comm mpicomm, int num_ranges,
+                         const int *ranges,
+                         int *num_receivers, int *receiver_ranks,
+                         int *num_senders, int *sender_ranks)
+{
+  int                 mpiret;
+  int                 i, j;
+  int                 nr;
+  int                 num_procs, rank;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &num_procs);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  /* identify receivers exactly as in sc_ranges_decode */
+  nr = 0;
+  for (i = 0; i < num_ranges; ++i) {
+    if (ranges[2 * i] < 0) {
+      /* this processor uses less ranges than the maximum */
+      break;
+    }
+    SC_ASSERT (i == 0 || ranges[2 * (i - 1) + 1] + 1 < ranges[2 * i]);
+    for (j = ranges[2 * i]; j <= ranges[2 * i + 1]; ++j) {
+      SC_ASSERT (0 <= j && j < num_procs);
+
+      /* exclude self */
+      if (j == rank) {
+        continue;
+      }
+      receiver_ranks[nr++] = j;
+    }
+  }
+  *num_receivers = nr;
+
+  /* the receivers are sorted and unique, so we may transpose the pattern */
+  mpiret = sc_notify_nary (receiver_ranks, nr,
+                           sender_ranks, num_senders, mpicomm);
+  SC_CHECK_MPI (mpiret);
+}
+
 void
 sc_ranges_statistics (int package_id, int log_priority,
                       sc_MPI_Comm mpicomm, int num_procs, const int *procs,
@@ -81,6 +81,7 @@ int                 sc_ranges_adaptive (int package_id, sc_MPI_Comm mpicomm,
  * This function is intended for compatibility and debugging only.
  * In particular, sc_ranges_adaptive may include non-receiving processors.
  * It is generally more efficient to use sc_notify instead of sc_ranges.
+ * For large process counts, use \ref sc_ranges_decode_notify instead.
  *
  * \param [in] num_procs    The number of parallel processors (aka mpisize).
  * \param [in] rank         Number of this processors (aka mpirank).
@@ -100,6 +101,36 @@ void                sc_ranges_decode (int num_procs, int rank,
                                       int *num_receivers, int *receiver_ranks,
                                       int *num_senders, int *sender_ranks);
 
+/** Determine an array of receivers and an array of senders from ranges.
+ * This function is a scalable replacement for \ref sc_ranges_decode.
+ * It does not require the global ranges array, which needs O(mpisize)
+ * memory per process.  Instead, the senders are found by \ref sc_notify_nary,
+ * which communicates only the expanded local receiver lists.
+ * The output is identical to that of \ref sc_ranges_decode.
+ * This function is collective.
+ *
+ * \param [in] mpicomm      MPI communicator to use.
+ * \param [in] num_ranges   Number of local range windows to consider.
+ *                          It is legal to pass the \b num_ranges argument
+ *                          of \ref sc_ranges_adaptive or its return value.
+ * \param [in] ranges       Array [2 * num_ranges] as computed by
+ *                          \ref sc_ranges_compute or \ref sc_ranges_adaptive,
+ *                          the latter called with global_ranges == NULL.
+ *                          Values of -1 indicate that the range is not used.
+ * \param [out] num_receivers   Number of receiver ranks.  Greater/equal to
+ *                              number of nonzero procs in sc_ranges_compute.
+ * \param [in,out] receiver_ranks   Array of at least mpisize for output.
+ * \param [out] num_senders         Number of senders to this processor.
+ * \param [in,out] sender_ranks     Array of at least mpisize for output.
+ */
+void                sc_ranges_decode_notify (sc_MPI_Comm mpicomm,
+                                             int num_ranges,
+                                             const int *ranges,
+                                             int *num_receivers,
+                                             int *receiver_ranks,
+                                             int *num_senders,
+                                             int *sender_ranks);
+
 /** Compute global statistical information on the ranges.
  *
  * \param [in] package_id       Registered package id or -1.
@@ -0,0 +1,425 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_ringbuf.h>
+
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#ifdef SC_HAVE_ATOMIC_BUILTINS
+#if defined SC_HAVE_LINUX_FUTEX_H && defined SC_HAVE_SYS_SYSCALL_H
+#define SC_RINGBUF_FUTEX
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#else
+/* without atomic builtins a mutex protects the positions */
+#define SC_RINGBUF_LOCK
+#endif
+#endif
+
+#ifdef SC_HAVE_ATOMIC_BUILTINS
+#define SC_RINGBUF_LOAD(p) __atomic_load_n ((p), __ATOMIC_ACQUIRE)
+#define SC_RINGBUF_STORE(p,v) __atomic_store_n ((p), (v), __ATOMIC_RELEASE)
+#define SC_RINGBUF_CAS(p,e,d) __atomic_compare_exchange_n \
+  ((p), (e), (d), 1, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#define SC_RINGBUF_ADD(p,v) __atomic_add_fetch ((p), (v), __ATOMIC_SEQ_CST)
+#define SC_RINGBUF_FENCE() __atomic_thread_fence (__ATOMIC_SEQ_CST)
+#else
+#define SC_RINGBUF_LOAD(p) (*(p))
+#define SC_RINGBUF_STORE(p,v) (*(p) = (v))
+#define SC_RINGBUF_CAS(p,e,d) \
+  (*(p) == *(e) ? (*(p) = (d), 1) : (*(e) = *(p), 0))
+#define SC_RINGBUF_ADD(p,v) (*(p) += (v))
+#define SC_RINGBUF_FENCE() ((void) 0)
+#endif
+
+/** We keep the positions of producers and consumers on distinct lines. */
+#define SC_RINGBUF_LINE 64
+
+struct sc_ringbuf
+{
+  size_t              elem_size;
+  size_t              mask;     /**< capacity minus one */
+  size_t             *seq;      /**< sequence number of each slot */
+  char               *data;
+
+  char                pad0[SC_RINGBUF_LINE];
+  size_t              head;     /**< next position to push */
+  char                pad1[SC_RINGBUF_LINE];
+  size_t              tail;     /**< next position to pop */
+  char                pad2[SC_RINGBUF_LINE];
+
+  /* event counts and waiter counts of the blocking functions */
+  int                 not_empty, not_full;
+  int                 pop_waiters, push_waiters;
+  int                 closed;
+#ifdef SC_RINGBUF_LOCK
+  pthread_mutex_t     lock;
+#endif
+#if defined SC_ENABLE_PTHREAD && !defined SC_RINGBUF_FUTEX
+  pthread_mutex_t     wait_mutex;
+  pthread_cond_t      wait_cond;
+#endif
+};
+
+sc_ringbuf_t       *
+sc_ringbuf_new (size_t elem_size, size_t capacity)
+{
+  size_t              zz, cap;
+  sc_ringbuf_t       *rb;
+
+  SC_ASSERT (capacity > 0);
+
+  for (cap = 1; cap < capacity; cap *= 2);
+
+  rb = SC_ALLOC_ZERO (sc_ringbuf_t, 1);
+  rb->elem_size = elem_size;
+  rb->mask = cap - 1;
+  rb->seq = SC_ALLOC (size_t, cap);
+  rb->data = SC_ALLOC (char, cap * elem_size);
+
+  /* slot i is free for the push at position i */
+  for (zz = 0; zz < cap; ++zz) {
+    rb->seq[zz] = zz;
+  }
+#ifdef SC_RINGBUF_LOCK
+  pthread_mutex_init (&rb->lock, NULL);
+#endif
+#if defined SC_ENABLE_PTHREAD && !defined SC_RINGBUF_FUTEX
+  pthread_mutex_init (&rb->wait_mutex, NULL);
+  pthread_cond_init (&rb->wait_cond, NULL);
+#endif
+
+  return rb;
+}
+
+void
+sc_ringbuf_destroy (sc_ringbuf_t * rb)
+{
+  SC_ASSERT (rb->pop_waiters == 0 && rb->push_waiters == 0);
+
+#ifdef SC_RINGBUF_LOCK
+  pthread_mutex_destroy (&rb->lock);
+#endif
+#if defined SC_ENABLE_PTHREAD && !defined SC_RINGBUF_FUTEX
+  pthread_cond_destroy (&rb->wait_cond);
+  pthread_mutex_destroy (&rb->wait_mutex);
+#endif
+  SC_FREE (rb->data);
+  SC_FREE (rb->seq);
+  SC_FREE (rb);
+}
+
+size_t
+sc_ringbuf_capacity (sc_ringbuf_t * rb)
+{
+  return rb->mask + 1;
+}
+
+size_t
+sc_ringbuf_count (sc_ringbuf_t * rb)
+{
+  size_t              tail, head;
+
+  tail = SC_RINGBUF_LOAD (&rb->tail);
+  head = SC_RINGBUF_LOAD (&rb->head);
+
+  /* the positions are read one after the other */
+  return head > tail ? SC_MIN (head - tail, rb->mask + 1) : 0;
+}
+
+/** Wake the threads waiting on an event count if there are any. */
+static void
+sc_ringbuf_wake (sc_ringbuf_t * rb, int *word, int *waiters)
+{
+#ifdef SC_RINGBUF_FUTEX
+  /* order our update of the slots before reading the waiter count */
+  SC_RINGBUF_FENCE ();
+  if (SC_RINGBUF_LOAD (waiters) > 0) {
+    SC_RINGBUF_ADD (word, 1);
+    syscall (SYS_futex, word, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+  }
+#elif defined SC_ENABLE_PTHREAD
+  pthread_mutex_lock (&rb->wait_mutex);
+  if (*waiters > 0) {
+    ++*word;
+    pthread_cond_broadcast (&rb->wait_cond);
+  }
+  pthread_mutex_unlock (&rb->wait_mutex);
+#endif
+}
+
+#ifdef SC_ENABLE_PTHREAD
+
+/** Register as a waiter and return the current event count.
+ * The caller must retry its operation before calling sc_ringbuf_wait.
+ */
+static int
+sc_ringbuf_enter (sc_ringbuf_t * rb, int *word, int *waiters)
+{
+  int                 seen;
+
+#ifdef SC_RINGBUF_FUTEX
+  SC_RINGBUF_ADD (waiters, 1);
+  seen = SC_RINGBUF_LOAD (word);
+#else
+  pthread_mutex_lock (&rb->wait_mutex);
+  ++*waiters;
+  seen = *word;
+  pthread_mutex_unlock (&rb->wait_mutex);
+#endif
+  return seen;
+}
+
+/** Wait until the event count has changed and unregister. */
+static void
+sc_ringbuf_wait (sc_ringbuf_t * rb, int *word, int *waiters, int seen,
+                 int block)
+{
+#ifdef SC_RINGBUF_FUTEX
+  while (block && SC_RINGBUF_LOAD (word) == seen) {
+    syscall (SYS_futex, word, FUTEX_WAIT_PRIVATE, seen, NULL, NULL, 0);
+  }
+  SC_RINGBUF_ADD (waiters, -1);
+#else
+  pthread_mutex_lock (&rb->wait_mutex);
+  while (block && *word == seen) {
+    pthread_cond_wait (&rb->wait_cond, &rb->wait_mutex);
+  }
+  --*waiters;
+  pthread_mutex_unlock (&rb->wait_mutex);
+#endif
+}
+
+#endif /* SC_ENABLE_PTHREAD */
+
+size_t
+sc_ringbuf_try_push_n (sc_ringbuf_t * rb, const void *elems, size_t n)
+{
+  const size_t        es = rb->elem_size;
+  size_t              pos, k, zz, seq = 0;
+
+  if (n == 0) {
+    return 0;
+  }
+#ifdef SC_RINGBUF_LOCK
+  pthread_mutex_lock (&rb->lock);
+#endif
+
+  /* claim the consecutive slots that are free */
+  pos = SC_RINGBUF_LOAD (&rb->head);
+  for (;;) {
+    for (k = 0; k < n; ++k) {
+      seq = SC_RINGBUF_LOAD (&rb->seq[(pos + k) & rb->mask]);
+      if (seq != pos + k) {
+        break;
+      }
+    }
+    if (k == 0) {
+      if ((ptrdiff_t) (seq - pos) < 0) {
+        /* the slot still holds an element: we are full */
+        break;
+      }
+      /* another producer has claimed this position */
+      pos = SC_RINGBUF_LOAD (&rb->head);
+    }
+    else if (SC_RINGBUF_CAS (&rb->head, &pos, pos + k)) {
+      break;
+    }
+  }
+
+  /* fill and publish the claimed slots */
+  for (zz = 0; zz < k; ++zz) {
+    memcpy (rb->data + ((pos + zz) & rb->mask) * es,
+            (const char *) elems + zz * es, es);
+    SC_RINGBUF_STORE (&rb->seq[(pos + zz) & rb->mask], pos + zz + 1);
+  }
+
+#ifdef SC_RINGBUF_LOCK
+  pthread_mutex_unlock (&rb->lock);
+#endif
+  if (k > 0) {
+    sc_ringbuf_wake (rb, &rb->not_empty, &rb->pop_waiters);
+  }
+  return k;
+}
+
+int
+sc_ringbuf_try_push (sc_ringbuf_t * rb, const void *elem)
+{
+  return sc_ringbuf_try_push_n (rb, elem, 1) == 1;
+}
+
+size_t
+sc_ringbuf_try_pop_n (sc_ringbuf_t * rb, void *elems, size_t n)
+{
+  const size_t        es = rb->elem_size;
+  size_t              pos, k, zz, seq = 0;
+
+  if (n == 0) {
+    return 0;
+  }
+#ifdef SC_RINGBUF_LOCK
+  pthread_mutex_lock (&rb->lock);
+#endif
+
+  /* claim the consecutive slots that are published */
+  pos = SC_RINGBUF_LOAD (&rb->tail);
+  for (;;) {
+    for (k = 0; k < n; ++k) {
+      seq = SC_RINGBUF_LOAD (&rb->seq[(pos + k) & rb->mask]);
+      if (seq != pos + k + 1) {
+        break;
+      }
+    }
+    if (k == 0) {
+      if ((ptrdiff_t) (seq - (pos + 1)) < 0) {
+        /* the slot has not been published: we are empty */
+        break;
+      }
+      /* another consumer has claimed this position */
+      pos = SC_RINGBUF_LOAD (&rb->tail);
+    }
+    else if (SC_RINGBUF_CAS (&rb->tail, &pos, pos + k)) {
+      break;
+    }
+  }
+
+  /* read the claimed slots and free them for the next round */
+  for (zz = 0; zz < k; ++zz) {
+    memcpy ((char *) elems + zz * es,
+            rb->data + ((pos + zz) & rb->mask) * es, es);
+    SC_RINGBUF_STORE (&rb->seq[(pos + zz) & rb->mask],
+                      pos + zz + rb->mask + 1);
+  }
+
+#ifdef SC_RINGBUF_LOCK
+  pthread_mutex_unlock (&rb->lock);
+#endif
+  if (k > 0) {
+    sc_ringbuf_wake (rb, &rb->not_full, &rb->push_waiters);
+  }
+  return k;
+}
+
+int
+sc_ringbuf_try_pop (sc_ringbuf_t * rb, void *elem)
+{
+  return sc_ringbuf_try_pop_n (rb, elem, 1) == 1;
+}
+
+void
+sc_ringbuf_push_n (sc_ringbuf_t * rb, const void *elems, size_t n)
+{
+  size_t              k;
+#ifdef SC_ENABLE_PTHREAD
+  int                 seen;
+#endif
+
+  SC_ASSERT (!SC_RINGBUF_LOAD (&rb->closed));
+
+  for (;;) {
+    k = sc_ringbuf_try_push_n (rb, elems, n);
+    elems = (const char *) elems + k * rb->elem_size;
+    n -= k;
+    if (n == 0) {
+      return;
+    }
+#ifdef SC_ENABLE_PTHREAD
+    seen = sc_ringbuf_enter (rb, &rb->not_full, &rb->push_waiters);
+    k = sc_ringbuf_try_push_n (rb, elems, n);
+    elems = (const char *) elems + k * rb->elem_size;
+    n -= k;
+    sc_ringbuf_wait (rb, &rb->not_full, &rb->push_waiters, seen, n > 0);
+    if (n == 0) {
+      return;
+    }
+#else
+    SC_ABORT ("Ring buffer full in a single thread");
+#endif
+  }
+}
+
+void
+sc_ringbuf_push (sc_ringbuf_t * rb, const void *elem)
+{
+  sc_ringbuf_push_n (rb, elem, 1);
+}
+
+size_t
+sc_ringbuf_pop_n (sc_ringbuf_t * rb, void *elems, size_t n)
+{
+  size_t              k;
+#ifdef SC_ENABLE_PTHREAD
+  int                 seen;
+#endif
+
+  SC_ASSERT (n > 0);
+
+  for (;;) {
+    if ((k = sc_ringbuf_try_pop_n (rb, elems, n)) > 0) {
+      return k;
+    }
+    if (SC_RINGBUF_LOAD (&rb->closed)) {
+      /* elements pushed before closing are visible now */
+      return sc_ringbuf_try_pop_n (rb, elems, n);
+    }
+#ifdef SC_ENABLE_PTHREAD
+    seen = sc_ringbuf_enter (rb, &rb->not_empty, &rb->pop_waiters);
+    k = sc_ringbuf_try_pop_n (rb, elems, n);
+    sc_ringbuf_wait (rb, &rb->not_empty, &rb->pop_waiters, seen,
+                     k == 0 && !SC_RINGBUF_LOAD (&rb->closed));
+    if (k > 0) {
+      return k;
+    }
+#else
+    SC_ABORT ("Ring buffer empty and open in a single thread");
+#endif
+  }
+}
+
+int
+sc_ringbuf_pop (sc_ringbuf_t * rb, void *elem)
+{
+  return sc_ringbuf_pop_n (rb, elem, 1) == 1;
+}
+
+void
+sc_ringbuf_close (sc_ringbuf_t * rb)
+{
+  SC_RINGBUF_ADD (&rb->closed, 1);
+
+  /* wake everybody regardless of the waiter counts */
+#ifdef SC_RINGBUF_FUTEX
+  SC_RINGBUF_ADD (&rb->not_empty, 1);
+  syscall (SYS_futex, &rb->not_empty, FUTEX_WAKE_PRIVATE, INT_MAX,
+           NULL, NULL, 0);
+#elif defined SC_ENABLE_PTHREAD
+  pthread_mutex_lock (&rb->wait_mutex);
+  ++rb->not_empty;
+  pthread_cond_broadcast (&rb->wait_cond);
+  pthread_mutex_unlock (&rb->wait_mutex);
+#endif
+}
@@ -0,0 +1,153 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef SC_RINGBUF_H
+#define SC_RINGBUF_H
+
+/** \file sc_ringbuf.h
+ * This file provides a bounded queue of fixed-size elements for threads.
+ *
+ * Any number of threads may push and pop concurrently.  With atomic
+ * builtins the try functions are lock-free: each element slot carries a
+ * sequence number that tells producers and consumers whether it is theirs,
+ * and the positions are advanced by compare-and-swap.  The batch functions
+ * claim several consecutive slots with a single compare-and-swap.
+ *
+ * The blocking functions wait on a futex if the system provides one and
+ * on a condition variable otherwise.  A queue can be closed to tell the
+ * consumers that no more elements will come, which is the usual way to shut
+ * down a pipeline of producer and consumer threads.
+ *
+ * Without --enable-pthread the queue works in a single thread, and the
+ * blocking functions abort if they would wait forever.
+ */
+
+#include <sc.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** The ring buffer is an opaque structure. */
+typedef struct sc_ringbuf sc_ringbuf_t;
+
+/** Create a new and empty ring buffer.
+ * \param [in] elem_size    Size of one element in bytes.
+ * \param [in] capacity     Minimum number of elements; it is rounded up
+ *                          to a power of two.  Must be positive.
+ * \return                  A valid ring buffer.
+ */
+sc_ringbuf_t       *sc_ringbuf_new (size_t elem_size, size_t capacity);
+
+/** Destroy a ring buffer.
+ * No thread may use it anymore; remaining elements are discarded.
+ * \param [in,out] rb       This ring buffer is invalidated.
+ */
+void                sc_ringbuf_destroy (sc_ringbuf_t * rb);
+
+/** Return the number of elements a ring buffer can hold.
+ * \param [in] rb           Valid ring buffer.
+ * \return                  The capacity, a power of two.
+ */
+size_t              sc_ringbuf_capacity (sc_ringbuf_t * rb);
+
+/** Return the number of elements in a ring buffer.
+ * With concurrent access, the result may be outdated when it returns.
+ * \param [in] rb           Valid ring buffer.
+ * \return                  Number of elements in [0, capacity].
+ */
+size_t              sc_ringbuf_count (sc_ringbuf_t * rb);
+
+/** Push an element if there is room.
+ * \param [in,out] rb       Valid ring buffer.
+ * \param [in] elem         The element of elem_size bytes is copied.
+ * \return                  True if the element was pushed.
+ */
+int                 sc_ringbuf_try_push (sc_ringbuf_t * rb, const void *elem);
+
+/** Push up to \b n consecutive elements as far as there is room.
+ * \param [in,out] rb       Valid ring buffer.
+ * \param [in] elems        Array of \b n elements.
+ * \param [in] n            Number of elements to push.
+ * \return                  The number of leading elements pushed.
+ */
+size_t              sc_ringbuf_try_push_n (sc_ringbuf_t * rb,
+                                           const void *elems, size_t n);
+
+/** Pop the oldest element if there is one.
+ * \param [in,out] rb       Valid ring buffer.
+ * \param [out] elem        Receives the element.
+ * \return                  True if an element was popped.
+ */
+int                 sc_ringbuf_try_pop (sc_ringbuf_t * rb, void *elem);
+
+/** Pop up to \b n of the oldest elements.
+ * \param [in,out] rb       Valid ring buffer.
+ * \param [out] elems       Room for \b n elements.
+ * \param [in] n            Maximum number of elements to pop.
+ * \return                  The number of elements popped.
+ */
+size_t              sc_ringbuf_try_pop_n (sc_ringbuf_t * rb,
+                                          void *elems, size_t n);
+
+/** Push an element and wait for room if necessary.
+ * \param [in,out] rb       Valid ring buffer that is not closed.
+ * \param [in] elem         The element of elem_size bytes is copied.
+ */
+void                sc_ringbuf_push (sc_ringbuf_t * rb, const void *elem);
+
+/** Push all of \b n elements, waiting for room as necessary.
+ * Elements of concurrent producers may be interleaved with them.
+ * \param [in,out] rb       Valid ring buffer that is not closed.
+ * \param [in] elems        Array of \b n elements.
+ * \param [in] n            Number of elements to push.
+ */
+void                sc_ringbuf_push_n (sc_ringbuf_t * rb,
+                                       const void *elems, size_t n);
+
+/** Pop the oldest element and wait for one if necessary.
+ * \param [in,out] rb       Valid ring buffer.
+ * \param [out] elem        Receives the element.
+ * \return                  True if an element was popped, false if the
+ *                          ring buffer is closed and empty.
+ */
+int                 sc_ringbuf_pop (sc_ringbuf_t * rb, void *elem);
+
+/** Pop up to \b n elements and wait for at least one if necessary.
+ * \param [in,out] rb       Valid ring buffer.
+ * \param [out] elems       Room for \b n elements.
+ * \param [in] n            Maximum number of elements to pop; positive.
+ * \return                  The number of elements popped; 0 only if the
+ *                          ring buffer is closed and empty.
+ */
+size_t              sc_ringbuf_pop_n (sc_ringbuf_t * rb,
+                                      void *elems, size_t n);
+
+/** Close a ring buffer for pushing.
+ * Waiting consumers are woken up.  Elements already pushed can still be
+ * popped, after which the blocking pop functions return immediately.
+ * \param [in,out] rb       Valid ring buffer.
+ */
+void                sc_ringbuf_close (sc_ringbuf_t * rb);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_RINGBUF_H */
@@ -94,6 +94,14 @@ sc_search_lower_bound64 (int64_t target, const int64_t * array,
 size_t
 sc_bsearch_range (const void *key, const void *base, size_t nmemb,
                   size_t size, int (*compar) (const void *, const void *))
+{
+  return sc_bsearch_range_r (key, base, nmemb, size, sc_compare_plain,
+                             &compar);
+}
+
+size_t
+sc_bsearch_range_r (const void *key, const void *base, size_t nmemb,
+                    size_t size, sc_compare_r_t compar, void *arg)
 {
   const char         *ckey = (char *) key;
   const char         *cbase = (char *) base;
@@ -113,7 +121,7 @@ sc_bsearch_range (const void *key, const void *base, size_t nmemb,
     SC_ASSERT (k_low < nmemb && k_high < nmemb);
 
     /* check if we have to search lower */
-    if (compar (ckey, cbase + guess * size) < 0) {
+    if (compar (ckey, cbase + guess * size, arg) < 0) {
       if (guess == k_low) {
         return nmemb;
       }
@@ -123,7 +131,7 @@ sc_bsearch_range (const void *key, const void *base, size_t nmemb,
     }
 
     /* check if we have to search higher */
-    if (compar (cbase + (guess + 1) * size, ckey) <= 0) {
+    if (compar (cbase + (guess + 1) * size, ckey, arg) <= 0) {
       if (guess == k_high) {
         return nmemb;
       }
@@ -137,7 +145,34 @@ sc_bsearch_range (const void *key, const void *base, size_t nmemb,
   }
 
   SC_ASSERT (guess < nmemb);
-  SC_ASSERT (compar (cbase + guess * size, ckey) <= 0);
-  SC_ASSERT (compar (ckey, cbase + (guess + 1) * size) < 0);
+  SC_ASSERT (compar (cbase + guess * size, ckey, arg) <= 0);
+  SC_ASSERT (compar (ckey, cbase + (guess + 1) * size, arg) < 0);
   return guess;
 }
+
+void               *
+sc_bsearch_r (const void *key, const void *base, size_t nmemb, size_t size,
+              sc_compare_r_t compar, void *arg)
+{
+  int                 cmp;
+  size_t              k_low, k_high, guess;
+  const char         *cbase = (const char *) base;
+
+  /* search the half-open range [k_low, k_high) */
+  k_low = 0;
+  k_high = nmemb;
+  while (k_low < k_high) {
+    guess = k_low + (k_high - k_low) / 2;
+    cmp = compar (key, cbase + guess * size, arg);
+    if (cmp == 0) {
+      return (void *) (cbase + guess * size);
+    }
+    if (cmp < 0) {
+      k_high = guess;
+    }
+    else {
+      k_low = guess + 1;
+    }
+  }
+  return NULL;
+}
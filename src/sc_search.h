@@ -67,6 +67,34 @@ size_t              sc_bsearch_range (const void *key, const void *base,
                                       int (*compar) (const void *,
                                                      const void *));
 
+/** Search position k in sorted array with array[k] <= target < array[k + 1].
+ * This function is like \ref sc_bsearch_range with a context argument.
+ * \param [in]  key     The target to find in the array range.
+ * \param [in]  base    The array to binary search in.
+ * \param [in]  nmemb   Number of entries in the array MINUS ONE.
+ * \param [in]  size    Size of one entry in the array in bytes.
+ * \param [in]  compar  Comparison function.
+ * \param [in]  arg     Passed to \b compar.
+ * \return              The matching array position if found, or nmemb if not.
+ */
+size_t              sc_bsearch_range_r (const void *key, const void *base,
+                                        size_t nmemb, size_t size,
+                                        sc_compare_r_t compar, void *arg);
+
+/** Search an entry equal to a key in a sorted array.
+ * This function is like the libc bsearch with a context argument.
+ * \param [in]  key     The object to search for.
+ * \param [in]  base    The array sorted in ascending order wrt. \b compar.
+ * \param [in]  nmemb   Number of entries in the array.
+ * \param [in]  size    Size of one entry in the array in bytes.
+ * \param [in]  compar  Comparison function called with \b key first.
+ * \param [in]  arg     Passed to \b compar.
+ * \return              Address of a matching entry, or NULL if not found.
+ */
+void               *sc_bsearch_r (const void *key, const void *base,
+                                  size_t nmemb, size_t size,
+                                  sc_compare_r_t compar, void *arg);
+
 SC_EXTERN_C_END;
 
 #endif /* !SC_SEARCH_H */
@@ -29,6 +29,22 @@
 #include <hwi/include/bqc/A2_inlines.h>
 #endif
 
+#if defined(SC_ENABLE_MPIWINSHARED)
+#ifdef SC_HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+#if defined SC_HAVE_LINUX_MEMPOLICY_H && defined SC_HAVE_SYS_SYSCALL_H
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#if defined SYS_mbind && defined SYS_get_mempolicy
+#define SC_SHMEM_MBIND
+#endif
+#endif
+
+/** The huge page size we align windows to; 2 MiB on common systems. */
+#define SC_SHMEM_HUGE_PAGE_SIZE ((size_t) 1 << 21)
+#endif
+
 #if defined(SC_ENABLE_MPI)
 static int          sc_shmem_keyval = MPI_KEYVAL_INVALID;
 #endif
@@ -173,6 +189,7 @@ sc_scan_on_array (void *recvchar, int size, int count, int typesize,
 #define SC_SHMEM_DEFAULT SC_SHMEM_BASIC
 #endif
 sc_shmem_type_t     sc_shmem_default_type = SC_SHMEM_DEFAULT;
+int                 sc_shmem_page_flags = SC_SHMEM_PAGES_DEFAULT;
 
 #ifdef SC_ENABLE_MPI
 
@@ -567,6 +584,90 @@ sc_shmem_get_win (void *array, sc_MPI_Comm comm, sc_MPI_Comm intranode,
   return ((MPI_Win *) array)[-intrasize + intrarank];
 }
 
+static size_t
+sc_shmem_page_size (void)
+{
+#ifdef _SC_PAGESIZE
+  long                psize = sysconf (_SC_PAGESIZE);
+
+  if (psize > 0) {
+    return (size_t) psize;
+  }
+#endif
+  return 4096;
+}
+
+/** Apply the page flags to the data of a window before it is touched.
+ * Called on the process that owns the memory.  Any failure is harmless.
+ */
+static void
+sc_shmem_advise_window (char *data, size_t bytes, int flags)
+{
+  size_t              psize = sc_shmem_page_size ();
+  size_t              offset;
+  char               *start;
+
+  if (bytes == 0) {
+    return;
+  }
+  offset = (size_t) ((uintptr_t) data % psize);
+  start = data - offset;
+  bytes += offset;
+#if defined SC_HAVE_SYS_MMAN_H && defined MADV_HUGEPAGE
+  if (flags & SC_SHMEM_PAGES_HUGE) {
+    if (madvise (start, bytes, MADV_HUGEPAGE)) {
+      SC_LDEBUG ("sc_shmem: huge pages not available\n");
+    }
+  }
+#endif
+#ifdef SC_SHMEM_MBIND
+  if (flags & SC_SHMEM_PAGES_INTERLEAVE) {
+    int                 mode, nodes;
+    unsigned long       mask[16], maxnode, bit;
+
+    /* interleave over all nodes that we are allowed to allocate from */
+    maxnode = 8 * sizeof (mask);
+    memset (mask, 0, sizeof (mask));
+    if (syscall (SYS_get_mempolicy, &mode, mask, maxnode, NULL,
+                 MPOL_F_MEMS_ALLOWED)) {
+      return;
+    }
+    for (nodes = 0, bit = 0; bit < maxnode; ++bit) {
+      nodes += (mask[bit / (8 * sizeof (long))] >>
+                (bit % (8 * sizeof (long)))) & 1;
+    }
+    if (nodes > 1) {
+      if (syscall (SYS_mbind, start, bytes, MPOL_INTERLEAVE,
+                   mask, maxnode, 0)) {
+        SC_LDEBUG ("sc_shmem: interleaving pages failed\n");
+      }
+    }
+  }
+#endif
+}
+
+/** Touch an equal share of the pages of a window on every process.
+ * Under the default first touch policy, each page ends up on the NUMA
+ * node of the process that faults it.
+ */
+static void
+sc_shmem_prefault_window (char *data, size_t bytes, int flags,
+                          int intrarank, int intrasize)
+{
+  size_t              psize, npages, first, last, lo, hi;
+
+  psize = (flags & SC_SHMEM_PAGES_HUGE) ?
+    SC_SHMEM_HUGE_PAGE_SIZE : sc_shmem_page_size ();
+  npages = (bytes + psize - 1) / psize;
+  first = (npages * intrarank) / intrasize;
+  last = (npages * (intrarank + 1)) / intrasize;
+  lo = SC_MIN (first * psize, bytes);
+  hi = SC_MIN (last * psize, bytes);
+  if (lo < hi) {
+    memset (data + lo, 0, hi - lo);
+  }
+}
+
 static void        *
 sc_shmem_malloc_window (int package, size_t elem_size, size_t elem_count,
                         sc_MPI_Comm comm, sc_MPI_Comm intranode,
@@ -574,6 +675,9 @@ sc_shmem_malloc_window (int package, size_t elem_size, size_t elem_count,
 {
   char               *array = NULL;
   int                 mpiret, disp_unit, intrarank, intrasize;
+  int                 flags = sc_shmem_page_flags;
+  size_t              header, bytes;
+  MPI_Info            info = MPI_INFO_NULL;
   MPI_Win             win;
   MPI_Aint            winsize = 0;
 
@@ -588,11 +692,44 @@ sc_shmem_malloc_window (int package, size_t elem_size, size_t elem_count,
       winsize = ((winsize / disp_unit) + 1) * disp_unit;
     }
   }
-  mpiret = MPI_Win_allocate_shared (winsize, disp_unit, MPI_INFO_NULL,
+  if (flags & SC_SHMEM_PAGES_HUGE) {
+    char                value[32];
+
+    /* this key is new in MPI 4.1; older libraries ignore it */
+    snprintf (value, 32, "%lu", (unsigned long) SC_SHMEM_HUGE_PAGE_SIZE);
+    mpiret = MPI_Info_create (&info);
+    SC_CHECK_MPI (mpiret);
+    mpiret = MPI_Info_set (info, "mpi_minimum_memory_alignment", value);
+    SC_CHECK_MPI (mpiret);
+  }
+  mpiret = MPI_Win_allocate_shared (winsize, disp_unit, info,
                                     intranode, &array, &win);
   SC_CHECK_MPI (mpiret);
+  if (info != MPI_INFO_NULL) {
+    mpiret = MPI_Info_free (&info);
+    SC_CHECK_MPI (mpiret);
+  }
   mpiret = MPI_Win_shared_query (win, 0, &winsize, &disp_unit, &array);
   SC_CHECK_MPI (mpiret);
+
+  /* the windows are stored in front of the data */
+  header = intrasize * sizeof (MPI_Win);
+  bytes = elem_size * elem_count;
+  if (flags & (SC_SHMEM_PAGES_HUGE | SC_SHMEM_PAGES_INTERLEAVE)) {
+    if (!intrarank) {
+      sc_shmem_advise_window (array + header, bytes, flags);
+    }
+    if (flags & SC_SHMEM_PAGES_PREFAULT) {
+      /* the pages must not be faulted before the policy is set */
+      mpiret = sc_MPI_Barrier (intranode);
+      SC_CHECK_MPI (mpiret);
+    }
+  }
+  if (flags & SC_SHMEM_PAGES_PREFAULT) {
+    sc_shmem_prefault_window (array + header, bytes, flags,
+                              intrarank, intrasize);
+  }
+
   /* store the windows at the front of the array */
   mpiret = sc_MPI_Gather (&win, sizeof (MPI_Win), sc_MPI_BYTE,
                           array, sizeof (MPI_Win), sc_MPI_BYTE, 0, intranode);
@@ -57,6 +57,28 @@ extern const char  *sc_shmem_type_to_string[SC_SHMEM_NUM_TYPES];
 
 extern sc_shmem_type_t sc_shmem_default_type;
 
+/** Flags to control the memory pages of window based shmem arrays.
+ * They may be combined by bitwise or and are ignored by the other types.
+ * Each flag is a hint: what the system does not support is skipped.
+ */
+typedef enum
+{
+  SC_SHMEM_PAGES_DEFAULT = 0,   /**< pages are faulted on first touch */
+  SC_SHMEM_PAGES_HUGE = 1,      /**< align the window to huge pages and
+                                     advise the kernel to use them */
+  SC_SHMEM_PAGES_PREFAULT = 2,  /**< every process of a node faults an equal
+                                     share of the pages on allocation */
+  SC_SHMEM_PAGES_INTERLEAVE = 4 /**< interleave the pages over all NUMA
+                                     nodes; best for read-mostly arrays */
+}
+sc_shmem_pages_t;
+
+/** The page flags used by \ref sc_shmem_malloc for window based arrays.
+ * A bitwise or of \ref sc_shmem_pages_t values.  It must be the same on
+ * all processes of the communicator passed to \ref sc_shmem_malloc.
+ */
+extern int          sc_shmem_page_flags;
+
 /* ALL sc_shmem routines should be considered collective: called on
  * every process in the communicator */
 
@@ -22,6 +22,7 @@
 */
 
 #include <sc_containers.h>
+#include <sc_private.h>
 #include <sc_sort.h>
 
 typedef struct sc_psort_peer
@@ -43,15 +44,457 @@ typedef struct sc_psort
   size_t              my_lo, my_hi, my_count;
   size_t             *gmemb;
   char               *my_base;
+  sc_compare_r_t      compar;
+  void               *arg;
+  sc_taskpool_t      *pool;     /**< NULL if local work is serial */
+  int                 num_threads;
+
+  /* scratch memory reused by all merge levels */
+  char               *scratch;  /**< Room for my_count values */
+  char               *temp;     /**< Room for one value */
+  sc_array_t          peers;    /**< Array of sc_psort_peer_t */
+  sc_array_t          rreqs, sreqs;     /**< Arrays of sc_MPI_Request */
+  sc_array_t          rindices, sindices;       /**< Arrays of int */
+  sc_array_t          rstatuses, sstatuses;     /**< Arrays of sc_MPI_Status */
 }
 sc_psort_t;
 
-/* qsort is not reentrant, so we do the inverse static */
-static int          (*sc_compare) (const void *, const void *);
+/** A bitonic sequence consists of at most three monotone runs.
+ * Each run ends where the direction turns, so a rotated bitonic sequence
+ * never needs more; with any more runs we sort instead of merging. */
+#define SC_PSORT_MAX_RUNS 3
+
+/** Local work on fewer values than this is not threaded. */
+#define SC_PSORT_PARALLEL_MIN 16384
+
+/** A piece of local work executed by the task pool. */
+typedef struct sc_psort_job
+{
+  sc_psort_t         *pst;
+  int                 dir;
+  int                 mode;     /**< exchange: 0 swaps, 1 keeps lo, 2 hi */
+  size_t              num_pieces;
+  const char         *a, *b;
+  size_t              na, nb;
+  char               *out;
+  char               *lo_data, *hi_data;
+}
+sc_psort_job_t;
+
+/** Ranges up to this length are sorted by insertion. */
+#define SC_QSORT_INSERTION 16
+
+static void
+sc_qsort_swap (char *a, char *b, size_t size)
+{
+  size_t              n;
+  char                temp[64];
+
+  while (size > 0) {
+    n = SC_MIN (size, sizeof (temp));
+    memcpy (temp, a, n);
+    memcpy (a, b, n);
+    memcpy (b, temp, n);
+    a += n;
+    b += n;
+    size -= n;
+  }
+}
+
+static void
+sc_qsort_heapsort (char *base, size_t n, size_t size,
+                   sc_compare_r_t compar, void *arg)
+{
+  size_t              start, end, root, child;
+
+  if (n < 2) {
+    return;
+  }
+
+  /* heapify, then move the maximum to the end repeatedly */
+  start = n / 2;
+  end = n;
+  for (;;) {
+    if (start > 0) {
+      --start;
+    }
+    else {
+      if (--end == 0) {
+        return;
+      }
+      sc_qsort_swap (base, base + end * size, size);
+    }
+    for (root = start; (child = 2 * root + 1) < end; root = child) {
+      if (child + 1 < end &&
+          compar (base + child * size, base + (child + 1) * size, arg) < 0) {
+        ++child;
+      }
+      if (compar (base + root * size, base + child * size, arg) >= 0) {
+        break;
+      }
+      sc_qsort_swap (base + root * size, base + child * size, size);
+    }
+  }
+}
+
+static void
+sc_qsort_intro (char *base, size_t n, size_t size,
+                sc_compare_r_t compar, void *arg, int depth)
+{
+  size_t              i, j;
+  char               *a, *m, *z;
+
+  while (n > SC_QSORT_INSERTION) {
+    if (depth-- == 0) {
+      sc_qsort_heapsort (base, n, size, compar, arg);
+      return;
+    }
+
+    /* order first, middle and last, then use the middle as pivot */
+    a = base;
+    m = base + (n / 2) * size;
+    z = base + (n - 1) * size;
+    if (compar (m, a, arg) < 0) {
+      sc_qsort_swap (m, a, size);
+    }
+    if (compar (z, m, arg) < 0) {
+      sc_qsort_swap (z, m, size);
+      if (compar (m, a, arg) < 0) {
+        sc_qsort_swap (m, a, size);
+      }
+    }
+    sc_qsort_swap (a, m, size);
+
+    /* Hoare partition around the pivot in base[0]; stopping on equal
+       entries keeps the ranges balanced for many duplicates */
+    i = 0;
+    j = n;
+    for (;;) {
+      do {
+        ++i;
+      } while (i < n && compar (base + i * size, base, arg) < 0);
+      do {
+        --j;
+      } while (compar (base, base + j * size, arg) < 0);
+      if (i >= j) {
+        break;
+      }
+      sc_qsort_swap (base + i * size, base + j * size, size);
+    }
+    sc_qsort_swap (base, base + j * size, size);
+
+    /* recurse into the smaller part and loop on the larger one */
+    if (j < n - j - 1) {
+      sc_qsort_intro (base, j, size, compar, arg, depth);
+      base += (j + 1) * size;
+      n -= j + 1;
+    }
+    else {
+      sc_qsort_intro (base + (j + 1) * size, n - j - 1, size,
+                      compar, arg, depth);
+      n = j;
+    }
+  }
+
+  for (i = 1; i < n; ++i) {
+    for (j = i; j > 0 && compar (base + (j - 1) * size,
+                                 base + j * size, arg) > 0; --j) {
+      sc_qsort_swap (base + (j - 1) * size, base + j * size, size);
+    }
+  }
+}
+
+void
+sc_qsort_r (void *base, size_t nmemb, size_t size,
+            sc_compare_r_t compar, void *arg)
+{
+  int                 depth;
+  size_t              n;
+
+  /* limit the recursion depth to twice the binary logarithm */
+  depth = 0;
+  for (n = nmemb; n > 1; n /= 2) {
+    depth += 2;
+  }
+  sc_qsort_intro ((char *) base, nmemb, size, compar, arg, depth);
+}
+
+/** Compare two values in the sort direction of the bitonic recursion. */
 static int
-sc_icompare (const void *v1, const void *v2)
+sc_psort_compare (sc_psort_t * pst, int dir, const void *v1, const void *v2)
 {
-  return sc_compare (v2, v1);
+  return dir ? pst->compar (v1, v2, pst->arg) :
+    pst->compar (v2, v1, pst->arg);
+}
+
+static int
+sc_psort_icompare (const void *v1, const void *v2, void *arg)
+{
+  sc_psort_t         *pst = (sc_psort_t *) arg;
+
+  return pst->compar (v2, v1, pst->arg);
+}
+
+/** Sort a range of local values in the given direction. */
+static void
+sc_psort_sort_serial (sc_psort_t * pst, char *base, size_t n, int dir)
+{
+  if (dir) {
+    sc_qsort_r (base, n, pst->size, pst->compar, pst->arg);
+  }
+  else {
+    sc_qsort_r (base, n, pst->size, sc_psort_icompare, pst);
+  }
+}
+
+/** Number of pieces to split local work of a given length into. */
+static size_t
+sc_psort_pieces (sc_psort_t * pst, size_t n)
+{
+  if (pst->pool == NULL || n < SC_PSORT_PARALLEL_MIN) {
+    return 1;
+  }
+  return SC_MIN ((size_t) 4 * (pst->num_threads + 1),
+                 n / (SC_PSORT_PARALLEL_MIN / 4));
+}
+
+/** Find how many of the first k merged values come from the first run.
+ * Ties are resolved in favor of the first run, as in sc_psort_merge_serial.
+ */
+static              size_t
+sc_psort_corank (sc_psort_job_t * job, size_t k)
+{
+  sc_psort_t         *pst = job->pst;
+  const size_t        size = pst->size;
+  size_t              i, j, i_low, j_low, delta;
+
+  i = SC_MIN (k, job->na);
+  j = k - i;
+  i_low = k > job->nb ? k - job->nb : 0;
+  j_low = k > job->na ? k - job->na : 0;
+  for (;;) {
+    if (i > 0 && j < job->nb &&
+        sc_psort_compare (pst, job->dir, job->a + (i - 1) * size,
+                          job->b + j * size) > 0) {
+      delta = (i - i_low + 1) / 2;
+      j_low = j;
+      i -= delta;
+      j += delta;
+    }
+    else if (j > 0 && i < job->na &&
+             sc_psort_compare (pst, job->dir, job->b + (j - 1) * size,
+                               job->a + i * size) >= 0) {
+      delta = (j - j_low + 1) / 2;
+      i_low = i;
+      i += delta;
+      j -= delta;
+    }
+    else {
+      return i;
+    }
+  }
+}
+
+static void
+sc_psort_merge_serial (sc_psort_t * pst, int dir, char *out,
+                       const char *a, size_t na, const char *b, size_t nb)
+{
+  const size_t        size = pst->size;
+  const char         *aend = a + na * size;
+  const char         *bend = b + nb * size;
+
+  while (a < aend && b < bend) {
+    if (sc_psort_compare (pst, dir, b, a) < 0) {
+      memcpy (out, b, size);
+      b += size;
+    }
+    else {
+      memcpy (out, a, size);
+      a += size;
+    }
+    out += size;
+  }
+  if (a < aend) {
+    memcpy (out, a, aend - a);
+  }
+  else if (b < bend) {
+    memcpy (out, b, bend - b);
+  }
+}
+
+static void
+sc_psort_merge_pieces (size_t pbegin, size_t pend, void *user)
+{
+  sc_psort_job_t     *job = (sc_psort_job_t *) user;
+  const size_t        size = job->pst->size;
+  const size_t        total = job->na + job->nb;
+  const size_t        q = total / job->num_pieces;
+  const size_t        r = total % job->num_pieces;
+  size_t              p, k0, k1, i0, i1;
+
+  for (p = pbegin; p < pend; ++p) {
+    /* each piece writes a contiguous range of the output */
+    k0 = q * p + SC_MIN (p, r);
+    k1 = q * (p + 1) + SC_MIN (p + 1, r);
+    i0 = sc_psort_corank (job, k0);
+    i1 = sc_psort_corank (job, k1);
+    sc_psort_merge_serial (job->pst, job->dir, job->out + k0 * size,
+                           job->a + i0 * size, i1 - i0,
+                           job->b + (k0 - i0) * size, (k1 - i1) - (k0 - i0));
+  }
+}
+
+/** Merge two sorted runs into distinct memory, threaded if large. */
+static void
+sc_psort_merge (sc_psort_t * pst, int dir, char *out,
+                const char *a, size_t na, const char *b, size_t nb)
+{
+  sc_psort_job_t      sjob, *job = &sjob;
+
+  job->num_pieces = sc_psort_pieces (pst, na + nb);
+  if (job->num_pieces == 1) {
+    sc_psort_merge_serial (pst, dir, out, a, na, b, nb);
+    return;
+  }
+  job->pst = pst;
+  job->dir = dir;
+  job->a = a;
+  job->na = na;
+  job->b = b;
+  job->nb = nb;
+  job->out = out;
+  sc_taskpool_parallel_for (pst->pool, 0, job->num_pieces, 1,
+                            sc_psort_merge_pieces, job);
+}
+
+static void
+sc_psort_sort_pieces (size_t pbegin, size_t pend, void *user)
+{
+  sc_psort_job_t     *job = (sc_psort_job_t *) user;
+  sc_psort_t         *pst = job->pst;
+  const size_t        q = job->na / job->num_pieces;
+  const size_t        r = job->na % job->num_pieces;
+  size_t              p, begin, end;
+
+  for (p = pbegin; p < pend; ++p) {
+    begin = q * p + SC_MIN (p, r);
+    end = q * (p + 1) + SC_MIN (p + 1, r);
+    if (job->dir) {
+      sc_qsort_r (job->out + begin * pst->size, end - begin, pst->size,
+                  pst->compar, pst->arg);
+    }
+    else {
+      sc_qsort_r (job->out + begin * pst->size, end - begin, pst->size,
+                  sc_psort_icompare, pst);
+    }
+  }
+}
+
+/** Sort a range of local values in the given direction.
+ * If threaded, we sort pieces in parallel and merge them pairwise,
+ * alternating between the range and the scratch memory.
+ */
+static void
+sc_psort_local (sc_psort_t * pst, char *base, size_t n, int dir)
+{
+  const size_t        size = pst->size;
+  size_t              num_pieces, width, p, q, r;
+  size_t              beg0, beg1, beg2;
+  char               *src, *dst, *temp;
+  sc_psort_job_t      sjob, *job = &sjob;
+
+  num_pieces = sc_psort_pieces (pst, n);
+  if (num_pieces == 1) {
+    sc_psort_sort_serial (pst, base, n, dir);
+    return;
+  }
+  SC_ASSERT (n <= pst->my_count);
+
+  job->pst = pst;
+  job->dir = dir;
+  job->num_pieces = num_pieces;
+  job->na = n;
+  job->out = base;
+  sc_taskpool_parallel_for (pst->pool, 0, num_pieces, 1,
+                            sc_psort_sort_pieces, job);
+
+  q = n / num_pieces;
+  r = n % num_pieces;
+  src = base;
+  dst = pst->scratch;
+  for (width = 1; width < num_pieces; width *= 2) {
+    for (p = 0; p < num_pieces; p += 2 * width) {
+      beg0 = q * p + SC_MIN (p, r);
+      beg1 = SC_MIN (p + width, num_pieces);
+      beg1 = q * beg1 + SC_MIN (beg1, r);
+      beg2 = SC_MIN (p + 2 * width, num_pieces);
+      beg2 = q * beg2 + SC_MIN (beg2, r);
+      sc_psort_merge (pst, dir, dst + beg0 * size, src + beg0 * size,
+                      beg1 - beg0, src + beg1 * size, beg2 - beg1);
+    }
+    temp = src;
+    src = dst;
+    dst = temp;
+  }
+  if (src != base) {
+    memcpy (base, src, n * size);
+  }
+}
+
+static void
+sc_psort_exchange_range (size_t begin, size_t end, void *user)
+{
+  sc_psort_job_t     *job = (sc_psort_job_t *) user;
+  sc_psort_t         *pst = job->pst;
+  const size_t        size = pst->size;
+  size_t              zz;
+  char               *lo_data, *hi_data;
+
+  lo_data = job->lo_data + begin * size;
+  hi_data = job->hi_data + begin * size;
+  for (zz = begin; zz < end; ++zz) {
+    if (job->dir == (pst->compar (lo_data, hi_data, pst->arg) > 0)) {
+      if (job->mode == 0) {
+        sc_qsort_swap (lo_data, hi_data, size);
+      }
+      else if (job->mode == 1) {
+        memcpy (lo_data, hi_data, size);
+      }
+      else {
+        memcpy (hi_data, lo_data, size);
+      }
+    }
+    lo_data += size;
+    hi_data += size;
+  }
+}
+
+/** Compare two ranges elementwise and order each pair in direction dir.
+ * \param [in] mode     If 0, both ranges are local and pairs are swapped.
+ *                      If 1, only the low range is local and updated,
+ *                      if 2, only the high range.
+ */
+static void
+sc_psort_exchange (sc_psort_t * pst, int dir, int mode,
+                   char *lo_data, char *hi_data, size_t length)
+{
+  size_t              num_pieces;
+  sc_psort_job_t      sjob, *job = &sjob;
+
+  job->pst = pst;
+  job->dir = dir;
+  job->mode = mode;
+  job->lo_data = lo_data;
+  job->hi_data = hi_data;
+  num_pieces = sc_psort_pieces (pst, length);
+  if (num_pieces == 1) {
+    sc_psort_exchange_range (0, length, job);
+  }
+  else {
+    sc_taskpool_parallel_for (pst->pool, 0, length,
+                              (length + num_pieces - 1) / num_pieces,
+                              sc_psort_exchange_range, job);
+  }
 }
 
 static              size_t
@@ -92,24 +535,103 @@ sc_bsearch_cumulative (const size_t * cumulative, size_t nmemb,
   return guess;
 }
 
+/** Grow an array to at least a given count without shrinking it. */
+static void
+sc_psort_reserve (sc_array_t * array, size_t count)
+{
+  if (array->elem_count < count) {
+    sc_array_resize (array, count);
+  }
+}
+
+/** Sort a range of values owned by this process in linear time.
+ * The range is expected to be a bitonic sequence as it occurs in the merge.
+ * We split it into maximal monotone runs, reverse the descending ones and
+ * merge them.  If there are more runs than expected, we fall back to a sort.
+ */
+static void
+sc_psort_merge_local (sc_psort_t * pst, size_t lo, size_t hi, int dir)
+{
+  const size_t        size = pst->size;
+  const size_t        n = hi - lo;
+  int                 cmp, descending;
+  int                 num_runs;
+  size_t              run_beg[SC_PSORT_MAX_RUNS + 1];
+  size_t              beg, end, zz;
+  size_t              end1, end2;
+  char               *base;
+
+  SC_ASSERT (lo >= pst->my_lo && hi <= pst->my_hi);
+  base = pst->my_base + (lo - pst->my_lo) * size;
+
+  /* identify the monotone runs and make them ascending wrt. compar */
+  num_runs = 0;
+  for (beg = 0; beg < n && num_runs < SC_PSORT_MAX_RUNS; beg = end) {
+    descending = -1;
+    for (end = beg + 1; end < n; ++end) {
+      cmp = sc_psort_compare (pst, dir, base + (end - 1) * size,
+                              base + end * size);
+      if (cmp == 0) {
+        continue;
+      }
+      if (descending == -1) {
+        descending = cmp > 0;
+      }
+      else if (descending != (cmp > 0)) {
+        break;
+      }
+    }
+    if (descending == 1) {
+      for (zz = 0; zz < (end - beg) / 2; ++zz) {
+        memcpy (pst->temp, base + (beg + zz) * size, size);
+        memcpy (base + (beg + zz) * size, base + (end - 1 - zz) * size,
+                size);
+        memcpy (base + (end - 1 - zz) * size, pst->temp, size);
+      }
+    }
+    run_beg[num_runs++] = beg;
+  }
+  if (beg < n) {
+    /* this is not a bitonic sequence */
+    sc_psort_local (pst, base, n, dir);
+    return;
+  }
+  run_beg[num_runs] = n;
+
+  /* merge the first two runs until only one remains */
+  for (; num_runs > 1; --num_runs) {
+    end1 = run_beg[1];
+    end2 = run_beg[2];
+    sc_psort_merge (pst, dir, pst->scratch, base, end1,
+                    base + end1 * size, end2 - end1);
+    memcpy (base, pst->scratch, end2 * size);
+    memmove (run_beg + 1, run_beg + 2, (num_runs - 1) * sizeof (size_t));
+  }
+}
+
 static void
 sc_merge_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
 {
   const size_t        n = hi - lo;
 
-  if (n > 1 && pst->my_hi > lo && pst->my_lo < hi) {
+  if (n > 1 && lo >= pst->my_lo && hi <= pst->my_hi) {
+    /* the remaining recursion is local and amounts to a linear merge */
+    sc_psort_merge_local (pst, lo, hi, dir);
+  }
+  else if (n > 1 && pst->my_hi > lo && pst->my_lo < hi) {
     const int           rank = pst->rank;
     const size_t        size = pst->size;
     size_t              k, n2;
     size_t              lo_end, hi_beg;
     size_t              lo_length, hi_length;
     size_t              offset, max_length;
+    size_t              consumed;
     int                 lo_owner, hi_owner;
     int                 num_peers, remaining, remaining2, outcount, outcount2;
     int                 mpiret;
-    sc_array_t          a, *pa = &a;
-    sc_array_t          r, *pr = &r;
-    sc_array_t          s, *ps = &s;
+    sc_array_t         *pa = &pst->peers;
+    sc_array_t         *pr = &pst->rreqs;
+    sc_array_t         *ps = &pst->sreqs;
     int                *wait_indices, *wait_indices2;
     sc_MPI_Status      *recv_statuses, *recv_statuses2;
     sc_psort_peer_t    *peer;
@@ -124,11 +646,12 @@ sc_merge_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
     hi_beg = lo + n2;
     SC_ASSERT (lo_end <= hi_beg && lo_end - lo == hi - hi_beg);
 
-    sc_array_init (pa, sizeof (sc_psort_peer_t));
-    sc_array_init (pr, sizeof (sc_MPI_Request));
-    sc_array_init (ps, sizeof (sc_MPI_Request));
+    SC_ASSERT (pa->elem_count == 0);
+    SC_ASSERT (pr->elem_count == 0);
+    SC_ASSERT (ps->elem_count == 0);
 
     /* loop 1: initiate communication */
+    consumed = 0;
     lo_owner = hi_owner = rank;
     offset = max_length = 0;
     for (offset = 0; offset < lo_end - lo; offset += max_length) {
@@ -159,7 +682,9 @@ sc_merge_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
         peer->sent = 0;
         peer->prank = hi_owner;
         peer->length = max_length;
-        peer->buffer = SC_ALLOC (char, bytes);
+        peer->buffer = pst->scratch + consumed * size;
+        consumed += max_length;
+        SC_ASSERT (consumed <= pst->my_count);
         peer->my_start = lo_data;
         mpiret = sc_MPI_Irecv (peer->buffer, bytes, sc_MPI_BYTE,
                                peer->prank, SC_TAG_PSORT_HI, pst->mpicomm,
@@ -188,7 +713,9 @@ sc_merge_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
         peer->sent = 0;
         peer->prank = lo_owner;
         peer->length = max_length;
-        peer->buffer = SC_ALLOC (char, bytes);
+        peer->buffer = pst->scratch + consumed * size;
+        consumed += max_length;
+        SC_ASSERT (consumed <= pst->my_count);
         peer->my_start = hi_data;
 
         mpiret = sc_MPI_Irecv (peer->buffer, bytes, sc_MPI_BYTE,
@@ -222,23 +749,11 @@ sc_merge_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
       SC_ASSERT (max_length > 0);
 
       if (lo_owner == rank && hi_owner == rank) {
-        size_t              zz;
-        char               *lo_data, *hi_data;
-        char               *temp = SC_ALLOC (char, size);
-
         /* local comparisons only */
-        lo_data = pst->my_base + (lo + offset - pst->my_lo) * size;
-        hi_data = pst->my_base + (hi_beg + offset - pst->my_lo) * size;
-        for (zz = 0; zz < max_length; ++zz) {
-          if (dir == (sc_compare (lo_data, hi_data) > 0)) {
-            memcpy (temp, lo_data, size);
-            memcpy (lo_data, hi_data, size);
-            memcpy (hi_data, temp, size);
-          }
-          lo_data += size;
-          hi_data += size;
-        }
-        SC_FREE (temp);
+        sc_psort_exchange (pst, dir, 0,
+                           pst->my_base + (lo + offset - pst->my_lo) * size,
+                           pst->my_base + (hi_beg + offset -
+                                           pst->my_lo) * size, max_length);
       }
     }
 
@@ -246,10 +761,14 @@ sc_merge_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
     outcount = 0;
     outcount2 = 0;
     num_peers = (int) pa->elem_count;
-    wait_indices = SC_ALLOC (int, num_peers);
-    wait_indices2 = SC_ALLOC (int, num_peers);
-    recv_statuses = SC_ALLOC (sc_MPI_Status, num_peers);
-    recv_statuses2 = SC_ALLOC (sc_MPI_Status, num_peers);
+    sc_psort_reserve (&pst->rindices, (size_t) num_peers);
+    sc_psort_reserve (&pst->sindices, (size_t) num_peers);
+    sc_psort_reserve (&pst->rstatuses, (size_t) num_peers);
+    sc_psort_reserve (&pst->sstatuses, (size_t) num_peers);
+    wait_indices = (int *) pst->rindices.array;
+    wait_indices2 = (int *) pst->sindices.array;
+    recv_statuses = (sc_MPI_Status *) pst->rstatuses.array;
+    recv_statuses2 = (sc_MPI_Status *) pst->sstatuses.array;
     for (remaining = num_peers, remaining2 = num_peers;
          remaining > 0 || remaining2 > 0;
          remaining -= outcount, remaining2 -= outcount2) {
@@ -263,8 +782,6 @@ sc_merge_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
         SC_ASSERT (outcount != sc_MPI_UNDEFINED);
         SC_ASSERT (outcount > 0);
         for (i = 0; i < outcount; ++i) {
-          size_t              zz;
-          char               *lo_data, *hi_data;
 #ifdef SC_ENABLE_DEBUG
           sc_MPI_Status      *jstatus;
 
@@ -282,30 +799,13 @@ sc_merge_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
 
             /* comparisons with remote peer */
             if (rank < peer->prank) {
-              lo_data = peer->my_start;
-              hi_data = peer->buffer;
-              for (zz = 0; zz < peer->length; ++zz) {
-                if (dir == (sc_compare (lo_data, hi_data) > 0)) {
-                  memcpy (lo_data, hi_data, size);
-                }
-                lo_data += size;
-                hi_data += size;
-              }
+              sc_psort_exchange (pst, dir, 1, peer->my_start, peer->buffer,
+                                 peer->length);
             }
             else {
-              lo_data = peer->buffer;
-              hi_data = peer->my_start;
-              for (zz = 0; zz < peer->length; ++zz) {
-                if (dir == (sc_compare (lo_data, hi_data) > 0)) {
-                  memcpy (hi_data, lo_data, size);
-                }
-                lo_data += size;
-                hi_data += size;
-              }
+              sc_psort_exchange (pst, dir, 2, peer->buffer, peer->my_start,
+                                 peer->length);
             }
-
-            /* close down this peer */
-            SC_FREE (peer->buffer);
           }
           peer->received = 1;
         }
@@ -319,9 +819,6 @@ sc_merge_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
         SC_ASSERT (outcount2 != sc_MPI_UNDEFINED);
         SC_ASSERT (outcount2 > 0);
         for (i = 0; i < outcount2; ++i) {
-          size_t              zz;
-          char               *lo_data, *hi_data;
-
           /* retrieve peer information */
           peer =
             (sc_psort_peer_t *) sc_array_index_int (pa, wait_indices2[i]);
@@ -331,30 +828,13 @@ sc_merge_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
 
             /* comparisons with remote peer */
             if (rank < peer->prank) {
-              lo_data = peer->my_start;
-              hi_data = peer->buffer;
-              for (zz = 0; zz < peer->length; ++zz) {
-                if (dir == (sc_compare (lo_data, hi_data) > 0)) {
-                  memcpy (lo_data, hi_data, size);
-                }
-                lo_data += size;
-                hi_data += size;
-              }
+              sc_psort_exchange (pst, dir, 1, peer->my_start, peer->buffer,
+                                 peer->length);
             }
             else {
-              lo_data = peer->buffer;
-              hi_data = peer->my_start;
-              for (zz = 0; zz < peer->length; ++zz) {
-                if (dir == (sc_compare (lo_data, hi_data) > 0)) {
-                  memcpy (hi_data, lo_data, size);
-                }
-                lo_data += size;
-                hi_data += size;
-              }
+              sc_psort_exchange (pst, dir, 2, peer->buffer, peer->my_start,
+                                 peer->length);
             }
-
-            /* close down this peer */
-            SC_FREE (peer->buffer);
           }
           peer->sent = 1;
         }
@@ -362,10 +842,6 @@ sc_merge_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
     }
     SC_ASSERT (remaining == 0);
     SC_ASSERT (remaining2 == 0);
-    SC_FREE (recv_statuses);
-    SC_FREE (wait_indices);
-    SC_FREE (recv_statuses2);
-    SC_FREE (wait_indices2);
 
     /* clean up */
     if (num_peers > 0) {
@@ -373,9 +849,9 @@ sc_merge_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
                                sc_MPI_STATUSES_IGNORE);
       SC_CHECK_MPI (mpiret);
     }
-    sc_array_reset (pa);
-    sc_array_reset (pr);
-    sc_array_reset (ps);
+    sc_array_truncate (pa);
+    sc_array_truncate (pr);
+    sc_array_truncate (ps);
 
     /* recursive merge */
     sc_merge_bitonic (pst, lo, lo + n2, dir);
@@ -390,8 +866,8 @@ sc_psort_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
 
   if (n > 1 && pst->my_hi > lo && pst->my_lo < hi) {
     if (lo >= pst->my_lo && hi <= pst->my_hi) {
-      qsort (pst->my_base + (lo - pst->my_lo) * pst->size,
-             n, pst->size, dir ? sc_compare : sc_icompare);
+      sc_psort_local (pst, pst->my_base + (lo - pst->my_lo) * pst->size,
+                      n, dir);
     }
     else {
       const size_t        n2 = n / 2;
@@ -406,6 +882,13 @@ sc_psort_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
 void
 sc_psort (sc_MPI_Comm mpicomm, void *base, size_t * nmemb, size_t size,
           int (*compar) (const void *, const void *))
+{
+  sc_psort_r (mpicomm, base, nmemb, size, sc_compare_plain, &compar);
+}
+
+void
+sc_psort_r (sc_MPI_Comm mpicomm, void *base, size_t * nmemb, size_t size,
+            sc_compare_r_t compar, void *arg)
 {
   int                 mpiret;
   int                 num_procs, rank;
@@ -414,8 +897,6 @@ sc_psort (sc_MPI_Comm mpicomm, void *base, size_t * nmemb, size_t size,
   size_t             *gmemb;
   sc_psort_t          pst;
 
-  SC_ASSERT (sc_compare == NULL);
-
   /* get basic MPI information */
   mpiret = sc_MPI_Comm_size (mpicomm, &num_procs);
   SC_CHECK_MPI (mpiret);
@@ -440,12 +921,35 @@ sc_psort (sc_MPI_Comm mpicomm, void *base, size_t * nmemb, size_t size,
   SC_ASSERT (pst.my_lo + pst.my_count == pst.my_hi);
   pst.gmemb = gmemb;
   pst.my_base = (char *) base;
-  sc_compare = compar;
+  pst.scratch = SC_ALLOC (char, pst.my_count * size);
+  pst.temp = SC_ALLOC (char, size);
+  sc_array_init (&pst.peers, sizeof (sc_psort_peer_t));
+  sc_array_init (&pst.rreqs, sizeof (sc_MPI_Request));
+  sc_array_init (&pst.sreqs, sizeof (sc_MPI_Request));
+  sc_array_init (&pst.rindices, sizeof (int));
+  sc_array_init (&pst.sindices, sizeof (int));
+  sc_array_init (&pst.rstatuses, sizeof (sc_MPI_Status));
+  sc_array_init (&pst.sstatuses, sizeof (sc_MPI_Status));
+  pst.compar = compar;
+  pst.arg = arg;
+  pst.pool = sc_taskpool_global_lookup ();
+  pst.num_threads = pst.pool == NULL ? 0 : sc_taskpool_num_threads (pst.pool);
+  if (pst.num_threads == 0) {
+    pst.pool = NULL;
+  }
   total = gmemb[num_procs];
   SC_GLOBAL_LDEBUGF ("Total values to sort %lld\n", (long long) total);
   sc_psort_bitonic (&pst, 0, total, 1);
 
   /* clean up and free memory */
-  sc_compare = NULL;
+  sc_array_reset (&pst.peers);
+  sc_array_reset (&pst.rreqs);
+  sc_array_reset (&pst.sreqs);
+  sc_array_reset (&pst.rindices);
+  sc_array_reset (&pst.sindices);
+  sc_array_reset (&pst.rstatuses);
+  sc_array_reset (&pst.sstatuses);
+  SC_FREE (pst.scratch);
+  SC_FREE (pst.temp);
   SC_FREE (gmemb);
 }
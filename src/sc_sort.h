@@ -28,9 +28,26 @@
 
 SC_EXTERN_C_BEGIN;
 
+/** Sort an array with a comparison function that takes a context.
+ * This is an introsort: a quicksort with median-of-three pivots that
+ * switches to heapsort if the recursion gets too deep and to insertion
+ * sort on short ranges.  It is not stable.  Unlike qsort_r, it is
+ * available on every system, and it is safe to call from several threads.
+ * \param [in,out] base        Array to sort.
+ * \param [in] nmemb           Number of entries in the array.
+ * \param [in] size            Size in bytes of each entry.
+ * \param [in] compar          Comparison function.
+ * \param [in] arg             Passed to \b compar.
+ */
+void                sc_qsort_r (void *base, size_t nmemb, size_t size,
+                                sc_compare_r_t compar, void *arg);
+
 /** Sort a distributed set of values in parallel.
- * This algorithm uses bitonic sort between processors and qsort locally.
- * The partition of the data can be arbitrary and is not changed.
+ * This algorithm uses bitonic sort between processors and \ref sc_qsort_r
+ * locally.  The partition of the data can be arbitrary and is not changed.
+ * If the global task pool has worker threads (see \ref sc_taskpool_global),
+ * the local sorting, merging and comparisons of large ranges are threaded,
+ * while all communication is issued by the calling thread.
  * \param [in] mpicomm          Communicator to use.
  * \param [in] base             Pointer to the local subset of data.
  * \param [in] nmemb            Array of mpisize counts of local data.
@@ -41,6 +58,20 @@ void                sc_psort (sc_MPI_Comm mpicomm, void *base,
                               size_t * nmemb, size_t size,
                               int (*compar) (const void *, const void *));
 
+/** Sort a distributed set of values in parallel with a context argument.
+ * This function is like \ref sc_psort but has no global state, so it
+ * may run concurrently on different communicators.
+ * \param [in] mpicomm          Communicator to use.
+ * \param [in] base             Pointer to the local subset of data.
+ * \param [in] nmemb            Array of mpisize counts of local data.
+ * \param [in] size             Size in bytes of each data value.
+ * \param [in] compar           Comparison function to use.
+ * \param [in] arg              Passed to \b compar.
+ */
+void                sc_psort_r (sc_MPI_Comm mpicomm, void *base,
+                                size_t * nmemb, size_t size,
+                                sc_compare_r_t compar, void *arg);
+
 SC_EXTERN_C_END;
 
 #endif /* SC_SORT_H */
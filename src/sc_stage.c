@@ -0,0 +1,401 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_stage.h>
+#include <sc_ringbuf.h>
+#include <errno.h>
+#ifdef SC_HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+#ifdef SC_HAVE_FSYNC
+#include <fcntl.h>
+#endif
+
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#define SC_STAGE_THREAD
+#endif
+
+/** Size of the buffer used to copy a staged file. */
+#define SC_STAGE_BUFFER (1 << 20)
+
+/** Number of closed files that may wait for the drain. */
+#define SC_STAGE_QUEUE 64
+
+/** Suffix of the final name while the copy is in progress. */
+#define SC_STAGE_PARTIAL ".part"
+
+typedef struct sc_stage_job
+{
+  sc_io_sink_t       *sink;     /**< the open sink or NULL */
+  char                staged[BUFSIZ];
+  char                final[BUFSIZ];
+}
+sc_stage_job_t;
+
+struct sc_stage
+{
+  char                dir[BUFSIZ];
+  long                pid;
+  int                 num_opened;
+  int                 num_closed;
+  int                 num_drained;      /**< protected by the mutex */
+  int                 num_errors;       /**< protected by the mutex */
+  sc_array_t          open;     /**< pointers to the jobs of open files */
+  sc_ringbuf_t       *queue;    /**< closed files waiting for the drain */
+#ifdef SC_STAGE_THREAD
+  pthread_t           thread;
+  pthread_mutex_t     mutex;
+  pthread_cond_t      cond;
+#endif
+};
+
+/** Make a renamed file durable by syncing the directory that contains it.
+ * \return          0 on success, nonzero otherwise.
+ */
+static int
+sc_stage_sync_dir (const char *filename)
+{
+#ifdef SC_HAVE_FSYNC
+  int                 fd, retval;
+  char                dir[BUFSIZ];
+  const char         *slash;
+
+  slash = strrchr (filename, '/');
+  if (slash == NULL) {
+    snprintf (dir, BUFSIZ, ".");
+  }
+  else {
+    /* keep the slash of the root directory */
+    snprintf (dir, BUFSIZ, "%.*s",
+              (int) (slash - filename) + (slash == filename), filename);
+  }
+  fd = open (dir, O_RDONLY);
+  if (fd < 0) {
+    return -1;
+  }
+
+  /* some file systems cannot sync directories and say so by EINVAL */
+  retval = fsync (fd) && errno != EINVAL;
+  retval = close (fd) || retval;
+  return retval;
+#else
+  return 0;
+#endif
+}
+
+/** Copy a staged file durably to its final name and remove it.
+ * \return          0 on success, nonzero otherwise.
+ */
+static int
+sc_stage_copy (const char *staged, const char *final)
+{
+  int                 retval;
+  size_t              bytes;
+  char                partial[BUFSIZ];
+  char               *buffer;
+  FILE               *fin, *fout;
+
+  if (snprintf (partial, BUFSIZ, "%s" SC_STAGE_PARTIAL, final) >= BUFSIZ) {
+    SC_LERRORF ("Stage file name too long: %s\n", final);
+    return -1;
+  }
+  fin = fopen (staged, "rb");
+  if (fin == NULL) {
+    SC_LERRORF ("Stage open %s: %s\n", staged, strerror (errno));
+    return -1;
+  }
+  fout = fopen (partial, "wb");
+  if (fout == NULL) {
+    SC_LERRORF ("Stage open %s: %s\n", partial, strerror (errno));
+    fclose (fin);
+    return -1;
+  }
+
+  retval = 0;
+  buffer = SC_ALLOC (char, SC_STAGE_BUFFER);
+  while ((bytes = fread (buffer, 1, SC_STAGE_BUFFER, fin)) > 0) {
+    if (fwrite (buffer, 1, bytes, fout) != bytes) {
+      retval = -1;
+      break;
+    }
+  }
+  SC_FREE (buffer);
+  retval = retval || ferror (fin) || fflush (fout);
+#ifdef SC_HAVE_FSYNC
+  retval = retval || fsync (fileno (fout));
+#endif
+  retval = fclose (fout) || retval;
+  fclose (fin);
+
+  /* the final name appears only with complete contents */
+  retval = retval || rename (partial, final);
+  if (retval) {
+    SC_LERRORF ("Stage drain %s: %s\n", final, strerror (errno));
+    remove (partial);
+    return -1;
+  }
+
+  /* the staged copy goes only when the rename has reached the disk */
+  if (sc_stage_sync_dir (final)) {
+    SC_LERRORF ("Stage sync %s: %s\n", final, strerror (errno));
+    return -1;
+  }
+  remove (staged);
+  return 0;
+}
+
+/** Drain one job and record its completion. */
+static void
+sc_stage_drain (sc_stage_t * stage, sc_stage_job_t * job)
+{
+  int                 retval;
+
+  retval = sc_stage_copy (job->staged, job->final);
+  SC_FREE (job);
+
+#ifdef SC_STAGE_THREAD
+  pthread_mutex_lock (&stage->mutex);
+#endif
+  ++stage->num_drained;
+  stage->num_errors += retval != 0;
+#ifdef SC_STAGE_THREAD
+  pthread_cond_broadcast (&stage->cond);
+  pthread_mutex_unlock (&stage->mutex);
+#endif
+}
+
+#ifdef SC_STAGE_THREAD
+
+static void        *
+sc_stage_drain_main (void *v)
+{
+  sc_stage_t         *stage = (sc_stage_t *) v;
+  sc_stage_job_t     *job;
+
+  while (sc_ringbuf_pop (stage->queue, &job)) {
+    sc_stage_drain (stage, job);
+  }
+  return NULL;
+}
+
+#else
+
+/** Drain the queued jobs in the calling thread. */
+static void
+sc_stage_drain_queue (sc_stage_t * stage)
+{
+  sc_stage_job_t     *job;
+
+  while (sc_ringbuf_try_pop (stage->queue, &job)) {
+    sc_stage_drain (stage, job);
+  }
+}
+
+#endif
+
+sc_stage_t         *
+sc_stage_new (const char *stage_dir)
+{
+  sc_stage_t         *stage;
+#ifdef SC_STAGE_THREAD
+  int                 pth;
+#endif
+
+  SC_ASSERT (stage_dir != NULL);
+
+#ifdef SC_HAVE_SYS_STAT_H
+  if (mkdir (stage_dir, 0777) && errno != EEXIST) {
+    SC_LERRORF ("Stage directory %s: %s\n", stage_dir, strerror (errno));
+    return NULL;
+  }
+#endif
+
+  stage = SC_ALLOC_ZERO (sc_stage_t, 1);
+  snprintf (stage->dir, BUFSIZ, "%s", stage_dir);
+  stage->pid = (long) getpid ();
+  sc_array_init (&stage->open, sizeof (sc_stage_job_t *));
+  stage->queue = sc_ringbuf_new (sizeof (sc_stage_job_t *), SC_STAGE_QUEUE);
+#ifdef SC_STAGE_THREAD
+  pthread_mutex_init (&stage->mutex, NULL);
+  pthread_cond_init (&stage->cond, NULL);
+  pth = pthread_create (&stage->thread, NULL, sc_stage_drain_main, stage);
+  SC_CHECK_ABORT (pth == 0, "Stage drain thread creation");
+#endif
+
+  return stage;
+}
+
+int
+sc_stage_destroy (sc_stage_t * stage)
+{
+  int                 retval;
+  sc_stage_job_t     *job;
+#ifdef SC_STAGE_THREAD
+  int                 pth;
+#endif
+
+  while (stage->open.elem_count > 0) {
+    job = *(sc_stage_job_t **) sc_array_index (&stage->open, 0);
+    sc_stage_close (stage, job->sink);
+  }
+  sc_array_reset (&stage->open);
+
+  /* the drain finishes the queue after it is closed */
+  sc_ringbuf_close (stage->queue);
+#ifdef SC_STAGE_THREAD
+  pth = pthread_join (stage->thread, NULL);
+  SC_CHECK_ABORT (pth == 0, "Stage drain thread join");
+  pthread_cond_destroy (&stage->cond);
+  pthread_mutex_destroy (&stage->mutex);
+#else
+  sc_stage_drain_queue (stage);
+#endif
+  SC_ASSERT (stage->num_drained == stage->num_closed);
+  sc_ringbuf_destroy (stage->queue);
+
+  retval = stage->num_errors;
+  SC_FREE (stage);
+  return retval;
+}
+
+sc_io_sink_t       *
+sc_stage_open (sc_stage_t * stage, const char *filename)
+{
+  const char         *base;
+  sc_stage_job_t     *job;
+
+  SC_ASSERT (filename != NULL);
+
+  /* the staged name is unique among the processes sharing the directory */
+  base = strrchr (filename, '/');
+  base = base == NULL ? filename : base + 1;
+  job = SC_ALLOC (sc_stage_job_t, 1);
+
+  /* the final name must leave room for the suffix of the partial copy */
+  if (snprintf (job->staged, BUFSIZ, "%s/%ld.%d.%s", stage->dir,
+                stage->pid, stage->num_opened, base) >= BUFSIZ ||
+      strlen (filename) + sizeof (SC_STAGE_PARTIAL) > BUFSIZ) {
+    SC_LERRORF ("Stage file name too long: %s\n", filename);
+    SC_FREE (job);
+    return NULL;
+  }
+  strcpy (job->final, filename);
+  job->sink = sc_io_sink_new (SC_IO_TYPE_FILENAME, SC_IO_MODE_WRITE,
+                              SC_IO_ENCODE_NONE, job->staged);
+  if (job->sink == NULL) {
+    SC_LERRORF ("Stage open %s: %s\n", job->staged, strerror (errno));
+    SC_FREE (job);
+    return NULL;
+  }
+
+  ++stage->num_opened;
+  *(sc_stage_job_t **) sc_array_push (&stage->open) = job;
+  return job->sink;
+}
+
+int
+sc_stage_close (sc_stage_t * stage, sc_io_sink_t * sink)
+{
+  size_t              iz;
+  sc_stage_job_t     *job, *last;
+
+  SC_ASSERT (sink != NULL);
+
+  for (iz = 0; iz < stage->open.elem_count; ++iz) {
+    job = *(sc_stage_job_t **) sc_array_index (&stage->open, iz);
+    if (job->sink == sink) {
+      break;
+    }
+  }
+  SC_CHECK_ABORT (iz < stage->open.elem_count, "Stage sink not open");
+  last = *(sc_stage_job_t **) sc_array_pop (&stage->open);
+  if (iz < stage->open.elem_count) {
+    *(sc_stage_job_t **) sc_array_index (&stage->open, iz) = last;
+  }
+
+  /* a staged file that is incomplete is not drained */
+  job->sink = NULL;
+  if (sc_io_sink_destroy (sink)) {
+    SC_LERRORF ("Stage close %s\n", job->staged);
+    remove (job->staged);
+    SC_FREE (job);
+    return -1;
+  }
+
+#ifdef SC_STAGE_THREAD
+  sc_ringbuf_push (stage->queue, &job);
+#else
+  if (!sc_ringbuf_try_push (stage->queue, &job)) {
+    sc_stage_drain_queue (stage);
+    sc_ringbuf_push (stage->queue, &job);
+  }
+#endif
+  return stage->num_closed++;
+}
+
+int
+sc_stage_test (sc_stage_t * stage, int ticket)
+{
+  int                 drained;
+
+  SC_ASSERT (0 <= ticket && ticket < stage->num_closed);
+
+#ifdef SC_STAGE_THREAD
+  pthread_mutex_lock (&stage->mutex);
+#endif
+  drained = ticket < stage->num_drained;
+#ifdef SC_STAGE_THREAD
+  pthread_mutex_unlock (&stage->mutex);
+#endif
+  return drained;
+}
+
+int
+sc_stage_sync (sc_stage_t * stage, sc_MPI_Comm mpicomm)
+{
+  int                 mpiret;
+  int                 errors, global;
+
+#ifdef SC_STAGE_THREAD
+  pthread_mutex_lock (&stage->mutex);
+  while (stage->num_drained < stage->num_closed) {
+    pthread_cond_wait (&stage->cond, &stage->mutex);
+  }
+  errors = stage->num_errors;
+  stage->num_errors = 0;
+  pthread_mutex_unlock (&stage->mutex);
+#else
+  sc_stage_drain_queue (stage);
+  errors = stage->num_errors;
+  stage->num_errors = 0;
+#endif
+
+  if (mpicomm != sc_MPI_COMM_NULL) {
+    mpiret = sc_MPI_Allreduce (&errors, &global, 1, sc_MPI_INT, sc_MPI_SUM,
+                               mpicomm);
+    SC_CHECK_MPI (mpiret);
+    errors = global;
+  }
+  return errors != 0;
+}
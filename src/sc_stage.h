@@ -0,0 +1,107 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef SC_STAGE_H
+#define SC_STAGE_H
+
+/** \file sc_stage.h
+ * This file provides a staging tier for files written in bursts.
+ *
+ * Files are written through ordinary file sinks into a fast directory,
+ * usually on a node-local disk or a memory file system.  Closing such a
+ * file hands it to a drain that copies it to its final name in the
+ * background and removes the staged copy.  The final file is written
+ * under a temporary name, synchronized to disk and renamed, so it is
+ * either complete or absent.  Drains run in the order of closing.
+ *
+ * Each closed file has a ticket to query its completion.  Before the
+ * staged data are needed again, for example before the next checkpoint,
+ * \ref sc_stage_sync waits until all files are durable.
+ *
+ * With --enable-pthread the drain runs on a thread of its own.  Otherwise
+ * the drain is deferred to \ref sc_stage_sync and \ref sc_stage_destroy,
+ * which still frees the writers from waiting for the final file system.
+ */
+
+#include <sc_io.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** A staging directory with its drain; opaque structure. */
+typedef struct sc_stage sc_stage_t;
+
+/** Create a staging tier.
+ * \param [in] stage_dir    Directory for the staged files.  It is created
+ *                          if it does not exist.  Several processes may
+ *                          share it.
+ * \return                  A valid object, or NULL if the directory is not
+ *                          usable.
+ */
+sc_stage_t         *sc_stage_new (const char *stage_dir);
+
+/** Destroy a staging tier after draining all closed files.
+ * Files still open are closed and drained first.
+ * \param [in,out] stage    This object is invalidated.
+ * \return                  0 on success, nonzero if some drain failed
+ *                          since the last \ref sc_stage_sync.
+ */
+int                 sc_stage_destroy (sc_stage_t * stage);
+
+/** Open a staged file for writing.
+ * \param [in,out] stage    Valid staging tier.
+ * \param [in] filename     The final name of the file.
+ * \return                  A file sink in the staging directory, or NULL
+ *                          on error.  It must be closed with
+ *                          \ref sc_stage_close.
+ */
+sc_io_sink_t       *sc_stage_open (sc_stage_t * stage, const char *filename);
+
+/** Close a staged file and queue it for draining.
+ * \param [in,out] stage    Valid staging tier.
+ * \param [in,out] sink     A sink returned by \ref sc_stage_open.  It is
+ *                          destroyed.
+ * \return                  A nonnegative ticket for \ref sc_stage_test,
+ *                          or -1 if the sink could not be completed.
+ */
+int                 sc_stage_close (sc_stage_t * stage, sc_io_sink_t * sink);
+
+/** Query whether a closed file has been drained.
+ * \param [in] stage        Valid staging tier.
+ * \param [in] ticket       A ticket returned by \ref sc_stage_close.
+ * \return                  True if the drain is finished, whether or not
+ *                          it was successful.
+ */
+int                 sc_stage_test (sc_stage_t * stage, int ticket);
+
+/** Wait until all closed files are durable at their final names.
+ * \param [in,out] stage    Valid staging tier.
+ * \param [in] mpicomm      If not sc_MPI_COMM_NULL, the call is collective
+ *                          and returns the same value on all processes.
+ * \return                  0 on success, nonzero if some drain failed
+ *                          since the previous call.
+ */
+int                 sc_stage_sync (sc_stage_t * stage, sc_MPI_Comm mpicomm);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_STAGE_H */
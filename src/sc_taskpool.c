@@ -0,0 +1,655 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/* we need CPU_SET and pthread_setaffinity_np for pinning */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <sc_private.h>
+#include <sc_taskpool.h>
+
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#ifdef SC_HAVE_PTHREAD_SETAFFINITY_NP
+#include <sched.h>
+#endif
+#endif
+
+typedef struct sc_task
+{
+  sc_task_function_t  fn;
+  void               *data;
+  sc_taskgroup_t     *group;
+}
+sc_task_t;
+
+#ifdef SC_ENABLE_PTHREAD
+
+/** Queue of tasks with two ends.
+ * The owner pushes and pops at the tail, thieves take from the head.
+ * The capacity is a power of two and the indices grow without bound.
+ */
+typedef struct sc_taskpool_deque
+{
+  pthread_mutex_t     mutex;
+  sc_task_t          *tasks;
+  size_t              capacity;
+  size_t              head, tail;
+}
+sc_taskpool_deque_t;
+
+typedef struct sc_taskpool_worker
+{
+  sc_taskpool_t      *pool;
+  int                 id;
+  pthread_t           thread;
+}
+sc_taskpool_worker_t;
+
+#endif /* SC_ENABLE_PTHREAD */
+
+struct sc_taskpool
+{
+  int                 num_threads;
+  int                 pin;
+#ifdef SC_ENABLE_PTHREAD
+  sc_taskpool_worker_t *workers;
+
+  /* one deque per worker and a last one for all other threads */
+  sc_taskpool_deque_t *deques;
+  int                 num_deques;
+
+  /* number of tasks in all deques; it is updated after the push and
+     after the take and may thus be off briefly, even negative */
+  int                 queued;
+
+  /* number of workers sleeping or about to sleep on the condition */
+  int                 sleeping;
+#ifndef SC_HAVE_ATOMIC_BUILTINS
+  pthread_mutex_t     count_mutex;
+#endif
+
+  /* the pool mutex protects the shutdown flag and the sleep */
+  pthread_mutex_t     mutex;
+  pthread_cond_t      cond;
+  int                 shutdown;
+
+  /* thread-specific pointer to the worker structure */
+  pthread_key_t       key;
+#endif
+};
+
+struct sc_taskgroup
+{
+  sc_taskpool_t      *pool;
+  int                 pending;
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_t     mutex;
+  pthread_cond_t      cond;
+#endif
+};
+
+static sc_taskpool_t *sc_taskpool_global_pool = NULL;
+
+static void
+sc_taskgroup_run (sc_task_t * task)
+{
+  sc_taskgroup_t     *group = task->group;
+
+  task->fn (task->data);
+
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_lock (&group->mutex);
+  SC_ASSERT (group->pending > 0);
+  if (--group->pending == 0) {
+    pthread_cond_broadcast (&group->cond);
+  }
+  pthread_mutex_unlock (&group->mutex);
+#else
+  SC_ASSERT (group->pending > 0);
+  --group->pending;
+#endif
+}
+
+#ifdef SC_ENABLE_PTHREAD
+
+/** Add to a counter of the pool and return the new value.
+ * With atomic builtins the update is sequentially consistent, which the
+ * handshake between spawning and sleeping threads relies on.
+ */
+static int
+sc_taskpool_count_add (sc_taskpool_t * pool, int *counter, int increment)
+{
+#ifdef SC_HAVE_ATOMIC_BUILTINS
+  return __atomic_add_fetch (counter, increment, __ATOMIC_SEQ_CST);
+#else
+  int                 value;
+
+  pthread_mutex_lock (&pool->count_mutex);
+  value = *counter += increment;
+  pthread_mutex_unlock (&pool->count_mutex);
+  return value;
+#endif
+}
+
+/** Read a counter that may be updated by \ref sc_taskpool_count_add. */
+static int
+sc_taskpool_count_get (sc_taskpool_t * pool, int *counter)
+{
+  return sc_taskpool_count_add (pool, counter, 0);
+}
+
+static void
+sc_taskpool_deque_init (sc_taskpool_deque_t * deque)
+{
+  pthread_mutex_init (&deque->mutex, NULL);
+  deque->capacity = 64;
+  deque->tasks = SC_ALLOC (sc_task_t, deque->capacity);
+  deque->head = deque->tail = 0;
+}
+
+static void
+sc_taskpool_deque_reset (sc_taskpool_deque_t * deque)
+{
+  SC_ASSERT (deque->head == deque->tail);
+  SC_FREE (deque->tasks);
+  pthread_mutex_destroy (&deque->mutex);
+}
+
+static void
+sc_taskpool_deque_push (sc_taskpool_deque_t * deque, const sc_task_t * task)
+{
+  size_t              i, count;
+  sc_task_t          *tasks;
+
+  pthread_mutex_lock (&deque->mutex);
+  count = deque->tail - deque->head;
+  if (count == deque->capacity) {
+    /* double the capacity and unwrap the ring */
+    tasks = SC_ALLOC (sc_task_t, 2 * deque->capacity);
+    for (i = 0; i < count; ++i) {
+      tasks[i] = deque->tasks[(deque->head + i) & (deque->capacity - 1)];
+    }
+    SC_FREE (deque->tasks);
+    deque->tasks = tasks;
+    deque->capacity *= 2;
+    deque->head = 0;
+    deque->tail = count;
+  }
+  deque->tasks[deque->tail++ & (deque->capacity - 1)] = *task;
+  pthread_mutex_unlock (&deque->mutex);
+}
+
+/** Take a task from one end of a deque.
+ * \param [in] from_tail    The owner takes the newest task, a thief the
+ *                          oldest one, which tends to be the largest.
+ * \return                  True if a task was taken.
+ */
+static int
+sc_taskpool_deque_take (sc_taskpool_deque_t * deque, int from_tail,
+                        sc_task_t * task)
+{
+  int                 found = 0;
+
+  pthread_mutex_lock (&deque->mutex);
+  if (deque->head != deque->tail) {
+    if (from_tail) {
+      *task = deque->tasks[--deque->tail & (deque->capacity - 1)];
+    }
+    else {
+      *task = deque->tasks[deque->head++ & (deque->capacity - 1)];
+    }
+    found = 1;
+  }
+  pthread_mutex_unlock (&deque->mutex);
+  return found;
+}
+
+/** Return the deque the calling thread pushes to and pops from. */
+static int
+sc_taskpool_own_deque (sc_taskpool_t * pool)
+{
+  sc_taskpool_worker_t *worker;
+
+  worker = (sc_taskpool_worker_t *) pthread_getspecific (pool->key);
+  return worker != NULL ? worker->id : pool->num_threads;
+}
+
+/** Find a task in the own deque first and steal from others if empty.
+ * \return                  True if a task was found.
+ */
+static int
+sc_taskpool_take (sc_taskpool_t * pool, int own, sc_task_t * task)
+{
+  int                 i, victim;
+
+  if (!sc_taskpool_deque_take (pool->deques + own, 1, task)) {
+    for (i = 1; i < pool->num_deques; ++i) {
+      victim = (own + i) % pool->num_deques;
+      if (sc_taskpool_deque_take (pool->deques + victim, 0, task)) {
+        break;
+      }
+    }
+    if (i == pool->num_deques) {
+      return 0;
+    }
+  }
+
+  sc_taskpool_count_add (pool, &pool->queued, -1);
+  return 1;
+}
+
+static void
+sc_taskpool_pin (sc_taskpool_worker_t * worker)
+{
+#ifdef SC_HAVE_PTHREAD_SETAFFINITY_NP
+  long                ncores;
+  cpu_set_t           cpuset;
+
+  ncores = sysconf (_SC_NPROCESSORS_ONLN);
+  if (ncores > 0) {
+    CPU_ZERO (&cpuset);
+    CPU_SET ((int) (worker->id % ncores), &cpuset);
+    if (pthread_setaffinity_np (worker->thread, sizeof (cpu_set_t),
+                                &cpuset)) {
+      SC_LERRORF ("Failed to pin worker %d\n", worker->id);
+    }
+  }
+#endif
+}
+
+static void        *
+sc_taskpool_worker_main (void *v)
+{
+  sc_taskpool_worker_t *worker = (sc_taskpool_worker_t *) v;
+  sc_taskpool_t      *pool = worker->pool;
+  sc_task_t           task;
+
+  pthread_setspecific (pool->key, worker);
+  if (pool->pin) {
+    sc_taskpool_pin (worker);
+  }
+
+  for (;;) {
+    if (sc_taskpool_take (pool, worker->id, &task)) {
+      sc_taskgroup_run (&task);
+      continue;
+    }
+
+    /* sleep until new tasks are spawned or the pool shuts down; we
+       announce the sleep before checking the count, and a spawner counts
+       its task before checking for sleepers, so one sees the other */
+    pthread_mutex_lock (&pool->mutex);
+    sc_taskpool_count_add (pool, &pool->sleeping, 1);
+    while (sc_taskpool_count_get (pool, &pool->queued) <= 0 &&
+           !pool->shutdown) {
+      pthread_cond_wait (&pool->cond, &pool->mutex);
+    }
+    sc_taskpool_count_add (pool, &pool->sleeping, -1);
+    if (sc_taskpool_count_get (pool, &pool->queued) <= 0 && pool->shutdown) {
+      pthread_mutex_unlock (&pool->mutex);
+      break;
+    }
+    pthread_mutex_unlock (&pool->mutex);
+  }
+
+  return NULL;
+}
+
+#endif /* SC_ENABLE_PTHREAD */
+
+sc_taskpool_t      *
+sc_taskpool_new (int num_threads, int pin)
+{
+  sc_taskpool_t      *pool;
+#ifdef SC_ENABLE_PTHREAD
+  int                 i;
+  int                 pth;
+  sc_taskpool_worker_t *worker;
+#endif
+
+  SC_ASSERT (num_threads >= 0);
+
+  pool = SC_ALLOC_ZERO (sc_taskpool_t, 1);
+#ifdef SC_ENABLE_PTHREAD
+  pool->num_threads = num_threads;
+  pool->pin = pin;
+  if (num_threads == 0) {
+    return pool;
+  }
+
+#ifndef SC_HAVE_ATOMIC_BUILTINS
+  pthread_mutex_init (&pool->count_mutex, NULL);
+#endif
+  pthread_mutex_init (&pool->mutex, NULL);
+  pthread_cond_init (&pool->cond, NULL);
+  pth = pthread_key_create (&pool->key, NULL);
+  SC_CHECK_ABORT (pth == 0, "Task pool key creation");
+
+  pool->num_deques = num_threads + 1;
+  pool->deques = SC_ALLOC (sc_taskpool_deque_t, pool->num_deques);
+  for (i = 0; i < pool->num_deques; ++i) {
+    sc_taskpool_deque_init (pool->deques + i);
+  }
+
+  pool->workers = SC_ALLOC (sc_taskpool_worker_t, num_threads);
+  for (i = 0; i < num_threads; ++i) {
+    worker = pool->workers + i;
+    worker->pool = pool;
+    worker->id = i;
+    pth = pthread_create (&worker->thread, NULL,
+                          sc_taskpool_worker_main, worker);
+    SC_CHECK_ABORT (pth == 0, "Task pool thread creation");
+  }
+#else
+  pool->num_threads = 0;
+  pool->pin = pin;
+#endif
+
+  return pool;
+}
+
+void
+sc_taskpool_destroy (sc_taskpool_t * pool)
+{
+#ifdef SC_ENABLE_PTHREAD
+  int                 i;
+  int                 pth;
+#endif
+
+  SC_ASSERT (pool != NULL);
+
+#ifdef SC_ENABLE_PTHREAD
+  if (pool->num_threads > 0) {
+    pthread_mutex_lock (&pool->mutex);
+    SC_ASSERT (sc_taskpool_count_get (pool, &pool->queued) == 0);
+    pool->shutdown = 1;
+    pthread_cond_broadcast (&pool->cond);
+    pthread_mutex_unlock (&pool->mutex);
+
+    for (i = 0; i < pool->num_threads; ++i) {
+      pth = pthread_join (pool->workers[i].thread, NULL);
+      SC_CHECK_ABORT (pth == 0, "Task pool thread join");
+    }
+    SC_FREE (pool->workers);
+
+    for (i = 0; i < pool->num_deques; ++i) {
+      sc_taskpool_deque_reset (pool->deques + i);
+    }
+    SC_FREE (pool->deques);
+
+    pthread_key_delete (pool->key);
+    pthread_cond_destroy (&pool->cond);
+    pthread_mutex_destroy (&pool->mutex);
+#ifndef SC_HAVE_ATOMIC_BUILTINS
+    pthread_mutex_destroy (&pool->count_mutex);
+#endif
+  }
+#endif
+
+  SC_FREE (pool);
+}
+
+int
+sc_taskpool_num_threads (sc_taskpool_t * pool)
+{
+  SC_ASSERT (pool != NULL);
+
+  return pool->num_threads;
+}
+
+int
+sc_taskpool_thread_id (sc_taskpool_t * pool)
+{
+#ifdef SC_ENABLE_PTHREAD
+  sc_taskpool_worker_t *worker;
+#endif
+
+  SC_ASSERT (pool != NULL);
+
+#ifdef SC_ENABLE_PTHREAD
+  if (pool->num_threads > 0) {
+    worker = (sc_taskpool_worker_t *) pthread_getspecific (pool->key);
+    return worker != NULL ? worker->id + 1 : 0;
+  }
+#endif
+  return 0;
+}
+
+sc_taskgroup_t     *
+sc_taskgroup_new (sc_taskpool_t * pool)
+{
+  sc_taskgroup_t     *group;
+
+  SC_ASSERT (pool != NULL);
+
+  group = SC_ALLOC (sc_taskgroup_t, 1);
+  group->pool = pool;
+  group->pending = 0;
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_init (&group->mutex, NULL);
+  pthread_cond_init (&group->cond, NULL);
+#endif
+
+  return group;
+}
+
+void
+sc_taskgroup_destroy (sc_taskgroup_t * group)
+{
+  SC_ASSERT (group != NULL);
+  SC_ASSERT (group->pending == 0);
+
+#ifdef SC_ENABLE_PTHREAD
+  pthread_cond_destroy (&group->cond);
+  pthread_mutex_destroy (&group->mutex);
+#endif
+  SC_FREE (group);
+}
+
+void
+sc_taskgroup_spawn (sc_taskgroup_t * group, sc_task_function_t fn,
+                    void *data)
+{
+  sc_task_t           task;
+#ifdef SC_ENABLE_PTHREAD
+  sc_taskpool_t      *pool;
+#endif
+
+  SC_ASSERT (group != NULL);
+  SC_ASSERT (fn != NULL);
+
+  task.fn = fn;
+  task.data = data;
+  task.group = group;
+
+#ifdef SC_ENABLE_PTHREAD
+  pool = group->pool;
+  if (pool->num_threads > 0) {
+    pthread_mutex_lock (&group->mutex);
+    ++group->pending;
+    pthread_mutex_unlock (&group->mutex);
+
+    /* publish the task before counting it, and wake a worker only
+       if one is sleeping */
+    sc_taskpool_deque_push (pool->deques + sc_taskpool_own_deque (pool),
+                            &task);
+    sc_taskpool_count_add (pool, &pool->queued, 1);
+    if (sc_taskpool_count_get (pool, &pool->sleeping) > 0) {
+      pthread_mutex_lock (&pool->mutex);
+      pthread_cond_signal (&pool->cond);
+      pthread_mutex_unlock (&pool->mutex);
+    }
+    return;
+  }
+#endif
+
+  /* without workers the task runs right away */
+  ++group->pending;
+  sc_taskgroup_run (&task);
+}
+
+void
+sc_taskgroup_wait (sc_taskgroup_t * group)
+{
+#ifdef SC_ENABLE_PTHREAD
+  int                 own;
+  sc_taskpool_t      *pool;
+  sc_task_t           task;
+#endif
+
+  SC_ASSERT (group != NULL);
+
+#ifdef SC_ENABLE_PTHREAD
+  pool = group->pool;
+  if (pool->num_threads > 0) {
+    own = sc_taskpool_own_deque (pool);
+    for (;;) {
+      pthread_mutex_lock (&group->mutex);
+      if (group->pending == 0) {
+        pthread_mutex_unlock (&group->mutex);
+        break;
+      }
+      pthread_mutex_unlock (&group->mutex);
+
+      /* help out while the group is not done */
+      if (sc_taskpool_take (pool, own, &task)) {
+        sc_taskgroup_run (&task);
+        continue;
+      }
+
+      /* all remaining tasks are running on other threads */
+      pthread_mutex_lock (&group->mutex);
+      while (group->pending > 0) {
+        pthread_cond_wait (&group->cond, &group->mutex);
+      }
+      pthread_mutex_unlock (&group->mutex);
+    }
+  }
+#endif
+
+  SC_ASSERT (group->pending == 0);
+}
+
+typedef struct sc_taskpool_range
+{
+  sc_taskgroup_t     *group;
+  sc_range_function_t fn;
+  void               *data;
+  size_t              begin, end;
+  size_t              grain;
+}
+sc_taskpool_range_t;
+
+static void
+sc_taskpool_range_task (void *v)
+{
+  sc_taskpool_range_t *range = (sc_taskpool_range_t *) v;
+  sc_taskpool_range_t *half;
+  size_t              mid;
+
+  /* split off the upper half until the range is small enough */
+  while (range->end - range->begin > range->grain) {
+    mid = range->begin + (range->end - range->begin) / 2;
+    half = SC_ALLOC (sc_taskpool_range_t, 1);
+    *half = *range;
+    half->begin = mid;
+    range->end = mid;
+    sc_taskgroup_spawn (range->group, sc_taskpool_range_task, half);
+  }
+  range->fn (range->begin, range->end, range->data);
+  SC_FREE (range);
+}
+
+void
+sc_taskpool_parallel_for (sc_taskpool_t * pool, size_t begin, size_t end,
+                          size_t grain, sc_range_function_t fn, void *data)
+{
+  sc_taskgroup_t     *group;
+  sc_taskpool_range_t *range;
+
+  SC_ASSERT (pool != NULL);
+  SC_ASSERT (begin <= end);
+  SC_ASSERT (fn != NULL);
+
+  if (begin == end) {
+    return;
+  }
+  if (grain == 0) {
+    /* aim at several subranges per thread for load balance */
+    grain = SC_MAX ((end - begin) / (8 * (pool->num_threads + 1)), 1);
+  }
+  if (pool->num_threads == 0 || end - begin <= grain) {
+    while (begin < end) {
+      fn (begin, SC_MIN (begin + grain, end), data);
+      begin = SC_MIN (begin + grain, end);
+    }
+    return;
+  }
+
+  group = sc_taskgroup_new (pool);
+  range = SC_ALLOC (sc_taskpool_range_t, 1);
+  range->group = group;
+  range->fn = fn;
+  range->data = data;
+  range->begin = begin;
+  range->end = end;
+  range->grain = grain;
+
+  /* the calling thread picks up the whole range first while waiting */
+  sc_taskgroup_spawn (group, sc_taskpool_range_task, range);
+  sc_taskgroup_wait (group);
+  sc_taskgroup_destroy (group);
+}
+
+sc_taskpool_t      *
+sc_taskpool_global (void)
+{
+  SC_ASSERT (sc_taskpool_global_pool != NULL);
+
+  return sc_taskpool_global_pool;
+}
+
+sc_taskpool_t      *
+sc_taskpool_global_lookup (void)
+{
+  return sc_taskpool_global_pool;
+}
+
+void
+sc_taskpool_global_init (int num_threads, int pin)
+{
+  SC_ASSERT (sc_taskpool_global_pool == NULL);
+
+  sc_taskpool_global_pool = sc_taskpool_new (num_threads, pin);
+}
+
+void
+sc_taskpool_global_finalize (void)
+{
+  if (sc_taskpool_global_pool != NULL) {
+    sc_taskpool_destroy (sc_taskpool_global_pool);
+    sc_taskpool_global_pool = NULL;
+  }
+}
@@ -0,0 +1,150 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef SC_TASKPOOL_H
+#define SC_TASKPOOL_H
+
+/** \file sc_taskpool.h
+ * This file provides a pool of worker threads that execute tasks.
+ *
+ * Each worker owns a double-ended queue of tasks.  It pushes and pops tasks
+ * at one end, and idle workers steal from the other end of other queues.
+ * Tasks are collected in task groups, which can be waited for.
+ * A thread waiting for a group helps executing tasks in the meantime.
+ *
+ * The library keeps one global pool, which is created in \ref sc_init.
+ * Its number of worker threads and their pinning to cores are set by
+ * \ref sc_set_thread_defaults, by default from the environment variables
+ * SC_NUM_THREADS and SC_PIN_THREADS.  Libraries built on libsc are meant to
+ * share this pool via \ref sc_taskpool_global instead of creating their own.
+ *
+ * Tasks may call \ref sc_malloc, \ref sc_free and the logging macros.
+ * Without --enable-pthread, or with zero threads, all tasks are executed
+ * immediately by the calling thread.
+ */
+
+#include <sc.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** The task pool is an opaque structure. */
+typedef struct sc_taskpool sc_taskpool_t;
+
+/** A group of tasks that can be waited for; opaque structure. */
+typedef struct sc_taskgroup sc_taskgroup_t;
+
+/** Function to execute as a task.
+ * \param [in] data     User data passed to \ref sc_taskgroup_spawn.
+ */
+typedef void        (*sc_task_function_t) (void *data);
+
+/** Function to execute on a subrange in \ref sc_taskpool_parallel_for.
+ * \param [in] begin    First index of the subrange.
+ * \param [in] end      One past the last index of the subrange.
+ * \param [in] data     User data passed to \ref sc_taskpool_parallel_for.
+ */
+typedef void        (*sc_range_function_t) (size_t begin, size_t end,
+                                            void *data);
+
+/** Create a new task pool.
+ * \param [in] num_threads  Number of worker threads to start.
+ *                          If zero, or if the library is configured without
+ *                          pthreads, all tasks run in the calling thread.
+ * \param [in] pin          If true and supported by the system, worker
+ *                          thread i is pinned to core i modulo the number
+ *                          of online cores.
+ * \return                  A valid task pool.
+ */
+sc_taskpool_t      *sc_taskpool_new (int num_threads, int pin);
+
+/** Destroy a task pool.
+ * All task groups of this pool must have been waited for and destroyed.
+ * \param [in,out] pool     This pool is invalidated.
+ */
+void                sc_taskpool_destroy (sc_taskpool_t * pool);
+
+/** Return the number of worker threads of a pool.
+ * \param [in] pool     Valid task pool.
+ * \return              Nonnegative number of workers.
+ */
+int                 sc_taskpool_num_threads (sc_taskpool_t * pool);
+
+/** Return the id of the calling thread within a pool.
+ * \param [in] pool     Valid task pool.
+ * \return              Worker i returns i + 1; all other threads return 0.
+ */
+int                 sc_taskpool_thread_id (sc_taskpool_t * pool);
+
+/** Return the global task pool of the library.
+ * It is valid between \ref sc_init and \ref sc_finalize.
+ * \return              The global pool.
+ */
+sc_taskpool_t      *sc_taskpool_global (void);
+
+/** Create a new and empty task group.
+ * \param [in] pool     Valid task pool.
+ * \return              A task group.
+ */
+sc_taskgroup_t     *sc_taskgroup_new (sc_taskpool_t * pool);
+
+/** Destroy a task group.
+ * \param [in,out] group    Group without pending tasks.
+ */
+void                sc_taskgroup_destroy (sc_taskgroup_t * group);
+
+/** Add a task to a group to be executed asynchronously.
+ * May be called from within a task, which is how nested parallelism works.
+ * \param [in,out] group    Valid task group.
+ * \param [in] fn           Function to execute.
+ * \param [in] data         Passed to \b fn.
+ */
+void                sc_taskgroup_spawn (sc_taskgroup_t * group,
+                                        sc_task_function_t fn, void *data);
+
+/** Wait for all tasks of a group, including tasks they spawned into it.
+ * The calling thread executes tasks of the pool while waiting.
+ * \param [in,out] group    Valid task group.
+ */
+void                sc_taskgroup_wait (sc_taskgroup_t * group);
+
+/** Execute a function on an index range in parallel and wait for it.
+ * The range is split recursively in halves down to the grain size,
+ * so idle workers steal large subranges first.
+ * \param [in] pool     Valid task pool.
+ * \param [in] begin    First index.
+ * \param [in] end      One past the last index.
+ * \param [in] grain    Maximum length of a subrange passed to \b fn.
+ *                      If 0, a value is chosen from the number of threads.
+ * \param [in] fn       Function called on disjoint subranges that cover
+ *                      the range.
+ * \param [in] data     Passed to \b fn.
+ */
+void                sc_taskpool_parallel_for (sc_taskpool_t * pool,
+                                              size_t begin, size_t end,
+                                              size_t grain,
+                                              sc_range_function_t fn,
+                                              void *data);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_TASKPOOL_H */
@@ -0,0 +1,220 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_archive.h>
+
+#define TEST_ARCHIVE_COUNT 10000
+
+/* write the test sections; return the reference arrays */
+static void
+test_archive_write (sc_io_sink_t * sink, sc_array_t ** ref)
+{
+  int                 retval;
+  sc_archive_writer_t *writer;
+
+  writer = sc_archive_writer_new (sink, 1);
+  SC_CHECK_ABORT (writer != NULL, "Writer create");
+  retval = sc_archive_write (writer, "field", 1, 3, ref[0],
+                             SC_ARCHIVE_ENCODE_SHUFFLE);
+  SC_CHECK_ABORT (retval == 0, "Write field");
+  retval = sc_archive_write (writer, "ids", 2, 1, ref[1],
+                             SC_ARCHIVE_ENCODE_NONE);
+  SC_CHECK_ABORT (retval == 0, "Write ids");
+  retval = sc_archive_write (writer, "levels", 3, 1, ref[2],
+                             SC_ARCHIVE_ENCODE_SHUFFLE_DELTA);
+  SC_CHECK_ABORT (retval == 0, "Write levels");
+  retval = sc_archive_write (writer, "empty", 4, 1, ref[3],
+                             SC_ARCHIVE_ENCODE_NONE);
+  SC_CHECK_ABORT (retval == 0, "Write empty");
+  retval = sc_archive_write (writer, "a name that is far too long for the "
+                             "archive index", 5, 1, ref[3],
+                             SC_ARCHIVE_ENCODE_NONE);
+  SC_CHECK_ABORT (retval != 0, "Write long name");
+  retval = sc_archive_writer_destroy (writer);
+  SC_CHECK_ABORT (retval == 0, "Writer destroy");
+}
+
+/* read all sections by name and compare them with the reference */
+static void
+test_archive_read (sc_io_source_t * source, sc_array_t ** ref)
+{
+  static const char  *names[4] = { "field", "ids", "levels", "empty" };
+  int                 i, j, retval;
+  sc_array_t         *data;
+  sc_archive_reader_t *reader;
+  const sc_archive_section_t *section;
+
+  reader = sc_archive_reader_new (source);
+  SC_CHECK_ABORT (reader != NULL, "Reader create");
+  SC_CHECK_ABORT (sc_archive_num_sections (reader) == 4, "Sections");
+  SC_CHECK_ABORT (sc_archive_find (reader, "missing") == -1, "Missing");
+
+  /* in reverse order to exercise random access */
+  for (j = 3; j >= 0; --j) {
+    i = sc_archive_find (reader, names[j]);
+    SC_CHECK_ABORTF (i == j, "Find %s", names[j]);
+    section = sc_archive_section (reader, i);
+    SC_CHECK_ABORT (section->type == (uint64_t) (j + 1) &&
+                    section->elem_count == ref[j]->elem_count &&
+                    section->offset % 64 == 0, "Section metadata");
+    data = sc_array_new (ref[j]->elem_size);
+    retval = sc_archive_read (reader, i, data);
+    SC_CHECK_ABORTF (retval == 0, "Read %s", names[j]);
+    SC_CHECK_ABORTF (sc_array_is_equal (data, ref[j]), "Compare %s",
+                     names[j]);
+    sc_array_destroy (data);
+  }
+
+  /* the element size must match */
+  data = sc_array_new (sizeof (char));
+  SC_CHECK_ABORT (sc_archive_read (reader, 0, data) != 0, "Read size");
+  sc_array_destroy (data);
+
+  sc_archive_reader_destroy (reader);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret, rank, retval;
+  int                *ids;
+  char                filename[BUFSIZ];
+  size_t              iz, offset;
+  uint64_t            word;
+  double             *field;
+  uint16_t           *levels;
+  sc_array_t         *ref[4], *buffer, view;
+  sc_io_sink_t       *sink;
+  sc_io_source_t     *source;
+  sc_archive_reader_t *reader;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (sc_MPI_COMM_WORLD, &rank);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  ref[0] = sc_array_new_count (sizeof (double), TEST_ARCHIVE_COUNT);
+  ref[1] = sc_array_new_count (sizeof (int), 777);
+  ref[2] = sc_array_new_count (sizeof (uint16_t), TEST_ARCHIVE_COUNT);
+  ref[3] = sc_array_new (sizeof (float));
+  field = (double *) ref[0]->array;
+  levels = (uint16_t *) ref[2]->array;
+  for (iz = 0; iz < TEST_ARCHIVE_COUNT; ++iz) {
+    field[iz] = cos (1e-3 * iz);
+    levels[iz] = (uint16_t) (iz / 100);
+  }
+  ids = (int *) ref[1]->array;
+  for (iz = 0; iz < ref[1]->elem_count; ++iz) {
+    ids[iz] = (int) (iz * iz) - rank;
+  }
+
+  /* an archive in memory */
+  buffer = sc_array_new (sizeof (char));
+  sink = sc_io_sink_new (SC_IO_TYPE_BUFFER, SC_IO_MODE_WRITE,
+                         SC_IO_ENCODE_NONE, buffer);
+  SC_CHECK_ABORT (sink != NULL, "Sink create");
+  test_archive_write (sink, ref);
+  retval = sc_io_sink_destroy (sink);
+  SC_CHECK_ABORT (retval == 0, "Sink destroy");
+  source = sc_io_source_new (SC_IO_TYPE_BUFFER, SC_IO_ENCODE_NONE, buffer);
+  SC_CHECK_ABORT (source != NULL, "Source create");
+  test_archive_read (source, ref);
+
+  /* unencoded sections are viewed in place */
+  reader = sc_archive_reader_new (source);
+  SC_CHECK_ABORT (reader != NULL, "Reader create");
+  retval = sc_archive_view (reader, sc_archive_find (reader, "ids"), &view);
+  SC_CHECK_ABORT (retval == 0 && sc_array_is_equal (&view, ref[1]) &&
+                  view.array > buffer->array &&
+                  view.array < buffer->array + buffer->elem_count,
+                  "View ids");
+  retval = sc_archive_view (reader, sc_archive_find (reader, "field"),
+                            &view);
+  SC_CHECK_ABORT (retval != 0, "View encoded");
+  sc_archive_reader_destroy (reader);
+  retval = sc_io_source_destroy (source);
+  SC_CHECK_ABORT (retval == 0, "Source destroy");
+
+  /* a corrupt section fails its checksum */
+  source = sc_io_source_new (SC_IO_TYPE_BUFFER, SC_IO_ENCODE_NONE, buffer);
+  reader = sc_archive_reader_new (source);
+  SC_CHECK_ABORT (reader != NULL, "Reader create");
+  retval = sc_archive_view (reader, sc_archive_find (reader, "ids"), &view);
+  SC_CHECK_ABORT (retval == 0, "View ids");
+  ((int *) view.array)[5] ^= 1;
+  sc_array_init (&view, sizeof (int));
+  retval = sc_archive_read (reader, sc_archive_find (reader, "ids"), &view);
+  SC_CHECK_ABORT (retval != 0, "Read corrupt");
+  sc_array_reset (&view);
+  sc_archive_reader_destroy (reader);
+  sc_io_source_destroy (source);
+
+  /* a raw section with bytes beyond its elements is refused; the index
+     entry of ids follows that of field, each with 48 name bytes and 11
+     words, and the size is the sixth word */
+  memcpy (&word, buffer->array + buffer->elem_count - 2 * sizeof (uint64_t),
+          sizeof (uint64_t));
+  offset = (size_t) word + 136 + 48 + 5 * sizeof (uint64_t);
+  memcpy (&word, buffer->array + offset, sizeof (uint64_t));
+  SC_CHECK_ABORT (word == ref[1]->elem_count * sizeof (int), "Ids size");
+  ++word;
+  memcpy (buffer->array + offset, &word, sizeof (uint64_t));
+  source = sc_io_source_new (SC_IO_TYPE_BUFFER, SC_IO_ENCODE_NONE, buffer);
+  SC_CHECK_ABORT (sc_archive_reader_new (source) == NULL, "Oversized");
+  sc_io_source_destroy (source);
+
+  /* a truncated archive is refused */
+  sc_array_resize (buffer, buffer->elem_count - 1);
+  source = sc_io_source_new (SC_IO_TYPE_BUFFER, SC_IO_ENCODE_NONE, buffer);
+  SC_CHECK_ABORT (sc_archive_reader_new (source) == NULL, "Truncated");
+  sc_io_source_destroy (source);
+  sc_array_destroy (buffer);
+
+  /* an archive in a file */
+  snprintf (filename, BUFSIZ, "sc_test_archive_%d.sca", rank);
+  sink = sc_io_sink_new (SC_IO_TYPE_FILENAME, SC_IO_MODE_WRITE,
+                         SC_IO_ENCODE_NONE, filename);
+  SC_CHECK_ABORT (sink != NULL, "Sink create");
+  test_archive_write (sink, ref);
+  retval = sc_io_sink_destroy (sink);
+  SC_CHECK_ABORT (retval == 0, "Sink destroy");
+  source = sc_io_source_new (SC_IO_TYPE_FILENAME, SC_IO_ENCODE_NONE,
+                             filename);
+  SC_CHECK_ABORT (source != NULL, "Source create");
+  test_archive_read (source, ref);
+  retval = sc_io_source_destroy (source);
+  SC_CHECK_ABORT (retval == 0, "Source destroy");
+  remove (filename);
+
+  for (iz = 0; iz < 4; ++iz) {
+    sc_array_destroy (ref[iz]);
+  }
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
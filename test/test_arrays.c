@@ -144,6 +144,235 @@ test_mstamp (void)
   }
 }
 
+static void
+test_scan_max_long (void *accum, const void *elem, void *data)
+{
+  long               *l = (long *) accum;
+
+  *l = SC_MAX (*l, *(const long *) elem);
+}
+
+static int
+test_compact_pred (sc_array_t * array, size_t index, void *data)
+{
+  return *(int *) sc_array_index (array, index) % *(int *) data != 0;
+}
+
+static void
+test_scan_compact (size_t N)
+{
+  const long          lmin = -1;
+  int                 i, sum, total, mod = 3;
+  long                lmax, ltotal;
+  size_t              zz, count;
+  sc_array_t         *a, *b, *c;
+
+  a = sc_array_new_count (sizeof (int), N);
+  b = sc_array_new_count (sizeof (int), N);
+  c = sc_array_new_count (sizeof (long), N);
+  for (zz = 0; zz < N; ++zz) {
+    i = (int) ((zz * 7919) % 13);
+    *(int *) sc_array_index (a, zz) = *(int *) sc_array_index (b, zz) = i;
+    *(long *) sc_array_index (c, zz) = (long) ((zz * 104729) % 100003);
+  }
+
+  /* inclusive and exclusive sums */
+  sc_array_scan (a, 0, NULL, sc_array_scan_sum_int, NULL, &total);
+  sc_array_scan (b, 1, NULL, sc_array_scan_sum_int, NULL, NULL);
+  sum = 0;
+  for (zz = 0; zz < N; ++zz) {
+    i = (int) ((zz * 7919) % 13);
+    SC_CHECK_ABORT (*(int *) sc_array_index (b, zz) == sum, "Exclusive scan");
+    sum += i;
+    SC_CHECK_ABORT (*(int *) sc_array_index (a, zz) == sum, "Inclusive scan");
+  }
+  SC_CHECK_ABORT (total == sum, "Scan total");
+
+  /* running maximum with a user operator and identity */
+  sc_array_scan (c, 0, &lmin, test_scan_max_long, NULL, &ltotal);
+  lmax = lmin;
+  for (zz = 0; zz < N; ++zz) {
+    lmax = SC_MAX (lmax, (long) ((zz * 104729) % 100003));
+    SC_CHECK_ABORT (*(long *) sc_array_index (c, zz) == lmax, "Max scan");
+  }
+  SC_CHECK_ABORT (ltotal == lmax, "Max total");
+
+  /* select the partial sums that are not divisible by mod */
+  sc_array_compact (b, a, test_compact_pred, &mod);
+  count = 0;
+  for (zz = 0; zz < N; ++zz) {
+    i = *(int *) sc_array_index (a, zz);
+    if (i % mod != 0) {
+      SC_CHECK_ABORT (count < b->elem_count &&
+                      *(int *) sc_array_index (b, count) == i, "Compact");
+      ++count;
+    }
+  }
+  SC_CHECK_ABORT (count == b->elem_count, "Compact count");
+
+  sc_array_destroy (a);
+  sc_array_destroy (b);
+  sc_array_destroy (c);
+}
+
+/* compare the blocked scans of a pool with workers to the serial ones */
+static void
+test_scan_parallel (size_t N)
+{
+  int                 t, mod = 5;
+  int                 itotal[2];
+  long                ltotal[2];
+  size_t              zz, ztotal[2];
+  sc_array_t         *a[2], *l[2], *z[2], *d[2];
+
+  for (t = 0; t < 2; ++t) {
+    sc_set_thread_defaults (t == 0 ? 0 : 4, 0);
+    a[t] = sc_array_new_count (sizeof (int), N);
+    l[t] = sc_array_new_count (sizeof (long), N);
+    z[t] = sc_array_new_count (sizeof (size_t), N);
+    d[t] = sc_array_new (sizeof (int));
+    for (zz = 0; zz < N; ++zz) {
+      *(int *) sc_array_index (a[t], zz) = (int) ((zz * 7919) % 13);
+      *(long *) sc_array_index (l[t], zz) = (long) ((zz * 104729) % 1009)
+        - 500;
+      *(size_t *) sc_array_index (z[t], zz) = zz % 17;
+    }
+    sc_array_scan (a[t], 0, NULL, sc_array_scan_sum_int, NULL, &itotal[t]);
+    sc_array_scan (l[t], 1, NULL, sc_array_scan_sum_long, NULL, &ltotal[t]);
+    sc_array_scan (z[t], 0, NULL, sc_array_scan_sum_size_t, NULL,
+                   &ztotal[t]);
+    sc_array_compact (d[t], a[t], test_compact_pred, &mod);
+  }
+  sc_set_thread_defaults (-1, 0);
+
+  SC_CHECK_ABORT (sc_array_is_equal (a[0], a[1]) && itotal[0] == itotal[1],
+                  "Parallel int scan");
+  SC_CHECK_ABORT (sc_array_is_equal (l[0], l[1]) && ltotal[0] == ltotal[1],
+                  "Parallel long scan");
+  SC_CHECK_ABORT (sc_array_is_equal (z[0], z[1]) && ztotal[0] == ztotal[1],
+                  "Parallel size_t scan");
+  SC_CHECK_ABORT (sc_array_is_equal (d[0], d[1]), "Parallel compact");
+
+  for (t = 0; t < 2; ++t) {
+    sc_array_destroy (a[t]);
+    sc_array_destroy (l[t]);
+    sc_array_destroy (z[t]);
+    sc_array_destroy (d[t]);
+  }
+}
+
+static unsigned
+test_hash_int (const void *v, const void *u)
+{
+  return (unsigned) *(const int *) v *2654435761U;
+}
+
+static int
+test_equal_int (const void *v1, const void *v2, const void *u)
+{
+  return *(const int *) v1 == *(const int *) v2;
+}
+
+static void
+test_hash_sum (void **v, const void *u, void *accum, void *data)
+{
+  *(long *) accum += *(int *) *v;
+}
+
+/* check that two hash tables have the same slots, lists and statistics */
+static void
+test_hash_is_same (sc_hash_t * h1, sc_hash_t * h2)
+{
+  size_t              slot;
+  sc_list_t          *l1, *l2;
+  sc_link_t          *k1, *k2;
+
+  SC_CHECK_ABORT (h1->elem_count == h2->elem_count &&
+                  h1->slots->elem_count == h2->slots->elem_count &&
+                  h1->resize_checks == h2->resize_checks &&
+                  h1->resize_actions == h2->resize_actions,
+                  "Hash bulk statistics");
+  for (slot = 0; slot < h1->slots->elem_count; ++slot) {
+    l1 = (sc_list_t *) sc_array_index (h1->slots, slot);
+    l2 = (sc_list_t *) sc_array_index (h2->slots, slot);
+    SC_CHECK_ABORT (l1->elem_count == l2->elem_count, "Hash bulk list");
+    for (k1 = l1->first, k2 = l2->first; k1 != NULL;
+         k1 = k1->next, k2 = k2->next) {
+      SC_CHECK_ABORT (k1->data == k2->data, "Hash bulk order");
+    }
+  }
+}
+
+static void
+test_hash_bulk (size_t N)
+{
+  int                *pi;
+  long                sum, psum;
+  size_t              zz, position;
+  void              **pv;
+  sc_array_t         *a, *objects, *contained;
+  sc_hash_t          *hash, *serial;
+  sc_hash_array_t    *hb, *hs;
+
+  a = sc_array_new_count (sizeof (int), N);
+  objects = sc_array_new_count (sizeof (void *), N);
+  for (zz = 0; zz < N; ++zz) {
+    pi = (int *) sc_array_index (a, zz);
+    *pi = (int) ((zz * 7919) % (N / 2 + 1));
+    *(void **) sc_array_index (objects, zz) = pi;
+  }
+
+  /* the bulk built hash array equals the one built by insertion */
+  hb = sc_hash_array_new_bulk (a, test_hash_int, test_equal_int, NULL);
+  hs = sc_hash_array_new (sizeof (int), test_hash_int, test_equal_int, NULL);
+  for (zz = 0; zz < N; ++zz) {
+    pi = (int *) sc_hash_array_insert_unique (hs, sc_array_index (a, zz),
+                                              &position);
+    if (pi != NULL) {
+      *pi = *(int *) sc_array_index (a, zz);
+    }
+  }
+  SC_CHECK_ABORT (sc_array_is_equal (&hb->a, &hs->a), "Hash array bulk");
+  SC_CHECK_ABORT (sc_hash_array_is_valid (hb), "Hash array valid");
+  sc_hash_array_destroy (hs);
+  sc_hash_array_destroy (hb);
+
+  /* bulk insertion reports the contained duplicates */
+  hash = sc_hash_new (test_hash_int, test_equal_int, NULL, NULL);
+  contained = sc_array_new (sizeof (void *));
+  zz = sc_hash_insert_bulk (hash, objects, contained);
+  SC_CHECK_ABORT (zz == hash->elem_count, "Hash bulk count");
+  SC_CHECK_ABORT (zz == (N > 0 ? SC_MIN (N, N / 2 + 1) : 0), "Hash unique");
+  sum = 0;
+  for (zz = 0; zz < N; ++zz) {
+    pi = (int *) sc_array_index (a, zz);
+    pv = (void **) sc_array_index (contained, zz);
+    SC_CHECK_ABORT (*(int *) *pv == *pi, "Hash contained");
+    if (*pv == pi) {
+      sum += *pi;
+    }
+    SC_CHECK_ABORT (sc_hash_lookup (hash, pi, NULL), "Hash lookup");
+  }
+
+  /* the table is the same as the one built by single insertions */
+  serial = sc_hash_new (test_hash_int, test_equal_int, NULL, NULL);
+  for (zz = 0; zz < N; ++zz) {
+    sc_hash_insert_unique (serial, sc_array_index (a, zz), NULL);
+  }
+  test_hash_is_same (hash, serial);
+  sc_hash_destroy (serial);
+
+  /* a parallel reduction over all members */
+  sc_hash_foreach_parallel (hash, test_hash_sum, NULL, sizeof (long), NULL,
+                            sc_array_scan_sum_long, &psum);
+  SC_CHECK_ABORT (psum == sum, "Hash sum");
+
+  sc_hash_destroy (hash);
+  sc_array_destroy (contained);
+  sc_array_destroy (objects);
+  sc_array_destroy (a);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -273,6 +502,29 @@ main (int argc, char **argv)
 
   test_mstamp ();
 
+  test_scan_compact (0);
+  test_scan_compact (N);
+  test_scan_compact (1000003);
+
+  /* around the smallest parallel size and with uneven blocks */
+  test_scan_parallel (16383);
+  test_scan_parallel (16384);
+  test_scan_parallel (16385);
+  test_scan_parallel (100003);
+  sc_set_thread_defaults (4, 0);
+  test_scan_compact (1000003);
+  sc_set_thread_defaults (-1, 0);
+
+  test_hash_bulk (0);
+  test_hash_bulk (N);
+  test_hash_bulk (300007);
+
+  /* the partitioned insertion with workers */
+  sc_set_thread_defaults (4, 0);
+  test_hash_bulk (16385);
+  test_hash_bulk (300007);
+  sc_set_thread_defaults (-1, 0);
+
   sc_finalize ();
 
   return 0;
@@ -0,0 +1,163 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_checkpoint.h>
+
+#define TEST_CHECKPOINT_BLOCK 4096
+
+/* write a checkpoint to a sink and check the number of blocks */
+static void
+test_checkpoint_write (sc_checkpoint_t * ckpt, sc_io_sink_t * sink,
+                       int full, size_t expected)
+{
+  int                 retval;
+  size_t              blocks;
+
+  retval = sc_checkpoint_write (ckpt, sink, full, &blocks);
+  SC_CHECK_ABORT (retval == 0, "Checkpoint write");
+  SC_CHECK_ABORTF (blocks == expected, "Checkpoint blocks %lld %lld",
+                   (long long) blocks, (long long) expected);
+}
+
+/* read all checkpoints of a buffer */
+static int
+test_checkpoint_read (sc_checkpoint_t * ckpt, sc_array_t * buffer,
+                      int *num_read)
+{
+  int                 retval;
+  sc_io_source_t     *source;
+
+  source = sc_io_source_new (SC_IO_TYPE_BUFFER, SC_IO_ENCODE_NONE, buffer);
+  SC_CHECK_ABORT (source != NULL, "Source create");
+  retval = sc_checkpoint_read (ckpt, source, num_read);
+  retval = sc_io_source_destroy (source) || retval;
+
+  return retval;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret, retval, num_read;
+  size_t              iz, nblocks;
+  uint64_t            size;
+  double             *field;
+  sc_array_t         *a, *b, *ra, *rb, *base, *delta;
+  sc_checkpoint_t    *writer, *reader;
+  sc_io_sink_t       *sink;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  /* a large field and a small one */
+  a = sc_array_new_count (sizeof (double), 100000);
+  field = (double *) a->array;
+  for (iz = 0; iz < a->elem_count; ++iz) {
+    field[iz] = sin (1e-4 * iz);
+  }
+  b = sc_array_new_count (sizeof (int), 10);
+  sc_array_memset (b, 0);
+  nblocks = (a->elem_count * sizeof (double) + TEST_CHECKPOINT_BLOCK - 1) /
+    TEST_CHECKPOINT_BLOCK;
+
+  writer = sc_checkpoint_new (TEST_CHECKPOINT_BLOCK);
+  SC_CHECK_ABORT (sc_checkpoint_add (writer, a) == 0, "Add a");
+  SC_CHECK_ABORT (sc_checkpoint_add (writer, b) == 1, "Add b");
+
+  /* a full checkpoint followed by deltas in one buffer */
+  base = sc_array_new (sizeof (char));
+  sink = sc_io_sink_new (SC_IO_TYPE_BUFFER, SC_IO_MODE_WRITE,
+                         SC_IO_ENCODE_NONE, base);
+  SC_CHECK_ABORT (sink != NULL, "Sink create");
+  test_checkpoint_write (writer, sink, 0, nblocks + 1);
+  test_checkpoint_write (writer, sink, 0, 0);
+  field[0] += 1.;
+  field[1] += 1.;
+  field[a->elem_count - 1] += 1.;
+  test_checkpoint_write (writer, sink, 0, 2);
+  sc_array_resize (b, 5000);
+  sc_array_memset (b, 7);
+  test_checkpoint_write (writer, sink, 0,
+                         (5000 * sizeof (int) + TEST_CHECKPOINT_BLOCK - 1) /
+                         TEST_CHECKPOINT_BLOCK);
+  retval = sc_io_sink_destroy (sink);
+  SC_CHECK_ABORT (retval == 0, "Sink destroy");
+
+  /* the reader reconstructs the latest state */
+  ra = sc_array_new (sizeof (double));
+  rb = sc_array_new (sizeof (int));
+  reader = sc_checkpoint_new (TEST_CHECKPOINT_BLOCK);
+  sc_checkpoint_add (reader, ra);
+  sc_checkpoint_add (reader, rb);
+  retval = test_checkpoint_read (reader, base, &num_read);
+  SC_CHECK_ABORT (retval == 0 && num_read == 4, "Checkpoint read");
+  SC_CHECK_ABORT (sc_array_is_equal (a, ra) && sc_array_is_equal (b, rb),
+                  "Checkpoint state");
+
+  /* a delta in a second buffer continues the first */
+  field[a->elem_count / 2] = -1.;
+  delta = sc_array_new (sizeof (char));
+  sink = sc_io_sink_new (SC_IO_TYPE_BUFFER, SC_IO_MODE_WRITE,
+                         SC_IO_ENCODE_NONE, delta);
+  SC_CHECK_ABORT (sink != NULL, "Sink create");
+  test_checkpoint_write (writer, sink, 0, 1);
+  retval = sc_io_sink_destroy (sink);
+  SC_CHECK_ABORT (retval == 0, "Sink destroy");
+  SC_CHECK_ABORT (delta->elem_count < TEST_CHECKPOINT_BLOCK + 256,
+                  "Delta size");
+  retval = test_checkpoint_read (reader, delta, &num_read);
+  SC_CHECK_ABORT (retval == 0 && num_read == 1, "Checkpoint read delta");
+  SC_CHECK_ABORT (sc_array_is_equal (a, ra) && sc_array_is_equal (b, rb),
+                  "Checkpoint state delta");
+  sc_checkpoint_destroy (reader);
+
+  /* a delta without its base is refused */
+  reader = sc_checkpoint_new (TEST_CHECKPOINT_BLOCK);
+  sc_checkpoint_add (reader, ra);
+  sc_checkpoint_add (reader, rb);
+  retval = test_checkpoint_read (reader, delta, &num_read);
+  SC_CHECK_ABORT (retval != 0 && num_read == 0, "Checkpoint without base");
+
+  /* a corrupt element count is refused before anything is allocated */
+  size = ~(uint64_t) 0 / 4;
+  memcpy (base->array + 6 * sizeof (uint64_t), &size, sizeof (uint64_t));
+  retval = test_checkpoint_read (reader, base, &num_read);
+  SC_CHECK_ABORT (retval != 0 && num_read == 0, "Checkpoint corrupt size");
+  sc_checkpoint_destroy (reader);
+
+  sc_checkpoint_destroy (writer);
+  sc_array_destroy (delta);
+  sc_array_destroy (base);
+  sc_array_destroy (ra);
+  sc_array_destroy (rb);
+  sc_array_destroy (a);
+  sc_array_destroy (b);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
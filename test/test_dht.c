@@ -0,0 +1,182 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_dht.h>
+
+typedef struct test_dht_item
+{
+  long                key;
+  double              value;
+}
+test_dht_item_t;
+
+static unsigned
+test_dht_hash (const void *v, const void *u)
+{
+  const long          key = *(const long *) v;
+  unsigned            a, b, c;
+
+  a = (unsigned) key;
+  b = (unsigned) (key >> 16);
+  c = 0x5c5c5c5cU;
+  sc_hash_final (a, b, c);
+
+  return c;
+}
+
+static int
+test_dht_equal (const void *v1, const void *v2, const void *u)
+{
+  return *(const long *) v1 == *(const long *) v2;
+}
+
+static void
+test_dht_run (sc_MPI_Comm mpicomm, int with_fn)
+{
+  int                 mpiret;
+  int                 mpisize, mpirank;
+  int                 is_found;
+  const int           per_rank = 100;
+  long                l, key;
+  size_t              zz;
+  double              value;
+  sc_array_t         *items, *keys, *values, *found;
+  test_dht_item_t    *item;
+  sc_dht_t           *dht;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  if (with_fn) {
+    dht = sc_dht_new (mpicomm, sizeof (long), sizeof (double),
+                      test_dht_hash, test_dht_equal, NULL);
+  }
+  else {
+    dht = sc_dht_new (mpicomm, sizeof (long), sizeof (double),
+                      NULL, NULL, NULL);
+  }
+
+  /* every process inserts its own keys */
+  items = sc_array_new_count (sizeof (test_dht_item_t), per_rank);
+  for (l = 0; l < per_rank; ++l) {
+    item = (test_dht_item_t *) sc_array_index_long (items, l);
+    item->key = (long) mpirank * per_rank + l;
+    item->value = 2. * item->key;
+  }
+  sc_dht_insert (dht, items);
+  SC_CHECK_ABORT (sc_dht_global_count (dht) ==
+                  (size_t) mpisize * per_rank, "Global count");
+
+  /* overwrite the values of the first keys of every process */
+  for (l = 0; l < per_rank; ++l) {
+    item = (test_dht_item_t *) sc_array_index_long (items, l);
+    item->value = l < per_rank / 2 ? 3. * item->key : 2. * item->key;
+  }
+  sc_dht_insert (dht, items);
+  SC_CHECK_ABORT (sc_dht_global_count (dht) ==
+                  (size_t) mpisize * per_rank, "Global count overwrite");
+  sc_array_destroy (items);
+
+  /* look up the keys of the next process and some missing ones */
+  keys = sc_array_new_count (sizeof (long), per_rank + 2);
+  for (l = 0; l < per_rank; ++l) {
+    *(long *) sc_array_index_long (keys, l) =
+      (long) ((mpirank + 1) % mpisize) * per_rank + l;
+  }
+  *(long *) sc_array_index_long (keys, per_rank) = -1;
+  *(long *) sc_array_index_long (keys, per_rank + 1) =
+    (long) mpisize *per_rank;
+  values = sc_array_new (sizeof (double));
+  found = sc_array_new (sizeof (int));
+  sc_dht_lookup (dht, keys, values, found);
+  SC_CHECK_ABORT (values->elem_count == keys->elem_count, "Value count");
+  for (zz = 0; zz < keys->elem_count; ++zz) {
+    key = *(long *) sc_array_index (keys, zz);
+    is_found = *(int *) sc_array_index (found, zz);
+    value = *(double *) sc_array_index (values, zz);
+    if (zz < (size_t) per_rank) {
+      SC_CHECK_ABORT (is_found, "Key not found");
+      SC_CHECK_ABORT (value == ((key % per_rank) < per_rank / 2 ?
+                                3. : 2.) * key, "Value mismatch");
+    }
+    else {
+      SC_CHECK_ABORT (!is_found && value == 0., "Missing key found");
+    }
+  }
+
+  /* remove the even keys we looked up and check the result */
+  for (l = 0; l < per_rank / 2; ++l) {
+    *(long *) sc_array_index_long (keys, l) =
+      *(long *) sc_array_index_long (keys, 2 * l);
+  }
+  sc_array_resize (keys, per_rank / 2);
+  sc_dht_remove (dht, keys, found);
+  SC_CHECK_ABORT (found->elem_count == keys->elem_count, "Found count");
+  for (zz = 0; zz < found->elem_count; ++zz) {
+    SC_CHECK_ABORT (*(int *) sc_array_index (found, zz), "Key not removed");
+  }
+  SC_CHECK_ABORT (sc_dht_global_count (dht) ==
+                  (size_t) mpisize * (per_rank / 2), "Global count remove");
+  sc_dht_remove (dht, keys, NULL);
+  sc_dht_lookup (dht, keys, NULL, found);
+  for (zz = 0; zz < found->elem_count; ++zz) {
+    SC_CHECK_ABORT (!*(int *) sc_array_index (found, zz), "Key remains");
+  }
+
+  /* every local item must be owned by this process */
+  items = sc_dht_local_items (dht);
+  for (zz = 0; zz < items->elem_count; ++zz) {
+    SC_CHECK_ABORT (sc_dht_owner (dht, sc_array_index (items, zz)) ==
+                    mpirank, "Owner mismatch");
+  }
+
+  sc_array_destroy (keys);
+  sc_array_destroy (values);
+  sc_array_destroy (found);
+  sc_dht_destroy (dht);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpicomm;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpicomm = sc_MPI_COMM_WORLD;
+
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  test_dht_run (mpicomm, 0);
+  test_dht_run (mpicomm, 1);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
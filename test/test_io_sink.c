@@ -62,6 +62,436 @@ the_test (const char *filename)
   }
 }
 
+/* write a few pieces in one call and read them back */
+static void
+test_vectored (FILE * file)
+{
+  int                 retval, i;
+  size_t              bytes_in, bytes_out;
+  char                header[8] = "header\n";
+  char                back_header[8];
+  sc_array_t         *buffer, *fields[2], *back_fields[2];
+  sc_io_vec_t         vecs[3], back_vecs[3];
+  sc_io_sink_t       *sink;
+  sc_io_source_t     *source;
+
+  for (i = 0; i < 2; ++i) {
+    fields[i] = sc_array_new_count (sizeof (int), (size_t) (1000 * i + 3));
+    sc_array_memset (fields[i], 'a' + i);
+    back_fields[i] = sc_array_new_count (sizeof (int), fields[i]->elem_count);
+  }
+  vecs[0].data = header;
+  vecs[0].bytes = sizeof (header);
+  sc_io_vec_array (&vecs[1], fields[0]);
+  sc_io_vec_array (&vecs[2], fields[1]);
+  back_vecs[0].data = back_header;
+  back_vecs[0].bytes = sizeof (back_header);
+
+  buffer = NULL;
+  if (file == NULL) {
+    buffer = sc_array_new (sizeof (char));
+    sink = sc_io_sink_new (SC_IO_TYPE_BUFFER, SC_IO_MODE_WRITE,
+                           SC_IO_ENCODE_NONE, buffer);
+  }
+  else {
+    sink = sc_io_sink_new (SC_IO_TYPE_FILEFILE, SC_IO_MODE_WRITE,
+                           SC_IO_ENCODE_NONE, file);
+  }
+  SC_CHECK_ABORT (sink != NULL, "Sink create");
+
+  /* the same data once with pieces and once with arrays */
+  retval = sc_io_sink_write (sink, "x", 1);
+  SC_CHECK_ABORT (retval == 0, "Sink write");
+  retval = sc_io_sink_writev (sink, vecs, 3);
+  SC_CHECK_ABORT (retval == 0, "Sink writev");
+  retval = sc_io_sink_write (sink, header, sizeof (header));
+  SC_CHECK_ABORT (retval == 0, "Sink write");
+  retval = sc_io_sink_write_arrays (sink, fields, 2);
+  SC_CHECK_ABORT (retval == 0, "Sink write arrays");
+  retval = sc_io_sink_complete (sink, &bytes_in, &bytes_out);
+  SC_CHECK_ABORT (retval == 0 && bytes_in == bytes_out &&
+                  bytes_in == 1 + 2 * (vecs[0].bytes + vecs[1].bytes +
+                                       vecs[2].bytes), "Sink complete");
+  retval = sc_io_sink_destroy (sink);
+  SC_CHECK_ABORT (retval == 0, "Sink destroy");
+
+  if (file == NULL) {
+    source = sc_io_source_new (SC_IO_TYPE_BUFFER, SC_IO_ENCODE_NONE, buffer);
+  }
+  else {
+    rewind (file);
+    source = sc_io_source_new (SC_IO_TYPE_FILEFILE, SC_IO_ENCODE_NONE, file);
+  }
+  SC_CHECK_ABORT (source != NULL, "Source create");
+  retval = sc_io_source_read (source, back_header, 1, NULL);
+  SC_CHECK_ABORT (retval == 0 && back_header[0] == 'x', "Source read");
+  for (i = 0; i < 2; ++i) {
+    sc_array_memset (back_fields[0], 0);
+    sc_array_memset (back_fields[1], 0);
+    memset (back_header, 0, sizeof (back_header));
+    if (i == 0) {
+      sc_io_vec_array (&back_vecs[1], back_fields[0]);
+      sc_io_vec_array (&back_vecs[2], back_fields[1]);
+      retval = sc_io_source_readv (source, back_vecs, 3, NULL);
+    }
+    else {
+      retval = sc_io_source_read (source, back_header, sizeof (back_header),
+                                  NULL);
+      retval = retval || sc_io_source_read_arrays (source, back_fields, 2);
+    }
+    SC_CHECK_ABORT (retval == 0, "Source readv");
+    SC_CHECK_ABORT (!memcmp (header, back_header, sizeof (header)) &&
+                    sc_array_is_equal (fields[0], back_fields[0]) &&
+                    sc_array_is_equal (fields[1], back_fields[1]),
+                    "Source readv data");
+  }
+
+  if (file != NULL) {
+    /* reading beyond the end is an error without a byte count */
+    retval = sc_io_source_readv (source, back_vecs, 1, &bytes_out);
+    SC_CHECK_ABORT (retval == 0 && bytes_out == 0, "Source readv end");
+    retval = sc_io_source_readv (source, back_vecs, 1, NULL);
+    SC_CHECK_ABORT (retval != 0, "Source readv beyond end");
+  }
+  retval = sc_io_source_destroy (source);
+  SC_CHECK_ABORT (retval == 0, "Source destroy");
+
+  for (i = 0; i < 2; ++i) {
+    sc_array_destroy (fields[i]);
+    sc_array_destroy (back_fields[i]);
+  }
+  if (buffer != NULL) {
+    sc_array_destroy (buffer);
+  }
+}
+
+#ifdef SC_ENABLE_MPIIO
+
+/* every process writes its pieces to one MPI file and reads them back */
+static void
+test_vectored_mpi (sc_MPI_Comm mpicomm)
+{
+  const char         *filename = "sc_test_io_sink.mpiv";
+  int                 mpiret, rank, i;
+  char                header[8] = "header\n";
+  char               *back;
+  size_t              bytes;
+  sc_array_t         *fields[2];
+  sc_io_vec_t         vecs[3];
+  sc_MPI_Status       mpistatus;
+  MPI_File            mpifile;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  for (i = 0; i < 2; ++i) {
+    fields[i] = sc_array_new_count (sizeof (int), (size_t) (1000 * i + 3));
+    sc_array_memset (fields[i], 'a' + i + rank);
+  }
+  vecs[0].data = header;
+  vecs[0].bytes = sizeof (header);
+  sc_io_vec_array (&vecs[1], fields[0]);
+  sc_io_vec_array (&vecs[2], fields[1]);
+  bytes = vecs[0].bytes + vecs[1].bytes + vecs[2].bytes;
+
+  /* the processes write their pieces one after the other */
+  mpiret = MPI_File_open (mpicomm, (char *) filename,
+                          MPI_MODE_WRONLY | MPI_MODE_CREATE,
+                          MPI_INFO_NULL, &mpifile);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_File_seek (mpifile, (MPI_Offset) (rank * bytes), MPI_SEEK_SET);
+  SC_CHECK_MPI (mpiret);
+  sc_mpi_writev (mpifile, vecs, 3, "MPI writev");
+  mpiret = MPI_File_close (&mpifile);
+  SC_CHECK_MPI (mpiret);
+
+  mpiret = MPI_File_open (mpicomm, (char *) filename, MPI_MODE_RDONLY,
+                          MPI_INFO_NULL, &mpifile);
+  SC_CHECK_MPI (mpiret);
+  back = SC_ALLOC (char, bytes);
+  mpiret = MPI_File_read_at_all (mpifile, (MPI_Offset) (rank * bytes), back,
+                                 (int) bytes, sc_MPI_BYTE, &mpistatus);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_File_close (&mpifile);
+  SC_CHECK_MPI (mpiret);
+  SC_CHECK_ABORT (!memcmp (back, header, vecs[0].bytes) &&
+                  !memcmp (back + vecs[0].bytes, vecs[1].data,
+                           vecs[1].bytes) &&
+                  !memcmp (back + vecs[0].bytes + vecs[1].bytes,
+                           vecs[2].data, vecs[2].bytes), "MPI writev data");
+  SC_FREE (back);
+
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (rank == 0) {
+    mpiret = MPI_File_delete ((char *) filename, MPI_INFO_NULL);
+    SC_CHECK_MPI (mpiret);
+  }
+  for (i = 0; i < 2; ++i) {
+    sc_array_destroy (fields[i]);
+  }
+}
+
+#endif /* SC_ENABLE_MPIIO */
+
+/* set the element count of a shuffle encoding and expect errors */
+static void
+test_shuffle_corrupt (sc_array_t * coded, sc_array_t * back, uint64_t count)
+{
+  int                 retval;
+  uint64_t            header[6];
+  sc_array_t         *copy;
+  sc_io_source_t     *source;
+
+  /* the block count is kept consistent with the element count */
+  copy = sc_array_new_count (1, coded->elem_count);
+  sc_array_copy (copy, coded);
+  memcpy (header, copy->array, sizeof (header));
+  header[2] = count;
+  header[5] = count / header[3] + (count % header[3] != 0);
+  memcpy (copy->array, header, sizeof (header));
+
+  retval = sc_io_decode_shuffle (copy, back);
+  SC_CHECK_ABORT (retval != 0, "Shuffle corrupt decode");
+
+  source = sc_io_source_new (SC_IO_TYPE_BUFFER, SC_IO_ENCODE_NONE, copy);
+  SC_CHECK_ABORT (source != NULL, "Source create");
+  retval = sc_io_source_read_shuffle (source, back);
+  SC_CHECK_ABORT (retval != 0, "Shuffle corrupt read");
+  sc_io_source_destroy (source);
+
+  sc_array_destroy (copy);
+}
+
+/* encode arrays with the shuffle codec and decode them again */
+static void
+test_shuffle (void)
+{
+  int                 retval, delta, level;
+  size_t              iz, count, elem_size;
+  sc_array_t         *data, *back, *coded, *buffer;
+  sc_io_sink_t       *sink;
+  sc_io_source_t     *source;
+
+  for (elem_size = 1; elem_size <= 8; elem_size += 7) {
+    for (count = 0; count < 100000; count = 7 * count + 1) {
+      data = sc_array_new_count (elem_size, count);
+      for (iz = 0; iz < count; ++iz) {
+        if (elem_size == sizeof (double)) {
+          /* a smooth field */
+          *(double *) sc_array_index (data, iz) = sin (1e-3 * iz);
+        }
+        else {
+          *(char *) sc_array_index (data, iz) = (char) (iz / 10);
+        }
+      }
+      back = sc_array_new (elem_size);
+      coded = sc_array_new (1);
+      for (level = 0; level <= 6; level += 6) {
+        for (delta = 0; delta < 2; ++delta) {
+          sc_io_encode_shuffle (data, coded, delta, level);
+          retval = sc_io_decode_shuffle (coded, back);
+          SC_CHECK_ABORT (retval == 0 && sc_array_is_equal (data, back),
+                          "Shuffle decode");
+          SC_GLOBAL_LDEBUGF ("Shuffle %d bytes level %d delta %d: %lld to "
+                             "%lld\n", (int) elem_size, level, delta,
+                             (long long) (count * elem_size),
+                             (long long) coded->elem_count);
+        }
+      }
+
+      /* huge counts in a corrupt header are refused without allocation */
+      test_shuffle_corrupt (coded, back, ~(uint64_t) 0);
+      test_shuffle_corrupt (coded, back, (uint64_t) 1 << 40);
+
+      /* a truncated encoding is detected */
+      sc_array_resize (coded, coded->elem_count - 1);
+      retval = sc_io_decode_shuffle (coded, back);
+      SC_CHECK_ABORT (retval != 0, "Shuffle truncated");
+
+      /* pass the encoding through a sink and a source */
+      buffer = sc_array_new (sizeof (char));
+      sink = sc_io_sink_new (SC_IO_TYPE_BUFFER, SC_IO_MODE_WRITE,
+                             SC_IO_ENCODE_NONE, buffer);
+      SC_CHECK_ABORT (sink != NULL, "Sink create");
+      retval = sc_io_sink_write_shuffle (sink, data, 1, 1);
+      retval = retval || sc_io_sink_write_shuffle (sink, data, 0, 0);
+      retval = retval || sc_io_sink_destroy (sink);
+      SC_CHECK_ABORT (retval == 0, "Sink write shuffle");
+      source = sc_io_source_new (SC_IO_TYPE_BUFFER, SC_IO_ENCODE_NONE,
+                                 buffer);
+      SC_CHECK_ABORT (source != NULL, "Source create");
+      for (delta = 0; delta < 2; ++delta) {
+        sc_array_reset (back);
+        retval = sc_io_source_read_shuffle (source, back);
+        SC_CHECK_ABORT (retval == 0 && sc_array_is_equal (data, back),
+                        "Source read shuffle");
+      }
+      retval = sc_io_source_destroy (source);
+      SC_CHECK_ABORT (retval == 0, "Source destroy");
+
+      sc_array_destroy (buffer);
+      sc_array_destroy (coded);
+      sc_array_destroy (back);
+      sc_array_destroy (data);
+    }
+  }
+}
+
+static void
+test_mirror (FILE * file)
+{
+  int                 retval;
+  size_t              iz, bytes;
+  char               *expect;
+  sc_array_t         *buffer, *back, view;
+  sc_io_source_t     *source;
+
+  buffer = sc_array_new_count (sizeof (char), 1000);
+  for (iz = 0; iz < buffer->elem_count; ++iz) {
+    *(char *) sc_array_index (buffer, iz) = (char) (3 * iz);
+  }
+  if (file == NULL) {
+    source = sc_io_source_new (SC_IO_TYPE_BUFFER, SC_IO_ENCODE_NONE, buffer);
+  }
+  else {
+    rewind (file);
+    SC_CHECK_ABORT (fwrite (buffer->array, 1, buffer->elem_count, file) ==
+                    buffer->elem_count, "File write");
+    rewind (file);
+    source = sc_io_source_new (SC_IO_TYPE_FILEFILE, SC_IO_ENCODE_NONE, file);
+  }
+  SC_CHECK_ABORT (source != NULL, "Source create");
+
+  /* the mirror holds what was read and not what was skipped */
+  retval = sc_io_source_activate_mirror_bytes (source, 64);
+  SC_CHECK_ABORT (retval == 0, "Mirror activate");
+  retval = sc_io_source_activate_mirror (source);
+  SC_CHECK_ABORT (retval != 0, "Mirror activate twice");
+  back = sc_array_new_count (sizeof (char), 400);
+  retval = sc_io_source_read (source, back->array, 100, NULL);
+  retval = retval || sc_io_source_read (source, NULL, 50, NULL);
+  retval = retval || sc_io_source_read (source, back->array + 100, 300,
+                                        NULL);
+  SC_CHECK_ABORT (retval == 0, "Source read");
+
+  expect = SC_ALLOC (char, 401);
+  retval = sc_io_source_read_mirror (source, expect, 401, &bytes);
+  SC_CHECK_ABORT (retval == 0 && bytes == 400 &&
+                  !memcmp (expect, back->array, 400), "Mirror read");
+  retval = sc_io_source_read_mirror (source, expect, 401, NULL);
+  SC_CHECK_ABORT (retval != 0, "Mirror read beyond");
+  SC_CHECK_ABORT (file == NULL || (source->mirror_buffer->elem_count == 400
+                                   && !memcmp (source->mirror_buffer->array,
+                                               back->array, 400)),
+                  "Mirror buffer");
+  SC_FREE (expect);
+
+  /* views of a buffer source point into the buffer */
+  retval = sc_io_source_mirror_view (source, 100, 300, &view);
+  SC_CHECK_ABORT (retval == 0 && view.elem_count == 300 &&
+                  !memcmp (view.array, back->array + 100, 300),
+                  "Mirror view");
+  SC_CHECK_ABORT (file != NULL || view.array == buffer->array + 150,
+                  "Mirror view reference");
+  retval = sc_io_source_mirror_view (source, 90, 20, &view);
+  SC_CHECK_ABORT ((retval == 0) == (file != NULL), "Mirror view chunks");
+  retval = sc_io_source_mirror_view (source, 350, 51, &view);
+  SC_CHECK_ABORT (retval != 0, "Mirror view beyond");
+
+  /* many small pieces are mirrored and read back in order */
+  sc_array_resize (back, 1000);
+  for (iz = 400; iz < 675; iz += 5) {
+    retval = sc_io_source_read (source, back->array + iz, 5, NULL);
+    retval = retval || sc_io_source_read (source, NULL, 5, NULL);
+    SC_CHECK_ABORT (retval == 0, "Source read pieces");
+  }
+  expect = SC_ALLOC (char, 675);
+  retval = sc_io_source_read_mirror (source, expect, 675, NULL);
+  SC_CHECK_ABORT (retval == 0 && !memcmp (expect, back->array, 675),
+                  "Mirror read pieces");
+  SC_FREE (expect);
+
+  retval = sc_io_source_destroy (source);
+  SC_CHECK_ABORT (retval == 0, "Source destroy");
+  sc_array_destroy (back);
+  sc_array_destroy (buffer);
+}
+
+static void
+test_buffered (void)
+{
+  const char         *filename = "sc_test_io_sink.buffered";
+  const size_t        align = SC_IO_DIRECT_ALIGN;
+  const size_t        total = 20 * SC_IO_DIRECT_ALIGN + 123;
+  const size_t        part = 11 * SC_IO_DIRECT_ALIGN + 100;
+  int                 direct, rdirect, retval;
+  size_t              iz, bytes;
+  char               *raw, *data, *back;
+  sc_io_sink_t       *sink;
+  sc_io_source_t     *source;
+
+  raw = SC_ALLOC (char, total + align);
+  data = raw + (align - (size_t) raw % align) % align;
+  for (iz = 0; iz < total; ++iz) {
+    data[iz] = (char) (7 * iz + iz / align);
+  }
+  back = SC_ALLOC (char, total + 1);
+
+  for (direct = 0; direct < 2; ++direct) {
+    /* write in unaligned pieces and complete in between */
+    sink = sc_io_sink_new (SC_IO_TYPE_FILENAME, SC_IO_MODE_WRITE,
+                           SC_IO_ENCODE_NONE, filename);
+    SC_CHECK_ABORT (sink != NULL, "Sink create");
+    retval = sc_io_sink_set_buffer (sink, 3 * align, direct);
+    retval = retval || sc_io_sink_write (sink, data, 1);
+    retval = retval || sc_io_sink_write (sink, data + 1, 5000);
+    retval = retval || sc_io_sink_complete (sink, NULL, NULL);
+    retval = retval || sc_io_sink_write (sink, data + 5001, 3 * align - 5001);
+
+    /* aligned memory at an aligned position */
+    retval = retval || sc_io_sink_write (sink, data + 3 * align,
+                                         part - 3 * align);
+    SC_CHECK_ABORT (retval == 0, "Sink write buffered");
+    retval = sc_io_sink_set_buffer (sink, 0, 0);
+    SC_CHECK_ABORT (retval != 0, "Sink buffer after write");
+    retval = sc_io_sink_destroy (sink);
+    SC_CHECK_ABORT (retval == 0, "Sink destroy");
+
+    /* append to a file that does not end on a block boundary */
+    sink = sc_io_sink_new (SC_IO_TYPE_FILENAME, SC_IO_MODE_APPEND,
+                           SC_IO_ENCODE_NONE, filename);
+    SC_CHECK_ABORT (sink != NULL, "Sink create");
+    retval = sc_io_sink_set_buffer (sink, 3 * align, direct);
+    retval = retval || sc_io_sink_write (sink, data + part, total - part);
+    retval = retval || sc_io_sink_destroy (sink);
+    SC_CHECK_ABORT (retval == 0, "Sink append buffered");
+
+    /* read back with a skip and beyond the end */
+    for (rdirect = 0; rdirect < 2; ++rdirect) {
+      memset (back, 0, total);
+      source = sc_io_source_new (SC_IO_TYPE_FILENAME, SC_IO_ENCODE_NONE,
+                                 filename);
+      SC_CHECK_ABORT (source != NULL, "Source create");
+      retval = sc_io_source_set_buffer (source, 2 * align, rdirect);
+      retval = retval || sc_io_source_read (source, back, 100, NULL);
+      retval = retval || sc_io_source_read (source, NULL, 4000, NULL);
+      retval = retval || sc_io_source_read (source, back + 4100,
+                                            total + 1 - 4100, &bytes);
+      SC_CHECK_ABORT (retval == 0 && bytes == total - 4100,
+                      "Source read buffered");
+      retval = sc_io_source_destroy (source);
+      SC_CHECK_ABORT (retval == 0, "Source destroy");
+      SC_CHECK_ABORT (!memcmp (back, data, 100) &&
+                      !memcmp (back + 4100, data + 4100, total - 4100),
+                      "Source data buffered");
+    }
+  }
+  remove (filename);
+
+  SC_FREE (back);
+  SC_FREE (raw);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -84,8 +514,22 @@ main (int argc, char **argv)
   }
 
   if (sc_is_root ()) {
+    FILE               *file;
+
     the_test (filename);
+    test_vectored (NULL);
+    test_shuffle ();
+    test_buffered ();
+    file = tmpfile ();
+    SC_CHECK_ABORT (file != NULL, "Temporary file");
+    test_vectored (file);
+    test_mirror (NULL);
+    test_mirror (file);
+    fclose (file);
   }
+#ifdef SC_ENABLE_MPIIO
+  test_vectored_mpi (sc_MPI_COMM_WORLD);
+#endif
 
   sc_options_destroy (opt);
   sc_finalize ();
@@ -139,6 +139,22 @@ main (int argc, char **argv)
     }
   }
 
+#if defined(SC_ENABLE_MPIWINSHARED)
+  /* arrays of several pages with all page placement hints */
+  sc_shmem_page_flags = SC_SHMEM_PAGES_HUGE | SC_SHMEM_PAGES_PREFAULT |
+    SC_SHMEM_PAGES_INTERLEAVE;
+  for (itype = (int) SC_SHMEM_WINDOW; itype <= (int) SC_SHMEM_WINDOW_PRESCAN;
+       itype++) {
+    SC_GLOBAL_PRODUCTIONF ("sc_shmem type: %s with page flags\n",
+                           sc_shmem_type_to_string[itype]);
+    for (count = 1; count <= (1 << 16); count <<= 8) {
+      retval +=
+        test_shmem (count, sc_MPI_COMM_WORLD, (sc_shmem_type_t) itype);
+    }
+  }
+  sc_shmem_page_flags = SC_SHMEM_PAGES_DEFAULT;
+#endif
+
   sc_finalize ();
 
   mpiret = sc_MPI_Finalize ();
@@ -0,0 +1,153 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_nodeio.h>
+
+/* the byte at a position of the test file */
+static char
+test_nodeio_byte (size_t position)
+{
+  return (char) ('a' + position % 23);
+}
+
+/* the number of bytes each process writes */
+static size_t
+test_nodeio_bytes (int rank, int round)
+{
+  return (size_t) ((rank * 37 + round * 101) % 300);
+}
+
+static void
+test_nodeio (sc_MPI_Comm mpicomm, int aggregators, size_t stripe)
+{
+  const char         *filename = "sc_test_nodeio.out";
+  int                 mpiret, rank, size, retval, round, q;
+  char               *data, *readback;
+  size_t              iz, bytes, before, total, offset;
+  FILE               *file;
+  sc_nodeio_t        *nio;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+
+  nio = sc_nodeio_open (mpicomm, filename, aggregators, stripe);
+  SC_CHECK_ABORT (nio != NULL, "Open file");
+
+  /* two rounds of writes in order of rank */
+  for (round = 0; round < 2; ++round) {
+    for (before = 0, q = 0; q < rank; ++q) {
+      before += test_nodeio_bytes (q, round);
+    }
+    offset = sc_nodeio_position (nio) + before;
+    bytes = test_nodeio_bytes (rank, round);
+    data = SC_ALLOC (char, SC_MAX (bytes, 1));
+    for (iz = 0; iz < bytes; ++iz) {
+      data[iz] = test_nodeio_byte (offset + iz);
+    }
+    retval = sc_nodeio_write_ordered (nio, data, bytes);
+    SC_CHECK_ABORT (retval == 0, "Write ordered");
+    SC_FREE (data);
+  }
+
+  /* a final round of equal pieces in reverse order of rank */
+  total = sc_nodeio_position (nio);
+  bytes = 1000;
+  offset = total + (size - 1 - rank) * bytes;
+  data = SC_ALLOC (char, bytes);
+  for (iz = 0; iz < bytes; ++iz) {
+    data[iz] = test_nodeio_byte (offset + iz);
+  }
+  retval = sc_nodeio_write_at (nio, offset, data, bytes);
+  SC_CHECK_ABORT (retval == 0, "Write at");
+  SC_FREE (data);
+  total += size * bytes;
+
+  retval = sc_nodeio_close (nio);
+  SC_CHECK_ABORT (retval == 0, "Close file");
+
+  if (rank == 0) {
+    readback = SC_ALLOC (char, total + 1);
+    file = fopen (filename, "rb");
+    SC_CHECK_ABORT (file != NULL, "Open readback");
+    SC_CHECK_ABORT (fread (readback, 1, total + 1, file) == total,
+                    "File size");
+    fclose (file);
+    for (iz = 0; iz < total; ++iz) {
+      SC_CHECK_ABORT (readback[iz] == test_nodeio_byte (iz), "File content");
+    }
+    SC_FREE (readback);
+    remove (filename);
+  }
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 attach, aggregators, size;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (sc_MPI_COMM_WORLD, &size);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  /* sc_init attaches the node communicators if MPI 3 is available */
+  for (attach = 0; attach < 3; ++attach) {
+    if (attach == 2) {
+      /* node communicators of a fixed size need not share memory */
+      sc_mpi_comm_detach_node_comms (sc_MPI_COMM_WORLD);
+      sc_mpi_comm_attach_node_comms (sc_MPI_COMM_WORLD, size % 2 ? 1 : 2);
+    }
+#ifdef SC_ENABLE_MPICOMMSHARED
+    else if (attach) {
+      sc_mpi_comm_attach_node_comms (sc_MPI_COMM_WORLD, 0);
+    }
+    else {
+      sc_mpi_comm_detach_node_comms (sc_MPI_COMM_WORLD);
+    }
+#else
+    else if (attach) {
+      continue;
+    }
+#endif
+    for (aggregators = 1; aggregators <= 2; ++aggregators) {
+      SC_GLOBAL_INFOF ("Node communicators %d aggregators %d\n",
+                       attach, aggregators);
+      /* a tiny stripe size exercises the merging of pieces */
+      test_nodeio (sc_MPI_COMM_WORLD, aggregators, 64);
+      test_nodeio (sc_MPI_COMM_WORLD, aggregators, 0);
+    }
+  }
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
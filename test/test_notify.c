@@ -68,6 +68,8 @@ typedef enum sc_test_stats
   SC_STAT_NOTIFY_NARY,
   SC_STAT_NOTIFY_PAYL,
   SC_STAT_NOTIFY_NATI,
+  SC_STAT_NOTIFY_ONES,
+  SC_STAT_NOTIFY_COMP,
   SC_STAT_NOTIFY_LAST
 }
 sc_test_stats_t;
@@ -82,14 +84,20 @@ main (int argc, char **argv)
   int                *senders2, num_senders2;
   int                *senders3, num_senders3;
   int                *senders4, num_senders4;
+  int                *senders5, num_senders5;
+  int                *senders6, num_senders6;
+  int                *senders7, num_senders7;
   int                *receivers, num_receivers;
   int                 ntop, nint, nbot;
   double              elapsed_allgather;
   double              elapsed_nary;
   double              elapsed_native;
   double              elapsed_payl;
+  double              elapsed_onesided;
+  double              elapsed_compressed;
   sc_MPI_Comm         mpicomm;
-  sc_array_t         *rec2, *snd2, *rec4, *pay4;
+  sc_array_t         *rec2, *snd2, *rec4, *pay4, *rec5, *pay5;
+  sc_array_t         *rec6, *pay6;
   sc_statinfo_t       stats[SC_STAT_NOTIFY_LAST];
 
   mpiret = sc_MPI_Init (&argc, &argv);
@@ -181,15 +189,74 @@ main (int argc, char **argv)
   elapsed_native += sc_MPI_Wtime ();
   sc_stats_set1 (stats + SC_STAT_NOTIFY_NATI, elapsed_native, "Native");
 
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  SC_GLOBAL_INFO ("Testing sc_notify_onesided_ext with payload\n");
+  rec5 = sc_array_new_count (sizeof (int), num_receivers);
+  pay5 = sc_array_new_count (sizeof (int), num_receivers);
+  for (i = 0; i < num_receivers; ++i) {
+    *(int *) sc_array_index_int (rec5, i) = receivers[i];
+    *(int *) sc_array_index_int (pay5, i) = 5 * mpirank + 1;
+  }
+  elapsed_onesided = -sc_MPI_Wtime ();
+  sc_notify_onesided_ext (rec5, NULL, pay5, mpicomm);
+  elapsed_onesided += sc_MPI_Wtime ();
+  senders5 = (int *) rec5->array;
+  num_senders5 = (int) rec5->elem_count;
+  SC_ASSERT ((int) pay5->elem_count == num_senders5);
+  sc_stats_set1 (stats + SC_STAT_NOTIFY_ONES, elapsed_onesided, "Onesided");
+
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  SC_GLOBAL_INFOF ("Testing compressed sc_notify_ext with %d %d %d\n",
+                   ntop, nint, nbot);
+  sc_notify_compress = 1;
+  rec6 = sc_array_new_count (sizeof (int), num_receivers);
+  pay6 = sc_array_new_count (sizeof (int), num_receivers);
+  for (i = 0; i < num_receivers; ++i) {
+    *(int *) sc_array_index_int (rec6, i) = receivers[i];
+    *(int *) sc_array_index_int (pay6, i) = -1000 * mpirank - 7;
+  }
+  elapsed_compressed = -sc_MPI_Wtime ();
+  sc_notify_ext (rec6, NULL, pay6, ntop, nint, nbot, mpicomm);
+  elapsed_compressed += sc_MPI_Wtime ();
+  senders6 = (int *) rec6->array;
+  num_senders6 = (int) rec6->elem_count;
+  SC_ASSERT ((int) pay6->elem_count == num_senders6);
+  sc_stats_set1 (stats + SC_STAT_NOTIFY_COMP, elapsed_compressed,
+                 "Compressed");
+
+  SC_GLOBAL_INFO ("Testing compressed native sc_notify\n");
+  senders7 = SC_ALLOC (int, mpisize);
+  mpiret = sc_notify (receivers, num_receivers,
+                      senders7, &num_senders7, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  sc_notify_compress = 0;
+  SC_CHECK_ABORT (num_senders3 == num_senders7, "Mismatch 37 sender count");
+  for (i = 0; i < num_senders3; ++i) {
+    SC_CHECK_ABORTF (senders3[i] == senders7[i], "Mismatch 37 sender %d", i);
+  }
+  SC_FREE (senders7);
+
   SC_CHECK_ABORT (num_senders1 == num_senders2, "Mismatch 12 sender count");
   SC_CHECK_ABORT (num_senders1 == num_senders3, "Mismatch 13 sender count");
   SC_CHECK_ABORT (num_senders1 == num_senders4, "Mismatch 14 sender count");
+  SC_CHECK_ABORT (num_senders1 == num_senders5, "Mismatch 15 sender count");
+  SC_CHECK_ABORT (num_senders1 == num_senders6, "Mismatch 16 sender count");
   for (i = 0; i < num_senders1; ++i) {
     SC_CHECK_ABORTF (senders1[i] == senders2[i], "Mismatch 12 sender %d", i);
     SC_CHECK_ABORTF (senders1[i] == senders3[i], "Mismatch 13 sender %d", i);
     SC_CHECK_ABORTF (senders1[i] == senders4[i], "Mismatch 14 sender %d", i);
     SC_CHECK_ABORTF (*(int *) sc_array_index_int (pay4, i) ==
                      2 * senders4[i] + 3, "Mismatch payload %d", i);
+    SC_CHECK_ABORTF (senders1[i] == senders5[i], "Mismatch 15 sender %d", i);
+    SC_CHECK_ABORTF (*(int *) sc_array_index_int (pay5, i) ==
+                     5 * senders5[i] + 1, "Mismatch onesided payload %d", i);
+    SC_CHECK_ABORTF (senders1[i] == senders6[i], "Mismatch 16 sender %d", i);
+    SC_CHECK_ABORTF (*(int *) sc_array_index_int (pay6, i) ==
+                     -1000 * senders6[i] - 7, "Mismatch compressed %d", i);
   }
 
   SC_FREE (receivers);
@@ -199,6 +266,10 @@ main (int argc, char **argv)
   SC_FREE (senders3);
   sc_array_destroy (rec4);
   sc_array_destroy (pay4);
+  sc_array_destroy (rec5);
+  sc_array_destroy (pay5);
+  sc_array_destroy (rec6);
+  sc_array_destroy (pay6);
 
   sc_stats_compute (mpicomm, SC_STAT_NOTIFY_LAST, stats);
   sc_stats_print (sc_package_id, SC_LP_STATISTICS,
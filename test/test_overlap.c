@@ -0,0 +1,127 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_overlap.h>
+
+#define TEST_OVERLAP_N 1000
+
+typedef struct test_overlap
+{
+  int                 run;
+  int                 num_received;
+  size_t              interior_done;
+}
+test_overlap_t;
+
+static void
+test_overlap_interior (size_t begin, size_t end, void *user)
+{
+  test_overlap_t     *to = (test_overlap_t *) user;
+
+  SC_CHECK_ABORT (begin == to->interior_done, "Interior out of order");
+  to->interior_done = end;
+}
+
+static void
+test_overlap_recv (int rank, void *buffer, size_t bytes, void *user)
+{
+  test_overlap_t     *to = (test_overlap_t *) user;
+  int                *data = (int *) buffer;
+  int                 i;
+
+  SC_CHECK_ABORT (bytes == TEST_OVERLAP_N * sizeof (int), "Message size");
+  for (i = 0; i < TEST_OVERLAP_N; ++i) {
+    SC_CHECK_ABORT (data[i] == 1000 * rank + i + to->run, "Message data");
+  }
+  ++to->num_received;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 mpisize, mpirank;
+  int                 provided;
+  int                 i, j, num_peers;
+  int                 peers[2];
+  int                *sendbuf, *recvbuf[2];
+  sc_MPI_Comm         mpicomm;
+  sc_overlap_t       *ov;
+  test_overlap_t      sto, *to = &sto;
+
+  mpiret = sc_MPI_Init_thread (&argc, &argv, sc_MPI_THREAD_MULTIPLE,
+                               &provided);
+  SC_CHECK_MPI (mpiret);
+  mpicomm = sc_MPI_COMM_WORLD;
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  /* exchange with both neighbors on a periodic ring */
+  peers[0] = (mpirank + mpisize - 1) % mpisize;
+  peers[1] = (mpirank + 1) % mpisize;
+  num_peers = peers[0] == peers[1] ? 1 : 2;
+
+  sendbuf = SC_ALLOC (int, TEST_OVERLAP_N);
+  ov = sc_overlap_new (mpicomm, SC_TAG_LAST);
+  for (j = 0; j < num_peers; ++j) {
+    recvbuf[j] = SC_ALLOC (int, TEST_OVERLAP_N);
+    sc_overlap_add_recv (ov, peers[j], recvbuf[j],
+                         TEST_OVERLAP_N * sizeof (int));
+    sc_overlap_add_send (ov, peers[j], sendbuf,
+                         TEST_OVERLAP_N * sizeof (int));
+  }
+
+  for (to->run = 0; to->run < 4; ++to->run) {
+    if (to->run == 2) {
+      SC_GLOBAL_INFOF ("Progress thread %s\n",
+                       sc_overlap_set_progress (ov, 1) ?
+                       "enabled" : "not available");
+    }
+    for (i = 0; i < TEST_OVERLAP_N; ++i) {
+      sendbuf[i] = 1000 * mpirank + i + to->run;
+    }
+    to->num_received = 0;
+    to->interior_done = 0;
+    sc_overlap_run (ov, 100000, to->run % 2 ? 0 : 1000,
+                    test_overlap_interior, test_overlap_recv, to);
+    SC_CHECK_ABORT (to->interior_done == 100000, "Interior incomplete");
+    SC_CHECK_ABORT (to->num_received == num_peers, "Receive count");
+  }
+
+  sc_overlap_destroy (ov);
+  for (j = 0; j < num_peers; ++j) {
+    SC_FREE (recvbuf[j]);
+  }
+  SC_FREE (sendbuf);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
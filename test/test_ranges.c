@@ -0,0 +1,111 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_ranges.h>
+
+int
+main (int argc, char **argv)
+{
+  int                 i, j;
+  int                 mpiret;
+  int                 mpisize, mpirank;
+  int                 first_peer, last_peer;
+  int                 inout1, inout2;
+  int                 num_ranges, nwin;
+  int                *procs, *ranges, *global_ranges;
+  int                 num_receivers1, *receivers1;
+  int                 num_senders1, *senders1;
+  int                 num_receivers2, *receivers2;
+  int                 num_senders2, *senders2;
+  sc_MPI_Comm         mpicomm;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpicomm = sc_MPI_COMM_WORLD;
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  /* create a sparse and irregular communication pattern */
+  procs = SC_ALLOC_ZERO (int, mpisize);
+  first_peer = mpisize;
+  last_peer = -1;
+  for (i = 0; i < 5; ++i) {
+    j = (5 * mpirank + 13 * i * i + 1) % mpisize;
+    if (j != mpirank) {
+      procs[j] = 1;
+      first_peer = SC_MIN (first_peer, j);
+      last_peer = SC_MAX (last_peer, j);
+    }
+  }
+
+  /* compute the ranges and everybody's ranges */
+  num_ranges = 3;
+  ranges = SC_ALLOC (int, 2 * num_ranges);
+  inout1 = first_peer;
+  inout2 = last_peer;
+  nwin = sc_ranges_adaptive (sc_package_id, mpicomm, procs, &inout1, &inout2,
+                             num_ranges, ranges, &global_ranges);
+  SC_CHECK_ABORT (nwin <= inout2, "Range count mismatch");
+
+  /* decode the ranges with the global and the scalable algorithm */
+  receivers1 = SC_ALLOC (int, mpisize);
+  senders1 = SC_ALLOC (int, mpisize);
+  sc_ranges_decode (mpisize, mpirank, inout2, global_ranges,
+                    &num_receivers1, receivers1, &num_senders1, senders1);
+  receivers2 = SC_ALLOC (int, mpisize);
+  senders2 = SC_ALLOC (int, mpisize);
+  sc_ranges_decode_notify (mpicomm, nwin, ranges,
+                           &num_receivers2, receivers2,
+                           &num_senders2, senders2);
+
+  /* both algorithms must agree */
+  SC_CHECK_ABORT (num_receivers1 == num_receivers2, "Receiver count");
+  for (i = 0; i < num_receivers1; ++i) {
+    SC_CHECK_ABORTF (receivers1[i] == receivers2[i], "Receiver %d", i);
+  }
+  SC_CHECK_ABORT (num_senders1 == num_senders2, "Sender count");
+  for (i = 0; i < num_senders1; ++i) {
+    SC_CHECK_ABORTF (senders1[i] == senders2[i], "Sender %d", i);
+  }
+  SC_GLOBAL_INFOF ("Decoded %d receivers and %d senders\n",
+                   num_receivers1, num_senders1);
+
+  SC_FREE (procs);
+  SC_FREE (ranges);
+  SC_FREE (global_ranges);
+  SC_FREE (receivers1);
+  SC_FREE (senders1);
+  SC_FREE (receivers2);
+  SC_FREE (senders2);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,165 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_io.h>
+
+#define TEST_REDISTRIBUTE_SECTIONS 5
+#define TEST_REDISTRIBUTE_HEADER 64
+#define TEST_REDISTRIBUTE_GAP 24
+
+/* write sections of the global indices with gaps between them */
+static void
+test_redistribute_write (const char *filename, size_t * counts,
+                         size_t * offsets)
+{
+  int                 s;
+  size_t              iz, index, offset;
+  uint64_t            value;
+  char                gap[TEST_REDISTRIBUTE_GAP];
+  FILE               *file;
+
+  file = fopen (filename, "wb");
+  SC_CHECK_ABORT (file != NULL, "File open");
+  memset (gap, -1, TEST_REDISTRIBUTE_GAP);
+  sc_fwrite (gap, 1, TEST_REDISTRIBUTE_HEADER % TEST_REDISTRIBUTE_GAP, file,
+             "File header");
+  offset = TEST_REDISTRIBUTE_HEADER % TEST_REDISTRIBUTE_GAP;
+  for (index = 0, s = 0; s < TEST_REDISTRIBUTE_SECTIONS; ++s) {
+    sc_fwrite (gap, 1, TEST_REDISTRIBUTE_GAP, file, "File gap");
+    offset += TEST_REDISTRIBUTE_GAP;
+    offsets[s] = offset;
+    for (iz = 0; iz < counts[s]; ++iz, ++index) {
+      value = (uint64_t) index;
+      sc_fwrite (&value, sizeof (value), 1, file, "File data");
+    }
+    offset += counts[s] * sizeof (value);
+  }
+  SC_CHECK_ABORT (fclose (file) == 0, "File close");
+}
+
+/* read with a weighted partition and check the data */
+static void
+test_redistribute_read (sc_MPI_Comm mpicomm, const char *filename,
+                        size_t * counts, size_t * offsets, double weight)
+{
+  int                 mpiret, rank, retval;
+  int                 s;
+  size_t              iz, total, local, begin;
+  unsigned long long  llocal, lbegin;
+  sc_array_t         *data;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  for (total = 0, s = 0; s < TEST_REDISTRIBUTE_SECTIONS; ++s) {
+    total += counts[s];
+  }
+  local = sc_io_partition_weighted (total, weight, mpicomm);
+  llocal = (unsigned long long) local;
+  lbegin = 0;
+  mpiret = sc_MPI_Exscan (&llocal, &lbegin, 1, sc_MPI_UNSIGNED_LONG_LONG,
+                          sc_MPI_SUM, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  begin = rank == 0 ? 0 : (size_t) lbegin;
+
+  data = sc_array_new (sizeof (uint64_t));
+  retval = sc_io_read_redistribute (mpicomm, filename,
+                                    TEST_REDISTRIBUTE_SECTIONS, counts,
+                                    offsets, local, data);
+  SC_CHECK_ABORT (retval == 0 && data->elem_count == local,
+                  "Read redistribute");
+  for (iz = 0; iz < local; ++iz) {
+    SC_CHECK_ABORT (*(uint64_t *) sc_array_index (data, iz) ==
+                    (uint64_t) (begin + iz), "Redistributed data");
+  }
+
+  /* counts that do not match the file are refused */
+  retval = sc_io_read_redistribute (mpicomm, filename,
+                                    TEST_REDISTRIBUTE_SECTIONS, counts,
+                                    offsets, local + 1, data);
+  SC_CHECK_ABORT (retval != 0, "Read redistribute mismatch");
+
+  /* a missing file is reported on all processes */
+  retval = sc_io_read_redistribute (mpicomm, "sc_test_redistribute.missing",
+                                    TEST_REDISTRIBUTE_SECTIONS, counts,
+                                    offsets, local, data);
+  SC_CHECK_ABORT (retval != 0, "Read redistribute missing");
+  sc_array_destroy (data);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret, rank, size;
+  int                 s;
+  const char         *filename = "sc_test_redistribute.out";
+  size_t              counts[TEST_REDISTRIBUTE_SECTIONS];
+  size_t              offsets[TEST_REDISTRIBUTE_SECTIONS];
+  unsigned long long  loffsets[TEST_REDISTRIBUTE_SECTIONS];
+  sc_MPI_Comm         mpicomm = sc_MPI_COMM_WORLD;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  /* a file written by a different number of processes, one empty */
+  for (s = 0; s < TEST_REDISTRIBUTE_SECTIONS; ++s) {
+    counts[s] = s == 2 ? 0 : (size_t) (1000 * s + 17);
+  }
+  if (rank == 0) {
+    test_redistribute_write (filename, counts, offsets);
+    for (s = 0; s < TEST_REDISTRIBUTE_SECTIONS; ++s) {
+      loffsets[s] = (unsigned long long) offsets[s];
+    }
+  }
+  mpiret = sc_MPI_Bcast (loffsets, TEST_REDISTRIBUTE_SECTIONS,
+                         sc_MPI_UNSIGNED_LONG_LONG, 0, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  for (s = 0; s < TEST_REDISTRIBUTE_SECTIONS; ++s) {
+    offsets[s] = (size_t) loffsets[s];
+  }
+
+  /* equal, growing, partly empty and inexact partitions */
+  test_redistribute_read (mpicomm, filename, counts, offsets, 1.);
+  test_redistribute_read (mpicomm, filename, counts, offsets, rank + 1.);
+  test_redistribute_read (mpicomm, filename, counts, offsets, rank % 2);
+  test_redistribute_read (mpicomm, filename, counts, offsets,
+                          .1 * (rank % 7 + 1) / 3.);
+
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (rank == 0) {
+    remove (filename);
+  }
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
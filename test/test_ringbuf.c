@@ -0,0 +1,185 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_ringbuf.h>
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#endif
+
+#define TEST_RINGBUF_PRODUCERS 3
+#define TEST_RINGBUF_CONSUMERS 3
+#define TEST_RINGBUF_ITEMS 100000
+
+static void
+test_serial (void)
+{
+  int                 i, j, k;
+  int                 values[20];
+  sc_ringbuf_t       *rb;
+
+  rb = sc_ringbuf_new (sizeof (int), 5);
+  SC_CHECK_ABORT (sc_ringbuf_capacity (rb) == 8, "Capacity");
+
+  /* fill, drain and wrap around several times */
+  for (j = 0; j < 5; ++j) {
+    for (i = 0; sc_ringbuf_try_push (rb, &i); ++i);
+    SC_CHECK_ABORT (i == 8 && sc_ringbuf_count (rb) == 8, "Full");
+    for (i = 0; i < 3; ++i) {
+      SC_CHECK_ABORT (sc_ringbuf_try_pop (rb, &k) && k == i, "Pop");
+    }
+    for (i = 0; i < 20; ++i) {
+      values[i] = 100 + i;
+    }
+    SC_CHECK_ABORT (sc_ringbuf_try_push_n (rb, values, 20) == 3, "Push n");
+    SC_CHECK_ABORT (sc_ringbuf_try_pop_n (rb, values, 20) == 8, "Pop n");
+    for (i = 0; i < 8; ++i) {
+      SC_CHECK_ABORT (values[i] == (i < 5 ? i + 3 : 100 + i - 5), "Order");
+    }
+    SC_CHECK_ABORT (!sc_ringbuf_try_pop (rb, &k), "Empty");
+  }
+
+  /* popping from a closed buffer returns the remaining elements */
+  sc_ringbuf_push (rb, &j);
+  sc_ringbuf_close (rb);
+  SC_CHECK_ABORT (sc_ringbuf_pop (rb, &k) && k == j, "Closed pop");
+  SC_CHECK_ABORT (!sc_ringbuf_pop (rb, &k), "Closed empty");
+  sc_ringbuf_destroy (rb);
+}
+
+#ifdef SC_ENABLE_PTHREAD
+
+typedef struct test_worker
+{
+  sc_ringbuf_t       *rb;
+  int                 id;
+  long                count, sum;
+  pthread_t           thread;
+}
+test_worker_t;
+
+static void        *
+test_producer (void *v)
+{
+  test_worker_t      *w = (test_worker_t *) v;
+  int                 i, j, n;
+  int                 values[7];
+
+  /* alternate between single and batch pushes */
+  for (i = 0; i < TEST_RINGBUF_ITEMS;) {
+    if (i % 2 == 0) {
+      values[0] = w->id * TEST_RINGBUF_ITEMS + i++;
+      sc_ringbuf_push (w->rb, values);
+    }
+    else {
+      n = SC_MIN (7, TEST_RINGBUF_ITEMS - i);
+      for (j = 0; j < n; ++j) {
+        values[j] = w->id * TEST_RINGBUF_ITEMS + i++;
+      }
+      sc_ringbuf_push_n (w->rb, values, (size_t) n);
+    }
+  }
+  return NULL;
+}
+
+static void        *
+test_consumer (void *v)
+{
+  test_worker_t      *w = (test_worker_t *) v;
+  int                 last[TEST_RINGBUF_PRODUCERS];
+  int                 values[5];
+  size_t              zz, n;
+
+  for (zz = 0; zz < TEST_RINGBUF_PRODUCERS; ++zz) {
+    last[zz] = -1;
+  }
+  while ((n = sc_ringbuf_pop_n (w->rb, values, 5)) > 0) {
+    for (zz = 0; zz < n; ++zz) {
+      /* the values of each producer arrive in order */
+      SC_CHECK_ABORT (values[zz] > last[values[zz] / TEST_RINGBUF_ITEMS],
+                      "Producer order");
+      last[values[zz] / TEST_RINGBUF_ITEMS] = values[zz];
+      ++w->count;
+      w->sum += values[zz];
+    }
+  }
+  return NULL;
+}
+
+static void
+test_threads (void)
+{
+  int                 i;
+  long                count, sum;
+  sc_ringbuf_t       *rb;
+  test_worker_t       producers[TEST_RINGBUF_PRODUCERS];
+  test_worker_t       consumers[TEST_RINGBUF_CONSUMERS];
+
+  rb = sc_ringbuf_new (sizeof (int), 16);
+  for (i = 0; i < TEST_RINGBUF_CONSUMERS; ++i) {
+    consumers[i].rb = rb;
+    consumers[i].id = i;
+    consumers[i].count = consumers[i].sum = 0;
+    pthread_create (&consumers[i].thread, NULL, test_consumer,
+                    &consumers[i]);
+  }
+  for (i = 0; i < TEST_RINGBUF_PRODUCERS; ++i) {
+    producers[i].rb = rb;
+    producers[i].id = i;
+    pthread_create (&producers[i].thread, NULL, test_producer,
+                    &producers[i]);
+  }
+  for (i = 0; i < TEST_RINGBUF_PRODUCERS; ++i) {
+    pthread_join (producers[i].thread, NULL);
+  }
+  sc_ringbuf_close (rb);
+
+  count = sum = 0;
+  for (i = 0; i < TEST_RINGBUF_CONSUMERS; ++i) {
+    pthread_join (consumers[i].thread, NULL);
+    SC_INFOF ("Consumer %d popped %ld values\n", i, consumers[i].count);
+    count += consumers[i].count;
+    sum += consumers[i].sum;
+  }
+  count -= (long) TEST_RINGBUF_PRODUCERS *TEST_RINGBUF_ITEMS;
+  sum -= (long) TEST_RINGBUF_PRODUCERS *TEST_RINGBUF_ITEMS *
+    ((long) TEST_RINGBUF_PRODUCERS * TEST_RINGBUF_ITEMS - 1) / 2;
+  SC_CHECK_ABORT (count == 0 && sum == 0, "Values lost");
+  sc_ringbuf_destroy (rb);
+}
+
+#endif /* SC_ENABLE_PTHREAD */
+
+int
+main (int argc, char **argv)
+{
+  sc_init (sc_MPI_COMM_NULL, 1, 1, NULL, SC_LP_DEFAULT);
+
+  test_serial ();
+#ifdef SC_ENABLE_PTHREAD
+  test_threads ();
+#endif
+
+  sc_finalize ();
+
+  return 0;
+}
@@ -24,20 +24,212 @@
 #include <sc_allgather.h>
 #include <sc_sort.h>
 
+static int
+test_compare_dir (const void *v1, const void *v2, void *arg)
+{
+  return *(int *) arg * sc_double_compare (v1, v2);
+}
+
+static void
+test_sort_verify (sc_MPI_Comm mpicomm, double *ldata, size_t * nmemb,
+                  int dir)
+{
+  int                 mpiret;
+  int                 rank, num_procs;
+  int                 i;
+  int                *recvc, *displ;
+  size_t              zz, gtotal;
+  double             *gdata;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &num_procs);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  SC_GLOBAL_PRODUCTION ("Verifying\n");
+  gtotal = 0;
+  recvc = NULL;
+  displ = NULL;
+  gdata = NULL;
+  if (rank == 0) {
+    recvc = SC_ALLOC (int, num_procs);
+    displ = SC_ALLOC (int, num_procs + 1);
+    displ[0] = 0;
+    for (i = 0; i < num_procs; ++i) {
+      recvc[i] = (int) nmemb[i];
+      displ[i + 1] = displ[i] + recvc[i];
+    }
+    gtotal = (size_t) displ[num_procs];
+    gdata = SC_ALLOC (double, gtotal);
+  }
+  mpiret = sc_MPI_Gatherv (ldata, (int) nmemb[rank], sc_MPI_DOUBLE,
+                           gdata, recvc, displ, sc_MPI_DOUBLE, 0, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (rank == 0) {
+    for (zz = 0; zz + 1 < gtotal; ++zz) {
+      SC_CHECK_ABORT (dir * gdata[zz] <= dir * gdata[zz + 1],
+                      "Parallel sort failed");
+    }
+  }
+  SC_FREE (gdata);
+  SC_FREE (displ);
+  SC_FREE (recvc);
+}
+
+static int
+test_compare_mod (const void *v1, const void *v2, void *arg)
+{
+  const int           mod = *(int *) arg;
+  const int           i1 = *(const int *) v1 % mod;
+  const int           i2 = *(const int *) v2 % mod;
+
+  return i1 == i2 ? 0 : i1 < i2 ? -1 : +1;
+}
+
+/** Compare sc_qsort_r with qsort on various patterns and sizes. */
+static void
+test_qsort_r (void)
+{
+  const size_t        sizes[6] = { 0, 1, 2, 17, 1000, 100003 };
+  int                 mod = 1 << 30;
+  int                 i, pattern, *a, *b;
+  size_t              n, zz;
+
+  for (i = 0; i < 6; ++i) {
+    n = sizes[i];
+    a = SC_ALLOC (int, n);
+    b = SC_ALLOC (int, n);
+    for (pattern = 0; pattern < 5; ++pattern) {
+      for (zz = 0; zz < n; ++zz) {
+        switch (pattern) {
+        case 0:                /* random */
+          a[zz] = rand () % mod;
+          break;
+        case 1:                /* ascending */
+          a[zz] = (int) zz;
+          break;
+        case 2:                /* descending */
+          a[zz] = (int) (n - zz);
+          break;
+        case 3:                /* all equal */
+          a[zz] = 7;
+          break;
+        default:               /* organ pipe */
+          a[zz] = (int) SC_MIN (zz, n - zz);
+        }
+      }
+      memcpy (b, a, n * sizeof (int));
+      qsort (b, n, sizeof (int), sc_int_compare);
+      sc_qsort_r (a, n, sizeof (int), test_compare_mod, &mod);
+      SC_CHECK_ABORT (n == 0 || !memcmp (a, b, n * sizeof (int)),
+                      "Reentrant sort failed");
+    }
+    SC_FREE (a);
+    SC_FREE (b);
+  }
+}
+
+typedef struct test_keyed
+{
+  double              key;
+  long                id;
+}
+test_keyed_t;
+
+static int
+test_compare_key (const void *v1, const void *v2)
+{
+  return sc_double_compare (&((const test_keyed_t *) v1)->key,
+                            &((const test_keyed_t *) v2)->key);
+}
+
+/** Sort with workers in the global pool such that the local sort and the
+ * merges are split into pieces.  Few distinct keys put duplicates at the
+ * split points; the ids verify that no value is lost or duplicated. */
+static void
+test_psort_threaded (sc_MPI_Comm mpicomm)
+{
+  const size_t        lcount = 100003;
+  int                 mpiret;
+  int                 rank, num_procs;
+  int                 i, bytes, *recvc, *displ;
+  char               *seen;
+  size_t              zz, gtotal, *nmemb;
+  test_keyed_t       *ldata, *gdata;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &num_procs);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  nmemb = SC_ALLOC (size_t, num_procs);
+  for (i = 0; i < num_procs; ++i) {
+    nmemb[i] = lcount + (size_t) (i % 3);
+  }
+  gtotal = 0;
+  for (i = 0; i < num_procs; ++i) {
+    gtotal += nmemb[i];
+  }
+  ldata = SC_ALLOC (test_keyed_t, nmemb[rank]);
+  for (zz = 0; zz < nmemb[rank]; ++zz) {
+    ldata[zz].key = (double) (rand () % 37);
+    ldata[zz].id = (long) (rank * (lcount + 2) + zz);
+  }
+
+  sc_set_thread_defaults (4, 0);
+  sc_psort (mpicomm, ldata, nmemb, sizeof (test_keyed_t), test_compare_key);
+  sc_set_thread_defaults (-1, 0);
+
+  /* gather the values and check the order and the ids */
+  recvc = displ = NULL;
+  gdata = NULL;
+  if (rank == 0) {
+    recvc = SC_ALLOC (int, num_procs);
+    displ = SC_ALLOC (int, num_procs);
+    for (i = 0; i < num_procs; ++i) {
+      recvc[i] = (int) (nmemb[i] * sizeof (test_keyed_t));
+      displ[i] = i == 0 ? 0 : displ[i - 1] + recvc[i - 1];
+    }
+    gdata = SC_ALLOC (test_keyed_t, gtotal);
+  }
+  bytes = (int) (nmemb[rank] * sizeof (test_keyed_t));
+  mpiret = sc_MPI_Gatherv (ldata, bytes, sc_MPI_BYTE, gdata, recvc, displ,
+                           sc_MPI_BYTE, 0, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (rank == 0) {
+    seen = SC_ALLOC_ZERO (char, num_procs * (lcount + 2));
+    for (zz = 0; zz < gtotal; ++zz) {
+      SC_CHECK_ABORT (zz == 0 || gdata[zz - 1].key <= gdata[zz].key,
+                      "Threaded sort order");
+      SC_CHECK_ABORT (gdata[zz].id >= 0 && gdata[zz].id <
+                      (long) (num_procs * (lcount + 2)) &&
+                      !seen[gdata[zz].id], "Threaded sort values");
+      seen[gdata[zz].id] = 1;
+    }
+    SC_FREE (seen);
+  }
+
+  SC_FREE (gdata);
+  SC_FREE (displ);
+  SC_FREE (recvc);
+  SC_FREE (ldata);
+  SC_FREE (nmemb);
+}
+
 int
 main (int argc, char **argv)
 {
 #ifdef SC_ENABLE_DEBUG
   int                 mpiret;
   int                 rank, num_procs;
-  int                 i, isizet;
+  int                 isizet;
   int                 k, printed;
-  int                *recvc, *displ;
   int                 timing;
+  int                 descending = -1;
   size_t              zz;
-  size_t              lcount, gtotal;
+  size_t              lcount;
   size_t             *nmemb;
-  double             *ldata, *gdata;
+  double             *ldata;
   sc_MPI_Comm         mpicomm;
   char                buffer[BUFSIZ];
 
@@ -51,6 +243,9 @@ main (int argc, char **argv)
 
   sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
 
+  test_qsort_r ();
+  test_psort_threaded (mpicomm);
+
   if (argc >= 2) {
     timing = 1;
     lcount = (size_t) strtol (argv[1], NULL, 0);
@@ -91,33 +286,12 @@ main (int argc, char **argv)
 
   /* verify result */
   if (!timing || lcount < 1000) {
-    SC_GLOBAL_PRODUCTION ("Verifying\n");
-    gtotal = 0;
-    recvc = NULL;
-    displ = NULL;
-    gdata = NULL;
-    if (rank == 0) {
-      recvc = SC_ALLOC (int, num_procs);
-      displ = SC_ALLOC (int, num_procs + 1);
-      displ[0] = 0;
-      for (i = 0; i < num_procs; ++i) {
-        recvc[i] = (int) nmemb[i];
-        displ[i + 1] = displ[i] + recvc[i];
-      }
-      gtotal = (size_t) displ[num_procs];
-      gdata = SC_ALLOC (double, gtotal);
-    }
-    mpiret = sc_MPI_Gatherv (ldata, (int) lcount, sc_MPI_DOUBLE,
-                             gdata, recvc, displ, sc_MPI_DOUBLE, 0, mpicomm);
-    SC_CHECK_MPI (mpiret);
-    if (rank == 0) {
-      for (zz = 0; zz < gtotal - 1; ++zz) {
-        SC_CHECK_ABORT (gdata[zz] <= gdata[zz + 1], "Parallel sort failed");
-      }
-    }
-    SC_FREE (gdata);
-    SC_FREE (displ);
-    SC_FREE (recvc);
+    test_sort_verify (mpicomm, ldata, nmemb, 1);
+
+    /* sort again in descending order through the context argument */
+    sc_psort_r (mpicomm, ldata, nmemb, sizeof (double),
+                test_compare_dir, &descending);
+    test_sort_verify (mpicomm, ldata, nmemb, -1);
   }
 
   /* clean up and exit */
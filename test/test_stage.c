@@ -0,0 +1,153 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_stage.h>
+
+#define TEST_STAGE_FILES 3
+#define TEST_STAGE_BYTES 300000
+
+/* write a number of files with contents depending on a round */
+static void
+test_stage_write (sc_stage_t * stage, int rank, int round, int *tickets)
+{
+  int                 i, retval;
+  size_t              iz;
+  char                filename[BUFSIZ];
+  sc_array_t         *data;
+  sc_io_sink_t       *sink;
+
+  data = sc_array_new_count (sizeof (char), TEST_STAGE_BYTES);
+  for (i = 0; i < TEST_STAGE_FILES; ++i) {
+    for (iz = 0; iz < data->elem_count; ++iz) {
+      *(char *) sc_array_index (data, iz) = (char) (iz + i + round);
+    }
+    snprintf (filename, BUFSIZ, "sc_test_stage_%d_%d.out", rank, i);
+    sink = sc_stage_open (stage, filename);
+    SC_CHECK_ABORT (sink != NULL, "Stage open");
+    retval = sc_io_sink_write (sink, data->array, data->elem_count);
+    SC_CHECK_ABORT (retval == 0, "Stage write");
+    tickets[i] = sc_stage_close (stage, sink);
+    SC_CHECK_ABORT (tickets[i] >= 0, "Stage close");
+  }
+  sc_array_destroy (data);
+}
+
+/* verify and optionally remove the final files */
+static void
+test_stage_verify (int rank, int round, int clean)
+{
+  int                 i;
+  size_t              iz;
+  char                filename[BUFSIZ];
+  char               *buffer;
+  FILE               *file;
+
+  buffer = SC_ALLOC (char, TEST_STAGE_BYTES + 1);
+  for (i = 0; i < TEST_STAGE_FILES; ++i) {
+    snprintf (filename, BUFSIZ, "sc_test_stage_%d_%d.out", rank, i);
+    file = fopen (filename, "rb");
+    SC_CHECK_ABORT (file != NULL, "Final open");
+    SC_CHECK_ABORT (fread (buffer, 1, TEST_STAGE_BYTES + 1, file) ==
+                    TEST_STAGE_BYTES, "Final size");
+    fclose (file);
+    for (iz = 0; iz < TEST_STAGE_BYTES; ++iz) {
+      SC_CHECK_ABORT (buffer[iz] == (char) (iz + i + round), "Final data");
+    }
+    if (clean) {
+      remove (filename);
+    }
+  }
+  SC_FREE (buffer);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret, rank, retval;
+  int                 i, round;
+  int                 tickets[TEST_STAGE_FILES];
+  const char         *stage_dir = "sc_test_stage.d";
+  char                filename[BUFSIZ];
+  sc_stage_t         *stage;
+  sc_io_sink_t       *sink;
+  sc_MPI_Comm         mpicomm = sc_MPI_COMM_WORLD;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  /* the stage directory is shared by all processes */
+  stage = sc_stage_new (stage_dir);
+  SC_CHECK_ABORT (stage != NULL, "Stage create");
+
+  /* every round overwrites the files of the previous one */
+  for (round = 0; round < 2; ++round) {
+    test_stage_write (stage, rank, round, tickets);
+    retval = sc_stage_sync (stage, mpicomm);
+    SC_CHECK_ABORT (retval == 0, "Stage sync");
+    for (i = 0; i < TEST_STAGE_FILES; ++i) {
+      SC_CHECK_ABORT (sc_stage_test (stage, tickets[i]), "Stage test");
+    }
+    test_stage_verify (rank, round, 0);
+  }
+
+  /* a drain to a missing directory fails */
+  sink = sc_stage_open (stage, "sc_test_stage_missing.d/file.out");
+  SC_CHECK_ABORT (sink != NULL, "Stage open");
+  tickets[0] = sc_stage_close (stage, sink);
+  SC_CHECK_ABORT (tickets[0] >= 0, "Stage close");
+  retval = sc_stage_sync (stage, mpicomm);
+  SC_CHECK_ABORT (retval != 0, "Stage sync error");
+  SC_CHECK_ABORT (sc_stage_test (stage, tickets[0]), "Stage test error");
+
+  /* the staged copy of a failed drain is kept */
+  snprintf (filename, BUFSIZ, "%s/%ld.%d.file.out", stage_dir,
+            (long) getpid (), 2 * TEST_STAGE_FILES);
+  SC_CHECK_ABORT (remove (filename) == 0, "Stage keep");
+
+  /* a final name without room for the partial suffix is refused */
+  memset (filename, 'x', BUFSIZ - 3);
+  filename[BUFSIZ - 3] = '\0';
+  SC_CHECK_ABORT (sc_stage_open (stage, filename) == NULL, "Stage long");
+
+  /* the files closed last are drained on destruction */
+  test_stage_write (stage, rank, 2, tickets);
+  retval = sc_stage_destroy (stage);
+  SC_CHECK_ABORT (retval == 0, "Stage destroy");
+  test_stage_verify (rank, 2, 1);
+
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (rank == 0) {
+    rmdir (stage_dir);
+  }
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,154 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_taskpool.h>
+
+typedef struct test_fib
+{
+  sc_taskpool_t      *pool;
+  int                 n;
+  long                result;
+}
+test_fib_t;
+
+static void
+test_fib_task (void *v)
+{
+  test_fib_t         *fib = (test_fib_t *) v;
+  test_fib_t         *child;
+  sc_taskgroup_t     *group;
+  long                second;
+
+  if (fib->n < 2) {
+    fib->result = fib->n;
+    return;
+  }
+
+  /* compute one branch asynchronously and the other one directly */
+  child = SC_ALLOC (test_fib_t, 1);
+  child->pool = fib->pool;
+  child->n = fib->n - 1;
+  group = sc_taskgroup_new (fib->pool);
+  sc_taskgroup_spawn (group, test_fib_task, child);
+
+  fib->n -= 2;
+  test_fib_task (fib);
+  second = fib->result;
+  fib->n += 2;
+
+  sc_taskgroup_wait (group);
+  sc_taskgroup_destroy (group);
+  fib->result = child->result + second;
+  SC_FREE (child);
+}
+
+typedef struct test_range
+{
+  long               *values;
+  size_t              grain;
+}
+test_range_t;
+
+static void
+test_range_fn (size_t begin, size_t end, void *data)
+{
+  test_range_t       *tr = (test_range_t *) data;
+  size_t              zz;
+
+  SC_CHECK_ABORT (begin < end && end - begin <= tr->grain,
+                  "Range exceeds grain size");
+  for (zz = begin; zz < end; ++zz) {
+    SC_CHECK_ABORT (tr->values[zz] == 0, "Range index visited twice");
+    tr->values[zz] = 2 * (long) zz + 1;
+  }
+}
+
+static void
+test_taskpool_run (sc_taskpool_t * pool)
+{
+  const size_t        n = 100003;
+  size_t              zz, grain;
+  test_fib_t          fib;
+  test_range_t        tr;
+
+  SC_GLOBAL_INFOF ("Testing task pool with %d threads\n",
+                   sc_taskpool_num_threads (pool));
+  SC_CHECK_ABORT (sc_taskpool_thread_id (pool) == 0, "Main thread id");
+
+  /* explicit grain sizes and the automatic choice */
+  tr.values = SC_ALLOC (long, n);
+  for (grain = 0; grain <= 1000; grain += 997) {
+    memset (tr.values, 0, n * sizeof (long));
+    tr.grain = grain == 0 ? n : grain;
+    sc_taskpool_parallel_for (pool, 0, n, grain, test_range_fn, &tr);
+    for (zz = 0; zz < n; ++zz) {
+      SC_CHECK_ABORT (tr.values[zz] == 2 * (long) zz + 1, "Range result");
+    }
+  }
+  SC_FREE (tr.values);
+
+  /* nested task groups */
+  fib.pool = pool;
+  fib.n = 20;
+  test_fib_task (&fib);
+  SC_CHECK_ABORT (fib.result == 6765, "Fibonacci result");
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_taskpool_t      *pool;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  test_taskpool_run (sc_taskpool_global ());
+
+  pool = sc_taskpool_new (0, 0);
+  test_taskpool_run (pool);
+  sc_taskpool_destroy (pool);
+
+  pool = sc_taskpool_new (4, 1);
+  test_taskpool_run (pool);
+  sc_taskpool_destroy (pool);
+
+  /* replace the global pool and return to the environment */
+  sc_set_thread_defaults (3, 0);
+#ifdef SC_ENABLE_PTHREAD
+  SC_CHECK_ABORT (sc_taskpool_num_threads (sc_taskpool_global ()) == 3,
+                  "Global pool threads");
+#endif
+  test_taskpool_run (sc_taskpool_global ());
+  sc_set_thread_defaults (-1, 0);
+  test_taskpool_run (sc_taskpool_global ());
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,260 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_io.h>
+#ifdef SC_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#define SC_TEST_VTK_ARRAYS 3
+
+/* the number of doubles in each test array */
+static const size_t sc_test_vtk_counts[SC_TEST_VTK_ARRAYS] =
+  { 0, 1000, 20000 };
+
+static double      *
+test_vtk_array (int rank, int which)
+{
+  size_t              iz, count = sc_test_vtk_counts[which];
+  double             *data;
+
+  data = SC_ALLOC (double, SC_MAX (count, 1));
+  for (iz = 0; iz < count; ++iz) {
+    /* repeat values to make the data compressible */
+    data[iz] = rank + .5 * which + (double) (iz % 97);
+  }
+  return data;
+}
+
+/* check one array of an appended section and return its length */
+static size_t
+test_vtk_check (const char *appended, int compressed, const double *data,
+                size_t count)
+{
+  uint64_t            header[3];
+  size_t              bytes = count * sizeof (double);
+
+  memcpy (header, appended, sizeof (uint64_t));
+  if (!compressed) {
+    SC_CHECK_ABORT (header[0] == (uint64_t) bytes, "Raw header");
+    SC_CHECK_ABORT (!memcmp (appended + sizeof (uint64_t), data, bytes),
+                    "Raw data");
+    return sizeof (uint64_t) + bytes;
+  }
+  else {
+#ifdef SC_HAVE_ZLIB
+    int                 retval;
+    char               *block;
+    size_t              ib, nblocks, position, blockbytes;
+    uint64_t            comp_size;
+    uLongf              length;
+
+    memcpy (header, appended, 3 * sizeof (uint64_t));
+    nblocks = (size_t) header[0];
+    SC_CHECK_ABORT (header[1] == 32768, "Block size");
+    SC_CHECK_ABORT (nblocks == (bytes + 32767) / 32768, "Block count");
+    position = (3 + nblocks) * sizeof (uint64_t);
+    block = SC_ALLOC (char, 32768);
+    for (ib = 0; ib < nblocks; ++ib) {
+      blockbytes = ib + 1 < nblocks ? 32768 : (size_t) header[2];
+      memcpy (&comp_size, appended + (3 + ib) * sizeof (uint64_t),
+              sizeof (uint64_t));
+      length = 32768;
+      retval = uncompress ((Bytef *) block, &length,
+                           (const Bytef *) appended + position,
+                           (uLong) comp_size);
+      SC_CHECK_ABORT (retval == Z_OK && length == blockbytes,
+                      "Uncompress");
+      SC_CHECK_ABORT (!memcmp (block, (const char *) data + ib * 32768,
+                               blockbytes), "Compressed data");
+      position += (size_t) comp_size;
+    }
+    SC_FREE (block);
+    return position;
+#else
+    SC_ABORT_NOT_REACHED ();
+    return 0;
+#endif
+  }
+}
+
+/* write a local appended section into a buffer and read it back */
+static void
+test_vtk_serial (int compression)
+{
+  int                 which, retval;
+  size_t              offset;
+  double             *data[SC_TEST_VTK_ARRAYS];
+  sc_array_t         *buffer;
+  sc_io_sink_t       *sink;
+  sc_vtk_appended_t  *app;
+
+  app = sc_vtk_appended_new (compression);
+  for (which = 0; which < SC_TEST_VTK_ARRAYS; ++which) {
+    data[which] = test_vtk_array (0, which);
+    offset = sc_vtk_appended_add (app, data[which],
+                                  sc_test_vtk_counts[which] *
+                                  sizeof (double));
+    SC_CHECK_ABORT (offset == sc_vtk_appended_offset (app, which),
+                    "Offset");
+  }
+
+  buffer = sc_array_new (sizeof (char));
+  sink = sc_io_sink_new (SC_IO_TYPE_BUFFER, SC_IO_MODE_WRITE,
+                         SC_IO_ENCODE_NONE, buffer);
+  SC_CHECK_ABORT (sink != NULL, "Sink create");
+  retval = sc_vtk_appended_write_sink (app, sink);
+  SC_CHECK_ABORT (retval == 0, "Appended write");
+  retval = sc_io_sink_destroy (sink);
+  SC_CHECK_ABORT (retval == 0, "Sink destroy");
+  SC_CHECK_ABORT (buffer->elem_count == sc_vtk_appended_size (app),
+                  "Appended size");
+
+  for (which = 0; which < SC_TEST_VTK_ARRAYS; ++which) {
+    offset = sc_vtk_appended_offset (app, which);
+    offset += test_vtk_check (buffer->array + offset, compression > 0,
+                              data[which], sc_test_vtk_counts[which]);
+    SC_CHECK_ABORT (offset == (which + 1 < SC_TEST_VTK_ARRAYS ?
+                               sc_vtk_appended_offset (app, which + 1) :
+                               buffer->elem_count), "Array length");
+    SC_FREE (data[which]);
+  }
+
+  sc_array_destroy (buffer);
+  sc_vtk_appended_destroy (app);
+}
+
+#ifdef SC_ENABLE_MPIIO
+
+/* write the sections of all processes into one file and check our own */
+static void
+test_vtk_parallel (int compression, sc_MPI_Comm mpicomm)
+{
+  const char         *filename = "sc_test_vtk.vtu";
+  const char         *head = "<VTKFile>\n<AppendedData encoding=\"raw\">\n_";
+  const char         *tail = "\n</AppendedData>\n</VTKFile>\n";
+  int                 which, rank, retval, mpiret;
+  char                piece[BUFSIZ];
+  char               *readback;
+  size_t              total, size;
+  long                position;
+  double             *data[SC_TEST_VTK_ARRAYS];
+  FILE               *file;
+  MPI_File            mpifile;
+  MPI_Offset          offset, start;
+  sc_vtk_appended_t  *app;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  app = sc_vtk_appended_new (compression);
+  for (which = 0; which < SC_TEST_VTK_ARRAYS; ++which) {
+    data[which] = test_vtk_array (rank, which);
+    (void) sc_vtk_appended_add (app, data[which],
+                                sc_test_vtk_counts[which] * sizeof (double));
+  }
+  total = sc_vtk_appended_exscan (app, mpicomm);
+  size = sc_vtk_appended_size (app);
+
+  mpiret = MPI_File_open (mpicomm, (char *) filename,
+                          MPI_MODE_WRONLY | MPI_MODE_CREATE, MPI_INFO_NULL,
+                          &mpifile);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_File_set_size (mpifile, 0);
+  SC_CHECK_MPI (mpiret);
+
+  /* the markup of each process refers to its global offsets */
+  offset = 0;
+  retval = sc_vtk_write_ordered_mpi (mpifile, &offset, head,
+                                     rank == 0 ? strlen (head) : 0, mpicomm);
+  SC_CHECK_ABORT (retval == 0, "Write head");
+  snprintf (piece, BUFSIZ, "<!-- rank %d offset %lld -->\n", rank,
+            (long long) sc_vtk_appended_offset (app, 0));
+  retval = sc_vtk_write_ordered_mpi (mpifile, &offset, piece,
+                                     strlen (piece), mpicomm);
+  SC_CHECK_ABORT (retval == 0, "Write piece");
+  start = offset;
+  retval = sc_vtk_appended_write_mpi (app, mpifile, &offset);
+  SC_CHECK_ABORT (retval == 0, "Write appended");
+  SC_CHECK_ABORT (offset == start + (MPI_Offset) total, "Appended end");
+  retval = sc_vtk_write_ordered_mpi (mpifile, &offset, tail,
+                                     rank == 0 ? strlen (tail) : 0, mpicomm);
+  SC_CHECK_ABORT (retval == 0, "Write tail");
+  mpiret = MPI_File_close (&mpifile);
+  SC_CHECK_MPI (mpiret);
+
+  /* every process reads back its own section */
+  readback = SC_ALLOC (char, SC_MAX (size, 1));
+  file = fopen (filename, "rb");
+  SC_CHECK_ABORT (file != NULL, "Open file");
+  position = (long) start + (long) sc_vtk_appended_offset (app, 0);
+  SC_CHECK_ABORT (fseek (file, position, SEEK_SET) == 0, "Seek file");
+  sc_fread (readback, 1, size, file, "Read file");
+  fclose (file);
+  for (which = 0; which < SC_TEST_VTK_ARRAYS; ++which) {
+    (void) test_vtk_check (readback + sc_vtk_appended_offset (app, which) -
+                           sc_vtk_appended_offset (app, 0), compression > 0,
+                           data[which], sc_test_vtk_counts[which]);
+    SC_FREE (data[which]);
+  }
+  SC_FREE (readback);
+  sc_vtk_appended_destroy (app);
+
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (rank == 0) {
+    remove (filename);
+  }
+}
+
+#endif
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 ic, compression[2] = { 0, 6 };
+  int                 ncompression = 1;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+#ifdef SC_HAVE_ZLIB
+  ncompression = 2;
+#endif
+  for (ic = 0; ic < ncompression; ++ic) {
+    SC_GLOBAL_INFOF ("Appended data with compression %d\n", compression[ic]);
+    test_vtk_serial (compression[ic]);
+#ifdef SC_ENABLE_MPIIO
+    test_vtk_parallel (compression[ic], sc_MPI_COMM_WORLD);
+#endif
+  }
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}